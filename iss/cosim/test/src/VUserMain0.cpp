@@ -177,9 +177,25 @@ int parseArgs(int argcIn, char** argvIn, rv32i_cfg_s &cfg, const int node)
             cfg.update_rst_vec = true;
             cfg.new_rst_vec    = strtol(optarg, NULL, 0);
             break;
+        case 'C':
+            cfg.en_dcache = false;
+            break;
+        case 'B':
+            cfg.en_blk_cache = false;
+            break;
+        case 'j':
+            cfg.en_jit = true;
+            break;
+        case 'J':
+            cfg.en_jit    = true;
+            cfg.jit_check = true;
+            break;
+        case 'T':
+            cfg.en_threaded = true;
+            break;
         case 'h':
         default:
-            fprintf(stderr, "Usage: %s -t <test executable> [-hHebdrg][-n <num instructions>]\n      [-S <start addr>][-A <brk addr>][-D <debug o/p filename>][-p <port num>]\n", argv[0]);
+            fprintf(stderr, "Usage: %s -t <test executable> [-hHebdrgCBjJT][-n <num instructions>]\n      [-S <start addr>][-A <brk addr>][-D <debug o/p filename>][-p <port num>]\n", argv[0]);
             fprintf(stderr, "   -t specify test executable (default test.exe)\n");
             fprintf(stderr, "   -n specify number of instructions to run (default 0, i.e. run until unimp)\n");
             fprintf(stderr, "   -d Enable disassemble mode (default off)\n");
@@ -192,6 +208,11 @@ int parseArgs(int argcIn, char** argvIn, rv32i_cfg_s &cfg, const int node)
             fprintf(stderr, "   -g Enable remote gdb mode (default disabled)\n");
             fprintf(stderr, "   -p Specify remote GDB port number (default 49152)\n");
             fprintf(stderr, "   -S Specify start address (default 0)\n");
+            fprintf(stderr, "   -C Disable decoded instruction cache (default enabled)\n");
+            fprintf(stderr, "   -B Disable basic block cache (default enabled)\n");
+            fprintf(stderr, "   -j Enable JIT translation of hot blocks (default disabled)\n");
+            fprintf(stderr, "   -J Enable JIT with lockstep checking against the interpreter (default disabled)\n");
+            fprintf(stderr, "   -T Use threaded dispatch execution engine (default interpreter)\n");
             fprintf(stderr, "   -h display this help message\n");
             error = 1;
             break;
@@ -255,6 +276,13 @@ extern "C" void VUserMain0()
         // Create and configure the top level cpu object
         pCpu = new rv32(cfg.dbg_fp);
 
+        // Memory map. The RAM and test bench registers are all in the HDL, so each
+        // region's accesses are made over the VProc bus, with the regions decoding
+        // the addresses in place of the ISS's own internal memory. Any other address
+        // goes to the external memory callback, and on to the (sparse) memory model.
+        pCpu->register_mmio(MEM_OFFSET,   MEM_SIZE,     ext_mem_access, RV32I_REGION_PERM_RWX);
+        pCpu->register_mmio(TB_REGS_ADDR, TB_REGS_SIZE, ext_mem_access);
+
         // Register external memory callback function
         pCpu->register_ext_mem_callback(ext_mem_access);
 
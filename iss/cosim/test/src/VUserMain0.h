@@ -15,11 +15,15 @@ extern "C" {
 }
 
 #define CFGFILENAME                        "vusermain.cfg"
-#define RV32I_GETOPT_ARG_STR               "hHdbrget:n:D:A:p:S:"
+#define RV32I_GETOPT_ARG_STR               "hHdbrgeCBjJTt:n:D:A:p:S:"
 #define MAXARGS                            100
 #define MEM_SIZE                           (1024*1024)
 #define MEM_OFFSET                         0
 
+// Test bench registers (byte enables, halt and interrupt), decoded in tb.v
+#define TB_REGS_ADDR                       0xAFFFFFF0
+#define TB_REGS_SIZE                       16
+
 // Define a sleep forever macro
 #define SLEEP_FOREVER {while(1)            VTick(0x7fffffff, node);}      
 
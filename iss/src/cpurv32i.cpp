@@ -29,6 +29,9 @@
 // ------------------------------------------------
 
 #include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 
 #if !defined _WIN32 && !defined _WIN64
 #include <unistd.h>
@@ -52,22 +55,60 @@ extern "C" {
 }
 
 #include "rv32.h"
+#include "rv32_smp.h"
 #include "rv32_cpu_gdb.h"
 
 // ------------------------------------------------
 // DEFINES
 // ------------------------------------------------
 
-#define RV32I_GETOPT_ARG_STR               "hHgdbert:n:D:A:p:S:"
+#define RV32I_GETOPT_ARG_STR               "hHgdbeCBjJTmsvPGULyXrt:n:D:A:p:S:i:f:M:O:N:Q:"
+
+// Execution engines benchmarked, in order
+#define RV32_BENCH_INTERPRETER             0
+#define RV32_BENCH_THREADED                1
+#define RV32_BENCH_JIT                     2
+#define RV32_BENCH_ENGINES                 3
 
 #define INT_ADDR                           0xaffffffc
+#define INT_TIMER_ADDR                     0xaffffff8
 #define UART_TX_ADDR                       0x80000000
 
 // ------------------------------------------------
 // LOCAL VARIABLES
 // ------------------------------------------------
 
-static uint32_t irq = 0;
+static std::atomic<uint32_t> irq(0);
+
+// Time at which the interrupt timer device sets irq, if counting
+static std::atomic<rv32i_time_t> irq_time(RV32I_EVENT_NEVER);
+
+// Benchmark mode, running the executable with each execution engine
+static bool     bench = false;
+
+// ISA configuration of the model
+static const char* isa = "rv32g";
+
+// Flat memory mode, using only the cpu's internal memory in place of the memory model
+static bool     flat_mem = false;
+
+// Memory model backed by host huge pages
+static bool     huge_mem = false;
+
+// Load the executable lazily, populating pages on first access
+static bool     lazy_load = false;
+
+// Read the executable's symbols and source lines, labelling disassembly
+static bool     symbols = false;
+
+// Number of harts
+static uint32_t num_harts = 1;
+
+// The memory model is not thread safe, so is locked for harts running in parallel
+static std::mutex mem_mutex;
+
+// The multiprocessor, whose harts all see the interrupt device's irq
+static rv32_smp* p_smp = NULL;
 
 // ------------------------------------------------
 // TYPE DEFINITIONS
@@ -136,9 +177,81 @@ int parse_args(int argc, char** argv, rv32i_cfg_s &cfg)
             cfg.update_rst_vec = true;
             cfg.new_rst_vec    = strtol(optarg, NULL, 0);
             break;
+        case 'C':
+            cfg.en_dcache = false;
+            break;
+        case 'B':
+            cfg.en_blk_cache = false;
+            break;
+        case 'j':
+            cfg.en_jit = true;
+            break;
+        case 'J':
+            cfg.en_jit    = true;
+            cfg.jit_check = true;
+            break;
+        case 'T':
+            cfg.en_threaded = true;
+            break;
+        case 'm':
+            bench = true;
+            break;
+        case 'i':
+            isa = optarg;
+            break;
+        case 's':
+            cfg.stats_en = true;
+            break;
+        case 'v':
+            cfg.time_mode = RV32I_TIME_VIRTUAL;
+            break;
+        case 'P':
+            cfg.time_mode = RV32I_TIME_PACED;
+            break;
+        case 'f':
+            cfg.cycles_per_tick = strtol(optarg, NULL, 0);
+            break;
+        case 'M':
+            {
+                unsigned long long size = strtoull(optarg, NULL, 0);
+
+                if (size > 0xffffffffULL)
+                {
+                    fprintf(stderr, "**ERROR: internal memory size (%s) must be less than 4GB.\n", optarg);
+                    error = 1;
+                }
+
+                cfg.int_mem_size = (uint32_t)size;
+                flat_mem         = true;
+            }
+            break;
+        case 'O':
+            cfg.int_mem_base = strtoul(optarg, NULL, 0);
+            break;
+        case 'G':
+            cfg.en_guest_space = true;
+            break;
+        case 'U':
+            huge_mem = true;
+            break;
+        case 'L':
+            lazy_load = true;
+            break;
+        case 'y':
+            symbols = true;
+            break;
+        case 'N':
+            num_harts = strtoul(optarg, NULL, 0);
+            break;
+        case 'Q':
+            cfg.smp_quantum = strtoul(optarg, NULL, 0);
+            break;
+        case 'X':
+            cfg.smp_parallel = true;
+            break;
         case 'h':
         default:
-            fprintf(stderr, "Usage: %s -t <test executable> [-hHebdrg][-n <num instructions>]\n      [-S <start addr>][-A <brk addr>][-D <debug o/p filename>][-p <port num>]\n", argv[0]);
+            fprintf(stderr, "Usage: %s -t <test executable> [-hHebdrgCBjJTmsvPGULyX][-n <num instructions>]\n      [-S <start addr>][-A <brk addr>][-D <debug o/p filename>][-p <port num>]\n      [-i <isa>][-f <cycles per tick>][-M <int mem size>][-O <int mem base>]\n      [-N <num harts>][-Q <quantum>]\n", argv[0]);
             fprintf(stderr, "   -t specify test executable (default test.exe)\n");
             fprintf(stderr, "   -n specify number of instructions to run (default 0, i.e. run until unimp)\n");
             fprintf(stderr, "   -d Enable disassemble mode (default off)\n");
@@ -151,6 +264,26 @@ int parse_args(int argc, char** argv, rv32i_cfg_s &cfg)
             fprintf(stderr, "   -g Enable remote gdb mode (default disabled)\n");
             fprintf(stderr, "   -p Specify remote GDB port number (default 49152)\n");
             fprintf(stderr, "   -S Specify start address (default 0)\n");
+            fprintf(stderr, "   -C Disable decoded instruction cache (default enabled)\n");
+            fprintf(stderr, "   -B Disable basic block cache (default enabled)\n");
+            fprintf(stderr, "   -j Enable JIT translation of hot blocks (default disabled)\n");
+            fprintf(stderr, "   -J Enable JIT with lockstep checking against the interpreter (default disabled)\n");
+            fprintf(stderr, "   -T Use threaded dispatch execution engine (default interpreter)\n");
+            fprintf(stderr, "   -m Benchmark mode: run with each execution engine and display MIPS (default off)\n");
+            fprintf(stderr, "   -s Display run statistics on completion (default off)\n");
+            fprintf(stderr, "   -v Use virtual mtime, derived from the cycle count (default wall clock)\n");
+            fprintf(stderr, "   -P Use virtual mtime, paced to the wall clock (default wall clock)\n");
+            fprintf(stderr, "   -f Specify cycles per microsecond tick of virtual mtime (default %d)\n", RV32I_DEFAULT_CYCLES_PER_TICK);
+            fprintf(stderr, "   -M Use only internal memory, of the specified size in bytes (default sparse memory model)\n");
+            fprintf(stderr, "   -O Specify internal memory base address (default 0x%08x)\n", RV32I_INT_MEM_BASE);
+            fprintf(stderr, "   -G Reserve the whole address space as directly accessed memory (default sparse memory model)\n");
+            fprintf(stderr, "   -U Back the sparse memory model with host huge pages (default normal pages)\n");
+            fprintf(stderr, "   -L Load the executable lazily, on first access of each page (default load all)\n");
+            fprintf(stderr, "   -y Read the executable's symbols and source lines, labelling disassembly (default off)\n");
+            fprintf(stderr, "   -i Specify ISA configuration: rv32i, rv32im, rv32ima or rv32g (default rv32g)\n");
+            fprintf(stderr, "   -N Specify number of harts, sharing memory (default 1)\n");
+            fprintf(stderr, "   -Q Specify instructions each hart runs between synchronisations (default %d)\n", RV32I_SMP_QUANTUM);
+            fprintf(stderr, "   -X Run harts in parallel on separate host threads (default round robin)\n");
             fprintf(stderr, "   -h display this help message\n");
             error = 1;
             break;
@@ -161,69 +294,290 @@ int parse_args(int argc, char** argv, rv32i_cfg_s &cfg)
 }
 
 // -------------------------------
-// External memory map access
-// callback function
+// UART device access function.
+// Only byte writes to transmit are
+// processed (all else is memory)
 //
-int ext_mem_access(const uint32_t byte_addr, uint32_t& data, const int type, const rv32i_time_t time)
+int uart_access(const uint32_t byte_addr, uint32_t& data, const int type, const rv32i_time_t time)
 {
-    int processed = RV32I_EXT_MEM_NOT_PROCESSED;
-
-    // If not interrupt address, access memory model
     if (byte_addr == UART_TX_ADDR && type == MEM_WR_ACCESS_BYTE)
     {
-        processed = 1;
         putchar(data & 0xff);
+        return 1;
     }
-    else if (byte_addr != INT_ADDR)
+
+    return RV32I_EXT_MEM_NOT_PROCESSED;
+}
+
+// -------------------------------
+// Interrupt device access function,
+// with word writes setting the
+// irq state, and reads returning it
+//
+int int_access(const uint32_t byte_addr, uint32_t& data, const int type, const rv32i_time_t time)
+{
+    switch (type & MEM_NOT_DBG_MASK)
     {
-        uint32_t addr = byte_addr;
-        processed = 1;
+    case MEM_WR_ACCESS_WORD:
+        irq  = data & 0x1;
 
-        switch (type & MEM_NOT_DBG_MASK)
+        // The writing hart calls its interrupt callback after the write, but
+        // the other harts must be told of the change
+        if (p_smp != NULL && p_smp->num_harts() > 1)
         {
-        case MEM_RD_ACCESS_BYTE:
-            data = ReadRamByte(addr, 0);
-            break;
-        case MEM_RD_ACCESS_HWORD:
-            data = ReadRamHWord(addr, true, 0);
-            break;
-        case MEM_RD_ACCESS_INSTR:
-        case MEM_RD_ACCESS_WORD:
-            data = ReadRamWord(addr, true, 0);
-            break;
-        case MEM_WR_ACCESS_BYTE:
-            WriteRamByte(addr, data, 0);
-            break;
-        case MEM_WR_ACCESS_HWORD:
-            WriteRamHWord(addr, data, true, 0);
-            break;
-        case MEM_WR_ACCESS_INSTR:
-        case MEM_WR_ACCESS_WORD:
-            WriteRamWord(addr, data, true, 0);
-            break;
-        default:
-            processed = RV32I_EXT_MEM_NOT_PROCESSED;
-            break;
+            p_smp->int_changed();
         }
+        return 1;
+    case MEM_RD_ACCESS_WORD:
+        data = irq;
+        return 1;
     }
-    else if ((type & MEM_NOT_DBG_MASK) == MEM_WR_ACCESS_WORD && byte_addr == INT_ADDR)
+
+    return RV32I_EXT_MEM_NOT_PROCESSED;
+}
+
+// -------------------------------
+// RAM page callback function,
+// returning the memory model's
+// storage for a page, allocated
+// only when written (reads of an
+// unwritten page return zero
+// through ext_mem_access)
+//
+uint8_t* ext_mem_page(const uint32_t page_addr, const bool write)
+{
+    std::lock_guard<std::mutex> lock(mem_mutex);
+
+    return (uint8_t*)(write ? GetRamPage(page_addr, 0) : PeekRamPage(page_addr, 0));
+}
+
+// -------------------------------
+// External memory map access
+// callback function, for memory in
+// pages shared with the devices
+// (not mapped by the page callback)
+//
+int ext_mem_access(const uint32_t byte_addr, uint32_t& data, const int type, const rv32i_time_t time)
+{
+    int processed = 1;
+
+    std::lock_guard<std::mutex> lock(mem_mutex);
+
+    switch (type & MEM_NOT_DBG_MASK)
     {
-        irq       = data & 0x1;
-        processed = 1;
+    case MEM_RD_ACCESS_BYTE:
+        data = ReadRamByte(byte_addr, 0);
+        break;
+    case MEM_RD_ACCESS_HWORD:
+        data = ReadRamHWord(byte_addr, true, 0);
+        break;
+    case MEM_RD_ACCESS_INSTR:
+    case MEM_RD_ACCESS_WORD:
+        data = ReadRamWord(byte_addr, true, 0);
+        break;
+    case MEM_WR_ACCESS_BYTE:
+        WriteRamByte(byte_addr, data, 0);
+        break;
+    case MEM_WR_ACCESS_HWORD:
+        WriteRamHWord(byte_addr, data, true, 0);
+        break;
+    case MEM_WR_ACCESS_INSTR:
+    case MEM_WR_ACCESS_WORD:
+        WriteRamWord(byte_addr, data, true, 0);
+        break;
+    default:
+        processed = RV32I_EXT_MEM_NOT_PROCESSED;
+        break;
     }
 
     return processed;
 }
 
+// -------------------------------
+// Interrupt timer device access
+// function, with word writes
+// setting irq after the written
+// number of cycles (cancelling
+// if 0), and reads returning
+// whether counting
+//
+int int_timer_access(const uint32_t byte_addr, uint32_t& data, const int type, const rv32i_time_t time)
+{
+    switch (type & MEM_NOT_DBG_MASK)
+    {
+    case MEM_WR_ACCESS_WORD:
+        irq_time = data ? time + data : RV32I_EVENT_NEVER;
+
+        // All harts must start polling for the time to be reached
+        if (p_smp != NULL && p_smp->num_harts() > 1)
+        {
+            p_smp->int_changed();
+        }
+        return 1;
+    case MEM_RD_ACCESS_WORD:
+        data = irq_time != RV32I_EVENT_NEVER;
+        return 1;
+    }
+
+    return RV32I_EXT_MEM_NOT_PROCESSED;
+}
+
 // ------------------------------
 // Interrupt callback function
 //
 uint32_t interrupt_callback(const rv32i_time_t time, rv32i_time_t *wakeup_time)
 {
-    *wakeup_time = time + 1;
+    rv32i_time_t set_time = irq_time;
+
+    // While the interrupt timer is counting, wakeup_time is left unchanged, so
+    // that this function is polled every cycle until the time is reached
+    if (set_time != RV32I_EVENT_NEVER)
+    {
+        if (time < set_time)
+        {
+            return irq;
+        }
+
+        // The first hart to reach the time sets irq, and tells the others
+        if (irq_time.compare_exchange_strong(set_time, RV32I_EVENT_NEVER))
+        {
+            irq = 1;
+
+            if (p_smp != NULL && p_smp->num_harts() > 1)
+            {
+                p_smp->int_changed();
+            }
+        }
+    }
+
+    // Otherwise irq only changes on a write to INT_ADDR or INT_TIMER_ADDR, which
+    // the ISS follows with a call to this function (on every hart, via the
+    // multiprocessor), so there is no need to be woken up
+    *wakeup_time = RV32I_EVENT_NEVER;
     return irq;
 }
 
+// -------------------------------
+// Configure the memory map and
+// register the callbacks with a
+// cpu
+//
+int register_callbacks(rv32csr_cpu* pCpu, const rv32i_cfg_s &cfg)
+{
+    if (pCpu->set_int_mem(cfg.int_mem_base, cfg.int_mem_size))
+    {
+        fprintf(stderr, "**ERROR: unable to configure internal memory (base 0x%08x, size 0x%x)\n", cfg.int_mem_base, cfg.int_mem_size);
+        return 1;
+    }
+
+    // Devices
+    pCpu->register_mmio(UART_TX_ADDR,   4, uart_access);
+    pCpu->register_mmio(INT_ADDR,       4, int_access);
+    pCpu->register_mmio(INT_TIMER_ADDR, 4, int_timer_access);
+
+    // Memory model, directly accessed a page at a time (except for
+    // pages shared with the devices), unless using only the flat
+    // internal memory, or a reserved guest address space
+    if (cfg.en_guest_space)
+    {
+        if (pCpu->reserve_guest_space())
+        {
+            fprintf(stderr, "**ERROR: unable to reserve guest address space\n");
+            return 1;
+        }
+    }
+    else if (!flat_mem)
+    {
+        SetMemHugePages(huge_mem, 0);
+        pCpu->register_ext_mem_callback(ext_mem_access);
+        pCpu->register_ram_page_callback(ext_mem_page);
+    }
+
+    pCpu->register_int_callback(interrupt_callback);
+
+    return 0;
+}
+
+// -------------------------------
+// Benchmark the execution engines,
+// loading and running the executable
+// with each in turn, and displaying
+// their MIPS side by side
+//
+int run_bench(rv32i_cfg_s &cfg)
+{
+    const char* engine_str[RV32_BENCH_ENGINES] = {"interpreter", "threaded", "JIT"};
+    uint64_t    instr[RV32_BENCH_ENGINES];
+    double      secs[RV32_BENCH_ENGINES];
+
+    for (int engine = 0; engine < RV32_BENCH_ENGINES; engine++)
+    {
+        // The JIT would fall back to the interpreter, so is not run where unsupported
+        if (engine == RV32_BENCH_JIT && !RV32I_JIT_HOST_SUPPORTED)
+        {
+            continue;
+        }
+
+        rv32csr_cpu* pCpu = rv32_create(isa, cfg.dbg_fp);
+
+        if (pCpu == NULL)
+        {
+            fprintf(stderr, "**ERROR: unsupported ISA configuration (%s)\n", isa);
+            return 1;
+        }
+
+        if (register_callbacks(pCpu, cfg))
+        {
+            delete pCpu;
+            return 1;
+        }
+
+        irq      = 0;
+        irq_time = RV32I_EVENT_NEVER;
+
+        // Each engine starts with the memory model empty
+        ResetMem(0);
+
+        if (pCpu->read_elf(cfg.exec_fname, NULL, lazy_load))
+        {
+            delete pCpu;
+            return 1;
+        }
+
+        // Each engine runs from its own copy of the configuration, as run() updates it
+        // (e.g. clearing update_rst_vec, so only the first would start at a -S address)
+        rv32i_cfg_s engine_cfg = cfg;
+
+        engine_cfg.en_threaded = (engine == RV32_BENCH_THREADED);
+        engine_cfg.en_jit      = (engine == RV32_BENCH_JIT);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        pCpu->run(engine_cfg);
+
+        secs[engine]  = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        instr[engine] = pCpu->instructions_run();
+
+        delete pCpu;
+    }
+
+    fprintf(stderr, "\n%-12s %16s %10s %10s\n", "Engine", "Instructions", "Time (s)", "MIPS");
+
+    for (int engine = 0; engine < RV32_BENCH_ENGINES; engine++)
+    {
+        if (engine == RV32_BENCH_JIT && !RV32I_JIT_HOST_SUPPORTED)
+        {
+            fprintf(stderr, "%-12s %16s\n", engine_str[engine], "not supported on this host");
+            continue;
+        }
+
+        fprintf(stderr, "%-12s %16llu %10.3f %10.2f\n", engine_str[engine], (unsigned long long)instr[engine], secs[engine],
+                        secs[engine] > 0.0 ? instr[engine] / (secs[engine] * 1e6) : 0.0);
+    }
+
+    return 0;
+}
+
 // -------------------------------
 // MAIN
 //
@@ -231,20 +585,49 @@ int main(int argc, char** argv)
 {
     int         error = 0;
 
-    rv32*         pCpu;
+    rv32_smp*     pSmp;
+    rv32csr_cpu*  pCpu;
     rv32i_cfg_s   cfg;
     
     // Process command line arguments
-    if (!(error = parse_args(argc, argv, cfg)))
+    if (!(error = parse_args(argc, argv, cfg)) && bench)
     {
-        // Create and configure the top level cpu object
-        pCpu = new rv32(cfg.dbg_fp);
+        error = run_bench(cfg);
+    }
+    else if (!error)
+    {
+        // Harts share one memory map, so not a guest space or lazy loading
+        // (configured per hart), and are not supported by the GDB interface
+        if (num_harts > 1 && (cfg.en_guest_space || lazy_load || cfg.gdb_mode))
+        {
+            fprintf(stderr, "**ERROR: -G, -L and -g are not supported with multiple harts\n");
+            return 1;
+        }
 
-        // Register external memory callback function
-        pCpu->register_ext_mem_callback(ext_mem_access);
+        // Create the harts, of the selected ISA configuration, with hart 0 the top level cpu object
+        pSmp = new rv32_smp(isa, num_harts, cfg.dbg_fp);
+
+        if (pSmp->num_harts() == 0)
+        {
+            fprintf(stderr, "**ERROR: unsupported ISA configuration (%s) or number of harts (%u)\n", isa, num_harts);
+            delete pSmp;
+            return 1;
+        }
 
-        // Register interrupt callback function
-        pCpu->register_int_callback(interrupt_callback);
+        pCpu  = pSmp->hart(0);
+        p_smp = pSmp;
+
+        // Configure the memory map, and register the callback functions, for each hart
+        for (uint32_t id = 0; id < num_harts; id++)
+        {
+            if (register_callbacks(pSmp->hart(id), cfg))
+            {
+                delete pSmp;
+                return 1;
+            }
+        }
+
+        pSmp->share_int_mem();
 
         // If GDB mode, pass execution to the remote GDB interface
         if (cfg.gdb_mode)
@@ -252,7 +635,7 @@ int main(int argc, char** argv)
             // Load an executable if specified on the command line
             if (cfg.user_fname)
             {
-                if (pCpu->read_elf(cfg.exec_fname))
+                if (pCpu->read_elf(cfg.exec_fname, NULL, lazy_load) || (symbols && pCpu->read_elf_symbols(cfg.exec_fname)))
                 {
                     error = 1;
                 }
@@ -271,14 +654,14 @@ int main(int argc, char** argv)
         else
         {
             // Load an executable
-            if (pCpu->read_elf(cfg.exec_fname))
+            if (pSmp->read_elf(cfg.exec_fname, NULL, lazy_load) || (symbols && pCpu->read_elf_symbols(cfg.exec_fname)))
             {
                 error = 1;
             }
             else
             {
                 // Run processor
-                pCpu->run(cfg);
+                pSmp->run(cfg);
 
 #ifdef RV32_DEBUG
                 for (int idx = 0; idx < RV32I_NUM_OF_REGISTERS; idx++)
@@ -289,6 +672,36 @@ int main(int argc, char** argv)
                 printf(" pc=0x%08x\n", pCpu->pc_val());
 #endif
 
+                if (cfg.stats_en)
+                {
+                    uint64_t lookups = pCpu->dcache_hits() + pCpu->dcache_misses();
+
+                    fprintf(stderr, "\nDecode cache: %llu hits, %llu misses (%.2f%% hit rate)\n",
+                                    (unsigned long long)pCpu->dcache_hits(), (unsigned long long)pCpu->dcache_misses(),
+                                    lookups ? (100.0 * pCpu->dcache_hits()) / lookups : 0.0);
+                    fprintf(stderr, "Block cache:  %llu blocks built, %llu executed (%llu chained)\n",
+                                    (unsigned long long)pCpu->blk_builds(), (unsigned long long)pCpu->blk_executions(),
+                                    (unsigned long long)pCpu->blk_chained());
+                    fprintf(stderr, "JIT:          %llu blocks translated, %llu native segments executed (%llu checked)\n",
+                                    (unsigned long long)pCpu->jit_translations(), (unsigned long long)pCpu->jit_executions(),
+                                    (unsigned long long)pCpu->jit_checks());
+                    fprintf(stderr, "Caches:       %llu bytes allocated\n", (unsigned long long)pCpu->cache_footprint());
+
+                    MemStats_t mem_stats;
+                    GetMemStats(&mem_stats, 0);
+
+                    fprintf(stderr, "Memory model: %llu pages touched, %llu bytes resident (%llu reserved)\n",
+                                    (unsigned long long)mem_stats.pages_touched, (unsigned long long)mem_stats.bytes_resident,
+                                    (unsigned long long)mem_stats.bytes_reserved);
+
+                    for (uint32_t id = 1; id < num_harts; id++)
+                    {
+                        fprintf(stderr, "Hart %-9u%llu instructions, pc=0x%08x, %llu cache bytes allocated\n", id,
+                                        (unsigned long long)pSmp->hart(id)->instructions_run(), pSmp->hart(id)->pc_val(),
+                                        (unsigned long long)pSmp->hart(id)->cache_footprint());
+                    }
+                }
+
                 // Print result
                 if (pCpu->regi_val(10) || pCpu->regi_val(17) != 93)
                 {
@@ -306,7 +719,7 @@ int main(int argc, char** argv)
         {
             fclose(cfg.dbg_fp);
         }
-        delete pCpu;
+        delete pSmp;
     }
 
     return error;
@@ -10,13 +10,20 @@
 // INCLUDES
 // -------------------------------------------------------------------------
 
+#if defined (_WIN32) || defined (_WIN64)
+# define  WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#else
+# include <sys/mman.h>
+#endif
+
 #include "mem.h"
 
 // -------------------------------------------------------------------------
 // STATICS
 // -------------------------------------------------------------------------
 
-static pPrimaryTbl_t PrimaryTable[MAX_NODES];
+static MemNode_t MemNodes[MAX_NODES];
 
 // -------------------------------------------------------------------------
 // InitialiseMem()
@@ -27,159 +34,397 @@ static pPrimaryTbl_t PrimaryTable[MAX_NODES];
 
 void InitialiseMem (int node)
 {
-    PrimaryTable[node] = NULL;
+    // Release any memory from a previous use of the node
+    FreeMem(node);
+
+    memset(&MemNodes[node], 0, sizeof(MemNode_t));
 }
 
 // -------------------------------------------------------------------------
-// InitialisePrimaryTable()
+// ReserveArena()
 //
-// Invalidates all entries in the memory primary table
+// Reserve an arena of MEM_ARENA_SIZE bytes from the host, which is only
+// committed as pages are touched. When using huge pages, the arena is
+// aligned to the huge page size, and the host advised to back it with
+// them. Returns NULL if the arena could not be reserved.
 //
 // -------------------------------------------------------------------------
 
-static void InitialisePrimaryTable (const pPrimaryTbl_t table)
+static char* ReserveArena (const bool huge_pages)
 {
-    int i;
+    char* base;
 
-    for (i = 0; i < TABLESIZE; i++)
+#if defined (_WIN32) || defined (_WIN64)
+    base = (char*)VirtualAlloc(NULL, MEM_ARENA_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+    size_t map_size = huge_pages ? 2*MEM_ARENA_SIZE : MEM_ARENA_SIZE;
+    size_t head;
+
+    if ((base = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0)) == MAP_FAILED)
     {
-        table[i].valid = false;
+        return NULL;
+    }
+
+    if (huge_pages)
+    {
+        // Trim the mapping to an aligned arena
+        head = (MEM_ARENA_SIZE - ((uintptr_t)base & (MEM_ARENA_SIZE-1))) & (MEM_ARENA_SIZE-1);
+
+        if (head)
+        {
+            munmap(base, head);
+        }
+        munmap(base + head + MEM_ARENA_SIZE, MEM_ARENA_SIZE - head);
+
+        base += head;
+# ifdef MADV_HUGEPAGE
+        madvise(base, MEM_ARENA_SIZE, MADV_HUGEPAGE);
+# endif
     }
+#endif
+
+    return base;
 }
 
 // -------------------------------------------------------------------------
-// InitialiseTable()
+// ReleaseArena()
 //
-// Initialise a secondary table
+// Return an arena's memory to the host, or just its pages allocated
+// so far (which will read as zero when next touched) if keep is true
 //
 // -------------------------------------------------------------------------
 
-static void InitialiseTable (char **table)
+static void ReleaseArena (const pMemArena_t p_arena, const bool keep)
 {
-    int i;
-
-    for (i = 0; i < TABLESIZE; i++)
+#if defined (_WIN32) || defined (_WIN64)
+    if (keep)
+    {
+        memset(p_arena->base, 0, p_arena->used);
+    }
+    else
     {
-        table[i] = NULL;
+        VirtualFree(p_arena->base, 0, MEM_RELEASE);
     }
+#else
+    if (keep)
+    {
+        madvise(p_arena->base, p_arena->used, MADV_DONTNEED);
+    }
+    else
+    {
+        munmap(p_arena->base, MEM_ARENA_SIZE);
+    }
+#endif
 }
 
 // -------------------------------------------------------------------------
-// bitrev()
+// AllocMem()
 //
-// An efficient bit reverse, up to 32 bits.
+// Allocate zeroed memory for a page or table from the node's arenas,
+// reserving a new arena if those already reserved are full. Returns
+// NULL if a new arena could not be reserved.
 //
 // -------------------------------------------------------------------------
 
-static uint32_t bitrev(const uint32_t Data, const int bits)
+static void* AllocMem (const pMemNode_t p_node, const uint32_t size)
 {
-    unsigned long result = Data;
-    int i;
+    pMemArena_t p_arena = p_node->p_curr_arena;
+    pMemArena_t p_last  = NULL;
+    char*       p;
+
+    // Arenas after the current one are either empty after a reset, or not yet reserved
+    while (p_arena != NULL && p_arena->used + size > MEM_ARENA_SIZE)
+    {
+        p_last  = p_arena;
+        p_arena = p_arena->next;
+    }
 
-    // Compare each of the bottom bits with reflected top bits
-    for (i = 0; i < bits/2; i++)
+    if (p_arena == NULL)
     {
-        // If top and bottom bits different, invert both bits
-        if (((result >> (bits-1-i*2)) ^ result) & (1 << i))
+        if ((p_arena = malloc(sizeof(MemArena_t))) == NULL)
         {
-            result ^= (1 << i) | (1 << (bits-1-i));
+            return NULL;
         }
+
+        if ((p_arena->base = ReserveArena(p_node->huge_pages)) == NULL)
+        {
+            free(p_arena);
+            return NULL;
+        }
+
+        p_arena->used = 0;
+        p_arena->next = NULL;
+
+        if (p_last != NULL)
+        {
+            p_last->next = p_arena;
+        }
+        else
+        {
+            p_node->arenas = p_arena;
+        }
+
+        p_node->stats.bytes_reserved += MEM_ARENA_SIZE;
     }
 
-    return result & ((1 << bits) - 1);
+    p_node->p_curr_arena = p_arena;
+
+    p              = p_arena->base + p_arena->used;
+    p_arena->used += size;
+
+    p_node->stats.bytes_resident += size;
+
+    return p;
 }
 
 // -------------------------------------------------------------------------
-// GenHash12()
+// FreeMem()
 //
-// A cheap and cheerful hash
+// Release all of a node's memory back to the host, leaving it empty
 //
 // -------------------------------------------------------------------------
 
-static uint32_t GenHash12(const uint64_t addr)
+void FreeMem (const uint32_t node)
 {
-    uint64_t munge = 0;
+    pMemNode_t  p_node = &MemNodes[node];
+    pMemArena_t p_arena, p_next;
 
-    munge ^= (addr >> 52) & 0xfffULL;
-    munge ^= (addr >> 40) & 0xfffULL;
-    munge ^= (addr >> 32) & 0xffULL;
-    munge ^= (addr >> 24) & 0xffULL;
+    for (p_arena = p_node->arenas; p_arena != NULL; p_arena = p_next)
+    {
+        p_next = p_arena->next;
+        ReleaseArena(p_arena, false);
+        free(p_arena);
+    }
+
+    p_node->arenas       = NULL;
+    p_node->p_curr_arena = NULL;
 
-    return bitrev((uint32_t) (munge & 0xfffULL), 12);
+    ResetMem(node);
+
+    p_node->stats.bytes_reserved = 0;
 }
 
 // -------------------------------------------------------------------------
-// WriteRamByteBlock()
+// ResetMem()
 //
-// Write a block of data to memory
+// Empty a node's memory, so that all of it reads as zero, keeping its
+// arenas reserved for reuse (though their pages are returned to the host)
 //
 // -------------------------------------------------------------------------
 
-void WriteRamByteBlock(const uint64_t addr, const PktData_t *data, const int fbe, int const lbe, const int length, const uint32_t node)
+void ResetMem (const uint32_t node)
 {
-    uint32_t pidx, sidx, offset;
-    int idx;
-
-    idx = pidx = GenHash12(addr);
-    sidx = (addr >> 12) & TABLEMASK;
-    offset = addr & TABLEMASK;
+    pMemNode_t  p_node = &MemNodes[node];
+    pMemArena_t p_arena;
 
-    if ((addr & ~TABLEMASK) != ((addr + length - 1) & ~TABLEMASK))
+    for (p_arena = p_node->arenas; p_arena != NULL; p_arena = p_arena->next)
     {
-        printf("WriteRamByteBlock: ***Error --- block write crosses 4K boundary (addr=0x%llx len=0x%x\n", (long long unsigned)addr, length);
+        ReleaseArena(p_arena, true);
+        p_arena->used = 0;
     }
 
-    // No primary table, so allocate some space for one and initialise
-    if (PrimaryTable[node] == NULL)
+    // All the tables were in the arenas, so start again with none
+    memset(p_node->space, 0, sizeof(p_node->space));
+
+    p_node->num_spaces           = 0;
+    p_node->last_page            = NULL;
+    p_node->p_curr_arena         = p_node->arenas;
+    p_node->stats.pages_touched  = 0;
+    p_node->stats.bytes_resident = 0;
+}
+
+// -------------------------------------------------------------------------
+// SetMemHugePages()
+//
+// Select whether arenas reserved from now on for the node are backed by
+// host huge pages (where supported)
+//
+// -------------------------------------------------------------------------
+
+void SetMemHugePages (const int enable, const uint32_t node)
+{
+    MemNodes[node].huge_pages = enable ? true : false;
+}
+
+// -------------------------------------------------------------------------
+// GetMemStats()
+//
+// Return the node's memory usage
+//
+// -------------------------------------------------------------------------
+
+void GetMemStats (pMemStats_t stats, const uint32_t node)
+{
+    *stats = MemNodes[node].stats;
+}
+
+// -------------------------------------------------------------------------
+// FindSpace()
+//
+// Return the first level table for the 4GB space holding the given
+// address, allocating it if not yet accessed and alloc is true.
+// Space 0 (address bits 63:32 zero) is always held in the first entry.
+//
+// -------------------------------------------------------------------------
+
+static pMemL1Tbl_t FindSpace (const pMemNode_t p_node, const uint64_t addr, const bool alloc)
+{
+    uint64_t upper = addr >> MEM_SPACE_BITS;
+    int idx = 0;
+
+    if (upper != 0)
     {
-        if ((PrimaryTable[node] = malloc(TABLESIZE * sizeof(PrimaryTbl_t))) == NULL)
+        for (idx = 1; idx <= p_node->num_spaces && p_node->space_upper[idx] != upper; idx++);
+
+        if (idx == MEM_MAX_SPACES)
         {
-            printf("WriteRamByteBlock: ***Error --- failed to allocate primary table memory\n");
+            if (alloc)
+            {
+                printf("GetRamPage: ***Error --- ran out of address spaces\n");
+            }
+            return NULL;
         }
-        InitialisePrimaryTable(PrimaryTable[node]);
     }
 
-    // Whilst we have a collision, increment primary offset until an invalid entry, or we matched address
-    while (PrimaryTable[node][pidx].valid && PrimaryTable[node][pidx].addr != (addr & 0xffffffffff000000ULL))
+    // No table for the space, so allocate some space for one (initialised to no pages)
+    if (p_node->space[idx] == NULL && alloc)
     {
-        pidx = (pidx+1) % TABLESIZE;
+        if ((p_node->space[idx] = AllocMem(p_node, sizeof(MemL1Tbl_t))) == NULL)
+        {
+            printf("GetRamPage: ***Error --- failed to allocate primary table memory\n");
+            return NULL;
+        }
+
+        p_node->space_upper[idx] = upper;
 
-        // If we have searched through the whole table....
-        if (pidx == idx)
+        if (idx)
         {
-            printf("WriteRamByteBlock: ***Error --- ran out of primary table space\n");
+            p_node->num_spaces++;
         }
     }
 
-    // If first time we have written to this block, validate it
-    if (!PrimaryTable[node][pidx].valid)
+    return p_node->space[idx];
+}
+
+// -------------------------------------------------------------------------
+// FindRamPage()
+//
+// Return a pointer to the (TABLESIZE byte) page holding the given
+// address, allocating it (zeroed) if not yet accessed and alloc is
+// true. Returns NULL if not allocated. The last page found for the node
+// is remembered, so that runs of accesses to a page skip the table walk.
+//
+// -------------------------------------------------------------------------
+
+static char* FindRamPage (const uint64_t addr, const uint32_t node, const bool alloc)
+{
+    pMemNode_t  p_node = &MemNodes[node];
+    pMemL1Tbl_t p_l1;
+    pMemL2Tbl_t p_l2;
+    uint32_t    l1idx, l2idx;
+
+    if (p_node->last_page != NULL && p_node->last_addr == (addr & ~(uint64_t)TABLEMASK))
+    {
+        return p_node->last_page;
+    }
+
+    if ((p_l1 = FindSpace(p_node, addr, alloc)) == NULL)
     {
-        PrimaryTable[node][pidx].valid = true;
-        PrimaryTable[node][pidx].addr = (addr & 0xffffffffff000000ULL);
-        PrimaryTable[node][pidx].p = NULL;
+        return NULL;
     }
 
-    // No secondary table, so allocate some space for one and initialise
-    if (PrimaryTable[node][pidx].p == NULL)
+    l1idx = (uint32_t)(addr >> (MEM_PAGE_BITS + MEM_L2_BITS)) & MEM_L1_MASK;
+    l2idx = (uint32_t)(addr >> MEM_PAGE_BITS) & MEM_L2_MASK;
+
+    // No secondary table, so allocate some space for one (initialised to no pages)
+    if ((p_l2 = p_l1->l2[l1idx]) == NULL)
     {
-        if ((PrimaryTable[node][pidx].p = malloc(TABLESIZE * sizeof(uint32_t *))) == NULL)
+        if (!alloc)
+        {
+            return NULL;
+        }
+
+        if ((p_l2 = p_l1->l2[l1idx] = AllocMem(p_node, sizeof(MemL2Tbl_t))) == NULL)
         {
-            printf("WriteRamByteBlock: ***Error --- failed to allocate secondary table memory\n");
-            //VWrite(PVH_FATAL, 0, 0, node);
+            printf("GetRamPage: ***Error --- failed to allocate secondary table memory\n");
+            return NULL;
         }
-        InitialiseTable(PrimaryTable[node][pidx].p);
     }
 
     // No memory block allocated, so allocate some space
-    if (PrimaryTable[node][pidx].p != NULL)
+    if (p_l2->page[l2idx] == NULL)
     {
-        if ((PrimaryTable[node][pidx].p)[sidx] == NULL)
+        if (!alloc)
         {
-            if (((PrimaryTable[node][pidx].p)[sidx] = malloc(TABLESIZE)) == NULL)
-            {
-                printf("WriteRamByteBlock: ***Error --- failed to allocate memory\n");
-            }
+            return NULL;
+        }
+
+        if ((p_l2->page[l2idx] = AllocMem(p_node, TABLESIZE)) == NULL)
+        {
+            printf("GetRamPage: ***Error --- failed to allocate memory\n");
+            return NULL;
         }
+
+        p_node->stats.pages_touched++;
+    }
+
+    p_node->last_addr = addr & ~(uint64_t)TABLEMASK;
+    p_node->last_page = p_l2->page[l2idx];
+
+    return p_node->last_page;
+}
+
+// -------------------------------------------------------------------------
+// GetRamPage()
+//
+// Return a pointer to the (TABLESIZE byte) block of memory holding
+// the given address, allocating it (zeroed) if not yet accessed.
+// Returns NULL if memory could not be allocated.
+//
+// -------------------------------------------------------------------------
+
+char* GetRamPage(const uint64_t addr, const uint32_t node)
+{
+    return FindRamPage(addr, node, true);
+}
+
+// -------------------------------------------------------------------------
+// PeekRamPage()
+//
+// Return a pointer to the (TABLESIZE byte) block of memory holding
+// the given address, if it has been accessed, without allocating it.
+// Returns NULL if the block does not yet exist (and so reads as zero).
+//
+// -------------------------------------------------------------------------
+
+char* PeekRamPage(const uint64_t addr, const uint32_t node)
+{
+    return FindRamPage(addr, node, false);
+}
+
+// -------------------------------------------------------------------------
+// WriteRamByteBlock()
+//
+// Write a block of data to memory
+//
+// -------------------------------------------------------------------------
+
+void WriteRamByteBlock(const uint64_t addr, const PktData_t *data, const int fbe, int const lbe, const int length, const uint32_t node)
+{
+    uint32_t offset;
+    char* page;
+    int idx;
+
+    offset = addr & TABLEMASK;
+
+    if ((addr & ~TABLEMASK) != ((addr + length - 1) & ~TABLEMASK))
+    {
+        printf("WriteRamByteBlock: ***Error --- block write crosses 4K boundary (addr=0x%llx len=0x%x\n", (long long unsigned)addr, length);
+    }
+
+    if ((page = GetRamPage(addr, node)) == NULL)
+    {
+        return;
     }
 
     for (idx = 0; idx < length; idx++)
@@ -188,13 +433,7 @@ void WriteRamByteBlock(const uint64_t addr, const PktData_t *data, const int fbe
              (idx >= (length-4) && ((1<<(4-(length-idx))) & lbe)) ||
              (idx >= 4 && idx < (length-4)))
         {
-            if (PrimaryTable[node][pidx].p != NULL)
-            {
-                if ((PrimaryTable[node][pidx].p)[sidx] != NULL)
-                {
-                    ((char*)((PrimaryTable[node][pidx].p)[sidx]))[(idx + offset) % TABLESIZE] = (char)data[idx];
-                }
-            }
+            page[(idx + offset) % TABLESIZE] = (char)data[idx];
         }
     }
 }
@@ -208,11 +447,10 @@ void WriteRamByteBlock(const uint64_t addr, const PktData_t *data, const int fbe
 
 int ReadRamByteBlock(const uint64_t addr, PktData_t *data, const int length, const uint32_t node)
 {
-    uint32_t pidx, sidx, offset;
+    uint32_t offset;
+    char* page;
     int idx;
 
-    idx = pidx = GenHash12(addr);
-    sidx = (addr >> 12) & TABLEMASK;
     offset = addr & TABLEMASK;
 
     if ((addr & ~TABLEMASK) != ((addr + length-1) & ~TABLEMASK))
@@ -220,44 +458,97 @@ int ReadRamByteBlock(const uint64_t addr, PktData_t *data, const int length, con
         printf("ReadRamByteBlock: ***Error --- block read crosses 4K boundary\n");
     }
 
-    if (PrimaryTable[node] == NULL)
+    // No memory block allocated, so flag an error
+    if ((page = FindRamPage(addr, node, false)) == NULL)
     {
-        Debugprintf("ReadRamByteBlock: ***Error --- reading from uninitialised primary table\n");
+        Debugprintf("ReadRamByteBlock: ***Error --- reading from uninitialised memory block\n");
         return MEM_BAD_STATUS;
     }
 
-    // Whilst we have detected a collision, increment primary offset until an invalid entry or we matched address
-    while (PrimaryTable[node][pidx].valid && PrimaryTable[node][pidx].addr != (addr & 0xffffffffff000000ULL))
+    for (idx = 0; idx < length; idx++)
+    {
+        data[idx] = page[(idx + offset) % TABLESIZE] & 0xff;
+    }
+
+    return MEM_GOOD_STATUS;
+}
+
+// -------------------------------------------------------------------------
+// WriteRamBlock()
+//
+// Write a buffer of bytes to memory, of any length, and crossing
+// page boundaries
+//
+// -------------------------------------------------------------------------
+
+void WriteRamBlock(const uint64_t addr, const uint8_t* data, const uint64_t length, const uint32_t node)
+{
+    uint64_t offset, chunk, idx;
+    char* page;
+
+    for (idx = 0; idx < length; idx += chunk)
     {
-        pidx = (pidx+1) % TABLESIZE;
+        offset = (addr + idx) & TABLEMASK;
+        chunk  = (length - idx < TABLESIZE - offset) ? length - idx : TABLESIZE - offset;
 
-        // If we searched the whole table...
-        if (pidx == idx)
+        if ((page = GetRamPage(addr + idx, node)) == NULL)
         {
-            printf("ReadRamByteBlock: ***Error --- address does not exist in primary table\n");
+            return;
         }
-    }
 
-    // No secondary table, so flag an error
-    if (PrimaryTable[node][pidx].p == NULL)
-    {
-        Debugprintf("ReadRamByteBlock: ***Error --- reading from uninitialised secondary table\n");
-        return MEM_BAD_STATUS;
+        memcpy(&page[offset], &data[idx], (size_t)chunk);
     }
+}
 
-    // No memory block allocated, so flag an error
-    if ((PrimaryTable[node][pidx].p)[sidx] == NULL)
-    {
-        Debugprintf("ReadRamByteBlock: ***Error --- reading from uninitialised memory block\n");
-        return MEM_BAD_STATUS;
-    }
+// -------------------------------------------------------------------------
+// ReadRamBlock()
+//
+// Read a buffer of bytes from memory, of any length, and crossing
+// page boundaries. Memory not yet written reads as zero.
+//
+// -------------------------------------------------------------------------
 
-    for (idx = 0; idx < length; idx++)
+void ReadRamBlock(const uint64_t addr, uint8_t* data, const uint64_t length, const uint32_t node)
+{
+    uint64_t offset, chunk, idx;
+    char* page;
+
+    for (idx = 0; idx < length; idx += chunk)
     {
-        data[idx] = ((char *)(PrimaryTable[node][pidx].p)[sidx])[idx+offset] & 0xff;
+        offset = (addr + idx) & TABLEMASK;
+        chunk  = (length - idx < TABLESIZE - offset) ? length - idx : TABLESIZE - offset;
+
+        if ((page = FindRamPage(addr + idx, node, false)) == NULL)
+        {
+            memset(&data[idx], 0, (size_t)chunk);
+        }
+        else
+        {
+            memcpy(&data[idx], &page[offset], (size_t)chunk);
+        }
     }
+}
 
-    return MEM_GOOD_STATUS;
+// -------------------------------------------------------------------------
+// SwapHWord(), SwapWord() and SwapDWord()
+//
+// Byte reverse data between host (little endian) and big endian order
+//
+// -------------------------------------------------------------------------
+
+static uint16_t SwapHWord (const uint16_t data)
+{
+    return (uint16_t)((data << 8) | (data >> 8));
+}
+
+static uint32_t SwapWord (const uint32_t data)
+{
+    return (data << 24) | ((data << 8) & 0x00ff0000UL) | ((data >> 8) & 0x0000ff00UL) | (data >> 24);
+}
+
+static uint64_t SwapDWord (const uint64_t data)
+{
+    return ((uint64_t)SwapWord((uint32_t)data) << 32) | SwapWord((uint32_t)(data >> 32));
 }
 
 // -------------------------------------------------------------------------
@@ -267,18 +558,14 @@ int ReadRamByteBlock(const uint64_t addr, PktData_t *data, const int length, con
 //
 // -------------------------------------------------------------------------
 
-void WriteRamByte(const uint64_t inaddr, const uint32_t data, const uint32_t node)
+void WriteRamByte(const uint64_t addr, const uint32_t data, const uint32_t node)
 {
-    uint64_t addr;
-    int addr_lo, fbe;
-    PktData_t buf[4];
+    char* page;
 
-    addr = inaddr & ~3ULL;
-    addr_lo = (int)(inaddr & 3ULL);
-    fbe  = 0x1 << addr_lo;
-    buf[addr_lo] = data & 0xff;
-
-    WriteRamByteBlock (addr, buf, fbe, 0, 4, node);
+    if ((page = GetRamPage(addr, node)) != NULL)
+    {
+        page[addr & TABLEMASK] = (char)data;
+    }
 }
 
 // -------------------------------------------------------------------------
@@ -290,21 +577,13 @@ void WriteRamByte(const uint64_t inaddr, const uint32_t data, const uint32_t nod
 
 void WriteRamHWord (const uint64_t addr, const uint32_t data, const int le, const uint32_t node)
 {
-    uint32_t data_out;
-    int addr_lo, fbe;
-    PktData_t buf[4];
-    int i;
+    uint16_t hword = le ? (uint16_t)data : SwapHWord((uint16_t)data);
+    char* page;
 
-    addr_lo  =  (int)(addr & 2ULL);
-    fbe      = 0x3 << addr_lo;
-    data_out = (addr_lo) ? (data << 16) : data;
-
-    for (i = 0; i < 4; i++)
+    if ((page = GetRamPage(addr, node)) != NULL)
     {
-        buf[i] = (le ? (data_out >> (i*8))  & 0xffffUL: (data_out >> ((3-i)*8))) & 0xff;
+        memcpy(&page[addr & TABLEMASK & ~1UL], &hword, sizeof(hword));
     }
-
-    WriteRamByteBlock (addr & ~3ULL, buf, fbe, 0x0, 4, node);
 }
 
 // -------------------------------------------------------------------------
@@ -316,15 +595,13 @@ void WriteRamHWord (const uint64_t addr, const uint32_t data, const int le, cons
 
 void WriteRamWord (const uint64_t addr, const uint32_t data, const int le, const uint32_t node)
 {
-    PktData_t buf[4];
-    int i;
+    uint32_t word = le ? data : SwapWord(data);
+    char* page;
 
-    for (i = 0; i < 4; i++)
+    if ((page = GetRamPage(addr, node)) != NULL)
     {
-        buf[i] = (le ? (data >> (i*8)) : (data >> ((3-i)*8))) & 0xff;
+        memcpy(&page[addr & TABLEMASK & ~3UL], &word, sizeof(word));
     }
-
-    WriteRamByteBlock (addr & ~3ULL, buf, 0xf, 0x0, 4, node);
 }
 
 // -------------------------------------------------------------------------
@@ -336,15 +613,13 @@ void WriteRamWord (const uint64_t addr, const uint32_t data, const int le, const
 
 void WriteRamDWord (const uint64_t addr, const uint64_t data, const int le, const uint32_t node)
 {
-    PktData_t buf[8];
-    int i;
+    uint64_t dword = le ? data : SwapDWord(data);
+    char* page;
 
-    for (i = 0; i < 8; i++)
+    if ((page = GetRamPage(addr, node)) != NULL)
     {
-        buf[i] = (PktData_t) (le ? (data >> (i*8)) : (data >> ((7-i)*8))) & 0xffULL;
+        memcpy(&page[addr & TABLEMASK & ~7UL], &dword, sizeof(dword));
     }
-
-    WriteRamByteBlock (addr & ~7ULL, buf, 0xf, 0xf, 8, node);
 }
 
 // -------------------------------------------------------------------------
@@ -356,18 +631,15 @@ void WriteRamDWord (const uint64_t addr, const uint64_t data, const int le, cons
 
 uint32_t ReadRamByte (const uint64_t addr, const uint32_t node)
 {
-    PktData_t buf[4];
-    int i;
+    char* page;
 
-    // If ReadRamByteBlock fails, return 0
-    if (ReadRamByteBlock (addr & ~3ULL, buf, 4, node))
+    // If memory not yet written, return 0
+    if ((page = FindRamPage(addr, node, false)) == NULL)
     {
         return 0;
     }
 
-    i = (int)(addr & 3ULL);
-
-    return buf[i];
+    return page[addr & TABLEMASK] & 0xff;
 }
 
 // -------------------------------------------------------------------------
@@ -379,23 +651,18 @@ uint32_t ReadRamByte (const uint64_t addr, const uint32_t node)
 
 uint32_t ReadRamHWord (const uint64_t addr, const int le, const uint32_t node)
 {
-    PktData_t buf[4];
-    uint32_t data = 0;
-    int addr_lo = addr & 0x2;
-    int i;
+    uint16_t hword;
+    char* page;
 
-    // If ReadRamByteBlock fails, return 0
-    if (ReadRamByteBlock (addr & ~3ULL, buf, 4, node))
+    // If memory not yet written, return 0
+    if ((page = FindRamPage(addr, node, false)) == NULL)
     {
         return 0;
     }
 
-    for (i = addr_lo; i < (2+addr_lo); i++)
-    {
-        data |= (buf[i] & 0xff) << (le ? (i*8) : ((3-i)*8));
-    }
+    memcpy(&hword, &page[addr & TABLEMASK & ~1UL], sizeof(hword));
 
-    return (addr_lo) ? (data >> 16) : data;
+    return le ? hword : SwapHWord(hword);
 }
 
 // -------------------------------------------------------------------------
@@ -407,22 +674,18 @@ uint32_t ReadRamHWord (const uint64_t addr, const int le, const uint32_t node)
 
 uint32_t ReadRamWord (const uint64_t addr, const int le, const uint32_t node)
 {
-    PktData_t buf[4];
-    uint32_t data = 0;
-    int i;
+    uint32_t word;
+    char* page;
 
-    // If ReadRamByteBlock fails, return 0
-    if (ReadRamByteBlock (addr & ~3ULL, buf, 4, node))
+    // If memory not yet written, return 0
+    if ((page = FindRamPage(addr, node, false)) == NULL)
     {
         return 0;
     }
 
-    for (i = 0; i < 4; i++)
-    {
-        data |= (buf[i] & 0xff) << (le ? (i*8) : ((3-i)*8));
-    }
+    memcpy(&word, &page[addr & TABLEMASK & ~3UL], sizeof(word));
 
-    return data;
+    return le ? word : SwapWord(word);
 }
 
 // -------------------------------------------------------------------------
@@ -433,23 +696,17 @@ uint32_t ReadRamWord (const uint64_t addr, const int le, const uint32_t node)
 // -------------------------------------------------------------------------
 
 uint64_t ReadRamDWord (const uint64_t addr, const int le, const uint32_t node)
-
 {
-    PktData_t buf[8];
-    uint64_t data = 0;
-    int i;
+    uint64_t dword;
+    char* page;
 
-    // If ReadRamByteBlock fails, return 0
-    if (ReadRamByteBlock (addr & ~7ULL, buf, 8, node))
+    // If memory not yet written, return 0
+    if ((page = FindRamPage(addr, node, false)) == NULL)
     {
         return 0ULL;
     }
 
-    for (i = 0; i < 8; i++)
-    {
-        data |= ((uint64_t)(buf[i] & 0xff)) << (le ? (i*8) : ((7-i)*8));
-    }
+    memcpy(&dword, &page[addr & TABLEMASK & ~7UL], sizeof(dword));
 
-    return data;
+    return le ? dword : SwapDWord(dword);
 }
-
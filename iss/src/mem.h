@@ -15,6 +15,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -25,6 +26,24 @@
 #define TABLESIZE      (4096UL)
 #define TABLEMASK      (TABLESIZE-1)
 
+// Radix table definitions. Each 4GB space is a two level table, indexed on
+// address bits 31:22 and then 21:12, to a page of TABLESIZE bytes. Spaces
+// for non-zero address bits 63:32 (the optional third level) are searched
+// for in a small table, with space 0 always first.
+#define MEM_PAGE_BITS   12
+#define MEM_L2_BITS     10
+#define MEM_L1_BITS     10
+#define MEM_L2_SIZE     (1UL << MEM_L2_BITS)
+#define MEM_L2_MASK     (MEM_L2_SIZE-1)
+#define MEM_L1_SIZE     (1UL << MEM_L1_BITS)
+#define MEM_L1_MASK     (MEM_L1_SIZE-1)
+#define MEM_SPACE_BITS  (MEM_PAGE_BITS + MEM_L2_BITS + MEM_L1_BITS)
+#define MEM_MAX_SPACES  16
+
+// Pages and tables are allocated from arenas (a multiple of the 2MB
+// host huge page size), which are only returned to the host by FreeMem()
+#define MEM_ARENA_SIZE  (2UL*1024*1024)
+
 #define MEM_BAD_STATUS  1
 #define MEM_GOOD_STATUS 0
 
@@ -42,11 +61,43 @@
 // TYPEDEFS
 // -------------------------------------------------------------------------
 
+// Second level table of pointers to pages
+typedef struct {
+    char*    page[MEM_L2_SIZE];
+} MemL2Tbl_t, *pMemL2Tbl_t;
+
+// First level table for a 4GB space
+typedef struct {
+    pMemL2Tbl_t l2[MEM_L1_SIZE];
+} MemL1Tbl_t, *pMemL1Tbl_t;
+
+// Arena of host memory, allocated from in whole pages
+typedef struct MemArena_s {
+    char*              base;
+    uint32_t           used;
+    struct MemArena_s* next;
+} MemArena_t, *pMemArena_t;
+
+// Per node memory usage
+typedef struct {
+    uint64_t    pages_touched;              // Pages allocated (zeroed) since last reset
+    uint64_t    bytes_resident;             // Bytes of arenas allocated to pages and tables
+    uint64_t    bytes_reserved;             // Bytes of arenas reserved from the host
+} MemStats_t, *pMemStats_t;
+
+// Per node memory, with each space's address bits 63:32, the last page
+// accessed (and its address), and its arenas (and the one allocated from)
 typedef struct {
-    char** p;
-    uint64_t addr;
-    bool   valid;
-} PrimaryTbl_t, *pPrimaryTbl_t;
+    pMemL1Tbl_t space[MEM_MAX_SPACES];
+    uint64_t    space_upper[MEM_MAX_SPACES];
+    int         num_spaces;
+    uint64_t    last_addr;
+    char*       last_page;
+    pMemArena_t arenas;
+    pMemArena_t p_curr_arena;
+    bool        huge_pages;
+    MemStats_t  stats;
+} MemNode_t, *pMemNode_t;
 
 typedef uint16_t  PktData_t;
 typedef uint16_t* pPktData_t;
@@ -56,9 +107,17 @@ typedef uint16_t* pPktData_t;
 // -------------------------------------------------------------------------
 
 extern void     InitialiseMem       (int node);
+extern char*    GetRamPage          (const uint64_t addr, const uint32_t node);
+extern char*    PeekRamPage         (const uint64_t addr, const uint32_t node);
+extern void     FreeMem             (const uint32_t node);
+extern void     ResetMem            (const uint32_t node);
+extern void     SetMemHugePages     (const int enable, const uint32_t node);
+extern void     GetMemStats         (pMemStats_t stats, const uint32_t node);
 
 extern void     WriteRamByteBlock   (const uint64_t addr, const PktData_t* const data, const int fbe, const int lbe, const int length, const uint32_t node);
 extern int      ReadRamByteBlock    (const uint64_t addr, PktData_t* const data, const int length, const uint32_t node);
+extern void     WriteRamBlock       (const uint64_t addr, const uint8_t* data, const uint64_t length, const uint32_t node);
+extern void     ReadRamBlock        (const uint64_t addr, uint8_t* data, const uint64_t length, const uint32_t node);
 extern void     WriteRamByte        (const uint64_t addr, const uint32_t data, const uint32_t node);
 extern void     WriteRamHWord       (const uint64_t addr, const uint32_t data, const int little_endian, const uint32_t node);
 extern void     WriteRamWord        (const uint64_t addr, const uint32_t data, const int little_endian, const uint32_t node);
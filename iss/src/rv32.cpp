@@ -0,0 +1,44 @@
+//=============================================================
+//
+// Copyright (c) 2021 Simon Southwell. All rights reserved.
+//
+// Date: 16th October 2026
+//
+// Contains the run time selection of the supported
+// configurations of the top level class
+//
+// This file is part of the RISC-V instruction set simulator
+// (rv32).
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#include <cstring>
+
+#include "rv32.h"
+
+// -----------------------------------------------------------
+// Create a model of the named configuration
+// -----------------------------------------------------------
+
+rv32csr_cpu* rv32_create(const char* isa, FILE* dbg_fp)
+{
+    if      (!strcmp(isa, "rv32i"))   return new rv32i_core(dbg_fp);
+    else if (!strcmp(isa, "rv32im"))  return new rv32im_core(dbg_fp);
+    else if (!strcmp(isa, "rv32ima")) return new rv32ima_core(dbg_fp);
+    else if (!strcmp(isa, "rv32g"))   return new rv32g_core(dbg_fp);
+
+    return NULL;
+}
@@ -4,7 +4,8 @@
 //
 // Date: 12th July 2021
 //
-// Contains the class definition for the top level derived class
+// Contains the class definition for the top level derived class,
+// and the supported configurations
 //
 // This file is part of the Zicsr extended RISC-V instruction
 // set simulator (rv32).
@@ -28,21 +29,72 @@
 #define _RV32_H_
 
 #include "rv32_extensions.h"
-#include RV32_TARGET_INCLUDE
 
-// This class is the top level ISS implementation class, configurable
-// to have only those extensions required to be modelled. The
-// rv32_inheritance.h file defines which extensions are to be included.
-class rv32 : public RV32_TARGET_INHERITANCE_CLASS
+// This class template is the top level ISS implementation class,
+// configurable to have only those extensions required to be modelled.
+// The rv32_extensions.h file defines the extension compositions for
+// the supported configurations. It is final, and the base classes'
+// execution loop and Zicsr instructions are run for it (as their CORE
+// class), so that the interrupt and CSR access hooks they call are
+// bound statically, rather than through the virtual methods. The
+// trap, decode exception and CSR write mask hooks are still virtual
+// calls, as they are made from code shared by all configurations (on
+// traps, decoding a new instruction and accessing a CSR).
+template <class EXT>
+class rv32_core final : public EXT
 {
 public:
-    LIBRISCV32_API rv32(FILE* dbg_fp = stdout) : RV32_TARGET_INHERITANCE_CLASS(dbg_fp)
+    rv32_core(FILE* dbg_fp = stdout) : EXT(dbg_fp)
     {
     };
 
     /*****************************************************/
     /* Add customisations and additional extensions here */
     /*****************************************************/
+
+protected:
+    // Run the execution loop for this class
+    int run_engine(rv32i_cfg_s &cfg, unsigned &instr_count, const bool trace) override
+    {
+        return trace ? this->template run_loop<rv32_core, true> (cfg, instr_count)
+                     : this->template run_loop<rv32_core, false>(cfg, instr_count);
+    }
+
+    // Point the Zicsr instructions at those for this class, once all are in the decode tables
+    void init_decode_tables() override
+    {
+        EXT::init_decode_tables();
+        this->template init_csr_decode<rv32_core>();
+    }
+
+private:
+    friend class rv32i_cpu;
+    friend class rv32csr_cpu;
+
+    // Hooks called for this class by the base classes, as qualified
+    // (so statically bound) calls of this class's final overriders
+    int core_process_interrupts()
+    {
+        return rv32_core::process_interrupts();
+    }
+
+    uint32_t core_access_csr(const unsigned funct3, const uint32_t addr, const uint32_t rd, const uint32_t value)
+    {
+        return rv32_core::access_csr(funct3, addr, rd, value);
+    }
 };
 
+// Supported configurations
+typedef rv32_core<rv32i_ext_t>                     rv32i_core;
+typedef rv32_core<rv32im_ext_t>                    rv32im_core;
+typedef rv32_core<rv32ima_ext_t>                   rv32ima_core;
+typedef rv32_core<rv32g_ext_t>                     rv32g_core;
+
+// Default target model
+typedef rv32_core<RV32_TARGET_INHERITANCE_CLASS>   rv32;
+
+// Create a model of the named configuration ("rv32i", "rv32im", "rv32ima"
+// or "rv32g"), selected at run time. Returns NULL if not supported.
+extern LIBRISCV32_API rv32csr_cpu* rv32_create(const char* isa, FILE* dbg_fp = stdout);
+
 #endif
@@ -84,8 +84,6 @@ static char hexchars[]     = HEX_CHAR_MAP;
 static char ip_buf[IP_BUFFER_SIZE];
 static char op_buf[OP_BUFFER_SIZE];
 
-static rv32i_cpu::rv32i_hart_state cpu_state;
-
 // -------------------------------------------------------------------------
 // rv32gdb_skt_init()
 //
@@ -190,27 +188,35 @@ static inline bool rv32gdb_write (void* fd, char* buf)
 //
 // -------------------------------------------------------------------------
 
-static int rv32gdb_gen_register_reply(rv32* cpu, const char* cmd, char *buf, unsigned char &checksum, const int sigval = SIGHUP)
+static int rv32gdb_gen_register_reply(rv32i_cpu* cpu, const char* cmd, char *buf, unsigned char &checksum, const int sigval = SIGHUP)
 {
-    int      bdx    = 0;
-    int      cdx    = 1;
-    int      regnum;
-    unsigned val;
+    int                bdx    = 0;
+    int                cdx    = 1;
+    int                regnum = 0;
+    unsigned           val;
+    rv32i_dirty_regs_t dirty;
 
     bool single_reg = cmd[0] == 'p';
     bool stop_reply = cmd[0] == '?' || cmd[0] == 'c' || cmd[0] == 's';
 
-    // Retrieve the current CPU state
-    cpu_state = cpu->rv32_get_cpu_state();
+    // View the current CPU state in place
+    const rv32i_cpu::rv32i_hart_state &cpu_state = cpu->rv32_cpu_state_view();
 
-    // If retrieving a single register, get register number and skip the '=' character
-    if (single_reg)
+    // A stop reply only sends the registers changed since the last stop (and
+    // the PC), with any others fetched by gdb as it needs them
+    if (stop_reply)
     {
-        regnum  = CHAR2NIB(cmd[cdx]) << 4; cdx++;
-        regnum |= CHAR2NIB(cmd[cdx]);      cdx++;
+        cpu->dirty_regs(dirty);
+        cpu->snapshot_regs();
+    }
 
-        // Skip '=' character
-        cdx++;
+    // If retrieving a single register, get the (variable length hex) register number
+    if (single_reg)
+    {
+        while (cmd[cdx] != '\0')
+        {
+            regnum = (regnum << 4) | CHAR2NIB(cmd[cdx]); cdx++;
+        }
     }
 
     // If a 'Stop' reply (e.g. from '?' command), format is "T AA n1:r1;n2:r2;...",
@@ -225,6 +231,8 @@ static int rv32gdb_gen_register_reply(rv32* cpu, const char* cmd, char *buf, uns
     // Run through all the registers...
     for (int idx = 0; idx < NUM_REGS; idx++)
     {
+        val = 0;
+
         if (idx < RV32I_NUM_OF_REGISTERS)
         {
             val = cpu_state.x[idx];
@@ -239,6 +247,11 @@ static int rv32gdb_gen_register_reply(rv32* cpu, const char* cmd, char *buf, uns
 
         if (stop_reply)
         {
+            if (idx != RV32_REG_PC && (idx >= RV32I_NUM_OF_REGISTERS || !((dirty.x >> idx) & 1)))
+            {
+                continue;
+            }
+
             // Add the register number as a 2 character hex value
             BUFBYTE(buf, bdx, idx);
             buf[bdx++] = ':';
@@ -284,24 +297,35 @@ static int rv32gdb_gen_register_reply(rv32* cpu, const char* cmd, char *buf, uns
 //
 // -------------------------------------------------------------------------
 
-static int rv32gdb_set_regs (rv32* cpu, const char* cmd, const int cmdlen, char* buf, unsigned char &checksum)
+static int rv32gdb_set_regs (rv32i_cpu* cpu, const char* cmd, const int cmdlen, char* buf, unsigned char &checksum)
 {
     int bdx        = 0;
     int cdx        = 1;
     int start_reg  = 0;
     int end_reg    = NUM_REGS;
 
-    // Retrieve the current CPU state
-    cpu_state = cpu->rv32_get_cpu_state();
-
     // If accessing a single register, get the register number and set
     // the loop for just this register
     if (cmd[0] == 'P')
     {
-        start_reg  = CHAR2NIB(cmd[cdx]) << 4; cdx++;
-        start_reg |= CHAR2NIB(cmd[cdx]);      cdx++;
+        uint32_t regnum = 0;
+
+        // Get the (variable length hex) register number, saturating so that
+        // overlong numbers are still out of range
+        while (cdx < cmdlen && cmd[cdx] != '=')
+        {
+            regnum = (regnum >= NUM_REGS) ? NUM_REGS : (regnum << 4) | CHAR2NIB(cmd[cdx]); cdx++;
+        }
+
+        // Reject a register number that is not one of the registers
+        if (regnum >= NUM_REGS)
+        {
+            BUFERR(EINVAL, buf, bdx, checksum);
+            return bdx;
+        }
 
-        end_reg = start_reg;
+        start_reg = regnum;
+        end_reg   = start_reg + 1;
 
         // Skip '=' character
         cdx++;
@@ -309,35 +333,33 @@ static int rv32gdb_set_regs (rv32* cpu, const char* cmd, const int cmdlen, char*
 
     // Run through the registers in order until all done, or command
     // buffer run out of characters
-    for (int rdx = start_reg; rdx < end_reg && cdx < cmdlen; rdx++)
+    for (int rdx = start_reg; rdx < end_reg && cdx + 4*2 <= cmdlen; rdx++)
     {
-        int val = 0;
+        uint32_t val = 0;
 
-        // Convert the 8 character (for 32 bits) hex nibbles to a number
-        for (int cdx = 0; cdx < 4*2; cdx++)
+        // Convert the 8 character (for 32 bits) hex nibbles, in little
+        // endian byte order, to a number
+        for (int bdx = 0; bdx < 4; bdx++)
         {
-            val  <<= 4;
-            val |= CHAR2NIB(cmd[cdx]); cdx++;
+            val |= (uint32_t)((CHAR2NIB(cmd[cdx]) << 4) | CHAR2NIB(cmd[cdx+1])) << (8*bdx);
+            cdx += 2;
         }
 
-        // Update the general purpose registers in the retrieved state structure
+        // Update the general purpose registers in place
         if (rdx < RV32I_NUM_OF_REGISTERS)
         {
-            cpu_state.x[rdx] = val;
+            cpu->write_xreg(rdx, val);
         }
-        // Update the special registers n the retrieved state structure
+        // Update the special registers in place
         else
         {
             switch (rdx)
             {
-               case RV32_REG_PC  : cpu_state.pc   = val; break;;
+               case RV32_REG_PC  : cpu->write_pc(val); break;
             }
         }
     }
 
-    // Write back the updated CPU state
-    cpu->rv32_set_cpu_state(cpu_state);
-
     // Acknowledge the command
     BUFOK(buf, bdx, checksum);
 
@@ -359,7 +381,7 @@ static int rv32gdb_set_regs (rv32* cpu, const char* cmd, const int cmdlen, char*
 //
 // -------------------------------------------------------------------------
 
-static int rv32gdb_read_mem(rv32* cpu, const char* cmd, const int cmdlen, char *buf, unsigned char &checksum)
+static int rv32gdb_read_mem(rv32i_cpu* cpu, const char* cmd, const int cmdlen, char *buf, unsigned char &checksum)
 {
     int      bdx  = 0;
     int      cdx  = 0;
@@ -388,14 +410,19 @@ static int rv32gdb_read_mem(rv32* cpu, const char* cmd, const int cmdlen, char *
         cdx++;
     }
 
-    // Get memory bytes and put values as hex characters in buffer
-    for (unsigned idx = 0; idx < len; idx++)
+    // Get memory bytes, a block at a time, and put values as hex characters in buffer
+    for (unsigned blk = 0; blk < len; blk += GDB_MEM_BLOCK_SIZE)
     {
-        bool fault;
-        unsigned val = cpu->read_mem(addr++, MEM_RD_ACCESS_BYTE, fault);
+        uint8_t  mem[GDB_MEM_BLOCK_SIZE];
+        unsigned blk_len = (len - blk < GDB_MEM_BLOCK_SIZE) ? len - blk : GDB_MEM_BLOCK_SIZE;
+
+        cpu->read_block(addr + blk, mem, blk_len);
 
-        checksum += buf[bdx++] = HIHEXCHAR(val);
-        checksum += buf[bdx++] = LOHEXCHAR(val);
+        for (unsigned idx = 0; idx < blk_len; idx++)
+        {
+            checksum += buf[bdx++] = HIHEXCHAR(mem[idx]);
+            checksum += buf[bdx++] = LOHEXCHAR(mem[idx]);
+        }
     }
 
     return bdx;
@@ -421,7 +448,7 @@ static int rv32gdb_read_mem(rv32* cpu, const char* cmd, const int cmdlen, char *
 //
 // -------------------------------------------------------------------------
 
-static int rv32gdb_write_mem (void* fd, rv32* cpu, const char* cmd, const int cmdlen, char *buf, unsigned char &checksum,
+static int rv32gdb_write_mem (void* fd, rv32i_cpu* cpu, const char* cmd, const int cmdlen, char *buf, unsigned char &checksum,
                               const bool is_binary)
 {
     int      bdx          = 0;
@@ -429,6 +456,8 @@ static int rv32gdb_write_mem (void* fd, rv32* cpu, const char* cmd, const int cm
     unsigned addr         = 0;
     unsigned len          = 0;
     bool     io_status_ok = true;
+    uint8_t  mem[GDB_MEM_BLOCK_SIZE];
+    unsigned mem_len      = 0;
 
     // Skip command character
     cdx++;
@@ -489,10 +518,15 @@ static int rv32gdb_write_mem (void* fd, rv32* cpu, const char* cmd, const int cm
 
         if (io_status_ok)
         {
-            bool fault;
+            // Collect byte, and write to memory when a block is full
+            mem[mem_len++] = (uint8_t)val;
 
-            // Write byte to memory
-            cpu->write_mem(addr++, val, MEM_WR_ACCESS_BYTE, fault);
+            if (mem_len == GDB_MEM_BLOCK_SIZE)
+            {
+                cpu->write_block(addr, mem, mem_len);
+                addr   += mem_len;
+                mem_len = 0;
+            }
 #ifdef RV32GDB_DEBUG
             fprintf(stderr, "%02X", val & 0xff);
 #endif
@@ -505,6 +539,12 @@ static int rv32gdb_write_mem (void* fd, rv32* cpu, const char* cmd, const int cm
         }
     }
 
+    // Write any remaining bytes
+    if (mem_len)
+    {
+        cpu->write_block(addr, mem, mem_len);
+    }
+
     // Acknowledge the command
     if (io_status_ok)
     {
@@ -536,28 +576,26 @@ static int rv32gdb_write_mem (void* fd, rv32* cpu, const char* cmd, const int cm
 //
 // -------------------------------------------------------------------------
 
-static int rv32gdb_run_cpu (rv32* cpu, rv32i_cfg_s &cfg, const char* cmd, const int cmdlen, const int type)
+static int rv32gdb_run_cpu (rv32i_cpu* cpu, rv32i_cfg_s &cfg, const char* cmd, const int cmdlen, const int type)
 {
     int  reason      = SIGHUP;
 
     // If there's an address, fetch it and update PC
     if (cmdlen > 1)
     {
-        int cdx = 1;
-
-        // Retrieve the current CPU state
-        cpu_state = cpu->rv32_get_cpu_state();
-        cpu_state.pc = 0;
+        int      cdx  = 1;
+        uint32_t addr = 0;
 
         // Get the address from the command buffer
         while (cdx < cmdlen)
         {
-            cpu_state.pc <<= 4;
-            cpu_state.pc |= CHAR2NIB(cmd[cdx]);
+            addr <<= 4;
+            addr  |= CHAR2NIB(cmd[cdx]);
             cdx++;
         }
-        // Write back the updated CPU state
-        cpu->rv32_set_cpu_state(cpu_state);
+
+        // Update the PC in place
+        cpu->write_pc(addr);
     }
 
     // Continue execution
@@ -580,7 +618,7 @@ static int rv32gdb_run_cpu (rv32* cpu, rv32i_cfg_s &cfg, const char* cmd, const
 //
 // -------------------------------------------------------------------------
 
-static bool rv32gdb_proc_gdb_cmd (rv32* cpu, rv32i_cfg_s &cfg, const char* cmd, const int cmdlen, void* fd)
+static bool rv32gdb_proc_gdb_cmd (rv32i_cpu* cpu, rv32i_cfg_s &cfg, const char* cmd, const int cmdlen, void* fd)
 {
     int           op_idx    = 0;
     unsigned char checksum  = 0;
@@ -793,7 +831,7 @@ static rv32gdb_skt_t rv32gdb_connect_skt (const int portno)
 //
 // -------------------------------------------------------------------------
 
-int rv32gdb_process_gdb (rv32* cpu, int port_num, rv32i_cfg_s &cfg)
+int rv32gdb_process_gdb (rv32i_cpu* cpu, int port_num, rv32i_cfg_s &cfg)
 {
     int   idx      = 0;
     bool  active   = false;
@@ -801,13 +839,16 @@ int rv32gdb_process_gdb (rv32* cpu, int port_num, rv32i_cfg_s &cfg)
     bool  waiting  = true;
     char  ipbyte;
     void* pty_fd;
+    rv32gdb_skt_t skt;
 
     // Create a TCP/IP socket
-    if ((pty_fd = (void *)rv32gdb_connect_skt(port_num)) < 0)
+    if ((skt = rv32gdb_connect_skt(port_num)) == (rv32gdb_skt_t)RV32GDB_ERR)
     {
         return PTY_ERROR;
     }
 
+    pty_fd = (void *)(intptr_t)skt;
+
     while (!detached && rv32gdb_read(pty_fd, &ipbyte))
     {
         // If waiting for first communication, flag that attachment has happened.
@@ -90,6 +90,7 @@ typedef long long rv32gdb_skt_t;
 #define GDB_MEM_DELIM_CHAR                             ':'
 #define GDB_BIN_ESC                                    0x7d
 #define GDB_BIN_XOR_VAL                                0x20
+#define GDB_MEM_BLOCK_SIZE                             256
 #define HEX_CHAR_MAP                                   {'0', '1', '2', '3', \
                                                         '4', '5', '6', '7', \
                                                         '8', '9', 'a', 'b', \
@@ -183,6 +184,6 @@ enum lm32gdb_regs_e
 // PUBLIC PROTOTYPES
 // -------------------------------------------------------------------------
 
-extern int rv32gdb_process_gdb (rv32* cpu, int port_num, rv32i_cfg_s &cfg);
+extern int rv32gdb_process_gdb (rv32i_cpu* cpu, int port_num, rv32i_cfg_s &cfg);
 
 #endif   
@@ -4,8 +4,8 @@
 //
 // Date: 12th July 2021
 //
-// Contains the definitions for the class inheritance structure
-// of the target compilation to add the required extensions
+// Contains the definitions for the composition of the extension
+// classes for the supported configurations
 //
 // This file is part of the Zicsr extended RISC-V instruction
 // set simulator (rv32csr_cpu).
@@ -28,48 +28,39 @@
 #ifndef _RSV32_EXTENSIONS_H_
 #define _RSV32_EXTENSIONS_H_
 
-// Define the inheritance chain for adding new extensions.
-// Currently this is setup to add Zicsr, M, A, F, and D
-// in that order. If an extension were to be skipped,
-// then the subsequent definition just uses the last
-// active class to inherit from in place of the skipped
-// class. Note, since the FENCE instruction is a NOP
-// in this model, Zifencei is implicit in the rv32i_cpu
-// base class.
+#include "rv32csr_cpu.h"
+#include "rv32m_cpu.h"
+#include "rv32a_cpu.h"
+#include "rv32f_cpu.h"
+#include "rv32d_cpu.h"
 
-#define RV32_I_INHERITANCE_CLASS
-#define RV32_ZIFENCEI_INHERITANCE_CLASS
-#define RV32_ZICSR_INHERITANCE_CLASS     rv32i_cpu
-#define RV32_M_INHERITANCE_CLASS         rv32csr_cpu
-#define RV32_A_INHERITANCE_CLASS         rv32m_cpu
-#define RV32_F_INHERITANCE_CLASS         rv32a_cpu
-#define RV32_D_INHERITANCE_CLASS         rv32f_cpu
+// Define the extension class compositions for the supported
+// configurations. Each extension class is a template on the class
+// it extends, so that a configuration is composed at compile time,
+// with calls to the methods it overrides resolved for that
+// configuration only. Extensions are added in the order Zicsr, M,
+// A, F and D, and may be skipped, except that D needs F. Zicsr is
+// in all configurations (so rv32csr_cpu is their common base
+// class), as trap and interrupt handling need the CSRs. Zifencei is
+// implicit in the rv32i_cpu base class, whose FENCE.I flushes the
+// decoded instruction and block caches. The extension class templates are
+// instantiated in the library for these compositions, so any new
+// configuration must also be instantiated in the extensions' source
+// files, and its core's run loop and Zicsr decode in rv32i_cpu.cpp
+// and rv32csr_cpu.cpp.
 
-// Inheritance for a G spec processor should have all the above
-// classes inherited, without skips
-#define RV32_G_INHERITANCE_CLASS         rv32d_cpu
+typedef rv32csr_cpu                                    rv32i_ext_t;
+typedef rv32m_cpu<rv32i_ext_t>                         rv32im_ext_t;
+typedef rv32a_cpu<rv32im_ext_t>                        rv32ima_ext_t;
+typedef rv32d_cpu<rv32f_cpu<rv32ima_ext_t> >           rv32g_ext_t;
 
 // Uncomment the following to compile for RV32E base class,
 // or define it when compiling rv32i_cpu.cpp
 
 //#define RV32E_EXTENSION
 
-// Define the class include file definitions used here. I.e. those needed
-// for the target spec. Each one defines its predecessor, as including
-// headers for later derived classes causes a compile error---even when
-// using forward references (needs a completed class reference).
+// Define the extension spec for the default target model (rv32).
+// Chose the composition of the configuration that's needed.
+#define RV32_TARGET_INHERITANCE_CLASS    rv32g_ext_t
 
-#define RV32CSR_INCLUDE                 "rv32i_cpu.h"
-#define RV32M_INCLUDE                   "rv32csr_cpu.h"
-#define RV32A_INCLUDE                   "rv32m_cpu.h"
-#define RV32F_INCLUDE                   "rv32a_cpu.h"
-#define RV32D_INCLUDE                   "rv32f_cpu.h"
-
-// Define the extension spec for the target model. Chose the
-// highest order class that's needed. Currently Zicsr extensions.
-#define RV32_TARGET_INHERITANCE_CLASS    rv32d_cpu
-
-// Define target include: must match include of RV32_TARGET_INHERITANCE_CLASS
-#define RV32_TARGET_INCLUDE             "rv32d_cpu.h"
-
-#endif
\ No newline at end of file
+#endif
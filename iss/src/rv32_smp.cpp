@@ -0,0 +1,306 @@
+//=============================================================
+//
+// Copyright (c) 2021 Simon Southwell. All rights reserved.
+//
+// Date: 16th October 2026
+//
+// Contains the multiprocessor model, and the scheduling of
+// its harts
+//
+// This file is part of the RISC-V instruction set simulator
+// (rv32).
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#include <csignal>
+#include <thread>
+#include <vector>
+
+#include "rv32_smp.h"
+
+// -----------------------------------------------------------
+// Constructor/destructor
+// -----------------------------------------------------------
+
+rv32_smp::rv32_smp(const char* isa, const uint32_t num_harts, FILE* dbg_fp)
+{
+    num = 0;
+
+    if (num_harts == 0 || num_harts > RV32_SMP_MAX_HARTS)
+    {
+        return;
+    }
+
+    for (uint32_t id = 0; id < num_harts; id++)
+    {
+        if ((harts[id] = rv32_create(isa, dbg_fp)) == NULL)
+        {
+            break;
+        }
+
+        harts[id]->set_hart_id(id);
+        int_pending[id] = false;
+
+        // A single hart has its memory and time to itself, so needs no
+        // reservation domain or time base
+        if (num_harts > 1)
+        {
+            if (harts[id]->join_rsvd_domain(&rsvd_domain))
+            {
+                delete harts[id];
+                break;
+            }
+
+            harts[id]->join_time_base(&time_base);
+        }
+
+        num++;
+    }
+
+    // An unsupported configuration (or running out of reservation slots) creates no harts
+    if (num != num_harts)
+    {
+        while (num)
+        {
+            delete harts[--num];
+        }
+    }
+}
+
+rv32_smp::~rv32_smp()
+{
+    // Hart 0 owns the shared memory, so is deleted last
+    while (num)
+    {
+        delete harts[--num];
+    }
+}
+
+// -----------------------------------------------------------
+// Configuration and loading
+// -----------------------------------------------------------
+
+void rv32_smp::share_int_mem()
+{
+    for (uint32_t id = 1; id < num; id++)
+    {
+        harts[id]->share_int_mem(harts[0]);
+    }
+}
+
+int rv32_smp::read_elf(const char* const filename, uint32_t* p_entry, const bool lazy)
+{
+    uint32_t entry;
+
+    if (harts[0]->read_elf(filename, &entry, lazy))
+    {
+        return 1;
+    }
+
+    for (uint32_t id = 1; id < num; id++)
+    {
+        harts[id]->write_pc(entry);
+    }
+
+    if (p_entry != NULL)
+    {
+        *p_entry = entry;
+    }
+
+    return 0;
+}
+
+void rv32_smp::int_changed()
+{
+    for (uint32_t id = 0; id < num; id++)
+    {
+        int_pending[id] = true;
+    }
+}
+
+// -----------------------------------------------------------
+// Scheduling
+// -----------------------------------------------------------
+
+bool rv32_smp::run_quantum(const uint32_t id)
+{
+    rv32i_cfg_s& cfg          = hart_cfg[id];
+    uint64_t     start        = harts[id]->instructions_run();
+    rv32i_time_t start_cycles = harts[id]->clock_cycles();
+
+    cfg.num_instr = (limited && remaining[id] < quantum) ? (unsigned)remaining[id] : quantum;
+
+    if (int_pending[id].exchange(false))
+    {
+        harts[id]->update_int_callback();
+    }
+
+    int error = harts[id]->run(cfg);
+
+    remaining[id]      -= harts[id]->instructions_run() - start;
+    quantum_cycles[id]  = harts[id]->clock_cycles() - start_cycles;
+
+    // A hart stopping other than at the end of its quantum has halted (including on
+    // an ebreak, which also returns SIGTRAP, as the quantum's last instruction)
+    if (!harts[id]->instr_limit_reached() || (limited && remaining[id] == 0))
+    {
+        status[id] = error;
+
+        if (id == 0)
+        {
+            stop = true;
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+void rv32_smp::hart_thread(const uint32_t id)
+{
+    bool running = true;
+
+    while (running)
+    {
+        running = !stop && run_quantum(id);
+
+        // Wait at the end of the quantum for the other running harts,
+        // with a halted hart dropping out of the count to wait for
+        std::unique_lock<std::mutex> lock(sync_mutex);
+
+        if (running)
+        {
+            sync_arrived++;
+        }
+        else
+        {
+            sync_active--;
+        }
+
+        if (sync_arrived == sync_active)
+        {
+            end_quantum();
+            sync_arrived = 0;
+            sync_gen++;
+            sync_cv.notify_all();
+        }
+        else if (running)
+        {
+            uint64_t gen = sync_gen;
+            sync_cv.wait(lock, [&] { return sync_gen != gen; });
+        }
+    }
+}
+
+void rv32_smp::end_quantum()
+{
+    rv32i_time_t max_cycles = 0;
+
+    // The system's time advances by the quantum's length for the hart that took
+    // longest, so no hart sees mtime go backwards at the start of the next
+    for (uint32_t id = 0; id < num; id++)
+    {
+        if (quantum_cycles[id] > max_cycles)
+        {
+            max_cycles = quantum_cycles[id];
+        }
+
+        quantum_cycles[id] = 0;
+    }
+
+    time_base.advance(max_cycles);
+}
+
+int rv32_smp::run(rv32i_cfg_s &cfg)
+{
+    // A single hart runs uninterrupted
+    if (num == 1)
+    {
+        return harts[0]->run(cfg);
+    }
+
+    quantum = cfg.smp_quantum ? cfg.smp_quantum : RV32I_SMP_QUANTUM;
+    limited = cfg.num_instr != 0;
+    stop    = false;
+
+    // The harts' time source is configured, and paced from, once for the whole run
+    time_base.start(cfg);
+
+    for (uint32_t id = 0; id < num; id++)
+    {
+        hart_cfg[id]       = cfg;
+        remaining[id]      = cfg.num_instr;
+        status[id]         = 0;
+        quantum_cycles[id] = 0;
+
+        // Each hart has its own caches, so they default to smaller than a lone core's
+        rv32i_cfg_s& hcfg  = hart_cfg[id];
+
+        hcfg.dcache_size     = cfg.dcache_size     ? cfg.dcache_size     : RV32I_SMP_DCACHE_SIZE;
+        hcfg.blk_tbl_size    = cfg.blk_tbl_size    ? cfg.blk_tbl_size    : RV32I_SMP_BLK_TBL_SIZE;
+        hcfg.blk_pool_size   = cfg.blk_pool_size   ? cfg.blk_pool_size   : RV32I_SMP_BLK_POOL_SIZE;
+        hcfg.blk_filter_size = cfg.blk_filter_size ? cfg.blk_filter_size : RV32I_SMP_BLK_FILTER_SIZE;
+        hcfg.jit_code_size   = cfg.jit_code_size   ? cfg.jit_code_size   : RV32I_SMP_JIT_CODE_SIZE;
+    }
+
+    // Any new start address is for all harts, and is only set once
+    cfg.update_rst_vec = false;
+
+    if (cfg.smp_parallel)
+    {
+        std::vector<std::thread> threads;
+
+        sync_active  = num;
+        sync_arrived = 0;
+        sync_gen     = 0;
+
+        for (uint32_t id = 0; id < num; id++)
+        {
+            threads.emplace_back(&rv32_smp::hart_thread, this, id);
+        }
+
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+    }
+    else
+    {
+        bool running[RV32_SMP_MAX_HARTS];
+        uint32_t active = num;
+
+        for (uint32_t id = 0; id < num; id++)
+        {
+            running[id] = true;
+        }
+
+        while (!stop && active)
+        {
+            for (uint32_t id = 0; id < num && !stop; id++)
+            {
+                if (running[id] && !(running[id] = run_quantum(id)))
+                {
+                    active--;
+                }
+            }
+
+            end_quantum();
+        }
+    }
+
+    return status[0];
+}
@@ -0,0 +1,127 @@
+//=============================================================
+//
+// Copyright (c) 2021 Simon Southwell. All rights reserved.
+//
+// Date: 16th October 2026
+//
+// Contains the class definition for the multiprocessor model,
+// of a number of harts sharing memory
+//
+// This file is part of the RISC-V instruction set simulator
+// (rv32).
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _RV32_SMP_H_
+#define _RV32_SMP_H_
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#include "rv32.h"
+
+// Each hart takes a slot of the multiprocessor's reservation domain
+#define RV32_SMP_MAX_HARTS                 RV32I_RSVD_MAX_CORES
+
+// Symmetric multiprocessor of a number of harts of the same ISA
+// configuration. Each hart is a core, with its own pc, registers and CSRs
+// (mhartid being its index), and its own TLB, caches and mtimecmp. Harts
+// share hart 0's internal memory, and should each be configured with the
+// same memory map and callbacks. Multiple harts join the multiprocessor's
+// reservation domain, so their LR/SC and AMOs are atomic with respect to
+// each other (but not to the cores of any other system), and its time
+// base, so they share one mtime. A hart sees another's writes to code
+// only after executing a FENCE.I, as the harts' decoded instruction
+// caches are not kept coherent.
+//
+// The harts run for a quantum of instructions at a time, either round
+// robin on the calling thread, or in parallel on a host thread each, when
+// all are synchronised at the end of each quantum. In parallel, memory
+// callbacks may be called from any of the threads.
+class rv32_smp
+{
+public:
+    // Create the harts, with num_harts zero if the ISA configuration is not
+    // supported, or too many harts are specified (for the harts or their
+    // reservation domain)
+    LIBRISCV32_API               rv32_smp       (const char* isa, const uint32_t num_harts, FILE* dbg_fp = stdout);
+    LIBRISCV32_API               ~rv32_smp      ();
+
+    LIBRISCV32_API uint32_t      num_harts      ()                  { return num; };
+    LIBRISCV32_API rv32csr_cpu*  hart           (const uint32_t id) { return harts[id]; };
+
+    // Share hart 0's internal memory with the other harts, once all are configured
+    LIBRISCV32_API void          share_int_mem  (void);
+
+    // Load an executable through hart 0, starting all the harts at its entry point
+    LIBRISCV32_API int           read_elf       (const char* const filename, uint32_t* p_entry = NULL, const bool lazy = false);
+
+    // Flag a change of interrupt state to all the harts, which call their interrupt
+    // callback at the start of their next quantum. A device shared by the harts
+    // calls this when written, as only the writing hart calls its callback after
+    // the write. May be called from any hart's thread.
+    LIBRISCV32_API void          int_changed    (void);
+
+    // Run the harts until hart 0 halts, or all have. The cfg num_instr is a
+    // limit for each hart, and smp_quantum and smp_parallel select the
+    // scheduling (a single hart running uninterrupted). Cache sizes left at
+    // 0 in cfg get the smaller multiprocessor defaults. Returns hart 0's
+    // run() status.
+    LIBRISCV32_API int           run            (rv32i_cfg_s &cfg);
+
+private:
+    // Run a hart for a quantum, returning false if it has halted
+    bool                         run_quantum    (const uint32_t id);
+
+    // Host thread body for a hart, when running in parallel
+    void                         hart_thread    (const uint32_t id);
+
+    // Advance the time base at the end of a quantum that all the running harts have run
+    void                         end_quantum    (void);
+
+    uint32_t                     num;
+    rv32csr_cpu*                 harts          [RV32_SMP_MAX_HARTS];
+
+    // LR/SC reservations and AMO bus lock, and time base, of the harts, outliving them
+    rv32i_rsvd_domain            rsvd_domain;
+    rv32i_time_base              time_base;
+
+    // Per hart run configuration, instructions left to run, run() status and
+    // cycles run in the current quantum
+    rv32i_cfg_s                  hart_cfg       [RV32_SMP_MAX_HARTS];
+    uint64_t                     remaining      [RV32_SMP_MAX_HARTS];
+    int                          status         [RV32_SMP_MAX_HARTS];
+    rv32i_time_t                 quantum_cycles [RV32_SMP_MAX_HARTS];
+
+    // Interrupt state changed since a hart's last quantum
+    std::atomic<bool>            int_pending    [RV32_SMP_MAX_HARTS];
+
+    unsigned                     quantum;
+    bool                         limited;
+
+    // Set when hart 0 halts, stopping the others
+    std::atomic<bool>            stop;
+
+    // End of quantum barrier, for harts still running in parallel
+    std::mutex                   sync_mutex;
+    std::condition_variable      sync_cv;
+    uint32_t                     sync_active;
+    uint32_t                     sync_arrived;
+    uint64_t                     sync_gen;
+};
+
+#endif
@@ -25,43 +25,57 @@
 //
 //=============================================================
 
-#include "rv32a_cpu.h"
+#include "rv32_extensions.h"
 
 // -----------------------------------------------------------
 // Constructor
 // -----------------------------------------------------------
 
-rv32a_cpu::rv32a_cpu(FILE* dbgfp) : RV32_A_INHERITANCE_CLASS(dbgfp)
+template <class BASE>
+rv32a_cpu<BASE>::rv32a_cpu(FILE* dbgfp) : BASE(dbgfp)
 {
-    state.hart[curr_hart].csr[RV32CSR_ADDR_MISA] |=  RV32CSR_EXT_A;
+    state.hart[curr_hart].csr[RV32CSR_IDX_MISA] |=  RV32CSR_EXT_A;
+}
+
+// -----------------------------------------------------------
+// Decode table set up
+// -----------------------------------------------------------
+
+template <class BASE>
+void rv32a_cpu<BASE>::init_decode_tables()
+{
+    BASE::init_decode_tables();
+
+    amo_tbl  = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    amow_tbl = new_decode_table(RV32I_NUM_TERTIARY_OPCODES);
 
     // Initialise the AMOW tertiary table for reserved instruction method
     for (int i = 0; i < RV32I_NUM_TERTIARY_OPCODES; i++)
     {
-        amow_tbl[i]               = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved }; /*RSVD*/
+        amow_tbl[i]               = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
     }
 
     // Set the AMOW table for all four combinations of the funct7 ar and rl bits
     // to the same instruction method (will decode those bits locally)---[1] Sec 8
     for (int i = 0; i < 4; i++)
     {
-        amow_tbl[(0x02 << 2) + i] = { false, lrw_str,     RV32I_INSTR_FMT_R, (pFunc_t)&rv32a_cpu::lrw };      /*LR.W*/
-        amow_tbl[(0x03 << 2) + i] = { false, scw_str,     RV32I_INSTR_FMT_R, (pFunc_t)&rv32a_cpu::scw };      /*SC.W*/
-        amow_tbl[(0x01 << 2) + i] = { false, amoswap_str, RV32I_INSTR_FMT_R, (pFunc_t)&rv32a_cpu::amoswapw }; /*AMOSWAP.W*/
-        amow_tbl[(0x00 << 2) + i] = { false, amoadd_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32a_cpu::amoaddw };  /*AMOADD.W*/
-        amow_tbl[(0x04 << 2) + i] = { false, amoxor_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32a_cpu::amoxorw };  /*AMOXOR.W*/
-        amow_tbl[(0x0c << 2) + i] = { false, amoand_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32a_cpu::amoandw };  /*AMOAND.W*/
-        amow_tbl[(0x08 << 2) + i] = { false, amoor_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32a_cpu::amoorw };   /*AMOOR.W*/
-        amow_tbl[(0x10 << 2) + i] = { false, amomin_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32a_cpu::amominw };  /*AMOMIN.W*/
-        amow_tbl[(0x14 << 2) + i] = { false, amomax_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32a_cpu::amomaxw };  /*AMOMAX.W*/
-        amow_tbl[(0x18 << 2) + i] = { false, amominu_str, RV32I_INSTR_FMT_R, (pFunc_t)&rv32a_cpu::amominuw }; /*AMOMINU.W*/
-        amow_tbl[(0x1c << 2) + i] = { false, amomaxu_str, RV32I_INSTR_FMT_R, (pFunc_t)&rv32a_cpu::amomaxuw }; /*AMOMAXU.W*/
+        amow_tbl[(0x02 << 2) + i] = { false, lrw_str,     RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32a_cpu, lrw)      };    /*LR.W*/
+        amow_tbl[(0x03 << 2) + i] = { false, scw_str,     RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32a_cpu, scw)      };    /*SC.W*/
+        amow_tbl[(0x01 << 2) + i] = { false, amoswap_str, RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32a_cpu, amoswapw) };    /*AMOSWAP.W*/
+        amow_tbl[(0x00 << 2) + i] = { false, amoadd_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32a_cpu, amoaddw)  };    /*AMOADD.W*/
+        amow_tbl[(0x04 << 2) + i] = { false, amoxor_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32a_cpu, amoxorw)  };    /*AMOXOR.W*/
+        amow_tbl[(0x0c << 2) + i] = { false, amoand_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32a_cpu, amoandw)  };    /*AMOAND.W*/
+        amow_tbl[(0x08 << 2) + i] = { false, amoor_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32a_cpu, amoorw)   };    /*AMOOR.W*/
+        amow_tbl[(0x10 << 2) + i] = { false, amomin_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32a_cpu, amominw)  };    /*AMOMIN.W*/
+        amow_tbl[(0x14 << 2) + i] = { false, amomax_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32a_cpu, amomaxw)  };    /*AMOMAX.W*/
+        amow_tbl[(0x18 << 2) + i] = { false, amominu_str, RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32a_cpu, amominuw) };    /*AMOMINU.W*/
+        amow_tbl[(0x1c << 2) + i] = { false, amomaxu_str, RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32a_cpu, amomaxuw) };    /*AMOMAXU.W*/
     }
 
     // Initialise the AMO secondary table for reserved instruction method
     for (int i = 0; i < RV32I_NUM_SECONDARY_OPCODES; i++)
     {
-        amo_tbl[i]                = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved };        /*RSVD*/
+        amo_tbl[i]                = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
     }
 
     // Funct3 is always 2 for all 32 bit RV32A instructions
@@ -75,296 +89,294 @@ rv32a_cpu::rv32a_cpu(FILE* dbgfp) : RV32_A_INHERITANCE_CLASS(dbgfp)
 // RV32A instruction methods
 // -----------------------------------------------------------
 
-void rv32a_cpu::lrw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32a_cpu<BASE>::lrw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_RA_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RA_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1];
 
-        uint32_t rd_val = read_mem(access_addr, MEM_RD_ACCESS_WORD, access_fault);
+        uint32_t rd_val = load_reserved(access_addr, access_fault);
 
-        if (!access_fault)
+        if (!access_fault && d->rd)
         {
             state.hart[curr_hart].x[d->rd] = rd_val;
-
-            rsvd_mem.active     = true;
-            rsvd_mem.start_addr = access_addr & ~(rsvd_mem_block_bytes - 1);
-            rsvd_mem.end_addr   = rsvd_mem.start_addr + rsvd_mem_block_bytes - 1;
         }
     }
 
-    if (!access_fault || disassemble)
+    if (!access_fault || RV32I_DISASSEM_ONLY)
     {
         increment_pc();
     }
 }
 
-void rv32a_cpu::scw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32a_cpu<BASE>::scw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_RA_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RA_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1];
 
-        if (rsvd_mem.active && access_addr >= rsvd_mem.start_addr && (access_addr + 3) <= rsvd_mem.end_addr)
-        {
-            write_mem(access_addr, state.hart[curr_hart].x[d->rs2], MEM_WR_ACCESS_WORD, access_fault);
-            state.hart[curr_hart].x[d->rd] = 0;
-        }
-        else
+        bool stored = store_conditional(access_addr, state.hart[curr_hart].x[d->rs2], access_fault);
+
+        if (!access_fault && d->rd)
         {
-            state.hart[curr_hart].x[d->rd] = 1;
+            state.hart[curr_hart].x[d->rd] = stored ? 0 : 1;
         }
-
-        rsvd_mem.active                    = false;
     }
 
-    if (!access_fault || disassemble)
+    if (!access_fault || RV32I_DISASSEM_ONLY)
     {
         increment_pc();
     }
 }
 
-void rv32a_cpu::amoswapw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32a_cpu<BASE>::amoswapw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_RA_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RA_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1];
 
-        uint32_t rd_val = read_mem(access_addr, MEM_RD_ACCESS_WORD, access_fault);
+        uint32_t rd_val = amo_word(access_addr, RV32I_AMO_SWAP, state.hart[curr_hart].x[d->rs2], access_fault);
 
-        if (!access_fault)
+        if (!access_fault && d->rd)
         {
             state.hart[curr_hart].x[d->rd] = rd_val;
-            write_mem(access_addr, state.hart[curr_hart].x[d->rs2], MEM_WR_ACCESS_WORD, access_fault);
         }
     }
 
-    if (!access_fault || disassemble)
+    if (!access_fault || RV32I_DISASSEM_ONLY)
     {
         increment_pc();
     }
 }
 
-void rv32a_cpu::amoaddw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32a_cpu<BASE>::amoaddw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_RA_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RA_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1];
 
-        uint32_t rd_val = read_mem(access_addr, MEM_RD_ACCESS_WORD, access_fault);
+        uint32_t rd_val = amo_word(access_addr, RV32I_AMO_ADD, state.hart[curr_hart].x[d->rs2], access_fault);
 
-        if (!access_fault)
+        if (!access_fault && d->rd)
         {
             state.hart[curr_hart].x[d->rd] = rd_val;
-            write_mem(access_addr, state.hart[curr_hart].x[d->rs2] + rd_val, MEM_WR_ACCESS_WORD, access_fault);
         }
     }
 
-    if (!access_fault || disassemble)
+    if (!access_fault || RV32I_DISASSEM_ONLY)
     {
         increment_pc();
     }
 }
 
-void rv32a_cpu::amoxorw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32a_cpu<BASE>::amoxorw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_RA_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RA_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1];
 
-        uint32_t rd_val = read_mem(access_addr, MEM_RD_ACCESS_WORD, access_fault);
+        uint32_t rd_val = amo_word(access_addr, RV32I_AMO_XOR, state.hart[curr_hart].x[d->rs2], access_fault);
 
-        if (!access_fault)
+        if (!access_fault && d->rd)
         {
             state.hart[curr_hart].x[d->rd] = rd_val;
-            write_mem(access_addr, state.hart[curr_hart].x[d->rs2] ^ rd_val, MEM_WR_ACCESS_WORD, access_fault);
         }
     }
 
-    if (!access_fault || disassemble)
+    if (!access_fault || RV32I_DISASSEM_ONLY)
     {
         increment_pc();
     }
 }
 
-void rv32a_cpu::amoandw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32a_cpu<BASE>::amoandw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1];
 
-        uint32_t rd_val = read_mem(access_addr, MEM_RD_ACCESS_WORD, access_fault);
+        uint32_t rd_val = amo_word(access_addr, RV32I_AMO_AND, state.hart[curr_hart].x[d->rs2], access_fault);
 
-        if (!access_fault)
+        if (!access_fault && d->rd)
         {
             state.hart[curr_hart].x[d->rd] = rd_val;
-            write_mem(access_addr, state.hart[curr_hart].x[d->rs2] & rd_val, MEM_WR_ACCESS_WORD, access_fault);
         }
     }
 
-    if (!access_fault || disassemble)
+    if (!access_fault || RV32I_DISASSEM_ONLY)
     {
         increment_pc();
-    };
+    }
 }
 
-void rv32a_cpu::amoorw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32a_cpu<BASE>::amoorw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_RA_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RA_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1];
 
-        uint32_t rd_val = read_mem(access_addr, MEM_RD_ACCESS_WORD, access_fault);
+        uint32_t rd_val = amo_word(access_addr, RV32I_AMO_OR, state.hart[curr_hart].x[d->rs2], access_fault);
 
-        if (!access_fault)
+        if (!access_fault && d->rd)
         {
             state.hart[curr_hart].x[d->rd] = rd_val;
-            write_mem(access_addr, state.hart[curr_hart].x[d->rs2] | rd_val, MEM_WR_ACCESS_WORD, access_fault);
         }
     }
 
-    if (!access_fault || disassemble)
+    if (!access_fault || RV32I_DISASSEM_ONLY)
     {
         increment_pc();
     }
 }
 
-void rv32a_cpu::amominw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32a_cpu<BASE>::amominw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1];
 
-        uint32_t rd_val = read_mem(access_addr, MEM_RD_ACCESS_WORD, access_fault);
+        uint32_t rd_val = amo_word(access_addr, RV32I_AMO_MIN, state.hart[curr_hart].x[d->rs2], access_fault);
 
-        if (!access_fault)
+        if (!access_fault && d->rd)
         {
             state.hart[curr_hart].x[d->rd] = rd_val;
-
-            uint32_t wr_val = ((int32_t)rd_val < (int32_t)state.hart[curr_hart].x[d->rs2]) ? rd_val : state.hart[curr_hart].x[d->rs2];
-
-            write_mem(access_addr, wr_val, MEM_WR_ACCESS_WORD, access_fault);
         }
     }
 
-    if (!access_fault || disassemble)
+    if (!access_fault || RV32I_DISASSEM_ONLY)
     {
         increment_pc();
-    };
+    }
 }
 
-void rv32a_cpu::amomaxw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32a_cpu<BASE>::amomaxw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1];
 
-        uint32_t rd_val = read_mem(access_addr, MEM_RD_ACCESS_WORD, access_fault);
+        uint32_t rd_val = amo_word(access_addr, RV32I_AMO_MAX, state.hart[curr_hart].x[d->rs2], access_fault);
 
-        if (!access_fault)
+        if (!access_fault && d->rd)
         {
             state.hart[curr_hart].x[d->rd] = rd_val;
-
-            uint32_t wr_val = ((int32_t)rd_val > (int32_t)state.hart[curr_hart].x[d->rs2]) ? rd_val : state.hart[curr_hart].x[d->rs2];
-
-            write_mem(access_addr, wr_val, MEM_WR_ACCESS_WORD, access_fault);
         }
     }
 
-    if (!access_fault || disassemble)
+    if (!access_fault || RV32I_DISASSEM_ONLY)
     {
         increment_pc();
-    };
+    }
 }
 
-void rv32a_cpu::amominuw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32a_cpu<BASE>::amominuw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1];
 
-        uint32_t rd_val = read_mem(access_addr, MEM_RD_ACCESS_WORD, access_fault);
+        uint32_t rd_val = amo_word(access_addr, RV32I_AMO_MINU, state.hart[curr_hart].x[d->rs2], access_fault);
 
-        if (!access_fault)
+        if (!access_fault && d->rd)
         {
             state.hart[curr_hart].x[d->rd] = rd_val;
-
-            uint32_t wr_val = (rd_val < state.hart[curr_hart].x[d->rs2]) ? rd_val : state.hart[curr_hart].x[d->rs2];
-
-            write_mem(access_addr, wr_val, MEM_WR_ACCESS_WORD, access_fault);
         }
     }
 
-    if (!access_fault || disassemble)
+    if (!access_fault || RV32I_DISASSEM_ONLY)
     {
         increment_pc();
-    };
+    }
 }
 
-void rv32a_cpu::amomaxuw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32a_cpu<BASE>::amomaxuw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1];
 
-        uint32_t rd_val = read_mem(access_addr, MEM_RD_ACCESS_WORD, access_fault);
+        uint32_t rd_val = amo_word(access_addr, RV32I_AMO_MAXU, state.hart[curr_hart].x[d->rs2], access_fault);
 
-        if (!access_fault)
+        if (!access_fault && d->rd)
         {
             state.hart[curr_hart].x[d->rd] = rd_val;
-
-            uint32_t wr_val = (rd_val > state.hart[curr_hart].x[d->rs2]) ? rd_val : state.hart[curr_hart].x[d->rs2];
-
-            write_mem(access_addr, wr_val, MEM_WR_ACCESS_WORD, access_fault);
         }
     }
 
-    if (!access_fault || disassemble)
+    if (!access_fault || RV32I_DISASSEM_ONLY)
     {
         increment_pc();
-    };
-}
\ No newline at end of file
+    }
+}
+
+// -----------------------------------------------------------
+// Instantiation for the configurations in rv32_extensions.h
+// -----------------------------------------------------------
+
+template class rv32a_cpu<rv32im_ext_t>;
@@ -27,82 +27,85 @@
 #ifndef _RV32A_CPU_H_
 #define _RV32A_CPU_H_
 
-#include "rv32_extensions.h"
 #include "rv32i_cpu_hdr.h"
-#include RV32A_INCLUDE
+#include "rv32i_cpu.h"
 
-class rv32a_cpu : public RV32_A_INHERITANCE_CLASS
+template <class BASE>
+class rv32a_cpu : public BASE
 {
 public:
              LIBRISCV32_API      rv32a_cpu      (FILE* dbgfp = stdout);
     virtual  LIBRISCV32_API      ~rv32a_cpu()   { };
 
-protected:
-    // Add an AMO instruction secondary table here. Make public to allow
-    // RV64A instructions to be added in a future derived class.
-    rv32i_decode_table_t  amo_tbl        [RV32I_NUM_SECONDARY_OPCODES];
+    using BASE::read_mem;
+    using BASE::write_mem;
 
-private:
+protected:
     // ------------------------------------------------
-    // Internal Type definitions
+    // Members of the extended classes used here
     // ------------------------------------------------
 
-    // Structure for LR.W reserved memory area
-    struct rsvd_mem_s
-    {
-        bool active;
-        uint32_t start_addr;
-        uint32_t end_addr;
+    using BASE::state;
+    using BASE::curr_hart;
+    using BASE::dasm_fp;
+    using BASE::disassemble;
+    using BASE::rt_disassem;
+    using BASE::rmap;
+    using BASE::rmap_str;
+    using BASE::instr_name;
+    using BASE::increment_pc;
+    using BASE::access_addr;
+    using BASE::load_reserved;
+    using BASE::store_conditional;
+    using BASE::amo_word;
+    using BASE::reserved_str;
+    using BASE::primary_tbl;
+    using BASE::new_decode_table;
+
+protected:
+    // Add an AMO instruction secondary table here. Make public to allow
+    // RV64A instructions to be added in a future derived class.
+    rv32i_decode_table_t* amo_tbl;
 
-        rsvd_mem_s()
-        {
-            active     = false;
-            start_addr = 0;
-            end_addr   = 0;
-        }
-    };
+    // Add the RV32A instructions to the decode tables
+    void init_decode_tables              (void);
 
+private:
     // ------------------------------------------------
     // Private member variables
     // ------------------------------------------------
 
-    // Granularity of LR.W reserved areas
-    static const uint32_t rsvd_mem_block_bytes        = 32;
-
-    const char lrw_str     [DISASSEM_STR_SIZE] = "lr.w     ";
-    const char scw_str     [DISASSEM_STR_SIZE] = "sc.w     ";
-    const char amoswap_str [DISASSEM_STR_SIZE] = "amoswap.w";
-    const char amoadd_str  [DISASSEM_STR_SIZE] = "amoadd.w ";
-    const char amoxor_str  [DISASSEM_STR_SIZE] = "amoxor.w ";
-    const char amoand_str  [DISASSEM_STR_SIZE] = "amoand.w ";
-    const char amoor_str   [DISASSEM_STR_SIZE] = "amoor.w  ";
-    const char amomin_str  [DISASSEM_STR_SIZE] = "amomin.w ";
-    const char amomax_str  [DISASSEM_STR_SIZE] = "amomax.w ";
-    const char amominu_str [DISASSEM_STR_SIZE] = "amominu.w";
-    const char amomaxu_str [DISASSEM_STR_SIZE] = "amomaxu.w";
+    static constexpr char lrw_str     [] = "lr.w     ";
+    static constexpr char scw_str     [] = "sc.w     ";
+    static constexpr char amoswap_str [] = "amoswap.w";
+    static constexpr char amoadd_str  [] = "amoadd.w ";
+    static constexpr char amoxor_str  [] = "amoxor.w ";
+    static constexpr char amoand_str  [] = "amoand.w ";
+    static constexpr char amoor_str   [] = "amoor.w  ";
+    static constexpr char amomin_str  [] = "amomin.w ";
+    static constexpr char amomax_str  [] = "amomax.w ";
+    static constexpr char amominu_str [] = "amominu.w";
+    static constexpr char amomaxu_str [] = "amomaxu.w";
 
     // Tertiary table for AMO.W instructions
-    rv32i_decode_table_t  amow_tbl       [RV32I_NUM_TERTIARY_OPCODES];
-
-    // Reserved memory state
-    rsvd_mem_s rsvd_mem;
+    rv32i_decode_table_t* amow_tbl;
 
     // ------------------------------------------------
     // Private member functions
     // ------------------------------------------------
 
     // RV32A extension instruction methods
-    void lrw                             (const p_rv32i_decode_t);
-    void scw                             (const p_rv32i_decode_t);
-    void amoswapw                        (const p_rv32i_decode_t);
-    void amoaddw                         (const p_rv32i_decode_t);
-    void amoxorw                         (const p_rv32i_decode_t);
-    void amoandw                         (const p_rv32i_decode_t);
-    void amoorw                          (const p_rv32i_decode_t);
-    void amominw                         (const p_rv32i_decode_t);
-    void amomaxw                         (const p_rv32i_decode_t); 
-    void amominuw                        (const p_rv32i_decode_t);
-    void amomaxuw                        (const p_rv32i_decode_t);
+    template <bool TRACE> void lrw       (const p_rv32i_decode_t);
+    template <bool TRACE> void scw       (const p_rv32i_decode_t);
+    template <bool TRACE> void amoswapw  (const p_rv32i_decode_t);
+    template <bool TRACE> void amoaddw   (const p_rv32i_decode_t);
+    template <bool TRACE> void amoxorw   (const p_rv32i_decode_t);
+    template <bool TRACE> void amoandw   (const p_rv32i_decode_t);
+    template <bool TRACE> void amoorw    (const p_rv32i_decode_t);
+    template <bool TRACE> void amominw   (const p_rv32i_decode_t);
+    template <bool TRACE> void amomaxw   (const p_rv32i_decode_t); 
+    template <bool TRACE> void amominuw  (const p_rv32i_decode_t);
+    template <bool TRACE> void amomaxuw  (const p_rv32i_decode_t);
 };
 
 #endif
@@ -26,49 +26,156 @@
 //=============================================================
 
 #include "rv32csr_cpu.h"
+#include "rv32.h"
 
 class rv32csr_cpu;
 
+#if RV32CSR_IDX_MHPMEVENT3 + 29 != RV32I_NUM_OF_CSRS
+#error "RV32I_NUM_OF_CSRS does not match the implemented CSR storage indices"
+#endif
+
 // -----------------------------------------------------------
-// Constructor
+// CSR address to storage index lookup table, shared by all
+// instances. Each address selects a block of indices, with
+// block 0 having no CSRs implemented.
 // -----------------------------------------------------------
 
-rv32csr_cpu::rv32csr_cpu(FILE* dbgfp) : RV32_ZICSR_INHERITANCE_CLASS(dbgfp)
+static class rv32csr_index_tbl
 {
-    int idx = 0;
+public:
+    uint8_t  blk[RV32I_CSR_SPACE_SIZE >> RV32CSR_IDX_BLK_BITS];
+    uint8_t  idx[RV32CSR_IDX_MAX_BLKS][RV32CSR_IDX_BLK_SIZE];
+    uint16_t addr[RV32I_NUM_OF_CSRS];
+
+    rv32csr_index_tbl()
+    {
+        memset(blk, 0, sizeof(blk));
+        memset(idx, RV32CSR_IDX_NONE, sizeof(idx));
+        num_blks = 1;
+
+        add(RV32CSR_ADDR_FFLAGS,        RV32CSR_IDX_FFLAGS);
+        add(RV32CSR_ADDR_FRM,           RV32CSR_IDX_FRM);
+        add(RV32CSR_ADDR_FCSR,          RV32CSR_IDX_FCSR);
+        add(RV32CSR_ADDR_MSTATUS,       RV32CSR_IDX_MSTATUS);
+        add(RV32CSR_ADDR_MISA,          RV32CSR_IDX_MISA);
+        add(RV32CSR_ADDR_MIE,           RV32CSR_IDX_MIE);
+        add(RV32CSR_ADDR_MTVEC,         RV32CSR_IDX_MTVEC);
+        add(RV32CSR_ADDR_MEPC,          RV32CSR_IDX_MEPC);
+        add(RV32CSR_ADDR_MCAUSE,        RV32CSR_IDX_MCAUSE);
+        add(RV32CSR_ADDR_MTVAL,         RV32CSR_IDX_MTVAL);
+        add(RV32CSR_ADDR_MIP,           RV32CSR_IDX_MIP);
+        add(RV32CSR_ADDR_MCYCLE,        RV32CSR_IDX_MCYCLE);
+        add(RV32CSR_ADDR_MCYCLEH,       RV32CSR_IDX_MCYCLEH);
+        add(RV32CSR_ADDR_MINSTRET,      RV32CSR_IDX_MINSTRET);
+        add(RV32CSR_ADDR_MINSTRETH,     RV32CSR_IDX_MINSTRETH);
+        add(RV32CSR_ADDR_MSCRATCH,      RV32CSR_IDX_MSCRATCH);
+        add(RV32CSR_ADDR_MCOUNTEREN,    RV32CSR_IDX_MCOUNTEREN);
+        add(RV32CSR_ADDR_MCOUNTINHIBIT, RV32CSR_IDX_MCOUNTINHIBIT);
+        add(RV32CSR_ADDR_MVENDORID,     RV32CSR_IDX_MVENDORID);
+        add(RV32CSR_ADDR_MARCHID,       RV32CSR_IDX_MARCHID);
+        add(RV32CSR_ADDR_MIMPID,        RV32CSR_IDX_MIMPID);
+        add(RV32CSR_ADDR_MHARTID,       RV32CSR_IDX_MHARTID);
+
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            add(RV32CSR_ADDR_PMPCFG0 + i, RV32CSR_IDX_PMPCFG0 + i);
+        }
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            add(RV32CSR_ADDR_PMPADDR0 + i, RV32CSR_IDX_PMPADDR0 + i);
+        }
+
+        for (uint32_t i = 0; i < 29; i++)
+        {
+            add(RV32CSR_ADDR_MHPMCOUNTER3  + i, RV32CSR_IDX_MHPMCOUNTER3  + i);
+            add(RV32CSR_ADDR_MHPMCOUNTER3H + i, RV32CSR_IDX_MHPMCOUNTER3H + i);
+            add(RV32CSR_ADDR_MHPMEVENT3    + i, RV32CSR_IDX_MHPMEVENT3    + i);
+        }
+    }
+
+    // Storage index of the CSR at addr, or RV32CSR_IDX_NONE if not implemented
+    inline uint32_t lookup(const uint32_t addr) const
+    {
+        return idx[blk[(addr & 0xfff) >> RV32CSR_IDX_BLK_BITS]][addr & (RV32CSR_IDX_BLK_SIZE - 1)];
+    }
+
+private:
+    uint32_t num_blks;
+
+    void add(const uint32_t addr, const uint32_t index)
+    {
+        if (blk[addr >> RV32CSR_IDX_BLK_BITS] == 0)
+        {
+            blk[addr >> RV32CSR_IDX_BLK_BITS] = (uint8_t)num_blks++;
+        }
+
+        idx[blk[addr >> RV32CSR_IDX_BLK_BITS]][addr & (RV32CSR_IDX_BLK_SIZE - 1)] = (uint8_t)index;
+        this->addr[index] = (uint16_t)addr;
+    }
+} csr_index;
 
+// -----------------------------------------------------------
+// Constructor
+// -----------------------------------------------------------
+
+rv32csr_cpu::rv32csr_cpu(FILE* dbgfp) : rv32i_cpu(dbgfp)
+{
     // No callback functions registered by default
     p_int_callback = NULL;
 
-    // Initialise interrupt wakeup time to time 0
-    interrupt_wakeup_time = 0;
+    hart_id        = 0;
+
+    // Set values of MSTATUS and MISA CSRs
+    state.hart[curr_hart].csr[RV32CSR_IDX_MISA] = RV32CSR_MXLEN32 | RV32CSR_EXT_I;
+#ifdef RV32E_EXTENSION
+    state.hart[curr_hart].csr[RV32CSR_IDX_MISA] |= RV32CSR_EXT_E;
+#endif
+    state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] = RV32CSR_MPP_BITMASK;                                   // In this model, MPP is always machine level
+
+}
+
+// -----------------------------------------------------------
+// Decode table set up
+// -----------------------------------------------------------
+
+void rv32csr_cpu::init_decode_tables()
+{
+    int idx = 0;
+
+    rv32i_cpu::init_decode_tables();
 
     // Update decode table with extended instructions
 
     // Tertiary table for ECALL, EBREAK and MRET instructions (decoded on funct12 = imm_i)
     // Skip ecall and ebreak entries, populated in the base class, and add mret
     idx += 2;
-    e_tbl[idx++]   = {false, mret_str,     RV32I_INSTR_FMT_R,   (pFunc_t)&rv32csr_cpu::mret };     /*MRET*/
+    e_tbl[idx++]   = {false, mret_str,     RV32I_INSTR_FMT_R,   RV32I_HANDLER(rv32csr_cpu, mret) };    /*MRET*/
     
     // Secondary table for system instructions (decoded on funct3)
-    idx = 1;                                                                                       // Skip updating to e_tbl, as done in base class
-    sys_tbl[idx++] = {false, csrrw_str,    RV32I_INSTR_FMT_I,   (pFunc_t)&rv32csr_cpu::csrrw };
-    sys_tbl[idx++] = {false, csrrs_str,    RV32I_INSTR_FMT_I,   (pFunc_t)&rv32csr_cpu::csrrs };
-    sys_tbl[idx++] = {false, csrrc_str,    RV32I_INSTR_FMT_I,   (pFunc_t)&rv32csr_cpu::csrrc };
-    sys_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, (pFunc_t)&rv32csr_cpu::reserved };
-    sys_tbl[idx++] = {false, csrrwi_str,   RV32I_INSTR_FMT_I,   (pFunc_t)&rv32csr_cpu::csrrwi };
-    sys_tbl[idx++] = {false, csrrsi_str,   RV32I_INSTR_FMT_I,   (pFunc_t)&rv32csr_cpu::csrrsi };
-    sys_tbl[idx++] = {false, csrrci_str,   RV32I_INSTR_FMT_I,   (pFunc_t)&rv32csr_cpu::csrrci };
-
-    // Set values of MSTATUS and MISA CSRs
-    state.hart[curr_hart].csr[RV32CSR_ADDR_MISA] = RV32CSR_MXLEN32 | RV32CSR_EXT_I;
-#ifdef RV32E_EXTENSION
-    state.hart[curr_hart].csr[RV32CSR_ADDR_MISA] |= RV32CSR_EXT_E;
-#endif
-    state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] = RV32CSR_MPP_BITMASK;                                   // In this model, MPP is always machine level
+    init_csr_decode<rv32csr_cpu>();
+}
 
+template <class CORE>
+void rv32csr_cpu::init_csr_decode()
+{
+    int idx = 1;    // Skip updating to e_tbl, as done in base class
+
+    sys_tbl[idx++] = {false, csrrw_str,    RV32I_INSTR_FMT_I,   RV32I_CORE_HANDLER(rv32csr_cpu, CORE, csrrw)  };
+    sys_tbl[idx++] = {false, csrrs_str,    RV32I_INSTR_FMT_I,   RV32I_CORE_HANDLER(rv32csr_cpu, CORE, csrrs)  };
+    sys_tbl[idx++] = {false, csrrc_str,    RV32I_INSTR_FMT_I,   RV32I_CORE_HANDLER(rv32csr_cpu, CORE, csrrc)  };
+    sys_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32csr_cpu, reserved)          };
+    sys_tbl[idx++] = {false, csrrwi_str,   RV32I_INSTR_FMT_I,   RV32I_CORE_HANDLER(rv32csr_cpu, CORE, csrrwi) };
+    sys_tbl[idx++] = {false, csrrsi_str,   RV32I_INSTR_FMT_I,   RV32I_CORE_HANDLER(rv32csr_cpu, CORE, csrrsi) };
+    sys_tbl[idx++] = {false, csrrci_str,   RV32I_INSTR_FMT_I,   RV32I_CORE_HANDLER(rv32csr_cpu, CORE, csrrci) };
 }
 
+// The Zicsr decode of the supported configurations' final classes (see rv32.h)
+template void rv32csr_cpu::init_csr_decode<rv32i_core>   ();
+template void rv32csr_cpu::init_csr_decode<rv32im_core>  ();
+template void rv32csr_cpu::init_csr_decode<rv32ima_core> ();
+template void rv32csr_cpu::init_csr_decode<rv32g_core>   ();
+
 // -----------------------------------------------------------
 // Reset
 // -----------------------------------------------------------
@@ -77,9 +184,11 @@ void rv32csr_cpu::reset()
 {
     rv32i_cpu::reset();
 
-    state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] = ~(RV32CSR_MIE_BITMASK | RV32CSR_MPRV_BITMASK);
+    state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] = ~(RV32CSR_MIE_BITMASK | RV32CSR_MPRV_BITMASK);
 
-    state.hart[curr_hart].csr[RV32CSR_ADDR_MCAUSE]  = 0;
+    state.hart[curr_hart].csr[RV32CSR_IDX_MCAUSE]  = 0;
+
+    state.hart[curr_hart].csr[RV32CSR_IDX_MHARTID] = hart_id;
 
 }
 
@@ -91,22 +200,22 @@ void rv32csr_cpu::process_trap(int trap_type)
 {
     uint32_t offset = 0;
 
-    state.hart[curr_hart].csr[RV32CSR_ADDR_MEPC]   = state.hart[curr_hart].pc;
-    state.hart[curr_hart].csr[RV32CSR_ADDR_MCAUSE] = trap_type;
+    state.hart[curr_hart].csr[RV32CSR_IDX_MEPC]   = state.hart[curr_hart].pc;
+    state.hart[curr_hart].csr[RV32CSR_IDX_MCAUSE] = trap_type;
 
     // Vol2: 3.1.17
     if (trap_type == RV32I_IADDR_MISALIGNED || trap_type == RV32I_LADDR_MISALIGNED ||
         trap_type == RV32I_ST_AMO_ADDR_MISALIGNED)
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_MTVAL] = get_last_access_addr();
+        state.hart[curr_hart].csr[RV32CSR_IDX_MTVAL] = get_last_access_addr();
     }
     else if (trap_type == RV32I_ILLEGAL_INSTR)
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_MTVAL] = get_curr_instruction();
+        state.hart[curr_hart].csr[RV32CSR_IDX_MTVAL] = get_curr_instruction();
     }
     else
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_MTVAL] = 0;
+        state.hart[curr_hart].csr[RV32CSR_IDX_MTVAL] = 0;
     }
 
     // If this is an asynchronous interrupt and MTVEC is in vectored mode,
@@ -115,81 +224,108 @@ void rv32csr_cpu::process_trap(int trap_type)
     {
         RV32I_DISASSEM_INT_PC_JUMP;
 
-        if ((state.hart[curr_hart].csr[RV32CSR_ADDR_MTVEC] & RV32CSR_MTVEC_MODE_MASK) == RV32CSR_MTVEC_MODE_VECTORED)
+        if ((state.hart[curr_hart].csr[RV32CSR_IDX_MTVEC] & RV32CSR_MTVEC_MODE_MASK) == RV32CSR_MTVEC_MODE_VECTORED)
         {
             offset = 4 * (trap_type & ~RV32CSR_MCAUSE_INT_MASK);
         }
     }
 
-    state.hart[curr_hart].pc = (state.hart[curr_hart].csr[RV32CSR_ADDR_MTVEC] & ~RV32CSR_MTVEC_MODE_MASK) + offset;
+    state.hart[curr_hart].pc = (state.hart[curr_hart].csr[RV32CSR_IDX_MTVEC] & ~RV32CSR_MTVEC_MODE_MASK) + offset;
 }
 
 int rv32csr_cpu::process_interrupts()
 {
-    bool fault;
+    // Firstly update pending statuses in the MIP CSR register for the
+    // event sources that are due
+
+    // If the interrupt callback is due, call it (if registered), and
+    // reschedule it for its requested wakeup time, which is the next
+    // cycle if it does not set one (i.e. it is polled)
+    if (event_due(RV32I_EVENT_INT_CALLBACK))
+    {
+        rv32i_time_t wakeup_time = (p_int_callback != NULL) ? clk_cycles() + 1 : RV32I_EVENT_NEVER;
+
+        if (p_int_callback != NULL)
+        {
+            // Update the MIP CSR MEIP bit with interrupt status
+            if ((*p_int_callback)(clk_cycles(), &wakeup_time))
+            {
+                state.hart[curr_hart].csr[RV32CSR_IDX_MIP] |= RV32CSR_MEIP_BITMASK;
+            }
+            else
+            {
+                state.hart[curr_hart].csr[RV32CSR_IDX_MIP] &= ~RV32CSR_MEIP_BITMASK;
+            }
+        }
 
-    // Firstly update pending statuses in the MIP CSR register
+        event_cycle[RV32I_EVENT_INT_CALLBACK] = wakeup_time;
+    }
 
-    // If an interrupt callback registered, call it if current cycle count
-    // at, or beyond, scheduled wakeup count.
-    if (p_int_callback != NULL && clk_cycles() >=  (uint32_t)interrupt_wakeup_time)
+    // If the timer is due, check it against the compare register. With virtual
+    // time the cycle at which mtime reaches mtimecmp is known, and the timer
+    // is next due then (or only when mtimecmp is written, if already reached).
+    // With real time it can't be scheduled exactly, and is checked again after
+    // a fixed number of cycles.
+    if (event_due(RV32I_EVENT_TIMER))
     {
-        // Update the MIP CSR MEIP bit with interrupt status
-        if ((*p_int_callback)(clk_cycles(), &interrupt_wakeup_time))
+        bool pending = (uint64_t)mtime() >= get_mtimecmp();
+
+        // If timer greater than compare register, set the pending bit, else clear it
+        if (pending)
         {
-            state.hart[curr_hart].csr[RV32CSR_ADDR_MIP] |= RV32CSR_MEIP_BITMASK;
+            state.hart[curr_hart].csr[RV32CSR_IDX_MIP] |= RV32CSR_MTIP_BITMASK;
         }
         else
         {
-            state.hart[curr_hart].csr[RV32CSR_ADDR_MIP] &= ~RV32CSR_MEIP_BITMASK;
+            state.hart[curr_hart].csr[RV32CSR_IDX_MIP] &= ~RV32CSR_MTIP_BITMASK;
         }
-    }
 
-    // Check timer compare
-    uint64_t mtimcmp = (uint64_t)read_mem(RV32I_RTCLOCK_CMP_ADDRESS, MEM_RD_ACCESS_WORD, fault) |
-                      ((uint64_t)read_mem(RV32I_RTCLOCK_CMP_ADDRESS + 4, MEM_RD_ACCESS_WORD, fault) << 32);
-
-    // If timer greater than compare register, set the pending bit, else clear it
-    if (real_time_us() >= mtimcmp)
-    {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_MIP] |= RV32CSR_MTIP_BITMASK;
-    }
-    else
-    {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_MIP] &= ~RV32CSR_MTIP_BITMASK;
+        if (virtual_time())
+        {
+            event_cycle[RV32I_EVENT_TIMER] = pending ? RV32I_EVENT_NEVER : mtime_cycle(get_mtimecmp());
+        }
+        else
+        {
+            event_cycle[RV32I_EVENT_TIMER] = clk_cycles() + RV32I_TIMER_POLL_CYCLES;
+        }
     }
 
+    // Pending statuses are now up to date, and are only re-evaluated when
+    // an event is next due
+    event_cycle[RV32I_EVENT_INT_UPDATE] = RV32I_EVENT_NEVER;
+    update_next_event();
+
     // Raise interrupts, depending on enable statuses
 
     // Check for global interrupt enable bit in mstatus before processing pending interrupts
-    if (state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] & RV32CSR_MIE_BITMASK)
+    if (state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] & RV32CSR_MIE_BITMASK)
     {
         // If external pending and enabled...
-        if ((state.hart[curr_hart].csr[RV32CSR_ADDR_MIE] & RV32CSR_MEIE_BITMASK) && (state.hart[curr_hart].csr[RV32CSR_ADDR_MIP] & RV32CSR_MEIP_BITMASK))
+        if ((state.hart[curr_hart].csr[RV32CSR_IDX_MIE] & RV32CSR_MEIE_BITMASK) && (state.hart[curr_hart].csr[RV32CSR_IDX_MIP] & RV32CSR_MEIP_BITMASK))
         {
             // Set MSTATUS MPIE and clear MIE
-            state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] |= RV32CSR_MPIE_BITMASK;
-            state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] &= ~RV32CSR_MIE_BITMASK;
+            state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] |= RV32CSR_MPIE_BITMASK;
+            state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] &= ~RV32CSR_MIE_BITMASK;
 
             process_trap(RV32CSR_INT_MEXT_CAUSE);
             return 1;
         }
         // Else if timer pending and enabled...
-        else if ((state.hart[curr_hart].csr[RV32CSR_ADDR_MIE] & RV32CSR_MTIE_BITMASK) && (state.hart[curr_hart].csr[RV32CSR_ADDR_MIP] & RV32CSR_MTIP_BITMASK))
+        else if ((state.hart[curr_hart].csr[RV32CSR_IDX_MIE] & RV32CSR_MTIE_BITMASK) && (state.hart[curr_hart].csr[RV32CSR_IDX_MIP] & RV32CSR_MTIP_BITMASK))
         {
             // Set MSTATUS MPIE and clear MIE
-            state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] |= RV32CSR_MPIE_BITMASK;
-            state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] &= ~RV32CSR_MIE_BITMASK;
+            state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] |= RV32CSR_MPIE_BITMASK;
+            state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] &= ~RV32CSR_MIE_BITMASK;
 
             process_trap(RV32CSR_INT_MTIM_CAUSE);
             return 1;
         }
         // else if software enabled and pending...
-        else if ((state.hart[curr_hart].csr[RV32CSR_ADDR_MIE] & RV32CSR_MSIE_BITMASK) && (state.hart[curr_hart].csr[RV32CSR_ADDR_MIP] & RV32CSR_MSIP_BITMASK))
+        else if ((state.hart[curr_hart].csr[RV32CSR_IDX_MIE] & RV32CSR_MSIE_BITMASK) && (state.hart[curr_hart].csr[RV32CSR_IDX_MIP] & RV32CSR_MSIP_BITMASK))
         {
             // Set MSTATUS MPIE and clear MIE
-            state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] |= RV32CSR_MPIE_BITMASK;
-            state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] &= ~RV32CSR_MIE_BITMASK;
+            state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] |= RV32CSR_MPIE_BITMASK;
+            state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] &= ~RV32CSR_MIE_BITMASK;
 
             process_trap(RV32CSR_INT_MSW_CAUSE);
             return 1;
@@ -215,6 +351,7 @@ uint32_t rv32csr_cpu::access_csr(const unsigned funct3, const uint32_t addr, con
 
     bool     unimplemented = false;
     uint32_t wr_mask;
+    uint32_t idx;
 
     // Check sufficient privilege level and register implemented
     if (state.priv_lvl < priv_reqd_level)
@@ -223,8 +360,15 @@ uint32_t rv32csr_cpu::access_csr(const unsigned funct3, const uint32_t addr, con
     }
     else
     {
-        // Fetch write mask (0 for read only reg), or flag as unimplemented CSR register
+        // Fetch write mask (0 for read only reg), or flag as unimplemented CSR register,
+        // which has no storage
         wr_mask = csr_wr_mask(addr, unimplemented);
+        idx     = csr_index.lookup(addr);
+
+        unimplemented |= (idx == RV32CSR_IDX_NONE);
+
+        // Any access to an unimplemented CSR register is illegal
+        error = unimplemented ? 1 : 0;
 
         // Read CSR registers
         if (rd && !unimplemented)
@@ -232,10 +376,10 @@ uint32_t rv32csr_cpu::access_csr(const unsigned funct3, const uint32_t addr, con
             prev_rd_value = state.hart[curr_hart].x[rd];
 
             // Take this opportunity to update the cycle count registers
-            state.hart[curr_hart].csr[RV32CSR_ADDR_MCYCLE]  = clk_cycles() & 0xffffffff;
-            state.hart[curr_hart].csr[RV32CSR_ADDR_MCYCLEH] = (clk_cycles() >> 32) & 0xffffffff;
+            state.hart[curr_hart].csr[RV32CSR_IDX_MCYCLE]  = clk_cycles() & 0xffffffff;
+            state.hart[curr_hart].csr[RV32CSR_IDX_MCYCLEH] = (clk_cycles() >> 32) & 0xffffffff;
 
-            state.hart[curr_hart].x[rd] = state.hart[curr_hart].csr[addr & 0xfff];
+            state.hart[curr_hart].x[rd] = state.hart[curr_hart].csr[idx];
         }
 
         // Write to CSR registers
@@ -255,16 +399,19 @@ uint32_t rv32csr_cpu::access_csr(const unsigned funct3, const uint32_t addr, con
 
                 if (RV32CSR_OP_RW(funct3))
                 {
-                    state.hart[curr_hart].csr[addr & 0xfff] = value & wr_mask;
+                    state.hart[curr_hart].csr[idx] = value & wr_mask;
                 }
                 else if (RV32CSR_OP_RS(funct3))
                 {
-                    state.hart[curr_hart].csr[addr & 0xfff] |= (value & wr_mask);
+                    state.hart[curr_hart].csr[idx] |= (value & wr_mask);
                 }
                 else if (RV32CSR_OP_RC(funct3))
                 {
-                    state.hart[curr_hart].csr[addr & 0xfff] &= ~(value & wr_mask);
+                    state.hart[curr_hart].csr[idx] &= ~(value & wr_mask);
                 }
+
+                // The write may have enabled a pending interrupt
+                schedule_event(RV32I_EVENT_INT_UPDATE, clk_cycles());
             }
             // Attempted to write to a read only or unimplemented CSR register
             else
@@ -282,6 +429,23 @@ uint32_t rv32csr_cpu::access_csr(const unsigned funct3, const uint32_t addr, con
     return error;
 }
 
+// Return the storage index of an implemented CSR, or -1
+int rv32csr_cpu::csr_storage_index(const uint32_t addr)
+{
+    bool     unimp;
+    uint32_t idx = csr_index.lookup(addr);
+
+    csr_wr_mask(addr & 0xfff, unimp);
+
+    return (unimp || idx == RV32CSR_IDX_NONE) ? -1 : (int)idx;
+}
+
+// Return the address of the CSR at a storage index, or -1 if not implemented
+int rv32csr_cpu::csr_storage_addr(const uint32_t idx)
+{
+    return (idx < RV32I_NUM_OF_CSRS && csr_storage_index(csr_index.addr[idx]) == (int)idx) ? csr_index.addr[idx] : -1;
+}
+
 // Return write mask (bit set equals writable) for given CSR
 uint32_t rv32csr_cpu::csr_wr_mask(const uint32_t addr, bool &unimp)
 {
@@ -368,61 +532,67 @@ uint32_t rv32csr_cpu::csr_wr_mask(const uint32_t addr, bool &unimp)
 // -----------------------------------------------------------
 // Zicsr instructions
 //
+template <class CORE, bool TRACE>
 void rv32csr_cpu::csrrw(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_ICSR_TYPE(d->instr, d->entry.instr_name, d->rd, d->imm_i & BIT12_MASK, d->rs1);
+    RV32I_DISASSEM_ICSR_TYPE(d->instr, instr_name(d), d->rd, d->imm_i & BIT12_MASK, d->rs1);
 
-    if (disassemble || !access_csr(d->funct3, d->imm_i & BIT12_MASK, d->rd, d->rs1))
+    if (RV32I_DISASSEM_ONLY || !static_cast<CORE*>(this)->core_access_csr(d->funct3, d->imm_i & BIT12_MASK, d->rd, d->rs1))
     {
         increment_pc();
     }
 }
 
+template <class CORE, bool TRACE>
 void rv32csr_cpu::csrrs(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_ICSR_TYPE(d->instr, d->entry.instr_name, d->rd, d->imm_i & BIT12_MASK, d->rs1);
+    RV32I_DISASSEM_ICSR_TYPE(d->instr, instr_name(d), d->rd, d->imm_i & BIT12_MASK, d->rs1);
 
-    if (disassemble || !access_csr(d->funct3, d->imm_i & BIT12_MASK, d->rd, d->rs1))
+    if (RV32I_DISASSEM_ONLY || !static_cast<CORE*>(this)->core_access_csr(d->funct3, d->imm_i & BIT12_MASK, d->rd, d->rs1))
     {
         increment_pc();
     }
 }
 
+template <class CORE, bool TRACE>
 void rv32csr_cpu::csrrc(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_ICSR_TYPE(d->instr, d->entry.instr_name, d->rd, d->imm_i & BIT12_MASK, d->rs1);
+    RV32I_DISASSEM_ICSR_TYPE(d->instr, instr_name(d), d->rd, d->imm_i & BIT12_MASK, d->rs1);
 
-    if (disassemble || !access_csr(d->funct3, d->imm_i & BIT12_MASK, d->rd, d->rs1))
+    if (RV32I_DISASSEM_ONLY || !static_cast<CORE*>(this)->core_access_csr(d->funct3, d->imm_i & BIT12_MASK, d->rd, d->rs1))
     {
         increment_pc();
     }
 }
 
+template <class CORE, bool TRACE>
 void rv32csr_cpu::csrrwi(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_ICSRI_TYPE(d->instr, d->entry.instr_name, d->rd, d->imm_i & BIT12_MASK, d->rs1);
+    RV32I_DISASSEM_ICSRI_TYPE(d->instr, instr_name(d), d->rd, d->imm_i & BIT12_MASK, d->rs1);
 
-    if (disassemble || !access_csr(d->funct3, d->imm_i & BIT12_MASK, d->rd, d->rs1))
+    if (RV32I_DISASSEM_ONLY || !static_cast<CORE*>(this)->core_access_csr(d->funct3, d->imm_i & BIT12_MASK, d->rd, d->rs1))
     {
         increment_pc();
     }
 }
 
+template <class CORE, bool TRACE>
 void rv32csr_cpu::csrrsi(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_ICSRI_TYPE(d->instr, d->entry.instr_name, d->rd, d->imm_i & BIT12_MASK, d->rs1);
+    RV32I_DISASSEM_ICSRI_TYPE(d->instr, instr_name(d), d->rd, d->imm_i & BIT12_MASK, d->rs1);
 
-    if (disassemble || !access_csr(d->funct3, d->imm_i & BIT12_MASK, d->rd, d->rs1))
+    if (RV32I_DISASSEM_ONLY || !static_cast<CORE*>(this)->core_access_csr(d->funct3, d->imm_i & BIT12_MASK, d->rd, d->rs1))
     {
         increment_pc();
     }
 }
 
+template <class CORE, bool TRACE>
 void rv32csr_cpu::csrrci(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_ICSRI_TYPE(d->instr, d->entry.instr_name, d->rd, d->imm_i & BIT12_MASK, d->rs1);
+    RV32I_DISASSEM_ICSRI_TYPE(d->instr, instr_name(d), d->rd, d->imm_i & BIT12_MASK, d->rs1);
 
-    if (disassemble || !access_csr(d->funct3, d->imm_i & BIT12_MASK, d->rd, d->rs1))
+    if (RV32I_DISASSEM_ONLY || !static_cast<CORE*>(this)->core_access_csr(d->funct3, d->imm_i & BIT12_MASK, d->rd, d->rs1))
     {
         increment_pc();
     }
@@ -432,18 +602,22 @@ void rv32csr_cpu::csrrci(const p_rv32i_decode_t d)
 // System instructions
 //
 
+template <bool TRACE>
 void rv32csr_cpu::mret(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_SYS_TYPE(d->instr, d->entry.instr_name);
+    RV32I_DISASSEM_SYS_TYPE(d->instr, instr_name(d));
     RV32I_DISASSEM_PC_JUMP;
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         // Set MSTATUS MIE to MPIE
-        state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] &= ~RV32CSR_MIE_BITMASK;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] |= (state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] & RV32CSR_MPIE_BITMASK) ? RV32CSR_MIE_BITMASK : 0;
+        state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] &= ~RV32CSR_MIE_BITMASK;
+        state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] |= (state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] & RV32CSR_MPIE_BITMASK) ? RV32CSR_MIE_BITMASK : 0;
+
+        state.hart[curr_hart].pc = state.hart[curr_hart].csr[RV32CSR_IDX_MEPC];
 
-        state.hart[curr_hart].pc = state.hart[curr_hart].csr[RV32CSR_ADDR_MEPC];
+        // Interrupts may now be re-enabled, with one pending
+        schedule_event(RV32I_EVENT_INT_UPDATE, clk_cycles());
     }
     else
     {
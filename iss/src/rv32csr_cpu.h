@@ -27,17 +27,23 @@
 #ifndef _RV32CSR_CPU_H_
 #define _RV32CSR_CPU_H_
 
-#include "rv32_extensions.h"
 #include "rv32csr_cpu_hdr.h"
-#include RV32CSR_INCLUDE
+#include "rv32i_cpu.h"
 
-class rv32csr_cpu : public RV32_ZICSR_INHERITANCE_CLASS
+class rv32csr_cpu : public rv32i_cpu
 {
 public:
              LIBRISCV32_API      rv32csr_cpu      (FILE* dbgfp = stdout);
     virtual  LIBRISCV32_API      ~rv32csr_cpu()   { };
 
-    LIBRISCV32_API void          register_int_callback          (p_rv32i_intcallback_t callback_func) { p_int_callback = callback_func; };
+    LIBRISCV32_API void          register_int_callback          (p_rv32i_intcallback_t callback_func) { p_int_callback = callback_func; schedule_event(RV32I_EVENT_INT_CALLBACK, clk_cycles()); };
+
+    // Call the interrupt callback before the next instruction, for an interrupt state
+    // change not seen by this core's own memory writes (e.g. by another hart's)
+    LIBRISCV32_API void          update_int_callback            (void) { schedule_event(RV32I_EVENT_INT_CALLBACK, clk_cycles()); };
+
+    // Set the hart ID read from mhartid (default 0), for each core of a multiprocessor
+    LIBRISCV32_API void          set_hart_id                    (const uint32_t id) { hart_id = id; state.hart[curr_hart].csr[RV32CSR_IDX_MHARTID] = id; };
 
 private:
     // ------------------------------------------------
@@ -47,15 +53,16 @@ private:
     // Pointer to interrupt callback function
     p_rv32i_intcallback_t p_int_callback;
 
-    rv32i_time_t          interrupt_wakeup_time;
+    // Hart ID, as returned by mhartid
+    uint32_t              hart_id;
 
-    const char mret_str    [DISASSEM_STR_SIZE] = "mret     ";
-    const char csrrw_str   [DISASSEM_STR_SIZE] = "csrrw    ";
-    const char csrrs_str   [DISASSEM_STR_SIZE] = "csrrs    ";
-    const char csrrc_str   [DISASSEM_STR_SIZE] = "csrrc    ";
-    const char csrrwi_str  [DISASSEM_STR_SIZE] = "csrrwi   ";
-    const char csrrsi_str  [DISASSEM_STR_SIZE] = "csrrsi   ";
-    const char csrrci_str  [DISASSEM_STR_SIZE] = "csrrci   ";
+    static constexpr char mret_str    [] = "mret     ";
+    static constexpr char csrrw_str   [] = "csrrw    ";
+    static constexpr char csrrs_str   [] = "csrrs    ";
+    static constexpr char csrrc_str   [] = "csrrc    ";
+    static constexpr char csrrwi_str  [] = "csrrwi   ";
+    static constexpr char csrrsi_str  [] = "csrrsi   ";
+    static constexpr char csrrci_str  [] = "csrrci   ";
 
     // ------------------------------------------------
     // Private member functions
@@ -64,30 +71,50 @@ private:
     // Overloaded reset function
     void reset                           (void);
 
+    // Return from trap instruction
+    template <bool TRACE> void mret      (const p_rv32i_decode_t);
+
+    // Zicsr instructions, calling the CSR access hook of a core class (CORE)
+    template <class CORE, bool TRACE> void csrrw  (const p_rv32i_decode_t);
+    template <class CORE, bool TRACE> void csrrs  (const p_rv32i_decode_t);
+    template <class CORE, bool TRACE> void csrrc  (const p_rv32i_decode_t);
+    template <class CORE, bool TRACE> void csrrwi (const p_rv32i_decode_t);
+    template <class CORE, bool TRACE> void csrrsi (const p_rv32i_decode_t);
+    template <class CORE, bool TRACE> void csrrci (const p_rv32i_decode_t);
+
+    // Hook called by the Zicsr instructions for a core class (CORE) of
+    // rv32csr_cpu itself, so through the virtual method. The final
+    // rv32_core<> class hides this with a statically bound call.
+    uint32_t core_access_csr             (const unsigned funct3, const uint32_t addr, const uint32_t rd, const uint32_t value)
+    {
+        return access_csr(funct3, addr, rd, value);
+    }
+
+protected:
     // Overload processing of traps
     void process_trap(int trap_type);
 
     // Process interrupts
     int  process_interrupts();
 
-    // Return from trap instruction
-    void mret                            (const p_rv32i_decode_t);
-
-    // Zicsr instructions
-    void csrrw                           (const p_rv32i_decode_t);
-    void csrrs                           (const p_rv32i_decode_t);
-    void csrrc                           (const p_rv32i_decode_t);
-    void csrrwi                          (const p_rv32i_decode_t);
-    void csrrsi                          (const p_rv32i_decode_t);
-    void csrrci                          (const p_rv32i_decode_t);
-
-protected:
     // CSR access method
     virtual uint32_t access_csr          (const unsigned funct3, const uint32_t addr, const uint32_t rd, const uint32_t value);
 
     // Return write mask (bit set equals writable) for given CSR, with unimplemented status flag
     virtual uint32_t csr_wr_mask         (const uint32_t addr, bool& unimp);
 
+    // Map between CSR addresses and storage indices
+    virtual int      csr_storage_index   (const uint32_t addr);
+    virtual int      csr_storage_addr    (const uint32_t idx);
+
+    // Add the Zicsr and MRET instructions to the decode tables
+    virtual void     init_decode_tables  (void);
+
+    // Point the Zicsr instructions' decode table entries at those for a core
+    // class (CORE). Each final rv32_core<> class is instantiated in rv32csr_cpu.cpp.
+    template <class CORE>
+    void             init_csr_decode     (void);
+
 };
 
 #endif
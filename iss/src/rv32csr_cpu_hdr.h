@@ -232,6 +232,43 @@
 #define RV32CSR_ADDR_DSCRATCH0                         0x7B2
 #define RV32CSR_ADDR_DSCRATCH1                         0x7B3
 
+// CSR storage indices of the implemented CSRs (see RV32I_NUM_OF_CSRS),
+// with an index of RV32CSR_IDX_NONE for an unimplemented CSR address
+#define RV32CSR_IDX_FFLAGS                             0
+#define RV32CSR_IDX_FRM                                1
+#define RV32CSR_IDX_FCSR                               2
+#define RV32CSR_IDX_MSTATUS                            3
+#define RV32CSR_IDX_MISA                               4
+#define RV32CSR_IDX_MIE                                5
+#define RV32CSR_IDX_MTVEC                              6
+#define RV32CSR_IDX_MEPC                               7
+#define RV32CSR_IDX_MCAUSE                             8
+#define RV32CSR_IDX_MTVAL                              9
+#define RV32CSR_IDX_MIP                                10
+#define RV32CSR_IDX_MCYCLE                             11
+#define RV32CSR_IDX_MCYCLEH                            12
+#define RV32CSR_IDX_MINSTRET                           13
+#define RV32CSR_IDX_MINSTRETH                          14
+#define RV32CSR_IDX_MSCRATCH                           15
+#define RV32CSR_IDX_MCOUNTEREN                         16
+#define RV32CSR_IDX_MCOUNTINHIBIT                      17
+#define RV32CSR_IDX_MVENDORID                          18
+#define RV32CSR_IDX_MARCHID                            19
+#define RV32CSR_IDX_MIMPID                             20
+#define RV32CSR_IDX_MHARTID                            21
+#define RV32CSR_IDX_PMPCFG0                            22     /* to 25 for PMPCFG3 */
+#define RV32CSR_IDX_PMPADDR0                           26     /* to 41 for PMPADDR15 */
+#define RV32CSR_IDX_MHPMCOUNTER3                       42     /* to 70 for MHPMCOUNTER31 */
+#define RV32CSR_IDX_MHPMCOUNTER3H                      71     /* to 99 for MHPMCOUNTER31H */
+#define RV32CSR_IDX_MHPMEVENT3                         100    /* to 128 for MHPMEVENT31 */
+#define RV32CSR_IDX_NONE                               0xff
+
+// CSR address to storage index lookup table geometry, with addresses split into
+// a block number (the top 8 bits) and a 16 entry block index
+#define RV32CSR_IDX_BLK_BITS                           4
+#define RV32CSR_IDX_BLK_SIZE                           (1 << RV32CSR_IDX_BLK_BITS)
+#define RV32CSR_IDX_MAX_BLKS                           16
+
 // CSR write masks (from perspective of CSR instructions)
 #define RV32CSR_MISA_WR_MASK                           0x00000000 /* can't update in this implementation */
 #define RV32CSR_MSTATUS_WR_MASK                        0x00000008
@@ -25,25 +25,41 @@
 //
 //=============================================================
 
-#include "rv32d_cpu.h"
+#include "rv32_extensions.h"
 
 // -----------------------------------------------------------
 // Constructor
 // -----------------------------------------------------------
 
-rv32d_cpu::rv32d_cpu(FILE* dbgfp) : RV32_D_INHERITANCE_CLASS(dbgfp)
+template <class BASE>
+rv32d_cpu<BASE>::rv32d_cpu(FILE* dbgfp) : BASE(dbgfp)
 {
-    int idx;
-
     // Advertise 'F' extensions
-    state.hart[curr_hart].csr[RV32CSR_ADDR_MISA]   |=  RV32CSR_EXT_D;
+    state.hart[curr_hart].csr[RV32CSR_IDX_MISA]   |=  RV32CSR_EXT_D;
 
     // Initialise FS field to Initial
-    state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] = RV32CSR_MSTATUS_FS_INITIAL;
+    state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] = RV32CSR_MSTATUS_FS_INITIAL;
 
     curr_rnd_method = RV32I_RMM;
     fesetround(FE_TONEAREST);
     feclearexcept(FE_ALL_EXCEPT);
+}
+
+// -----------------------------------------------------------
+// Decode table set up
+// -----------------------------------------------------------
+
+template <class BASE>
+void rv32d_cpu<BASE>::init_decode_tables()
+{
+    int idx;
+
+    BASE::init_decode_tables();
+
+    fsgnjd_tbl   = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    fminmaxd_tbl = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    fcmpd_tbl    = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    fclassd_tbl  = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
 
     // Quarternary tables for floating point, decoded in funct3.
     // For OP-FP instructions not using 'rm' field in funct3 place.
@@ -51,71 +67,71 @@ rv32d_cpu::rv32d_cpu(FILE* dbgfp) : RV32_D_INHERITANCE_CLASS(dbgfp)
     // Initialise quarternary table to reserved instruction method
     for (int i = 0; i < RV32I_NUM_SECONDARY_OPCODES; i++)
     {
-        fsgnjd_tbl[i]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};
-        fminmaxd_tbl[i] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};
-        fclassd_tbl[i]  = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};
-        fcmpd_tbl[i]    = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};
+        fsgnjd_tbl[i]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved)};
+        fminmaxd_tbl[i] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved)};
+        fclassd_tbl[i]  = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved)};
+        fcmpd_tbl[i]    = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved)};
     }
 
     // Setup quarternary tables (decoded on funct3 via decode_exception method)
     idx = 0;
-    fsgnjd_tbl[idx++]   = { false, fsgnjd_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fsgnjd };
-    fsgnjd_tbl[idx++]   = { false, fsgnjnd_str, RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fsgnjnd };
-    fsgnjd_tbl[idx++]   = { false, fsgnjxd_str, RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fsgnjxd };
+    fsgnjd_tbl[idx++]   = { false, fsgnjd_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fsgnjd)  };
+    fsgnjd_tbl[idx++]   = { false, fsgnjnd_str, RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fsgnjnd) };
+    fsgnjd_tbl[idx++]   = { false, fsgnjxd_str, RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fsgnjxd) };
 
     idx = 0;
-    fminmaxd_tbl[idx++] = { false, fmind_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fmind };
-    fminmaxd_tbl[idx++] = { false, fmaxd_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fmaxd };
+    fminmaxd_tbl[idx++] = { false, fmind_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fmind) };
+    fminmaxd_tbl[idx++] = { false, fmaxd_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fmaxd) };
 
-    fclassd_tbl[0x01]   = { false, fclassd_str, RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fclassd };
+    fclassd_tbl[0x01]   = { false, fclassd_str, RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fclassd) };
 
     idx = 0;
-    fcmpd_tbl[idx++]     = { false, fled_str,    RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fled };
-    fcmpd_tbl[idx++]     = { false, fltd_str,    RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fltd };
-    fcmpd_tbl[idx++]     = { false, feqd_str,    RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::feqd };
+    fcmpd_tbl[idx++]     = { false, fled_str,    RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fled) };
+    fcmpd_tbl[idx++]     = { false, fltd_str,    RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fltd) };
+    fcmpd_tbl[idx++]     = { false, feqd_str,    RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, feqd) };
 
     // Tertiary table for OP-FP
-    fs_tbl[0x01]        = { false, faddd_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::faddd };
-    fs_tbl[0x05]        = { false, fsubd_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fsubd };
-    fs_tbl[0x09]        = { false, fmuld_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fmuld };
-    fs_tbl[0x0d]        = { false, fdivd_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fdivd };
-    fs_tbl[0x2d]        = { false, fsqrtd_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fsqrtd };
+    fs_tbl[0x01]        = { false, faddd_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, faddd)  };
+    fs_tbl[0x05]        = { false, fsubd_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fsubd)  };
+    fs_tbl[0x09]        = { false, fmuld_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fmuld)  };
+    fs_tbl[0x0d]        = { false, fdivd_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fdivd)  };
+    fs_tbl[0x2d]        = { false, fsqrtd_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fsqrtd) };
     INIT_TBL_WITH_SUBTBL(fs_tbl[0x11], fsgnjd_tbl);
     INIT_TBL_WITH_SUBTBL(fs_tbl[0x15], fminmaxd_tbl);
-    fs_tbl[0x61]        = { false, fcvtwd_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fcvtwd };  // FCVT.W.D and FCVT.WU.D
+    fs_tbl[0x61]        = { false, fcvtwd_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fcvtwd) };    // FCVT.W.D and FCVT.WU.D
     INIT_TBL_WITH_SUBTBL(fs_tbl[0x71], fclassd_tbl);
     INIT_TBL_WITH_SUBTBL(fs_tbl[0x51], fcmpd_tbl);
-    fs_tbl[0x69]        = { false, fcvtdw_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fcvtdw };  // FCVT.D.W and FCVT.D.WU
+    fs_tbl[0x69]        = { false, fcvtdw_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fcvtdw) };    // FCVT.D.W and FCVT.D.WU
 
-    fs_tbl[0x20]        = { false, fcvtsd_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fcvtsd };
-    fs_tbl[0x21]        = { false, fcvtds_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32d_cpu::fcvtds };
+    fs_tbl[0x20]        = { false, fcvtsd_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fcvtsd) };
+    fs_tbl[0x21]        = { false, fcvtds_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32d_cpu, fcvtds) };
 
     // Update the primary table for non OP-FP RV32D instructions, overriding
-    // the entries set by rv32f_cpu class (if present). The D instrcutions
-    // do final decode, and call single precision methods, if available (else reserved).
-    primary_tbl[0x01]  = {false, fld_str,          RV32I_INSTR_FMT_I, (pFunc_t)&rv32d_cpu::fld};      //LOAD-FP
-    primary_tbl[0x09]  = {false, fsd_str,          RV32I_INSTR_FMT_S, (pFunc_t)&rv32d_cpu::fsd};      //STORE-FP
+    // the entries set by the rv32f_cpu class it extends. The D instrcutions
+    // do final decode, and call the single precision methods for .S instructions.
+    primary_tbl[0x01]  = {false, fld_str,          RV32I_INSTR_FMT_I, RV32I_HANDLER(rv32d_cpu, fld)};    //LOAD-FP
+    primary_tbl[0x09]  = {false, fsd_str,          RV32I_INSTR_FMT_S, RV32I_HANDLER(rv32d_cpu, fsd)};    //STORE-FP
 
     idx = 0x10;
-    primary_tbl[idx++] = {false, fmaddd_str,       RV32I_INSTR_FMT_R4, (pFunc_t)&rv32d_cpu::fmaddd};  //MADD (both .S and .D)
-    primary_tbl[idx++] = {false, fmsubd_str,       RV32I_INSTR_FMT_R4, (pFunc_t)&rv32d_cpu::fmsubd};  //MSUB (both .S and .D)
-    primary_tbl[idx++] = {false, fnmsubd_str,      RV32I_INSTR_FMT_R4, (pFunc_t)&rv32d_cpu::fnmsubd}; //NMSUB (both .S and .D)
-    primary_tbl[idx++] = {false, fnmaddd_str,      RV32I_INSTR_FMT_R4, (pFunc_t)&rv32d_cpu::fnmaddd}; //NMADD (both .S and .D)
+    primary_tbl[idx++] = {false, fmaddd_str,       RV32I_INSTR_FMT_R4, RV32I_HANDLER(rv32d_cpu, fmaddd) };    //MADD (both .S and .D)
+    primary_tbl[idx++] = {false, fmsubd_str,       RV32I_INSTR_FMT_R4, RV32I_HANDLER(rv32d_cpu, fmsubd) };    //MSUB (both .S and .D)
+    primary_tbl[idx++] = {false, fnmsubd_str,      RV32I_INSTR_FMT_R4, RV32I_HANDLER(rv32d_cpu, fnmsubd)};    //NMSUB (both .S and .D)
+    primary_tbl[idx++] = {false, fnmaddd_str,      RV32I_INSTR_FMT_R4, RV32I_HANDLER(rv32d_cpu, fnmaddd)};    //NMADD (both .S and .D)
 
     INIT_TBL_WITH_SUBTBL(primary_tbl[idx], fsop_tbl); idx++;
-
 }
 
 // -----------------------------------------------------------
 // Floating point CSR register access methods
 // -----------------------------------------------------------
 
-uint32_t rv32d_cpu::access_csr(const unsigned funct3, const uint32_t addr, const uint32_t rd, const uint32_t rs1_uimm)
+template <class BASE>
+uint32_t rv32d_cpu<BASE>::access_csr(const unsigned funct3, const uint32_t addr, const uint32_t rd, const uint32_t rs1_uimm)
 {
     uint32_t error = 0;
     
     // Call parent class's access_csr function.
-    if (!(error = RV32_F_INHERITANCE_CLASS::access_csr(funct3, addr, rd, rs1_uimm)))
+    if (!(error = BASE::access_csr(funct3, addr, rd, rs1_uimm)))
     {
         // If no error, check if access was to floating point CSRs. Since FRM and FFLAGS are
         // copies of FCSR fields, if any are updated, the relevant other registers need
@@ -124,16 +140,16 @@ uint32_t rv32d_cpu::access_csr(const unsigned funct3, const uint32_t addr, const
         switch (addr)
         {
         case RV32CSR_ADDR_FFLAGS:
-            state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   = (state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   & ~RV32CSR_FFLAGS_WR_MASK) |
-                                                             (state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] & RV32CSR_FFLAGS_WR_MASK);
+            state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   = (state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   & ~RV32CSR_FFLAGS_WR_MASK) |
+                                                             (state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] & RV32CSR_FFLAGS_WR_MASK);
             break;
         case RV32CSR_ADDR_FRM:
-            state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   = (state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR] & ~(RV32CSR_FRM_WR_MASK << 5)) | 
-                                                             ((state.hart[curr_hart].csr[RV32CSR_ADDR_FRM] & RV32CSR_FRM_WR_MASK ) << 5);
+            state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   = (state.hart[curr_hart].csr[RV32CSR_IDX_FCSR] & ~(RV32CSR_FRM_WR_MASK << 5)) | 
+                                                             ((state.hart[curr_hart].csr[RV32CSR_IDX_FRM] & RV32CSR_FRM_WR_MASK ) << 5);
             break;
         case RV32CSR_ADDR_FCSR:
-            state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] =  state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR] & RV32CSR_FFLAGS_WR_MASK;
-            state.hart[curr_hart].csr[RV32CSR_ADDR_FRM]    = (state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR] >> 5) & RV32CSR_FRM_WR_MASK;
+            state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] =  state.hart[curr_hart].csr[RV32CSR_IDX_FCSR] & RV32CSR_FFLAGS_WR_MASK;
+            state.hart[curr_hart].csr[RV32CSR_IDX_FRM]    = (state.hart[curr_hart].csr[RV32CSR_IDX_FCSR] >> 5) & RV32CSR_FRM_WR_MASK;
             break;
         default:
             break;
@@ -147,10 +163,11 @@ uint32_t rv32d_cpu::access_csr(const unsigned funct3, const uint32_t addr, const
 // Overloaded CSR write mask method
 // -----------------------------------------------------------
 
-uint32_t rv32d_cpu::csr_wr_mask(const uint32_t addr, bool& unimp)
+template <class BASE>
+uint32_t rv32d_cpu<BASE>::csr_wr_mask(const uint32_t addr, bool& unimp)
 {
     // Offer the access to the ancestor classes first
-    uint32_t mask =  RV32_F_INHERITANCE_CLASS::csr_wr_mask(addr, unimp);
+    uint32_t mask =  BASE::csr_wr_mask(addr, unimp);
 
     // If not implemented in the parent classes, decode here
     if (unimp)
@@ -191,11 +208,12 @@ uint32_t rv32d_cpu::csr_wr_mask(const uint32_t addr, bool& unimp)
 // RV32F floating point control and exception methods
 // -----------------------------------------------------------
 
-void rv32d_cpu::update_rm(int req_rnd_method)
+template <class BASE>
+void rv32d_cpu<BASE>::update_rm(int req_rnd_method)
 {
     // If requested method is dynamic, get dynamic setting from FRM,
     // else use argument value.
-    int rnd_method = (req_rnd_method == RV32I_DYN) ? state.hart->csr[RV32CSR_ADDR_FRM] : 
+    int rnd_method = (req_rnd_method == RV32I_DYN) ? state.hart->csr[RV32CSR_IDX_FRM] : 
                                                      req_rnd_method;
 
     // Only set if there's a change.
@@ -225,39 +243,40 @@ void rv32d_cpu::update_rm(int req_rnd_method)
     }
 }
 
-void rv32d_cpu::handle_fexceptions()
+template <class BASE>
+void rv32d_cpu<BASE>::handle_fexceptions()
 {
     // Update the CSR status, mapping from underlying exception
     // values to the flags in FCSR and FFLAGS.
 
     if (fetestexcept(FE_INVALID))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NV;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
     }
 
     if (fetestexcept(FE_OVERFLOW))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_OF;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_OF;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_OF;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_OF;
     }
 
     if (fetestexcept(FE_DIVBYZERO))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_DZ;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_DZ;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_DZ;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_DZ;
     }
 
     if (fetestexcept(FE_UNDERFLOW))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_UF;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_UF;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_UF;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_UF;
     }
 
     if (fetestexcept(FE_INEXACT))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NX;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NX;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NX;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NX;
     }
 
     feclearexcept(FE_ALL_EXCEPT);
@@ -267,23 +286,21 @@ void rv32d_cpu::handle_fexceptions()
 // RV32F instruction methods
 // -----------------------------------------------------------
 
-void rv32d_cpu::fld(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fld(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
     if (d->funct3 != 0x3)
     {
-#if RV32_D_INHERITANCE_CLASS == rv32f_cpu
-        RV32_D_INHERITANCE_CLASS::flw(d);
-#else
-        reserved(d);
-#endif
+        BASE::template flw<TRACE>(d);
     }
     else
     {
-        RV32I_DISASSEM_IFS_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+        RV32I_DISASSEM_IFS_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
 
-        if (!disassemble)
+        if (!RV32I_DISASSEM_ONLY)
         {
             access_addr = state.hart[curr_hart].x[d->rs1] + d->imm_i;
 
@@ -303,26 +320,24 @@ void rv32d_cpu::fld(const p_rv32i_decode_t d)
     }
 }
 
-void rv32d_cpu::fsd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fsd(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
     if (d->funct3 != 0x3)
     {
-#if RV32_D_INHERITANCE_CLASS == rv32f_cpu
-        RV32_D_INHERITANCE_CLASS::fsw(d);
-#else
-        reserved(d);
-#endif
+        BASE::template fsw<TRACE>(d);
     }
     else
     {
-        RV32I_DISASSEM_SFS_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+        RV32I_DISASSEM_SFS_TYPE(d->instr, instr_name(d), d->rs1, d->rs2, d->imm_s);
 
-        if (!disassemble)
+        if (!RV32I_DISASSEM_ONLY)
         {
             // Enabling stores only when MSTATUS FS bits != 0 (off)
-            if (state.hart->csr[RV32CSR_ADDR_MSTATUS] & RV32CSR_MSTATUS_FS_MASK)
+            if (state.hart->csr[RV32CSR_IDX_MSTATUS] & RV32CSR_MSTATUS_FS_MASK)
             {
                 access_addr = state.hart[curr_hart].x[d->rs1] + d->imm_s;
 
@@ -338,19 +353,17 @@ void rv32d_cpu::fsd(const p_rv32i_decode_t d)
     }
 }
 
-void rv32d_cpu::fmaddd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fmaddd(const p_rv32i_decode_t d)
 {
     if (!(d->funct7 & BIT2_MASK))
     {
-#if RV32_D_INHERITANCE_CLASS == rv32f_cpu
-        RV32_D_INHERITANCE_CLASS::fmadds(d);
-#else
-        reserved(d);
-#endif
+        BASE::template fmadds<TRACE>(d);
     }
     else
     {
-        RV32I_DISASSEM_R4_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2, ((d->imm_s >> 2) & BIT5_MASK));
+        RV32I_DISASSEM_R4_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2, (d->funct7 >> 2));
 
         double rd_val;
 
@@ -378,19 +391,17 @@ void rv32d_cpu::fmaddd(const p_rv32i_decode_t d)
     }
 }
 
-void rv32d_cpu::fmsubd (const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fmsubd (const p_rv32i_decode_t d)
 {
     if (!(d->funct7 & BIT2_MASK))
     {
-#if RV32_D_INHERITANCE_CLASS == rv32f_cpu
-        RV32_D_INHERITANCE_CLASS::fmsubs(d);
-#else
-        reserved(d);
-#endif
+        BASE::template fmsubs<TRACE>(d);
     }
     else
     {
-        RV32I_DISASSEM_R4_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2, ((d->imm_s >> 2) & BIT5_MASK));
+        RV32I_DISASSEM_R4_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2, (d->funct7 >> 2));
 
         update_rm(d->funct3);
 
@@ -418,19 +429,17 @@ void rv32d_cpu::fmsubd (const p_rv32i_decode_t d)
     }
 }
 
-void rv32d_cpu::fnmsubd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fnmsubd(const p_rv32i_decode_t d)
 {
     if (!(d->funct7 & BIT2_MASK))
     {
-#if RV32_D_INHERITANCE_CLASS == rv32f_cpu
-        RV32_D_INHERITANCE_CLASS::fnmsubs(d);
-#else
-        reserved(d);
-#endif
+        BASE::template fnmsubs<TRACE>(d);
     }
     else
     {
-        RV32I_DISASSEM_R4_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2, ((d->imm_s >> 2) & BIT5_MASK));
+        RV32I_DISASSEM_R4_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2, (d->funct7 >> 2));
 
         double rd_val;
         double rs1_val = map_uint_to_double(state.hart[curr_hart].f[d->rs1]);
@@ -456,19 +465,17 @@ void rv32d_cpu::fnmsubd(const p_rv32i_decode_t d)
     }
 }
 
-void rv32d_cpu::fnmaddd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fnmaddd(const p_rv32i_decode_t d)
 {
     if (!(d->funct7 & BIT2_MASK))
     {
-#if RV32_D_INHERITANCE_CLASS == rv32f_cpu
-        RV32_D_INHERITANCE_CLASS::fnmadds(d);
-#else
-        reserved(d);
-#endif
+        BASE::template fnmadds<TRACE>(d);
     }
     else
     {
-        RV32I_DISASSEM_R4_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2, ((d->imm_s >> 2) & BIT5_MASK));
+        RV32I_DISASSEM_R4_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2, (d->funct7 >> 2));
 
         double rd_val;
         double rs1_val = map_uint_to_double(state.hart[curr_hart].f[d->rs1]);
@@ -494,14 +501,16 @@ void rv32d_cpu::fnmaddd(const p_rv32i_decode_t d)
     }
 }
 
-void rv32d_cpu::faddd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::faddd(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     // Make sure this is a double precision instruction
     if ((d->funct7 & BIT2_MASK) != 0x01)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -528,14 +537,16 @@ void rv32d_cpu::faddd(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fsubd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fsubd(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     // Make sure this is a double precision instruction
     if ((d->funct7 & BIT2_MASK) != 0x01)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -561,14 +572,16 @@ void rv32d_cpu::fsubd(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fmuld(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fmuld(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     // Make sure this is a double precision instruction
     if ((d->funct7 & BIT2_MASK) != 0x01)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -594,14 +607,16 @@ void rv32d_cpu::fmuld(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fdivd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fdivd(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
     
     // Make sure this is a double precision instruction
     if ((d->funct7 & BIT2_MASK) != 0x01)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -627,14 +642,16 @@ void rv32d_cpu::fdivd(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fsqrtd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fsqrtd(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     // Make sure this is a double precision instruction
     if ((d->funct7 & BIT2_MASK) != 0x01)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -659,9 +676,11 @@ void rv32d_cpu::fsqrtd(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fsgnjd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fsgnjd(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     state.hart[curr_hart].f[d->rd] = (state.hart[curr_hart].f[d->rs1] & ~SIGN32_BIT) | 
                                      (state.hart[curr_hart].f[d->rs2] & SIGN32_BIT);
@@ -669,9 +688,11 @@ void rv32d_cpu::fsgnjd(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fsgnjnd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fsgnjnd(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     state.hart[curr_hart].f[d->rd] = (state.hart[curr_hart].f[d->rs1] & ~SIGN32_BIT) | 
                                      (~state.hart[curr_hart].f[d->rs2] & SIGN32_BIT);
@@ -679,18 +700,22 @@ void rv32d_cpu::fsgnjnd(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fsgnjxd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fsgnjxd(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
     state.hart[curr_hart].f[d->rd] = (state.hart[curr_hart].f[d->rs1] & ~SIGN32_BIT) | 
                                      ((state.hart[curr_hart].f[d->rs1] ^ state.hart[curr_hart].f[d->rs2]) & SIGN32_BIT);
 
     increment_pc();
 }
 
-void rv32d_cpu::fmind(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fmind(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     double rd_val;
     double rs1_val =  map_uint_to_double(state.hart[curr_hart].f[d->rs1]);
@@ -704,8 +729,8 @@ void rv32d_cpu::fmind(const p_rv32i_decode_t d)
     {
         rd_val = rs1_val;
 
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NV;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
     }
     else if (rs1_val == -0.0 || rs2_val == -0.0)
     {
@@ -721,9 +746,11 @@ void rv32d_cpu::fmind(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fmaxd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fmaxd(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     double rd_val;
     double rs1_val =  map_uint_to_double(state.hart[curr_hart].f[d->rs1]);
@@ -737,8 +764,8 @@ void rv32d_cpu::fmaxd(const p_rv32i_decode_t d)
     {
         rd_val = rs2_val;
 
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NV;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
     }
     else if (rs1_val == -0.0 || rs2_val == -0.0)
     {
@@ -754,9 +781,11 @@ void rv32d_cpu::fmaxd(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::feqd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::feqd(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     double rs1_val =  map_uint_to_double(state.hart[curr_hart].f[d->rs1]);
     double rs2_val =  map_uint_to_double(state.hart[curr_hart].f[d->rs2]);
@@ -767,8 +796,8 @@ void rv32d_cpu::feqd(const p_rv32i_decode_t d)
 
         if (state.hart[curr_hart].f[d->rs1] == RV32I_SNAND)
         {
-            state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NV;
-            state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+            state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NV;
+            state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
         }
     }
     else
@@ -779,9 +808,11 @@ void rv32d_cpu::feqd(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fltd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fltd(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     double rs1_val =  map_uint_to_double(state.hart[curr_hart].f[d->rs1]);
     double rs2_val =  map_uint_to_double(state.hart[curr_hart].f[d->rs2]);
@@ -790,8 +821,8 @@ void rv32d_cpu::fltd(const p_rv32i_decode_t d)
     {
         state.hart[curr_hart].x[d->rd] = 0;
 
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NV;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
     }
     else
     {
@@ -801,9 +832,11 @@ void rv32d_cpu::fltd(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fled(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fled(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     double rs1_val =  map_uint_to_double(state.hart[curr_hart].f[d->rs1]);
     double rs2_val =  map_uint_to_double(state.hart[curr_hart].f[d->rs2]);
@@ -812,8 +845,8 @@ void rv32d_cpu::fled(const p_rv32i_decode_t d)
     {
         state.hart[curr_hart].x[d->rd] = 0;
 
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NV;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
     }
     else
     {
@@ -823,9 +856,11 @@ void rv32d_cpu::fled(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fclassd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fclassd(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RFCVT1_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RFCVT1_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     double      rs1_val =  map_uint_to_double(state.hart[curr_hart].f[d->rs1]);
     uint64_t* p_rs1_uint = (uint64_t*)&rs1_val;
@@ -852,13 +887,12 @@ void rv32d_cpu::fclassd(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fcvtdw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fcvtdw(const p_rv32i_decode_t d)
 {
-    if (d->rs2)
-    {
-        d->entry.instr_name = fcvtdwu_str;
-    }
-    RV32I_DISASSEM_RFCVT2_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    // Unsigned conversion when rs2 is non-zero
+    RV32I_DISASSEM_RFCVT2_TYPE(d->instr, (d->rs2 ? fcvtdwu_str : instr_name(d)), d->rd, d->rs1, d->rs2);
 
     update_rm(d->funct3);
 
@@ -869,13 +903,12 @@ void rv32d_cpu::fcvtdw(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fcvtwd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fcvtwd(const p_rv32i_decode_t d)
 {
-    if (d->rs2)
-    {
-        d->entry.instr_name = fcvtwud_str;
-    }
-    RV32I_DISASSEM_RFCVT1_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    // Unsigned conversion when rs2 is non-zero
+    RV32I_DISASSEM_RFCVT1_TYPE(d->instr, (d->rs2 ? fcvtwud_str : instr_name(d)), d->rd, d->rs1, d->rs2);
 
     double rs1_val =  map_uint_to_double(state.hart[curr_hart].f[d->rs1]);
 
@@ -887,28 +920,30 @@ void rv32d_cpu::fcvtwd(const p_rv32i_decode_t d)
 
     if (d->rs2 && (cmp < 0 || cmp > (powf(2.0, 32.0) - 1.0) || std::isnan(rs1_val) || rs1_val == INFINITY || rs1_val == -INFINITY))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
 
         state.hart[curr_hart].x[d->rd] = (cmp < 0.0 || rs1_val == -INFINITY) ? 0 : UINT_MAX;
     }
     else if (!d->rs2 && (cmp < powf(-2.0, 31.0) || cmp >(powf(2.0, 31.0) - 1.0) || std::isnan(rs1_val) || rs1_val == INFINITY  || rs1_val == -INFINITY))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
 
         state.hart[curr_hart].x[d->rd] = (cmp < powf(-2.0, 31.0) || rs1_val == -INFINITY) ? INT_MIN : INT_MAX;
 
     }
     else if (cmp != rs1_val)
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NX;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NX;
     }
 
     increment_pc();
 }
 
-void rv32d_cpu::fcvtsd(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fcvtsd(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RFCVT3_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2); 
+    RV32I_DISASSEM_RFCVT3_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2); 
 
     update_rm(d->funct3);
 
@@ -927,29 +962,39 @@ void rv32d_cpu::fcvtsd(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32d_cpu::fcvtds(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32d_cpu<BASE>::fcvtds(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RFCVT3_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RFCVT3_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
-    uint32_t rs1 = (uint32_t)(state.hart[curr_hart].f[d->rs1] & 0xffffffffUL);
+    uint32_t rs1    = (uint32_t)(state.hart[curr_hart].f[d->rs1] & 0xffffffffUL);
+    float    rs1_f  = 0.0f;
+    uint64_t rd_int = 0;
 
-    // Point to rs1 as a float
-    float* prs1_d = (float*)&rs1;
+    // Copy rs1's bits as a float
+    memcpy(&rs1_f, &rs1, sizeof(rs1_f));
 
     // Convert rs1 to double precision
-    double   rd_d  = (double)*prs1_d;
+    double   rd_d  = (double)rs1_f;
 
-    // Point to result as a 64 bit integer
-    uint64_t* prd_uint = (uint64_t*)&rd_d;
+    // Copy the result's bits as a 64 bit integer
+    memcpy(&rd_int, &rd_d, sizeof(rd_int));
 
     // [1] Sec 12.2
     if (std::isnan(rd_d))
     {
-        *prd_uint = RV32I_QNAND;
+        rd_int = RV32I_QNAND;
     }
 
     // Save in rd register
-    state.hart[curr_hart].f[d->rd] = *prd_uint;
+    state.hart[curr_hart].f[d->rd] = rd_int;
 
     increment_pc();
 }
+
+// -----------------------------------------------------------
+// Instantiation for the configurations in rv32_extensions.h
+// -----------------------------------------------------------
+
+template class rv32d_cpu<rv32f_cpu<rv32ima_ext_t> >;
@@ -30,62 +30,87 @@
 #include <cmath>
 #include <cfenv>
 #include <climits>
+#include <cstring>
 
-#include "rv32_extensions.h"
 #include "rv32i_cpu_hdr.h"
-#include RV32D_INCLUDE
+#include "rv32f_cpu.h"
 
-class rv32d_cpu : public RV32_D_INHERITANCE_CLASS
+template <class BASE>
+class rv32d_cpu : public BASE
 {
 public:
              LIBRISCV32_API      rv32d_cpu      (FILE* dbgfp = stdout);
     virtual  LIBRISCV32_API      ~rv32d_cpu()   { };
 
-private:
-    // Add an RV32F instruction secondary table here.
-    rv32i_decode_table_t  fdop_tbl      [RV32I_NUM_SECONDARY_OPCODES];
+    using BASE::read_mem;
+    using BASE::write_mem;
+    using BASE::reserved;
+
+protected:
+    // ------------------------------------------------
+    // Members of the extended classes used here
+    // ------------------------------------------------
 
-    // OP-FP tertiary table (decoded on funct7)
-    rv32i_decode_table_t  fd_tbl        [RV32I_NUM_TERTIARY_OPCODES];
+    using BASE::state;
+    using BASE::curr_hart;
+    using BASE::dasm_fp;
+    using BASE::disassemble;
+    using BASE::rt_disassem;
+    using BASE::rmap;
+    using BASE::rmap_str;
+    using BASE::instr_name;
+    using BASE::increment_pc;
+    using BASE::fmap;
+    using BASE::fmap_str;
+    using BASE::access_addr;
+    using BASE::reserved_str;
+    using BASE::primary_tbl;
+    using BASE::fsop_tbl;
+    using BASE::fs_tbl;
+    using BASE::new_decode_table;
+
+    // Add the RV32D instructions to the decode tables (the OP-FP ones to those of rv32f_cpu)
+    void init_decode_tables             (void);
 
+private:
     // Quarternary table (decoded on funct3 via decode_exception method)
-    rv32i_decode_table_t  fsgnjd_tbl    [RV32I_NUM_SECONDARY_OPCODES];
-    rv32i_decode_table_t  fminmaxd_tbl  [RV32I_NUM_SECONDARY_OPCODES];
-    rv32i_decode_table_t  fcmpd_tbl     [RV32I_NUM_SECONDARY_OPCODES];
-    rv32i_decode_table_t  fclassd_tbl   [RV32I_NUM_SECONDARY_OPCODES];
+    rv32i_decode_table_t* fsgnjd_tbl;
+    rv32i_decode_table_t* fminmaxd_tbl;
+    rv32i_decode_table_t* fcmpd_tbl;
+    rv32i_decode_table_t* fclassd_tbl;
 
     // ------------------------------------------------
     // Private member variables
     // ------------------------------------------------
 
-    const char fld_str           [DISASSEM_STR_SIZE] = "fld      ";
-    const char fsd_str           [DISASSEM_STR_SIZE] = "fsd      ";
-    const char fmaddd_str        [DISASSEM_STR_SIZE] = "fmadd.d  ";
-    const char fmsubd_str        [DISASSEM_STR_SIZE] = "fmsub.d  ";
-    const char fnmsubd_str       [DISASSEM_STR_SIZE] = "fnmsub.d ";
-    const char fnmaddd_str       [DISASSEM_STR_SIZE] = "fnmadd.d ";
-    const char faddd_str         [DISASSEM_STR_SIZE] = "fadd.d   ";
-    const char fsubd_str         [DISASSEM_STR_SIZE] = "fsub.d   ";
-    const char fmuld_str         [DISASSEM_STR_SIZE] = "fmul.d   ";
-    const char fdivd_str         [DISASSEM_STR_SIZE] = "fdiv.d   ";
-    const char fsqrtd_str        [DISASSEM_STR_SIZE] = "fsqrt.d  ";
-    const char fsgnjd_str        [DISASSEM_STR_SIZE] = "fsgnj.d  ";
-    const char fsgnjnd_str       [DISASSEM_STR_SIZE] = "fsgnjn.d ";
-    const char fsgnjxd_str       [DISASSEM_STR_SIZE] = "fsgnjx.d ";
-    const char fmind_str         [DISASSEM_STR_SIZE] = "fmin.d   ";
-    const char fmaxd_str         [DISASSEM_STR_SIZE] = "fmax.d   ";
-    const char fcvtwd_str        [DISASSEM_STR_SIZE] = "fcvt.w.d ";
-    const char fcvtwud_str       [DISASSEM_STR_SIZE] = "fcvt.wu.d";
-    const char feqd_str          [DISASSEM_STR_SIZE] = "feq.d    ";
-    const char fltd_str          [DISASSEM_STR_SIZE] = "flt.d    ";
-    const char fled_str          [DISASSEM_STR_SIZE] = "fle.s    ";
-    const char fclassd_str       [DISASSEM_STR_SIZE] = "fclass.d ";
-    const char fcvtdw_str        [DISASSEM_STR_SIZE] = "fcvt.d.w ";
-    const char fcvtdwu_str       [DISASSEM_STR_SIZE] = "fcvt.d.wu";
+    static constexpr char fld_str           [] = "fld      ";
+    static constexpr char fsd_str           [] = "fsd      ";
+    static constexpr char fmaddd_str        [] = "fmadd.d  ";
+    static constexpr char fmsubd_str        [] = "fmsub.d  ";
+    static constexpr char fnmsubd_str       [] = "fnmsub.d ";
+    static constexpr char fnmaddd_str       [] = "fnmadd.d ";
+    static constexpr char faddd_str         [] = "fadd.d   ";
+    static constexpr char fsubd_str         [] = "fsub.d   ";
+    static constexpr char fmuld_str         [] = "fmul.d   ";
+    static constexpr char fdivd_str         [] = "fdiv.d   ";
+    static constexpr char fsqrtd_str        [] = "fsqrt.d  ";
+    static constexpr char fsgnjd_str        [] = "fsgnj.d  ";
+    static constexpr char fsgnjnd_str       [] = "fsgnjn.d ";
+    static constexpr char fsgnjxd_str       [] = "fsgnjx.d ";
+    static constexpr char fmind_str         [] = "fmin.d   ";
+    static constexpr char fmaxd_str         [] = "fmax.d   ";
+    static constexpr char fcvtwd_str        [] = "fcvt.w.d ";
+    static constexpr char fcvtwud_str       [] = "fcvt.wu.d";
+    static constexpr char feqd_str          [] = "feq.d    ";
+    static constexpr char fltd_str          [] = "flt.d    ";
+    static constexpr char fled_str          [] = "fle.s    ";
+    static constexpr char fclassd_str       [] = "fclass.d ";
+    static constexpr char fcvtdw_str        [] = "fcvt.d.w ";
+    static constexpr char fcvtdwu_str       [] = "fcvt.d.wu";
     
     // New to RV32D
-    const char fcvtsd_str        [DISASSEM_STR_SIZE] = "fcvt.s.d ";
-    const char fcvtds_str        [DISASSEM_STR_SIZE] = "fcvt.d.s ";
+    static constexpr char fcvtsd_str        [] = "fcvt.s.d ";
+    static constexpr char fcvtds_str        [] = "fcvt.d.s ";
 
     int        curr_rnd_method;
 
@@ -93,10 +118,6 @@ private:
     // Private member functions
     // ------------------------------------------------
 
-    // CSR access routines
-    uint32_t csr_wr_mask(const uint32_t addr, bool& unimp);
-    uint32_t access_csr(const unsigned funct3, const uint32_t addr, const uint32_t rd, const uint32_t rs1_uimm);
-
     // Updates the floating point rounding method
     void update_rm(int req_rnd_method);
 
@@ -129,32 +150,36 @@ private:
 
 protected:
 
+    // CSR access routines (protected, so a final class can call them statically bound)
+    uint32_t csr_wr_mask(const uint32_t addr, bool& unimp);
+    uint32_t access_csr(const unsigned funct3, const uint32_t addr, const uint32_t rd, const uint32_t rs1_uimm);
+
     // RV32D extension instruction methods
-    void fld                             (const p_rv32i_decode_t);
-    void fsd                             (const p_rv32i_decode_t);
-    void fmaddd                          (const p_rv32i_decode_t);
-    void fmsubd                          (const p_rv32i_decode_t);
-    void fnmsubd                         (const p_rv32i_decode_t);
-    void fnmaddd                         (const p_rv32i_decode_t);
-    void faddd                           (const p_rv32i_decode_t);
-    void fsubd                           (const p_rv32i_decode_t);
-    void fmuld                           (const p_rv32i_decode_t);
-    void fdivd                           (const p_rv32i_decode_t);
-    void fsqrtd                          (const p_rv32i_decode_t);
-    void fsgnjd                          (const p_rv32i_decode_t);
-    void fsgnjnd                         (const p_rv32i_decode_t);
-    void fsgnjxd                         (const p_rv32i_decode_t);
-    void fmind                           (const p_rv32i_decode_t);
-    void fmaxd                           (const p_rv32i_decode_t);
-    void fcvtwd                          (const p_rv32i_decode_t);
-    void feqd                            (const p_rv32i_decode_t);
-    void fltd                            (const p_rv32i_decode_t);
-    void fled                            (const p_rv32i_decode_t);
-    void fclassd                         (const p_rv32i_decode_t);
-    void fcvtdw                          (const p_rv32i_decode_t);
+    template <bool TRACE> void fld       (const p_rv32i_decode_t);
+    template <bool TRACE> void fsd       (const p_rv32i_decode_t);
+    template <bool TRACE> void fmaddd    (const p_rv32i_decode_t);
+    template <bool TRACE> void fmsubd    (const p_rv32i_decode_t);
+    template <bool TRACE> void fnmsubd   (const p_rv32i_decode_t);
+    template <bool TRACE> void fnmaddd   (const p_rv32i_decode_t);
+    template <bool TRACE> void faddd     (const p_rv32i_decode_t);
+    template <bool TRACE> void fsubd     (const p_rv32i_decode_t);
+    template <bool TRACE> void fmuld     (const p_rv32i_decode_t);
+    template <bool TRACE> void fdivd     (const p_rv32i_decode_t);
+    template <bool TRACE> void fsqrtd    (const p_rv32i_decode_t);
+    template <bool TRACE> void fsgnjd    (const p_rv32i_decode_t);
+    template <bool TRACE> void fsgnjnd   (const p_rv32i_decode_t);
+    template <bool TRACE> void fsgnjxd   (const p_rv32i_decode_t);
+    template <bool TRACE> void fmind     (const p_rv32i_decode_t);
+    template <bool TRACE> void fmaxd     (const p_rv32i_decode_t);
+    template <bool TRACE> void fcvtwd    (const p_rv32i_decode_t);
+    template <bool TRACE> void feqd      (const p_rv32i_decode_t);
+    template <bool TRACE> void fltd      (const p_rv32i_decode_t);
+    template <bool TRACE> void fled      (const p_rv32i_decode_t);
+    template <bool TRACE> void fclassd   (const p_rv32i_decode_t);
+    template <bool TRACE> void fcvtdw    (const p_rv32i_decode_t);
     
-    void fcvtsd                          (const p_rv32i_decode_t);
-    void fcvtds                          (const p_rv32i_decode_t);
+    template <bool TRACE> void fcvtsd    (const p_rv32i_decode_t);
+    template <bool TRACE> void fcvtds    (const p_rv32i_decode_t);
 };
 
 #endif
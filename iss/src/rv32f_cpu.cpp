@@ -25,25 +25,43 @@
 //
 //=============================================================
 
-#include "rv32f_cpu.h"
+#include "rv32_extensions.h"
 
 // -----------------------------------------------------------
 // Constructor
 // -----------------------------------------------------------
 
-rv32f_cpu::rv32f_cpu(FILE* dbgfp) : RV32_F_INHERITANCE_CLASS(dbgfp)
+template <class BASE>
+rv32f_cpu<BASE>::rv32f_cpu(FILE* dbgfp) : BASE(dbgfp)
 {
-    int idx;
-
     // Advertise 'F' extensions
-    state.hart[curr_hart].csr[RV32CSR_ADDR_MISA]   |=  RV32CSR_EXT_F;
+    state.hart[curr_hart].csr[RV32CSR_IDX_MISA]   |=  RV32CSR_EXT_F;
 
     // Initialise FS field to Initial
-    state.hart[curr_hart].csr[RV32CSR_ADDR_MSTATUS] = RV32CSR_MSTATUS_FS_INITIAL;
+    state.hart[curr_hart].csr[RV32CSR_IDX_MSTATUS] = RV32CSR_MSTATUS_FS_INITIAL;
 
     curr_rnd_method = RV32I_RMM;
     fesetround(FE_TONEAREST);
     feclearexcept(FE_ALL_EXCEPT);
+}
+
+// -----------------------------------------------------------
+// Decode table set up
+// -----------------------------------------------------------
+
+template <class BASE>
+void rv32f_cpu<BASE>::init_decode_tables()
+{
+    int idx;
+
+    BASE::init_decode_tables();
+
+    fsop_tbl     = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    fs_tbl       = new_decode_table(RV32I_NUM_TERTIARY_OPCODES);
+    fsgnjs_tbl   = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    fminmaxs_tbl = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    fcmp_tbl     = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    fmv_tbl      = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
 
     // Quarternary tables for floating point, decoded in funct3.
     // For OP-FP instructions not using 'rm' field in funct3 place.
@@ -51,44 +69,44 @@ rv32f_cpu::rv32f_cpu(FILE* dbgfp) : RV32_F_INHERITANCE_CLASS(dbgfp)
     // Initialise quarternary table to reserved instruction method
     for (int i = 0; i < RV32I_NUM_SECONDARY_OPCODES; i++)
     {
-        fsgnjs_tbl[i]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};
-        fminmaxs_tbl[i] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};
-        fmv_tbl[i]      = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};
-        fcmp_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};
+        fsgnjs_tbl[i]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved)};
+        fminmaxs_tbl[i] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved)};
+        fmv_tbl[i]      = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved)};
+        fcmp_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved)};
     }
 
     // Setup quarternary tables (decoded on funct3 via decode_exception method)
     idx = 0;
-    fsgnjs_tbl[idx++]   = { false, fsgnjs_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fsgnjs };
-    fsgnjs_tbl[idx++]   = { false, fsgnjns_str, RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fsgnjns };
-    fsgnjs_tbl[idx++]   = { false, fsgnjxs_str, RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fsgnjxs };
+    fsgnjs_tbl[idx++]   = { false, fsgnjs_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fsgnjs)  };
+    fsgnjs_tbl[idx++]   = { false, fsgnjns_str, RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fsgnjns) };
+    fsgnjs_tbl[idx++]   = { false, fsgnjxs_str, RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fsgnjxs) };
 
     idx = 0;
-    fminmaxs_tbl[idx++] = { false, fmins_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fmins };
-    fminmaxs_tbl[idx++] = { false, fmaxs_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fmaxs };
+    fminmaxs_tbl[idx++] = { false, fmins_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fmins) };
+    fminmaxs_tbl[idx++] = { false, fmaxs_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fmaxs) };
 
     idx = 0;
-    fmv_tbl[idx++]      = { false, fmvxw_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fmvxw };
-    fmv_tbl[idx++]      = { false, fclasss_str, RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fclasss };
+    fmv_tbl[idx++]      = { false, fmvxw_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fmvxw)   };
+    fmv_tbl[idx++]      = { false, fclasss_str, RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fclasss) };
 
     idx = 0;
-    fcmp_tbl[idx++]     = { false, fles_str,    RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fles };
-    fcmp_tbl[idx++]     = { false, flts_str,    RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::flts };
-    fcmp_tbl[idx++]     = { false, feqs_str,    RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::feqs };
+    fcmp_tbl[idx++]     = { false, fles_str,    RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fles) };
+    fcmp_tbl[idx++]     = { false, flts_str,    RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, flts) };
+    fcmp_tbl[idx++]     = { false, feqs_str,    RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, feqs) };
 
     // Tertiary table for OP-FP
-    fs_tbl[0x00]        = { false, fadds_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fadds };
-    fs_tbl[0x04]        = { false, fsubs_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fsubs };
-    fs_tbl[0x08]        = { false, fmuls_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fmuls };
-    fs_tbl[0x0c]        = { false, fdivs_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fdivs };
-    fs_tbl[0x2c]        = { false, fsqrts_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fsqrts };
+    fs_tbl[0x00]        = { false, fadds_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fadds)  };
+    fs_tbl[0x04]        = { false, fsubs_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fsubs)  };
+    fs_tbl[0x08]        = { false, fmuls_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fmuls)  };
+    fs_tbl[0x0c]        = { false, fdivs_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fdivs)  };
+    fs_tbl[0x2c]        = { false, fsqrts_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fsqrts) };
     INIT_TBL_WITH_SUBTBL(fs_tbl[0x10], fsgnjs_tbl);
     INIT_TBL_WITH_SUBTBL(fs_tbl[0x14], fminmaxs_tbl);
-    fs_tbl[0x60]        = { false, fcvtws_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fcvtws };  // FCVT.W.S and FCVT.WU.S
+    fs_tbl[0x60]        = { false, fcvtws_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fcvtws) };    // FCVT.W.S and FCVT.WU.S
     INIT_TBL_WITH_SUBTBL(fs_tbl[0x70], fmv_tbl);
     INIT_TBL_WITH_SUBTBL(fs_tbl[0x50], fcmp_tbl);
-    fs_tbl[0x68]        = { false, fcvtsw_str,  RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fcvtsw };  // FCVT.S.W and FCVT.S.WU
-    fs_tbl[0x78]        = { false, fmvwx_str,   RV32I_INSTR_FMT_R, (pFunc_t)&rv32f_cpu::fmvwx };
+    fs_tbl[0x68]        = { false, fcvtsw_str,  RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fcvtsw) };    // FCVT.S.W and FCVT.S.WU
+    fs_tbl[0x78]        = { false, fmvwx_str,   RV32I_INSTR_FMT_R, RV32I_HANDLER(rv32f_cpu, fmvwx)  };
 
     // For all combinations of funct3, point to the tertiary fsop_tbl. 
     // Will decode funct3 in quarternary tables. Avoids large
@@ -100,14 +118,14 @@ rv32f_cpu::rv32f_cpu(FILE* dbgfp) : RV32_F_INHERITANCE_CLASS(dbgfp)
         INIT_TBL_WITH_SUBTBL(fsop_tbl[i], fs_tbl);
     }
 
-    primary_tbl[0x01]  = {false, flw_str,          RV32I_INSTR_FMT_I, (pFunc_t)&rv32f_cpu::flw};      /*LOAD-FP*/
-    primary_tbl[0x09]  = {false, fsw_str,          RV32I_INSTR_FMT_S, (pFunc_t)&rv32f_cpu::fsw};      /*STORE-FP*/
+    primary_tbl[0x01]  = {false, flw_str,          RV32I_INSTR_FMT_I, RV32I_HANDLER(rv32f_cpu, flw)};    /*LOAD-FP*/
+    primary_tbl[0x09]  = {false, fsw_str,          RV32I_INSTR_FMT_S, RV32I_HANDLER(rv32f_cpu, fsw)};    /*STORE-FP*/
 
     idx = 0x10;
-    primary_tbl[idx++] = {false, fmadds_str,       RV32I_INSTR_FMT_R4, (pFunc_t)&rv32f_cpu::fmadds};  /*MADD*/
-    primary_tbl[idx++] = {false, fmsubs_str,       RV32I_INSTR_FMT_R4, (pFunc_t)&rv32f_cpu::fmsubs};  /*MSUB*/
-    primary_tbl[idx++] = {false, fnmsubs_str,      RV32I_INSTR_FMT_R4, (pFunc_t)&rv32f_cpu::fnmsubs}; /*NMSUB*/
-    primary_tbl[idx++] = {false, fnmadds_str,      RV32I_INSTR_FMT_R4, (pFunc_t)&rv32f_cpu::fnmadds}; /*NMADD*/
+    primary_tbl[idx++] = {false, fmadds_str,       RV32I_INSTR_FMT_R4, RV32I_HANDLER(rv32f_cpu, fmadds) };    /*MADD*/
+    primary_tbl[idx++] = {false, fmsubs_str,       RV32I_INSTR_FMT_R4, RV32I_HANDLER(rv32f_cpu, fmsubs) };    /*MSUB*/
+    primary_tbl[idx++] = {false, fnmsubs_str,      RV32I_INSTR_FMT_R4, RV32I_HANDLER(rv32f_cpu, fnmsubs)};    /*NMSUB*/
+    primary_tbl[idx++] = {false, fnmadds_str,      RV32I_INSTR_FMT_R4, RV32I_HANDLER(rv32f_cpu, fnmadds)};    /*NMADD*/
 
     INIT_TBL_WITH_SUBTBL(primary_tbl[idx], fsop_tbl); idx++;
 }
@@ -116,12 +134,13 @@ rv32f_cpu::rv32f_cpu(FILE* dbgfp) : RV32_F_INHERITANCE_CLASS(dbgfp)
 // Floating point CSR register access methods
 // -----------------------------------------------------------
 
-uint32_t rv32f_cpu::access_csr(const unsigned funct3, const uint32_t addr, const uint32_t rd, const uint32_t rs1_uimm)
+template <class BASE>
+uint32_t rv32f_cpu<BASE>::access_csr(const unsigned funct3, const uint32_t addr, const uint32_t rd, const uint32_t rs1_uimm)
 {
     uint32_t error = 0;
     
     // Call parent class's access_csr function.
-    if (!(error = RV32_F_INHERITANCE_CLASS::access_csr(funct3, addr, rd, rs1_uimm)))
+    if (!(error = BASE::access_csr(funct3, addr, rd, rs1_uimm)))
     {
         // If no error, check if access was to floating point CSRs. Since FRM and FFLAGS are
         // copies of FCSR fields, if any are updated, the relevant other registers need
@@ -130,16 +149,16 @@ uint32_t rv32f_cpu::access_csr(const unsigned funct3, const uint32_t addr, const
         switch (addr)
         {
         case RV32CSR_ADDR_FFLAGS:
-            state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   = (state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   & ~RV32CSR_FFLAGS_WR_MASK) |
-                                                             (state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] & RV32CSR_FFLAGS_WR_MASK);
+            state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   = (state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   & ~RV32CSR_FFLAGS_WR_MASK) |
+                                                             (state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] & RV32CSR_FFLAGS_WR_MASK);
             break;
         case RV32CSR_ADDR_FRM:
-            state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   = (state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR] & ~(RV32CSR_FRM_WR_MASK << 5)) | 
-                                                             ((state.hart[curr_hart].csr[RV32CSR_ADDR_FRM] & RV32CSR_FRM_WR_MASK ) << 5);
+            state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   = (state.hart[curr_hart].csr[RV32CSR_IDX_FCSR] & ~(RV32CSR_FRM_WR_MASK << 5)) | 
+                                                             ((state.hart[curr_hart].csr[RV32CSR_IDX_FRM] & RV32CSR_FRM_WR_MASK ) << 5);
             break;
         case RV32CSR_ADDR_FCSR:
-            state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] =  state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR] & RV32CSR_FFLAGS_WR_MASK;
-            state.hart[curr_hart].csr[RV32CSR_ADDR_FRM]    = (state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR] >> 5) & RV32CSR_FRM_WR_MASK;
+            state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] =  state.hart[curr_hart].csr[RV32CSR_IDX_FCSR] & RV32CSR_FFLAGS_WR_MASK;
+            state.hart[curr_hart].csr[RV32CSR_IDX_FRM]    = (state.hart[curr_hart].csr[RV32CSR_IDX_FCSR] >> 5) & RV32CSR_FRM_WR_MASK;
             break;
         default:
             break;
@@ -153,10 +172,11 @@ uint32_t rv32f_cpu::access_csr(const unsigned funct3, const uint32_t addr, const
 // Overloaded CSR write mask method
 // -----------------------------------------------------------
 
-uint32_t rv32f_cpu::csr_wr_mask(const uint32_t addr, bool& unimp)
+template <class BASE>
+uint32_t rv32f_cpu<BASE>::csr_wr_mask(const uint32_t addr, bool& unimp)
 {
     // Offer the access to the ancestor classes first
-    uint32_t mask =  RV32_F_INHERITANCE_CLASS::csr_wr_mask(addr, unimp);
+    uint32_t mask =  BASE::csr_wr_mask(addr, unimp);
 
     // If not implemented in the parent classes, decode here
     if (unimp)
@@ -197,11 +217,12 @@ uint32_t rv32f_cpu::csr_wr_mask(const uint32_t addr, bool& unimp)
 // RV32F floating point control and exception methods
 // -----------------------------------------------------------
 
-void rv32f_cpu::update_rm(int req_rnd_method)
+template <class BASE>
+void rv32f_cpu<BASE>::update_rm(int req_rnd_method)
 {
     // If requested method is dynamic, get dynamic setting from FRM,
     // else use argument value.
-    int rnd_method = (req_rnd_method == RV32I_DYN) ? state.hart->csr[RV32CSR_ADDR_FRM] : 
+    int rnd_method = (req_rnd_method == RV32I_DYN) ? state.hart->csr[RV32CSR_IDX_FRM] : 
                                                      req_rnd_method;
 
     // Only set if there's a change.
@@ -231,39 +252,40 @@ void rv32f_cpu::update_rm(int req_rnd_method)
     }
 }
 
-void rv32f_cpu::handle_fexceptions()
+template <class BASE>
+void rv32f_cpu<BASE>::handle_fexceptions()
 {
     // Update the CSR status, mapping from underlying exception
     // values to the flags in FCSR and FFLAGS.
 
     if (fetestexcept(FE_INVALID))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NV;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
     }
 
     if (fetestexcept(FE_OVERFLOW))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_OF;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_OF;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_OF;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_OF;
     }
 
     if (fetestexcept(FE_DIVBYZERO))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_DZ;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_DZ;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_DZ;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_DZ;
     }
 
     if (fetestexcept(FE_UNDERFLOW))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_UF;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_UF;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_UF;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_UF;
     }
 
     if (fetestexcept(FE_INEXACT))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NX;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NX;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NX;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NX;
     }
 
     feclearexcept(FE_ALL_EXCEPT);
@@ -273,13 +295,15 @@ void rv32f_cpu::handle_fexceptions()
 // RV32F instruction methods
 // -----------------------------------------------------------
 
-void rv32f_cpu::flw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::flw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_IFS_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_IFS_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1] + d->imm_i;
 
@@ -297,16 +321,18 @@ void rv32f_cpu::flw(const p_rv32i_decode_t d)
     }
 }
 
-void rv32f_cpu::fsw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fsw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_SFS_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_SFS_TYPE(d->instr, instr_name(d), d->rs1, d->rs2, d->imm_s);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         // Enabling stores only when MSTATUS FS bits != 0 (off)
-        if (state.hart->csr[RV32CSR_ADDR_MSTATUS] & RV32CSR_MSTATUS_FS_MASK)
+        if (state.hart->csr[RV32CSR_IDX_MSTATUS] & RV32CSR_MSTATUS_FS_MASK)
         {
             access_addr = state.hart[curr_hart].x[d->rs1] + d->imm_s;
 
@@ -320,14 +346,16 @@ void rv32f_cpu::fsw(const p_rv32i_decode_t d)
     }
 }
 
-void rv32f_cpu::fmadds(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fmadds(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R4_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2, ((d->imm_s >> 2) & BIT5_MASK));
+    RV32I_DISASSEM_R4_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2, (d->funct7 >> 2));
 
     // Make sure this is a 32 bit single precision instruction (botttom 2 bits of funct7)
     if (d->funct7 & BIT2_MASK)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -357,16 +385,18 @@ void rv32f_cpu::fmadds(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fmsubs (const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fmsubs (const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R4_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2, ((d->imm_s >> 2)& BIT5_MASK));
+    RV32I_DISASSEM_R4_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2, (d->funct7 >> 2));
 
     update_rm(d->funct3);
 
     // Make sure this is a 32 bit single precision instrucions
     if (d->funct7 & BIT2_MASK)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -394,14 +424,16 @@ void rv32f_cpu::fmsubs (const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fnmsubs(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fnmsubs(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R4_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2, ((d->imm_s >> 2) & BIT5_MASK));
+    RV32I_DISASSEM_R4_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2, (d->funct7 >> 2));
     
     // Make sure this is a 32 bit single precision instrucions
     if (d->funct7 & BIT2_MASK)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -429,14 +461,16 @@ void rv32f_cpu::fnmsubs(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fnmadds(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fnmadds(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R4_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2, ((d->imm_s >> 2)& BIT5_MASK));
+    RV32I_DISASSEM_R4_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2, (d->funct7 >> 2));
 
     // Make sure this is a 32 bit single precision instruction
     if (d->funct7 & BIT2_MASK)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -464,14 +498,16 @@ void rv32f_cpu::fnmadds(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fadds(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fadds(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     // Make sure this is a 32 bit single precision instruction
     if (d->funct7 & BIT2_MASK)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -498,14 +534,16 @@ void rv32f_cpu::fadds(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fsubs(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fsubs(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     // Make sure this is a 32 bit single precision instruction
     if (d->funct7 & BIT2_MASK)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -531,14 +569,16 @@ void rv32f_cpu::fsubs(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fmuls(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fmuls(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     // Make sure this is a 32 bit single precision instruction
     if (d->funct7 & BIT2_MASK)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -564,14 +604,16 @@ void rv32f_cpu::fmuls(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fdivs(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fdivs(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
     
     // Make sure this is a 32 bit single precision instruction
     if (d->funct7 & BIT2_MASK)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -597,14 +639,16 @@ void rv32f_cpu::fdivs(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fsqrts(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fsqrts(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     // Make sure this is a 32 bit single precision instruction
     if (d->funct7 & BIT2_MASK)
     {
-        reserved(d);
+        BASE::template reserved<TRACE>(d);
     }
     else
     {
@@ -629,9 +673,11 @@ void rv32f_cpu::fsqrts(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fsgnjs(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fsgnjs(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     state.hart[curr_hart].f[d->rd] = (state.hart[curr_hart].f[d->rs1] & ~SIGN32_BIT) | 
                                      (state.hart[curr_hart].f[d->rs2] & SIGN32_BIT);
@@ -639,9 +685,11 @@ void rv32f_cpu::fsgnjs(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fsgnjns(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fsgnjns(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     state.hart[curr_hart].f[d->rd] = (state.hart[curr_hart].f[d->rs1] & ~SIGN32_BIT) | 
                                      (~state.hart[curr_hart].f[d->rs2] & SIGN32_BIT);
@@ -649,18 +697,22 @@ void rv32f_cpu::fsgnjns(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fsgnjxs(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fsgnjxs(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
     state.hart[curr_hart].f[d->rd] = (state.hart[curr_hart].f[d->rs1] & ~SIGN32_BIT) | 
                                      ((state.hart[curr_hart].f[d->rs1] ^ state.hart[curr_hart].f[d->rs2]) & SIGN32_BIT);
 
     increment_pc();
 }
 
-void rv32f_cpu::fmins(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fmins(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     float rd_val;
     float rs1_val =  map_uint_to_float(state.hart[curr_hart].f[d->rs1]);
@@ -674,8 +726,8 @@ void rv32f_cpu::fmins(const p_rv32i_decode_t d)
     {
         rd_val = rs1_val;
 
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NV;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
     }
     else if (rs1_val == -0.0 || rs2_val == -0.0)
     {
@@ -691,9 +743,11 @@ void rv32f_cpu::fmins(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fmaxs(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fmaxs(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     float rd_val;
     float rs1_val =  map_uint_to_float(state.hart[curr_hart].f[d->rs1]);
@@ -707,8 +761,8 @@ void rv32f_cpu::fmaxs(const p_rv32i_decode_t d)
     {
         rd_val = rs2_val;
 
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NV;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
     }
     else if (rs1_val == -0.0 || rs2_val == -0.0)
     {
@@ -724,9 +778,11 @@ void rv32f_cpu::fmaxs(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::feqs(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::feqs(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     float rs1_val =  map_uint_to_float(state.hart[curr_hart].f[d->rs1]);
     float rs2_val =  map_uint_to_float(state.hart[curr_hart].f[d->rs2]);
@@ -737,8 +793,8 @@ void rv32f_cpu::feqs(const p_rv32i_decode_t d)
 
         if (state.hart[curr_hart].f[d->rs1] == RV32I_SNANF)
         {
-            state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NV;
-            state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+            state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NV;
+            state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
         }
     }
     else
@@ -749,9 +805,11 @@ void rv32f_cpu::feqs(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::flts(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::flts(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     float rs1_val =  map_uint_to_float(state.hart[curr_hart].f[d->rs1]);
     float rs2_val =  map_uint_to_float(state.hart[curr_hart].f[d->rs2]);
@@ -760,8 +818,8 @@ void rv32f_cpu::flts(const p_rv32i_decode_t d)
     {
         state.hart[curr_hart].x[d->rd] = 0;
 
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NV;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
     }
     else
     {
@@ -771,9 +829,11 @@ void rv32f_cpu::flts(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fles   (const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fles   (const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RF_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RF_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     float rs1_val =  map_uint_to_float(state.hart[curr_hart].f[d->rs1]);
     float rs2_val =  map_uint_to_float(state.hart[curr_hart].f[d->rs2]);
@@ -782,8 +842,8 @@ void rv32f_cpu::fles   (const p_rv32i_decode_t d)
     {
         state.hart[curr_hart].x[d->rd] = 0;
 
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FCSR]   |= RV32I_NV;
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FCSR]   |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
     }
     else
     {
@@ -793,9 +853,11 @@ void rv32f_cpu::fles   (const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fclasss(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fclasss(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RFCVT1_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2); 
+    RV32I_DISASSEM_RFCVT1_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2); 
 
     float      rs1_val =  map_uint_to_float(state.hart[curr_hart].f[d->rs1]);
     uint32_t* p_rs1_uint = (uint32_t*)&rs1_val;
@@ -822,13 +884,12 @@ void rv32f_cpu::fclasss(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fcvtsw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fcvtsw(const p_rv32i_decode_t d)
 {
-    if (d->rs2)
-    {
-        d->entry.instr_name = fcvtswu_str;
-    }
-    RV32I_DISASSEM_RFCVT2_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    // Unsigned conversion when rs2 is non-zero
+    RV32I_DISASSEM_RFCVT2_TYPE(d->instr, (d->rs2 ? fcvtswu_str : instr_name(d)), d->rd, d->rs1, d->rs2);
 
     update_rm(d->funct3);
 
@@ -839,13 +900,12 @@ void rv32f_cpu::fcvtsw(const p_rv32i_decode_t d)
     increment_pc();
 }
 
-void rv32f_cpu::fcvtws(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fcvtws(const p_rv32i_decode_t d)
 {
-    if (d->rs2)
-    {
-        d->entry.instr_name = fcvtwus_str;
-    }
-    RV32I_DISASSEM_RFCVT1_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    // Unsigned conversion when rs2 is non-zero
+    RV32I_DISASSEM_RFCVT1_TYPE(d->instr, (d->rs2 ? fcvtwus_str : instr_name(d)), d->rd, d->rs1, d->rs2);
 
     float rs1_val =  map_uint_to_float(state.hart[curr_hart].f[d->rs1]);
 
@@ -857,39 +917,49 @@ void rv32f_cpu::fcvtws(const p_rv32i_decode_t d)
 
     if (d->rs2 && (cmp < 0 || cmp > (powf(2.0, 32.0) - 1.0) || std::isnan(rs1_val) || rs1_val == INFINITY || rs1_val == -INFINITY))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
 
         state.hart[curr_hart].x[d->rd] = (cmp < 0.0 || rs1_val == -INFINITY) ? 0 : UINT_MAX;
     }
     else if (!d->rs2 && (cmp < powf(-2.0, 31.0) || cmp >(powf(2.0, 31.0) - 1.0) || std::isnan(rs1_val) || rs1_val == INFINITY  || rs1_val == -INFINITY))
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NV;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NV;
 
         state.hart[curr_hart].x[d->rd] = (cmp < powf(-2.0, 31.0) || rs1_val == -INFINITY) ? INT_MIN : INT_MAX;
 
     }
     else if (cmp != rs1_val)
     {
-        state.hart[curr_hart].csr[RV32CSR_ADDR_FFLAGS] |= RV32I_NX;
+        state.hart[curr_hart].csr[RV32CSR_IDX_FFLAGS] |= RV32I_NX;
     }
 
     increment_pc();
 }
 
-void rv32f_cpu::fmvwx(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fmvwx(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RFCVT2_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RFCVT2_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     state.hart[curr_hart].f[d->rd] = state.hart[curr_hart].x[d->rs1];
 
     increment_pc();
 }
 
-void rv32f_cpu::fmvxw(const p_rv32i_decode_t d)
+template <class BASE>
+template <bool TRACE>
+void rv32f_cpu<BASE>::fmvxw(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_RFCVT1_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_RFCVT1_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     state.hart[curr_hart].x[d->rd] = (uint32_t)state.hart[curr_hart].f[d->rs1];
 
     increment_pc();
 }
+
+// -----------------------------------------------------------
+// Instantiation for the configurations in rv32_extensions.h
+// -----------------------------------------------------------
+
+template class rv32f_cpu<rv32ima_ext_t>;
@@ -31,28 +31,56 @@
 #include <cfenv>
 #include <climits>
 
-#include "rv32_extensions.h"
 #include "rv32i_cpu_hdr.h"
-#include RV32F_INCLUDE
+#include "rv32csr_cpu.h"
 
-class rv32f_cpu : public RV32_F_INHERITANCE_CLASS
+template <class BASE>
+class rv32f_cpu : public BASE
 {
 public:
              LIBRISCV32_API      rv32f_cpu      (FILE* dbgfp = stdout);
     virtual  LIBRISCV32_API      ~rv32f_cpu()   { };
 
+    using BASE::read_mem;
+    using BASE::write_mem;
+    using BASE::reserved;
+
+protected:
+    // ------------------------------------------------
+    // Members of the extended classes used here
+    // ------------------------------------------------
+
+    using BASE::state;
+    using BASE::curr_hart;
+    using BASE::dasm_fp;
+    using BASE::disassemble;
+    using BASE::rt_disassem;
+    using BASE::rmap;
+    using BASE::rmap_str;
+    using BASE::instr_name;
+    using BASE::increment_pc;
+    using BASE::fmap;
+    using BASE::fmap_str;
+    using BASE::access_addr;
+    using BASE::reserved_str;
+    using BASE::primary_tbl;
+    using BASE::new_decode_table;
+
 protected:
     // Add an RV32F instruction secondary table here.
-    rv32i_decode_table_t  fsop_tbl      [RV32I_NUM_SECONDARY_OPCODES];
+    rv32i_decode_table_t* fsop_tbl;
 
     // OP-FP tertiary table (decoded on funct7)
-    rv32i_decode_table_t  fs_tbl        [RV32I_NUM_TERTIARY_OPCODES];
+    rv32i_decode_table_t* fs_tbl;
 
     // Quarternary table (decoded on funct3 via decode_exception method)
-    rv32i_decode_table_t  fsgnjs_tbl    [RV32I_NUM_SECONDARY_OPCODES];
-    rv32i_decode_table_t  fminmaxs_tbl  [RV32I_NUM_SECONDARY_OPCODES];
-    rv32i_decode_table_t  fcmp_tbl      [RV32I_NUM_SECONDARY_OPCODES];
-    rv32i_decode_table_t  fmv_tbl       [RV32I_NUM_SECONDARY_OPCODES];
+    rv32i_decode_table_t* fsgnjs_tbl;
+    rv32i_decode_table_t* fminmaxs_tbl;
+    rv32i_decode_table_t* fcmp_tbl;
+    rv32i_decode_table_t* fmv_tbl;
+
+    // Add the RV32F instructions to the decode tables
+    void init_decode_tables             (void);
 
 private:
 
@@ -60,43 +88,44 @@ private:
     // Private member variables
     // ------------------------------------------------
     
-    const char flw_str           [DISASSEM_STR_SIZE] = "flw      ";
-    const char fsw_str           [DISASSEM_STR_SIZE] = "fsw      ";
-    const char fmadds_str        [DISASSEM_STR_SIZE] = "fmadd.s  ";
-    const char fmsubs_str        [DISASSEM_STR_SIZE] = "fmsub.s  ";
-    const char fnmsubs_str       [DISASSEM_STR_SIZE] = "fnmsub.s ";
-    const char fnmadds_str       [DISASSEM_STR_SIZE] = "fnmadd.s ";
-    const char fadds_str         [DISASSEM_STR_SIZE] = "fadd.s   ";
-    const char fsubs_str         [DISASSEM_STR_SIZE] = "fsub.s   ";
-    const char fmuls_str         [DISASSEM_STR_SIZE] = "fmul.s   ";
-    const char fdivs_str         [DISASSEM_STR_SIZE] = "fdiv.s   ";
-    const char fsqrts_str        [DISASSEM_STR_SIZE] = "fsqrt.s  ";
-    const char fsgnjs_str        [DISASSEM_STR_SIZE] = "fsgnj.s  ";
-    const char fsgnjns_str       [DISASSEM_STR_SIZE] = "fsgnjn.s ";
-    const char fsgnjxs_str       [DISASSEM_STR_SIZE] = "fsgnjx.s ";
-    const char fmins_str         [DISASSEM_STR_SIZE] = "fmin.s   ";
-    const char fmaxs_str         [DISASSEM_STR_SIZE] = "fmax.s   ";
-    const char fcvtws_str        [DISASSEM_STR_SIZE] = "fcvt.w.s ";
-    const char fcvtwus_str       [DISASSEM_STR_SIZE] = "fcvt.wu.s";
-    const char fmvxw_str         [DISASSEM_STR_SIZE] = "fmv.x.w  ";
-    const char feqs_str          [DISASSEM_STR_SIZE] = "feq.s    ";
-    const char flts_str          [DISASSEM_STR_SIZE] = "flt.s    ";
-    const char fles_str          [DISASSEM_STR_SIZE] = "fle.s    ";
-    const char fclasss_str       [DISASSEM_STR_SIZE] = "fclass.s ";
-    const char fcvtsw_str        [DISASSEM_STR_SIZE] = "fcvt.s.w ";
-    const char fcvtswu_str       [DISASSEM_STR_SIZE] = "fcvt.s.wu";
-    const char fmvwx_str         [DISASSEM_STR_SIZE] = "fmv.w.x  ";
+    static constexpr char flw_str           [] = "flw      ";
+    static constexpr char fsw_str           [] = "fsw      ";
+    static constexpr char fmadds_str        [] = "fmadd.s  ";
+    static constexpr char fmsubs_str        [] = "fmsub.s  ";
+    static constexpr char fnmsubs_str       [] = "fnmsub.s ";
+    static constexpr char fnmadds_str       [] = "fnmadd.s ";
+    static constexpr char fadds_str         [] = "fadd.s   ";
+    static constexpr char fsubs_str         [] = "fsub.s   ";
+    static constexpr char fmuls_str         [] = "fmul.s   ";
+    static constexpr char fdivs_str         [] = "fdiv.s   ";
+    static constexpr char fsqrts_str        [] = "fsqrt.s  ";
+    static constexpr char fsgnjs_str        [] = "fsgnj.s  ";
+    static constexpr char fsgnjns_str       [] = "fsgnjn.s ";
+    static constexpr char fsgnjxs_str       [] = "fsgnjx.s ";
+    static constexpr char fmins_str         [] = "fmin.s   ";
+    static constexpr char fmaxs_str         [] = "fmax.s   ";
+    static constexpr char fcvtws_str        [] = "fcvt.w.s ";
+    static constexpr char fcvtwus_str       [] = "fcvt.wu.s";
+    static constexpr char fmvxw_str         [] = "fmv.x.w  ";
+    static constexpr char feqs_str          [] = "feq.s    ";
+    static constexpr char flts_str          [] = "flt.s    ";
+    static constexpr char fles_str          [] = "fle.s    ";
+    static constexpr char fclasss_str       [] = "fclass.s ";
+    static constexpr char fcvtsw_str        [] = "fcvt.s.w ";
+    static constexpr char fcvtswu_str       [] = "fcvt.s.wu";
+    static constexpr char fmvwx_str         [] = "fmv.w.x  ";
 
     int        curr_rnd_method;
 
+protected:
     // ------------------------------------------------
     // Virtual member functions
     // ------------------------------------------------
 
     // These functions are virtual so that they can be overridden,
     // if need be, by the rv32d_cpu class, which implements its own
-    // versions (even when the same functionality) so that it does
-    // not rely on the presence of this class in the class hierarchy.
+    // versions (even when the same functionality), and protected so
+    // that its versions can offer accesses to these first.
 
     // CSR access routines
     virtual uint32_t csr_wr_mask   (const uint32_t addr, bool& unimp);
@@ -121,6 +150,7 @@ private:
         }
     }
 
+private:
     // ------------------------------------------------
     // Private member functions
     // ------------------------------------------------
@@ -139,30 +169,30 @@ private:
 protected:
 
     // RV32F extension instruction methods
-    void flw                             (const p_rv32i_decode_t);
-    void fsw                             (const p_rv32i_decode_t);
-    void fmadds                          (const p_rv32i_decode_t);
-    void fmsubs                          (const p_rv32i_decode_t);
-    void fnmsubs                         (const p_rv32i_decode_t);
-    void fnmadds                         (const p_rv32i_decode_t);
-    void fadds                           (const p_rv32i_decode_t);
-    void fsubs                           (const p_rv32i_decode_t);
-    void fmuls                           (const p_rv32i_decode_t); 
-    void fdivs                           (const p_rv32i_decode_t);
-    void fsqrts                          (const p_rv32i_decode_t);
-    void fsgnjs                          (const p_rv32i_decode_t);
-    void fsgnjns                         (const p_rv32i_decode_t);
-    void fsgnjxs                         (const p_rv32i_decode_t);
-    void fmins                           (const p_rv32i_decode_t);
-    void fmaxs                           (const p_rv32i_decode_t);
-    void fcvtws                          (const p_rv32i_decode_t);
-    void feqs                            (const p_rv32i_decode_t);
-    void flts                            (const p_rv32i_decode_t);
-    void fles                            (const p_rv32i_decode_t);
-    void fclasss                         (const p_rv32i_decode_t);
-    void fcvtsw                          (const p_rv32i_decode_t);
-    void fmvwx                           (const p_rv32i_decode_t);
-    void fmvxw                           (const p_rv32i_decode_t);
+    template <bool TRACE> void flw       (const p_rv32i_decode_t);
+    template <bool TRACE> void fsw       (const p_rv32i_decode_t);
+    template <bool TRACE> void fmadds    (const p_rv32i_decode_t);
+    template <bool TRACE> void fmsubs    (const p_rv32i_decode_t);
+    template <bool TRACE> void fnmsubs   (const p_rv32i_decode_t);
+    template <bool TRACE> void fnmadds   (const p_rv32i_decode_t);
+    template <bool TRACE> void fadds     (const p_rv32i_decode_t);
+    template <bool TRACE> void fsubs     (const p_rv32i_decode_t);
+    template <bool TRACE> void fmuls     (const p_rv32i_decode_t); 
+    template <bool TRACE> void fdivs     (const p_rv32i_decode_t);
+    template <bool TRACE> void fsqrts    (const p_rv32i_decode_t);
+    template <bool TRACE> void fsgnjs    (const p_rv32i_decode_t);
+    template <bool TRACE> void fsgnjns   (const p_rv32i_decode_t);
+    template <bool TRACE> void fsgnjxs   (const p_rv32i_decode_t);
+    template <bool TRACE> void fmins     (const p_rv32i_decode_t);
+    template <bool TRACE> void fmaxs     (const p_rv32i_decode_t);
+    template <bool TRACE> void fcvtws    (const p_rv32i_decode_t);
+    template <bool TRACE> void feqs      (const p_rv32i_decode_t);
+    template <bool TRACE> void flts      (const p_rv32i_decode_t);
+    template <bool TRACE> void fles      (const p_rv32i_decode_t);
+    template <bool TRACE> void fclasss   (const p_rv32i_decode_t);
+    template <bool TRACE> void fcvtsw    (const p_rv32i_decode_t);
+    template <bool TRACE> void fmvwx     (const p_rv32i_decode_t);
+    template <bool TRACE> void fmvxw     (const p_rv32i_decode_t);
 };
 
 #endif
@@ -31,8 +31,128 @@
 
 #include <cstring>
 #include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <typeinfo>
+
+#if defined (_WIN32) || defined (_WIN64)
+# define  WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#else
+# include <sys/mman.h>
+# include <signal.h>
+#endif
 
 #include "rv32i_cpu.h"
+#include "rv32.h"
+
+// -------------------------------------------------------------------------
+// STATIC DATA
+// -------------------------------------------------------------------------
+
+// Flattened decode lookups generated so far, one for each class of core
+// run, and the lock serialising their generation
+static rv32i_decode_lookup_t*             dec_lookups = NULL;
+static std::mutex                         dec_lookup_mutex;
+
+// Decode tables allocated for generating a lookup, freed once it is generated
+static std::vector<rv32i_decode_table_t*> dec_tbls;
+
+#define RSVD_VALID                        0x1U
+#define RSVD_NO_SLOT                      -1
+#define RSVD_GRANULE(_addr)               ((_addr) & ~(uint32_t)(RV32I_RSVD_GRANULE_BYTES-1))
+#define RSVD_IDX(_addr)                   (((_addr) / RV32I_RSVD_GRANULE_BYTES) & RV32I_RSVD_TBL_MASK)
+#define RSVD_ENTRY(_addr)                 (RSVD_GRANULE(_addr) | RSVD_VALID)
+
+// -------------------------------------------------------------------------
+// RESERVATION DOMAIN METHODS
+// -------------------------------------------------------------------------
+
+rv32i_rsvd_domain::rv32i_rsvd_domain() : slots_used(0)
+{
+    for (int slot = 0; slot < RV32I_RSVD_MAX_CORES; slot++)
+    {
+        slots[slot] = 0;
+    }
+
+    for (int idx = 0; idx < RV32I_RSVD_TBL_SIZE; idx++)
+    {
+        holders[idx] = 0;
+    }
+}
+
+// Allocate a free reservation slot, returning RSVD_NO_SLOT if none are
+int rv32i_rsvd_domain::alloc_slot()
+{
+    uint64_t used = slots_used.load();
+
+    for (int slot = 0; slot < RV32I_RSVD_MAX_CORES; slot++)
+    {
+        uint64_t bit = 1ULL << slot;
+
+        if (!(used & bit))
+        {
+            if (slots_used.compare_exchange_strong(used, used | bit))
+            {
+                slots[slot] = 0;
+                return slot;
+            }
+
+            // Another core took a slot first, so start again with those now used
+            slot = -1;
+        }
+    }
+
+    return RSVD_NO_SLOT;
+}
+
+void rv32i_rsvd_domain::free_slot(const int slot)
+{
+    slots[slot] = 0;
+    slots_used.fetch_and(~(1ULL << slot));
+}
+
+// Only the slots flagged in the granule's holders entry are checked, so that
+// stores to granules no core has reserved only read the entry
+void rv32i_rsvd_domain::clear(const uint32_t byte_addr)
+{
+    uint64_t h = holders[RSVD_IDX(byte_addr)].load();
+
+    for (int slot = 0; h != 0; slot++, h >>= 1)
+    {
+        uint32_t entry = RSVD_ENTRY(byte_addr);
+
+        if (h & 1)
+        {
+            slots[slot].compare_exchange_strong(entry, 0);
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+// TIME BASE METHODS
+// -------------------------------------------------------------------------
+
+rv32i_time_base::rv32i_time_base()
+{
+    time_mode       = RV32I_TIME_REAL;
+    cycles_per_tick = RV32I_DEFAULT_CYCLES_PER_TICK;
+    pace_wall_base  = 0;
+    pace_mtime_base = 0;
+    sys_cycles      = 0;
+}
+
+// The system's cycle count carries on from any previous run
+void rv32i_time_base::start(const rv32i_cfg_s &cfg)
+{
+    using namespace std::chrono;
+
+    time_mode       = cfg.time_mode;
+    cycles_per_tick = cfg.cycles_per_tick ? cfg.cycles_per_tick : 1;
+    pace_wall_base  = time_point_cast<microseconds>(system_clock::now()).time_since_epoch().count();
+    pace_mtime_base = sys_cycles / cycles_per_tick;
+}
 
 // -------------------------------------------------------------------------
 // METHODS
@@ -43,6 +163,48 @@ rv32i_cpu::rv32i_cpu(FILE* dbg_fp) : dasm_fp(dbg_fp)
 {
     // No callback functions registered by default
     p_mem_callback     = NULL;
+    p_page_callback    = NULL;
+
+    // Empty memory map, and no RAM mapped in the TLB
+    num_regions        = 0;
+    p_last_region      = NULL;
+    flush_tlb();
+
+    // Default internal memory
+    int_mem            = NULL;
+    int_mem_size       = 0;
+    int_mem_shared     = false;
+    set_int_mem(RV32I_INT_MEM_BASE, RV32I_INT_MEM_SIZE);
+
+    // Own time base
+    p_time_base        = NULL;
+    run_cycle_base     = 0;
+
+    // No LR/SC reservation held
+    p_rsvd_domain      = NULL;
+    rsvd_slot          = RSVD_NO_SLOT;
+    rsvd_held          = false;
+    rsvd_addr          = 0;
+    rsvd_val           = 0;
+
+    // No reserved guest address space by default
+    guest_mem          = NULL;
+    guest_fault        = false;
+
+    // No lazily loaded executable
+    lazy_file          = NULL;
+    lazy_size          = 0;
+    lazy_num_segs      = 0;
+    lazy_pending       = 0;
+
+    // No symbols
+    syms               = NULL;
+    num_syms           = 0;
+    lines              = NULL;
+    num_lines          = 0;
+    sym_pool           = NULL;
+    dasm_file          = NULL;
+    dasm_line          = 0;
 
     // Cycle count set to 0
     cycle_count        = 0;
@@ -55,8 +217,77 @@ rv32i_cpu::rv32i_cpu(FILE* dbg_fp) : dasm_fp(dbg_fp)
 
     reset_vector       = RV32I_RESET_VECTOR;
 
+    // No basic block cache until first used
+    blk_tbl            = NULL;
+    blk_tbl_mask       = 0;
+    blk_pool           = NULL;
+    blk_pool_size      = 0;
+    blk_filter         = NULL;
+    blk_filter_mask    = 0;
+    blk_en             = false;
+    blk_exec_count     = 0;
+    blk_chain_count    = 0;
+    blk_build_count    = 0;
+
+    // No JIT code cache until first used
+    jit_code           = NULL;
+    jit_code_size      = 0;
+    jit_code_idx       = 0;
+    jit_seg_pool       = NULL;
+    jit_en             = false;
+    jit_check          = false;
+    jit_trans_count    = 0;
+    jit_exec_count     = 0;
+    jit_check_count    = 0;
+
+    // Interpreter execution engine by default
+    thr_en             = false;
+    instr_run_count    = 0;
+    limit_reached      = false;
+
+    // No decoded instruction cache until first run
+    dcache             = NULL;
+    dcache_mask        = 0;
+    dcache_en          = true;
+    dcache_hit_count   = 0;
+    dcache_miss_count  = 0;
+
+    // The flattened decode lookup is generated (or shared with another
+    // core of the same class) on the first run
+    p_dec              = NULL;
+
     // Reset state
     reset();
+};
+
+// -----------------------------------------------------------
+// Decode table set up
+//
+// Only called when generating the flattened decode lookup
+// for the first core of a class, with any extensions
+// overriding this to add their instructions to the tables
+// of the class they extend.
+// -----------------------------------------------------------
+
+void rv32i_cpu::init_decode_tables()
+{
+    primary_tbl = new_decode_table(RV32I_NUM_PRIMARY_OPCODES);
+    load_tbl    = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    store_tbl   = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    branch_tbl  = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    op_imm_tbl  = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    op_tbl      = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    arith_tbl   = new_decode_table(RV32I_NUM_TERTIARY_OPCODES);
+    sri_tbl     = new_decode_table(RV32I_NUM_TERTIARY_OPCODES);
+    srr_tbl     = new_decode_table(RV32I_NUM_TERTIARY_OPCODES);
+    sll_tbl     = new_decode_table(RV32I_NUM_TERTIARY_OPCODES);
+    slt_tbl     = new_decode_table(RV32I_NUM_TERTIARY_OPCODES);
+    sltu_tbl    = new_decode_table(RV32I_NUM_TERTIARY_OPCODES);
+    xor_tbl     = new_decode_table(RV32I_NUM_TERTIARY_OPCODES);
+    or_tbl      = new_decode_table(RV32I_NUM_TERTIARY_OPCODES);
+    and_tbl     = new_decode_table(RV32I_NUM_TERTIARY_OPCODES);
+    sys_tbl     = new_decode_table(RV32I_NUM_SECONDARY_OPCODES);
+    e_tbl       = new_decode_table(RV32I_NUM_SYSTEM_OPCODES);
 
     // Set up decode tables for RV32I, as per The RISC-V Instruction Set Manual,
     // Volume I: RISC-V Unprivileged ISA V20191213 chapter 24
@@ -64,84 +295,84 @@ rv32i_cpu::rv32i_cpu(FILE* dbg_fp) : dasm_fp(dbg_fp)
     // Initialse tertiary tables to reserved instruction
     for (int i = 0; i < RV32I_NUM_TERTIARY_OPCODES; i++)
     {
-        sri_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved };
-        arith_tbl[i]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved };
-        sll_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved };
-        slt_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved };
-        sltu_tbl[i]    = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved };
-        srr_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved };
-        xor_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved };
-        or_tbl[i]      = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved };
-        and_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved };
+        sri_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };
+        arith_tbl[i]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };
+        sll_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };
+        slt_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };
+        sltu_tbl[i]    = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };
+        srr_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };
+        xor_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };
+        or_tbl[i]      = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };
+        and_tbl[i]     = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };
     }
 
     // Seconary table for load instructions (decoded on funct3)
     int idx = 0;
-    load_tbl[idx++]    = {false, lb_str,       RV32I_INSTR_FMT_I,   &rv32i_cpu::lb };       /* LB */
-    load_tbl[idx++]    = {false, lh_str,       RV32I_INSTR_FMT_I,   &rv32i_cpu::lh };       /* LH */
-    load_tbl[idx++]    = {false, lw_str,       RV32I_INSTR_FMT_I,   &rv32i_cpu::lw };       /* LW */
-    load_tbl[idx++]    = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved }; /*RSVD*/
-    load_tbl[idx++]    = {false, lbu_str,      RV32I_INSTR_FMT_I,   &rv32i_cpu::lbu };      /* LBU*/
-    load_tbl[idx++]    = {false, lhu_str,      RV32I_INSTR_FMT_I,   &rv32i_cpu::lhu };      /* LHU*/
-    load_tbl[idx++]    = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved }; /*RSVD*/
-    load_tbl[idx++]    = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved }; /*RSVD*/
+    load_tbl[idx++]    = {false, lb_str,       RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, lb)       };    /* LB */
+    load_tbl[idx++]    = {false, lh_str,       RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, lh)       };    /* LH */
+    load_tbl[idx++]    = {false, lw_str,       RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, lw)       };    /* LW */
+    load_tbl[idx++]    = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
+    load_tbl[idx++]    = {false, lbu_str,      RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, lbu)      };    /* LBU*/
+    load_tbl[idx++]    = {false, lhu_str,      RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, lhu)      };    /* LHU*/
+    load_tbl[idx++]    = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
+    load_tbl[idx++]    = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
 
     // Seconary table for store instructions (decoded on funct3)
     idx = 0;
-    store_tbl[idx++]   = {false, sb_str,       RV32I_INSTR_FMT_S,   &rv32i_cpu::sb };       /* SB */
-    store_tbl[idx++]   = {false, sh_str,       RV32I_INSTR_FMT_S,   &rv32i_cpu::sh };       /* SH */
-    store_tbl[idx++]   = {false, sw_str,       RV32I_INSTR_FMT_S,   &rv32i_cpu::sw };       /* SW */
-    store_tbl[idx++]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved }; /*RSVD*/
-    store_tbl[idx++]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved }; /*RSVD*/
-    store_tbl[idx++]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved }; /*RSVD*/
-    store_tbl[idx++]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved }; /*RSVD*/
-    store_tbl[idx++]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved }; /*RSVD*/
+    store_tbl[idx++]   = {false, sb_str,       RV32I_INSTR_FMT_S,   RV32I_HANDLER(rv32i_cpu, sb)       };    /* SB */
+    store_tbl[idx++]   = {false, sh_str,       RV32I_INSTR_FMT_S,   RV32I_HANDLER(rv32i_cpu, sh)       };    /* SH */
+    store_tbl[idx++]   = {false, sw_str,       RV32I_INSTR_FMT_S,   RV32I_HANDLER(rv32i_cpu, sw)       };    /* SW */
+    store_tbl[idx++]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
+    store_tbl[idx++]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
+    store_tbl[idx++]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
+    store_tbl[idx++]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
+    store_tbl[idx++]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
 
     // Seconary table for branch instructions (decoded on funct3)
     idx = 0;
-    branch_tbl[idx++]  = {false, beq_str,      RV32I_INSTR_FMT_B,   &rv32i_cpu::beq };      /*BEQ*/
-    branch_tbl[idx++]  = {false, bne_str,      RV32I_INSTR_FMT_B,   &rv32i_cpu::bne };      /*BNE*/
-    branch_tbl[idx++]  = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved }; /*RSVD*/
-    branch_tbl[idx++]  = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved }; /*RSVD*/
-    branch_tbl[idx++]  = {false, blt_str,      RV32I_INSTR_FMT_B,   &rv32i_cpu::blt };      /*BLT*/
-    branch_tbl[idx++]  = {false, bge_str,      RV32I_INSTR_FMT_B,   &rv32i_cpu::bge };      /*BGE*/
-    branch_tbl[idx++]  = {false, bltu_str,     RV32I_INSTR_FMT_B,   &rv32i_cpu::bltu };     /*BLTU*/
-    branch_tbl[idx++]  = {false, bgeu_str,     RV32I_INSTR_FMT_B,   &rv32i_cpu::bgeu };     /*BGEU*/
+    branch_tbl[idx++]  = {false, beq_str,      RV32I_INSTR_FMT_B,   RV32I_HANDLER(rv32i_cpu, beq)      };    /*BEQ*/
+    branch_tbl[idx++]  = {false, bne_str,      RV32I_INSTR_FMT_B,   RV32I_HANDLER(rv32i_cpu, bne)      };    /*BNE*/
+    branch_tbl[idx++]  = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
+    branch_tbl[idx++]  = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
+    branch_tbl[idx++]  = {false, blt_str,      RV32I_INSTR_FMT_B,   RV32I_HANDLER(rv32i_cpu, blt)      };    /*BLT*/
+    branch_tbl[idx++]  = {false, bge_str,      RV32I_INSTR_FMT_B,   RV32I_HANDLER(rv32i_cpu, bge)      };    /*BGE*/
+    branch_tbl[idx++]  = {false, bltu_str,     RV32I_INSTR_FMT_B,   RV32I_HANDLER(rv32i_cpu, bltu)     };    /*BLTU*/
+    branch_tbl[idx++]  = {false, bgeu_str,     RV32I_INSTR_FMT_B,   RV32I_HANDLER(rv32i_cpu, bgeu)     };    /*BGEU*/
 
     // Tertiary table for shift right immediate instructions (decoded on funct7)
-    sri_tbl[0x00]      = {false, srli_str,     RV32I_INSTR_FMT_I,   &rv32i_cpu::srli };     /*SRLI*/
-    sri_tbl[0x20]      = {false, srai_str,     RV32I_INSTR_FMT_I,   &rv32i_cpu::srai };     /*SRAI*/
+    sri_tbl[0x00]      = {false, srli_str,     RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, srli) };    /*SRLI*/
+    sri_tbl[0x20]      = {false, srai_str,     RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, srai) };    /*SRAI*/
 
     // Seconary table for immediate operations instructions (decoded on funct3)
     idx = 0;
-    op_imm_tbl[idx++]  = {false, addi_str,     RV32I_INSTR_FMT_I,   &rv32i_cpu::addi };     /*ADDI*/
-    op_imm_tbl[idx++]  = {false, slli_str,     RV32I_INSTR_FMT_I,   &rv32i_cpu::slli };     /*SLLI*/
-    op_imm_tbl[idx++]  = {false, slti_str,     RV32I_INSTR_FMT_I,   &rv32i_cpu::slti };     /*SLTI*/
-    op_imm_tbl[idx++]  = {false, sltiu_str,    RV32I_INSTR_FMT_I,   &rv32i_cpu::sltiu };    /*SLTIU*/
-    op_imm_tbl[idx++]  = {false, xori_str,     RV32I_INSTR_FMT_I,   &rv32i_cpu::xori };     /*XORI*/
-    INIT_TBL_WITH_SUBTBL(op_imm_tbl[idx], sri_tbl); idx++;                                  /*SRLI and SRAI*/
-    op_imm_tbl[idx++]  = {false, ori_str,      RV32I_INSTR_FMT_I,   &rv32i_cpu::ori };      /*ORI*/
-    op_imm_tbl[idx++]  = {false, andi_str,     RV32I_INSTR_FMT_I,   &rv32i_cpu::andi };     /*ANDI*/
+    op_imm_tbl[idx++]  = {false, addi_str,     RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, addi)  };    /*ADDI*/
+    op_imm_tbl[idx++]  = {false, slli_str,     RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, slli)  };    /*SLLI*/
+    op_imm_tbl[idx++]  = {false, slti_str,     RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, slti)  };    /*SLTI*/
+    op_imm_tbl[idx++]  = {false, sltiu_str,    RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, sltiu) };    /*SLTIU*/
+    op_imm_tbl[idx++]  = {false, xori_str,     RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, xori)  };    /*XORI*/
+    INIT_TBL_WITH_SUBTBL(op_imm_tbl[idx], sri_tbl); idx++;                                                /*SRLI and SRAI*/
+    op_imm_tbl[idx++]  = {false, ori_str,      RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, ori)   };    /*ORI*/
+    op_imm_tbl[idx++]  = {false, andi_str,     RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, andi)  };    /*ANDI*/
 
     // Tertiary table for arithmetic instructions (decoded on funct7)
-    arith_tbl[0x00]    = {false, add_str,      RV32I_INSTR_FMT_R,   &rv32i_cpu::addr };     /*ADD*/
-    arith_tbl[0x20]    = {false, sub_str,      RV32I_INSTR_FMT_R,   &rv32i_cpu::subr };     /*SUB*/
+    arith_tbl[0x00]    = {false, add_str,      RV32I_INSTR_FMT_R,   RV32I_HANDLER(rv32i_cpu, addr) };    /*ADD*/
+    arith_tbl[0x20]    = {false, sub_str,      RV32I_INSTR_FMT_R,   RV32I_HANDLER(rv32i_cpu, subr) };    /*SUB*/
 
     // Tertiary table for shift left register to register instructions (decoded on funct7
-    sll_tbl[0x00]      = {false, sll_str,      RV32I_INSTR_FMT_R,   &rv32i_cpu::sllr };     /*SLL*/
+    sll_tbl[0x00]      = {false, sll_str,      RV32I_INSTR_FMT_R,   RV32I_HANDLER(rv32i_cpu, sllr) };    /*SLL*/
  
     // Tertiary table for set-less-than register to register instructions (decoded on funct7
-    slt_tbl[0x00]      = {false, slt_str,      RV32I_INSTR_FMT_R,   &rv32i_cpu::sltr };     /*SLT*/
-    sltu_tbl[0x00]     = {false, sltu_str,     RV32I_INSTR_FMT_R,   &rv32i_cpu::sltur };    /*SLTU*/
+    slt_tbl[0x00]      = {false, slt_str,      RV32I_INSTR_FMT_R,   RV32I_HANDLER(rv32i_cpu, sltr)  };    /*SLT*/
+    sltu_tbl[0x00]     = {false, sltu_str,     RV32I_INSTR_FMT_R,   RV32I_HANDLER(rv32i_cpu, sltur) };    /*SLTU*/
 
     // Tertiary table for shift right register to register instructions (decoded on funct7)
-    srr_tbl[0x00]      = {false, srl_str,      RV32I_INSTR_FMT_R,   &rv32i_cpu::srlr };     /*SRL*/
-    srr_tbl[0x20]      = {false, sra_str,      RV32I_INSTR_FMT_R,   &rv32i_cpu::srar };     /*SRA*/
+    srr_tbl[0x00]      = {false, srl_str,      RV32I_INSTR_FMT_R,   RV32I_HANDLER(rv32i_cpu, srlr) };    /*SRL*/
+    srr_tbl[0x20]      = {false, sra_str,      RV32I_INSTR_FMT_R,   RV32I_HANDLER(rv32i_cpu, srar) };    /*SRA*/
 
     // Tertiary table for logic operation register to register instructions (decoded on funct7
-    xor_tbl[0x00]      = {false, xor_str,      RV32I_INSTR_FMT_R,   &rv32i_cpu::xorr };     /*XOR*/
-    or_tbl[0x00]       = {false, or_str,       RV32I_INSTR_FMT_R,   &rv32i_cpu::orr };      /*OR*/
-    and_tbl[0x00]      = {false, and_str,      RV32I_INSTR_FMT_R,   &rv32i_cpu::andr };     /*AND*/
+    xor_tbl[0x00]      = {false, xor_str,      RV32I_INSTR_FMT_R,   RV32I_HANDLER(rv32i_cpu, xorr) };    /*XOR*/
+    or_tbl[0x00]       = {false, or_str,       RV32I_INSTR_FMT_R,   RV32I_HANDLER(rv32i_cpu, orr)  };    /*OR*/
+    and_tbl[0x00]      = {false, and_str,      RV32I_INSTR_FMT_R,   RV32I_HANDLER(rv32i_cpu, andr) };    /*AND*/
 
     // Seconary table for register to register operations instructions (decoded on funct3)
     idx = 0;
@@ -156,60 +387,59 @@ rv32i_cpu::rv32i_cpu(FILE* dbg_fp) : dasm_fp(dbg_fp)
 
      // Seconary table for immediate operations instructions (decoded on funct3)
     idx = 0;
-    op_imm_tbl[idx++]  = {false, addi_str,     RV32I_INSTR_FMT_I,   &rv32i_cpu::addi };
+    op_imm_tbl[idx++]  = {false, addi_str,     RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, addi) };
 
     // Update decode table with extended instructions
     idx = 0;
     // Tertiary table for ECALL and EBREAK instructions (decoded on funct12 = imm_i)
-    e_tbl[idx++]       = {false, ecall_str,    RV32I_INSTR_FMT_R,   &rv32i_cpu::ecall };    /*ECALL*/
-    e_tbl[idx++]       = {false, ebrk_str,     RV32I_INSTR_FMT_R,   &rv32i_cpu::ebreak };   /*EBREAK*/
-    e_tbl[idx++]       = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved };
-    e_tbl[idx++]       = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved };
+    e_tbl[idx++]       = {false, ecall_str,    RV32I_INSTR_FMT_R,   RV32I_HANDLER(rv32i_cpu, ecall)    };    /*ECALL*/
+    e_tbl[idx++]       = {false, ebrk_str,     RV32I_INSTR_FMT_R,   RV32I_HANDLER(rv32i_cpu, ebreak)   };    /*EBREAK*/
+    e_tbl[idx++]       = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };
+    e_tbl[idx++]       = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };
 
     // Secondary table for system instructions (decoded on funct3)
     idx = 0;
-    INIT_TBL_WITH_SUBTBL(sys_tbl[idx], e_tbl); idx++;                                       /*ECALL/EBREAK*/
+    INIT_TBL_WITH_SUBTBL(sys_tbl[idx], e_tbl); idx++;                                                        /*ECALL/EBREAK*/
     for (idx = 1; idx < RV32I_NUM_SECONDARY_OPCODES; idx++)
     {
-        sys_tbl[idx]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved }; /*RSVD*/
+        sys_tbl[idx]   = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
     }
 
     // Primary decode table (decoded on opcode)
     idx = 0;
-    INIT_TBL_WITH_SUBTBL(primary_tbl[idx], load_tbl); idx++;                                /*LOAD */
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*LOAD-FP*/ 
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*custom-0*/
-    primary_tbl[idx++] = {false, fence_str,    RV32I_INSTR_FMT_I,   &rv32i_cpu::fence};     /*MISC-MEM*/
-    INIT_TBL_WITH_SUBTBL(primary_tbl[idx], op_imm_tbl); idx++;                              /*OP-IMM*/
-    primary_tbl[idx++] = {false, auipc_str,    RV32I_INSTR_FMT_U,   &rv32i_cpu::auipc};     /*AUIPC*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*OP-IMM-32*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*48b*/
-    INIT_TBL_WITH_SUBTBL(primary_tbl[idx], store_tbl); idx++;                               /*STORE*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*STORE-FP*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*custom-1*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*AMO*/
-    INIT_TBL_WITH_SUBTBL(primary_tbl[idx], op_tbl); idx++;                                  /*OP*/
-    primary_tbl[idx++] = {false, lui_str,      RV32I_INSTR_FMT_R,   &rv32i_cpu::lui};       /*LUI*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*OP-32*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*64b*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*MADD*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*MSUB*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*NMSUB*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*NMADD*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*OP-FP*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*RSVD*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*RSVD128*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*48b*/
-    INIT_TBL_WITH_SUBTBL(primary_tbl[idx], branch_tbl); idx++;                              /*BRANCH*/
-    primary_tbl[idx++] = {false, jalr_str,     RV32I_INSTR_FMT_I,   &rv32i_cpu::jalr};      /*JALR*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*RSVD*/
-    primary_tbl[idx++] = {false, jal_str,      RV32I_INSTR_FMT_J,   &rv32i_cpu::jal};       /*JAL*/
-    INIT_TBL_WITH_SUBTBL(primary_tbl[idx], sys_tbl); idx++;                                 /*SYSTEM*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*RSVD*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*RSVD128*/
-    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, &rv32i_cpu::reserved};  /*>=80b*/
-
-};
+    INIT_TBL_WITH_SUBTBL(primary_tbl[idx], load_tbl); idx++;                                                 /*LOAD */
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*LOAD-FP*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*custom-0*/
+    primary_tbl[idx++] = {false, fence_str,    RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, fence)    };    /*MISC-MEM*/
+    INIT_TBL_WITH_SUBTBL(primary_tbl[idx], op_imm_tbl); idx++;                                               /*OP-IMM*/
+    primary_tbl[idx++] = {false, auipc_str,    RV32I_INSTR_FMT_U,   RV32I_HANDLER(rv32i_cpu, auipc)    };    /*AUIPC*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*OP-IMM-32*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*48b*/
+    INIT_TBL_WITH_SUBTBL(primary_tbl[idx], store_tbl); idx++;                                                /*STORE*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*STORE-FP*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*custom-1*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*AMO*/
+    INIT_TBL_WITH_SUBTBL(primary_tbl[idx], op_tbl); idx++;                                                   /*OP*/
+    primary_tbl[idx++] = {false, lui_str,      RV32I_INSTR_FMT_U,   RV32I_HANDLER(rv32i_cpu, lui)      };    /*LUI*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*OP-32*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*64b*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*MADD*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*MSUB*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*NMSUB*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*NMADD*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*OP-FP*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD128*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*48b*/
+    INIT_TBL_WITH_SUBTBL(primary_tbl[idx], branch_tbl); idx++;                                               /*BRANCH*/
+    primary_tbl[idx++] = {false, jalr_str,     RV32I_INSTR_FMT_I,   RV32I_HANDLER(rv32i_cpu, jalr)     };    /*JALR*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
+    primary_tbl[idx++] = {false, jal_str,      RV32I_INSTR_FMT_J,   RV32I_HANDLER(rv32i_cpu, jal)      };    /*JAL*/
+    INIT_TBL_WITH_SUBTBL(primary_tbl[idx], sys_tbl); idx++;                                                  /*SYSTEM*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*RSVD128*/
+    primary_tbl[idx++] = {false, reserved_str, RV32I_INSTR_ILLEGAL, RV32I_HANDLER(rv32i_cpu, reserved) };    /*>=80b*/
+}
 
 // -----------------------------------------------------------
 // Reset
@@ -231,12 +461,44 @@ void rv32i_cpu::reset()
 
     str_idx = 0;
 
+    // Timer compare disabled, and all events due for processing
+    mtimecmp = RV32I_EVENT_NEVER;
+
+    time_mode       = RV32I_TIME_REAL;
+    cycles_per_tick = RV32I_DEFAULT_CYCLES_PER_TICK;
+
+    for (int event = 0; event < RV32I_NUM_EVENTS; event++)
+    {
+        event_cycle[event] = 0;
+    }
+    next_event_cycle = 0;
+
     // Initialise register state for each supported HART
     for (unsigned idx = 0; idx < RV32I_NUM_OF_HARTS; idx++)
     {
-        state.hart[curr_hart].pc   = reset_vector;
+        state.hart[idx].pc   = reset_vector;
+
+        // Registers are clean from reset for dirty register tracking
+        clean_state[idx] = state.hart[idx];
+    }
+
+}
+
+// -----------------------------------------------------------
+// Number of entries in a cache, being the configured size
+// rounded down to a power of 2, or the default if it is 0
+// -----------------------------------------------------------
+
+static uint32_t cache_size(const uint32_t cfg_size, const uint32_t default_size)
+{
+    uint32_t size = cfg_size ? cfg_size : default_size;
+
+    while (size & (size - 1))
+    {
+        size &= size - 1;
     }
 
+    return size;
 }
 
 // -----------------------------------------------------------
@@ -252,10 +514,55 @@ int rv32i_cpu::run(rv32i_cfg_s &cfg)
     rt_disassem = cfg.rt_dis;
     disassemble = cfg.dis_en;
 
+    // Generate the flattened decode lookup on first run
+    if (p_dec == NULL && build_decode())
+    {
+        return USER_ERROR;
+    }
+
+    // Create the decoded instruction cache on first run, sized from that run's configuration
+    if (dcache == NULL)
+    {
+        dcache_mask = cache_size(cfg.dcache_size, RV32I_DCACHE_SIZE) - 1;
+        dcache      = new rv32i_dcache_entry_t[dcache_mask + 1];
+        flush_dcache();
+    }
+
     // Set halt switches
     halt_rsvd_instr = cfg.hlt_on_inst_err;
     halt_ecall      = cfg.hlt_on_ecall;
 
+    // Set mtime source. Virtual time is paced from the start of each run (or
+    // from the start of the system's run, configuring the source, when sharing
+    // a time base), and a changed source needs the timer comparing again.
+    if (p_time_base != NULL)
+    {
+        time_mode       = p_time_base->time_mode;
+        cycles_per_tick = p_time_base->cycles_per_tick;
+        pace_wall_base  = p_time_base->pace_wall_base;
+        pace_mtime_base = p_time_base->pace_mtime_base;
+        run_cycle_base  = cycle_count;
+    }
+    else
+    {
+        time_mode       = cfg.time_mode;
+        cycles_per_tick = cfg.cycles_per_tick ? cfg.cycles_per_tick : 1;
+        pace_wall_base  = real_time_us();
+        pace_mtime_base = mtime();
+    }
+
+    schedule_event(RV32I_EVENT_TIMER, cycle_count);
+    event_cycle[RV32I_EVENT_PACE] = RV32I_EVENT_NEVER;
+
+    if (time_mode == RV32I_TIME_PACED)
+    {
+        schedule_event(RV32I_EVENT_PACE, cycle_count + RV32I_PACE_CYCLES);
+    }
+
+    // State may have been altered between runs (e.g. by a debugger),
+    // so re-evaluate the interrupts before the first instruction
+    schedule_event(RV32I_EVENT_INT_UPDATE, cycle_count);
+
     // If a new start address specified, update the reset vector
     if (cfg.update_rst_vec)
     {
@@ -266,344 +573,2360 @@ int rv32i_cpu::run(rv32i_cfg_s &cfg)
         cfg.update_rst_vec       = false;
     }
 
-    rv32i_decode_t        decode;
-    rv32i_decode_table_t* p_entry;
+    // Disabling the decoded instruction cache discards its contents, so
+    // that it is empty should it be re-enabled on a later call
+    if (!cfg.en_dcache && dcache_en)
+    {
+        flush_dcache();
+    }
+    dcache_en = cfg.en_dcache;
+
+    // Basic blocks are built from decoded instruction cache entries, so need it enabled. Blocks
+    // are not used when disassembling, where every instruction is stepped through in sequence.
+    blk_en    = cfg.en_blk_cache && dcache_en && !disassemble;
+
+    // Create the basic block cache on first use, sized from that run's configuration,
+    // with a pool large enough for at least one block
+    if (blk_en && blk_tbl == NULL)
+    {
+        blk_tbl_mask    = cache_size(cfg.blk_tbl_size, RV32I_BLK_TBL_SIZE) - 1;
+        blk_pool_size   = cfg.blk_pool_size ? cfg.blk_pool_size : RV32I_BLK_POOL_SIZE;
+        blk_pool_size   = (blk_pool_size < RV32I_BLK_MAX_INSTR) ? RV32I_BLK_MAX_INSTR : blk_pool_size;
+        blk_filter_mask = cache_size(cfg.blk_filter_size, RV32I_BLK_FILTER_SIZE) - 1;
+
+        blk_tbl         = new rv32i_block_t[blk_tbl_mask + 1];
+        blk_pool        = new rv32i_dcache_entry_t[blk_pool_size];
+        blk_filter      = new uint8_t[blk_filter_mask + 1];
+        flush_blocks();
+    }
+
+    // The JIT translates blocks, so needs them enabled, and is not used when disassembling at run time
+    jit_en    = cfg.en_jit && blk_en && !rt_disassem;
+    jit_check = cfg.jit_check;
+
+    // Checking the JIT must not silently fall back to the interpreter, where there is nothing to check
+    if (jit_en && !RV32I_JIT_HOST_SUPPORTED)
+    {
+        if (jit_check)
+        {
+            fprintf(stderr, "***ERROR: JIT checking requested, but JIT not supported on this host\n");
+            return USER_ERROR;
+        }
+
+        fprintf(stderr, "***WARNING: JIT not supported on this host. Using interpreter\n");
+        jit_en = false;
+    }
+
+    // Create the JIT code cache on first use, sized from that run's configuration
+    if (jit_en && jit_code == NULL)
+    {
+        if (jit_alloc_code(cfg.jit_code_size ? cfg.jit_code_size : RV32I_JIT_CODE_SIZE))
+        {
+            jit_seg_pool = new rv32i_jit_seg_t[blk_pool_size];
+            flush_blocks();
+        }
+        else if (jit_check)
+        {
+            fprintf(stderr, "***ERROR: JIT checking requested, but unable to allocate JIT code cache\n");
+            return USER_ERROR;
+        }
+        else
+        {
+            fprintf(stderr, "***WARNING: unable to allocate JIT code cache. Using interpreter\n");
+            jit_en = false;
+        }
+    }
+
+    // The threaded dispatch engine executes blocks, and (as for the JIT) is not used when disassembling at run time
+    thr_en    = cfg.en_threaded && blk_en && !rt_disassem;
+
+    if (thr_en && !RV32I_THR_SUPPORTED)
+    {
+        fprintf(stderr, "***WARNING: threaded dispatch not supported by this build. Using interpreter\n");
+        thr_en = false;
+    }
+
+    // Any partially recorded block from a previous call is discarded
+    blk_rec = NULL;
+
+    // Run the traced variant of the execution loop (and instruction methods) only
+    // when disassembling, so that the untraced variant carries no disassembly cost
+    instr_count = 0;
+    error       = run_engine(cfg, instr_count, disassemble || rt_disassem);
 
-    for (instr_count = 0; 
-         (cfg.num_instr == 0 || instr_count < cfg.num_instr) && !error && !(cfg.en_brk_on_addr && cfg.brk_addr == state.hart[curr_hart].pc);
-         instr_count++)
+    // Any incomplete block is kept, as it is still a valid run of instructions
+    end_block();
+
+    instr_run_count += instr_count;
+    limit_reached    = false;
+
+    if (cfg.en_brk_on_addr && cfg.brk_addr == state.hart[curr_hart].pc)
+    {
+        error = SIGTERM;
+    }
+    // Reaching the instruction limit is only reported if not halted by its last instruction
+    else if (!error && cfg.num_instr != 0 && instr_count >= cfg.num_instr)
+    {
+        error         = SIGTRAP;
+        limit_reached = true;
+    }
+
+    return error;
+}
+
+// -----------------------------------------------------------
+// Process the due events, returning non-zero if an interrupt
+// was raised
+// -----------------------------------------------------------
+
+template <class CORE>
+int rv32i_cpu::process_events()
+{
+    if (event_due(RV32I_EVENT_PACE))
+    {
+        pace_time();
+    }
+
+    // Processes the due interrupt events, and recalculates the
+    // next event, including any rescheduled pacing
+    return static_cast<CORE*>(this)->core_process_interrupts();
+}
+
+// -----------------------------------------------------------
+// Pace virtual time to the wall clock, sleeping for as long
+// as mtime is ahead of the wall clock time since the run began
+// -----------------------------------------------------------
+
+void rv32i_cpu::pace_time()
+{
+    rv32i_time_t ahead_us = (mtime() - pace_mtime_base) - ((rv32i_time_t)real_time_us() - pace_wall_base);
+
+    if (ahead_us > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(ahead_us));
+    }
+
+    event_cycle[RV32I_EVENT_PACE] = cycle_count + RV32I_PACE_CYCLES;
+}
+
+// -----------------------------------------------------------
+// Run the execution loop for this class, with the hooks it
+// calls bound through their virtual methods
+// -----------------------------------------------------------
+
+int rv32i_cpu::run_engine(rv32i_cfg_s &cfg, unsigned &instr_count, const bool trace)
+{
+    return trace ? run_loop<rv32i_cpu, true>(cfg, instr_count) : run_loop<rv32i_cpu, false>(cfg, instr_count);
+}
+
+// -----------------------------------------------------------
+// Execution loop, running until the instruction count or a
+// break address is reached, or an error. The instruction
+// count is updated with those executed.
+// -----------------------------------------------------------
+
+template <class CORE, bool TRACE>
+int rv32i_cpu::run_loop(rv32i_cfg_s &cfg, unsigned &instr_count)
+{
+    int            error = 0;
+    rv32i_block_t* p_blk = NULL;
+
+    while ((cfg.num_instr == 0 || instr_count < cfg.num_instr) && !error && !(cfg.en_brk_on_addr && cfg.brk_addr == state.hart[curr_hart].pc))
     {
-        // Firstly, check interrupt status
-        if (!process_interrupts())
+        // Firstly, check interrupt status if an interrupt event is due. With the
+        // block cache enabled, this is at block boundaries (and each instruction
+        // whilst a block is recorded).
+        if (cycle_count >= next_event_cycle && process_events<CORE>())
+        {
+            // Finish any block being recorded at the interrupted instruction
+            end_block();
+            p_blk = NULL;
+        }
+        else if (blk_en)
         {
-            // Fetch instruction
-            curr_instr = fetch_instruction();
+            uint32_t       pc     = state.hart[curr_hart].pc;
+            rv32i_block_t* p_next = NULL;
 
-            // Decode
-            p_entry = primary_decode(curr_instr, decode);
+            // Follow a chain from the last executed block, if its successor at this
+            // address is still valid, else look up the block table
+            if (p_blk != NULL)
+            {
+                int chain_idx = (pc == p_blk->tag + 4*p_blk->num_instr) ? RV32I_BLK_CHAIN_NOT_TAKEN : RV32I_BLK_CHAIN_TAKEN;
+
+                p_next = p_blk->p_chain[chain_idx];
 
-            // Execute
-            if (p_entry != NULL)
+                if (p_next != NULL && p_next->tag == pc)
+                {
+                    blk_chain_count++;
+                }
+                else
+                {
+                    p_next = &blk_tbl[(pc >> 2) & blk_tbl_mask];
+
+                    if (p_next->tag == pc)
+                    {
+                        p_blk->p_chain[chain_idx] = p_next;
+                    }
+                    else
+                    {
+                        p_next = NULL;
+                    }
+                }
+            }
+            else if (blk_tbl[(pc >> 2) & blk_tbl_mask].tag == pc)
             {
-                error = execute(decode, p_entry);
+                p_next = &blk_tbl[(pc >> 2) & blk_tbl_mask];
             }
-            else
+
+            p_blk = p_next;
+
+            if (p_blk != NULL)
             {
-                if (!halt_rsvd_instr)
+                uint32_t max_instr = p_blk->num_instr;
+
+                // Any block being recorded ends where an existing one starts
+                end_block();
+
+                // Limit the block's execution to the number of instructions remaining
+                if (cfg.num_instr != 0 && (cfg.num_instr - instr_count) < max_instr)
                 {
-                    process_trap(RV32I_ILLEGAL_INSTR);
+                    max_instr = cfg.num_instr - instr_count;
                 }
-                else
+
+                // Limit the block's execution to stop at any break address within it
+                if (cfg.en_brk_on_addr && (cfg.brk_addr - pc) < 4*max_instr && !((cfg.brk_addr - pc) & 0x3))
+                {
+                    max_instr = (cfg.brk_addr - pc) >> 2;
+                }
+
+                error = execute_block<TRACE>(p_blk, max_instr, instr_count);
+
+                continue;
+            }
+
+            // No block at this address, so record one whilst stepping its instructions
+            if (blk_rec == NULL)
+            {
+                start_block(pc);
+            }
+
+            if (blk_rec != NULL)
+            {
+                uint32_t              next_pc = pc + 4;
+                rv32i_dcache_entry_t* p_rec   = &blk_rec->p_instr[blk_rec->num_instr];
+
+                error = step<TRACE>(p_rec);
+
+                // A block is ended at an instruction that could not be decoded (not recorded), a control
+                // flow, system, fence or reserved instruction, or when execution is not sequential.
+                if (p_rec->tag == RV32I_DCACHE_INVALID_TAG)
+                {
+                    end_block();
+                }
+                else if (blk_rec != NULL)
                 {
-                    error = SIGILL;
+                    uint32_t idx = (p_rec->decode.opcode >> 2);
+
+                    blk_rec->num_instr++;
+
+                    if (error || blk_rec->num_instr == RV32I_BLK_MAX_INSTR || state.hart[curr_hart].pc != next_pc ||
+                        idx == RV32I_BRANCH_IDX || idx == RV32I_JAL_IDX    || idx == RV32I_JALR_IDX ||
+                        idx == RV32I_SYSTEM_IDX || idx == RV32I_MISC_MEM_IDX || p_rec->p_entry->p == &rv32i_cpu::reserved<false>)
+                    {
+                        end_block();
+                    }
                 }
             }
+            else
+            {
+                error = step<TRACE>(NULL);
+            }
+        }
+        else
+        {
+            error = step<TRACE>(NULL);
+        }
+
+        instr_count++;
+    }
+
+    return error;
+}
+
+// The execution loops of the supported configurations' final classes (see rv32.h)
+template int rv32i_cpu::run_loop<rv32i_core,   false>(rv32i_cfg_s &cfg, unsigned &instr_count);
+template int rv32i_cpu::run_loop<rv32i_core,   true> (rv32i_cfg_s &cfg, unsigned &instr_count);
+template int rv32i_cpu::run_loop<rv32im_core,  false>(rv32i_cfg_s &cfg, unsigned &instr_count);
+template int rv32i_cpu::run_loop<rv32im_core,  true> (rv32i_cfg_s &cfg, unsigned &instr_count);
+template int rv32i_cpu::run_loop<rv32ima_core, false>(rv32i_cfg_s &cfg, unsigned &instr_count);
+template int rv32i_cpu::run_loop<rv32ima_core, true> (rv32i_cfg_s &cfg, unsigned &instr_count);
+template int rv32i_cpu::run_loop<rv32g_core,   false>(rv32i_cfg_s &cfg, unsigned &instr_count);
+template int rv32i_cpu::run_loop<rv32g_core,   true> (rv32i_cfg_s &cfg, unsigned &instr_count);
+
+// -----------------------------------------------------------
+// Execute an instruction
+// -----------------------------------------------------------
+
+template <bool TRACE>
+int  rv32i_cpu::execute(rv32i_decode_t& decode, rv32i_handler_t* p_entry)
+{
+    int error = 0;
+
+    // Label the start of each symbol in the disassembly
+    if (TRACE && num_syms)
+    {
+        uint32_t    offset;
+        const char* p_name = lookup_symbol(state.hart[curr_hart].pc, offset);
+
+        if (p_name != NULL && offset == 0)
+        {
+            fprintf(dasm_fp, "%08x <%s>:\n", state.hart[curr_hart].pc, p_name);
+        }
+    }
+
+    // Label each change of source line in the disassembly (as for objdump -l)
+    if (TRACE && num_lines)
+    {
+        uint32_t    line;
+        const char* p_file = lookup_line(state.hart[curr_hart].pc, line);
+
+        if (p_file != NULL && (p_file != dasm_file || line != dasm_line))
+        {
+            fprintf(dasm_fp, "%s:%u\n", p_file, line);
         }
+
+        dasm_file = p_file;
+        dasm_line = p_file ? line : 0;
+    }
+ 
+    (this->*(TRACE ? p_entry->p_trace : p_entry->p))(&decode);
+ 
+    cycle_count += 1;
+
+    // If an illegal/unimplemented instruction, or halt on a system instruction, flag to calling function
+    if ((halt_rsvd_instr && trap) || (halt_ecall && (trap == SIGTERM || trap == SIGTRAP)))
+    {
+        error = trap;
+        trap = 0;
+    }
+
+    return error;
+}
+
+// The JIT and threaded dispatch engines only use the untraced variant
+template int rv32i_cpu::execute<false>(rv32i_decode_t& decode, rv32i_handler_t* p_entry);
+
+// -----------------------------------------------------------
+// Fetch, decode and execute a single instruction, using the
+// decoded instruction cache. If p_rec is not NULL, the decoded
+// instruction is copied to it, with an invalid tag if it could
+// not be decoded (or its fetch faulted).
+// -----------------------------------------------------------
+
+template <bool TRACE>
+int rv32i_cpu::step(rv32i_dcache_entry_t* p_rec)
+{
+    int                   error = 0;
+    uint32_t              pc    = state.hart[curr_hart].pc;
+    rv32i_dcache_entry_t  miss_entry;
+    rv32i_dcache_entry_t* p_dc  = &dcache[(pc >> 2) & dcache_mask];
+
+    // If the instruction at the PC has been decoded before, use the cached
+    // decode, accounting for the cycles its fetch would have taken
+    if (p_dc->tag == pc && dcache_en)
+    {
+        dcache_hit_count++;
+
+        cycle_count += p_dc->fetch_cycles;
+    }
+    else
+    {
+        rv32i_time_t fetch_start = cycle_count;
+
+        if (dcache_en)
+        {
+            dcache_miss_count++;
+        }
+
+        // Fetch instruction
+        miss_entry.decode.instr = fetch_instruction();
+
+        // Decode
+        miss_entry.p_entry      = primary_decode(miss_entry.decode.instr, miss_entry.decode);
+
+        // Only valid instructions can be cached, so long as the fetch did
+        // not fault (and redirect the PC)
+        miss_entry.tag          = (miss_entry.p_entry != NULL && state.hart[curr_hart].pc == pc) ? pc : RV32I_DCACHE_INVALID_TAG;
+        miss_entry.fetch_cycles = (uint32_t)(cycle_count - fetch_start);
+
+        if (dcache_en && miss_entry.tag != RV32I_DCACHE_INVALID_TAG)
+        {
+            *p_dc = miss_entry;
+        }
+
+        p_dc = &miss_entry;
+    }
+
+    if (p_rec != NULL)
+    {
+        *p_rec = *p_dc;
+    }
+
+    curr_instr = p_dc->decode.instr;
+
+    // Execute
+    if (p_dc->p_entry != NULL)
+    {
+        error = execute<TRACE>(p_dc->decode, p_dc->p_entry);
+    }
+    else
+    {
+        if (!halt_rsvd_instr)
+        {
+            process_trap(RV32I_ILLEGAL_INSTR);
+        }
+        else
+        {
+            error = SIGILL;
+        }
+    }
+
+    return error;
+}
+
+// -----------------------------------------------------------
+// Execute up to max_instr instructions of a basic block,
+// stopping early on an error, a non-sequential PC update
+// (e.g. a trap), or a request to exit the block. The
+// instruction count is updated with those executed. The
+// block is passed to the JIT or threaded dispatch engine
+// when enabled.
+// -----------------------------------------------------------
+
+template <bool TRACE>
+int rv32i_cpu::execute_block(rv32i_block_t* p_blk, uint32_t max_instr, unsigned &instr_count)
+{
+    int                   error   = 0;
+    uint32_t              next_pc = p_blk->tag;
+    uint32_t              idx     = 0;
+    rv32i_dcache_entry_t* p_instr = p_blk->p_instr;
+
+    // Run the block as native code once hot, unless it is to be cut short
+    if (jit_en && max_instr == p_blk->num_instr)
+    {
+        if (p_blk->jit_state == RV32I_JIT_NONE && ++p_blk->exec_count >= RV32I_JIT_THRESHOLD)
+        {
+            jit_translate(p_blk);
+        }
+
+        if (p_blk->jit_state == RV32I_JIT_DONE)
+        {
+            return jit_execute_block(p_blk, instr_count);
+        }
+    }
+
+    if (thr_en)
+    {
+        return thr_execute_block(p_blk, max_instr, instr_count);
+    }
+
+    blk_exec_count++;
+
+    blk_exit = false;
+
+    while (idx < max_instr)
+    {
+        cycle_count += p_instr->fetch_cycles;
+        curr_instr   = p_instr->decode.instr;
+
+        error        = execute<TRACE>(p_instr->decode, p_instr->p_entry);
+
+        idx++;
+        p_instr++;
+        next_pc     += 4;
+
+        if (error || blk_exit || state.hart[curr_hart].pc != next_pc)
+        {
+            break;
+        }
+    }
+
+    instr_count += idx;
+
+    return error;
+}
+
+// -----------------------------------------------------------
+// Start recording a new basic block at the given address,
+// flushing the block cache if the pool can't hold a
+// maximum sized block.
+// -----------------------------------------------------------
+
+void rv32i_cpu::start_block(const uint32_t pc)
+{
+    if (blk_pool_idx + RV32I_BLK_MAX_INSTR > blk_pool_size)
+    {
+        flush_blocks();
+    }
+
+    blk_rec             = &blk_tbl[(pc >> 2) & blk_tbl_mask];
+    blk_rec_pc          = pc;
+
+    // Replacing any old block in the table
+    blk_rec->tag        = RV32I_DCACHE_INVALID_TAG;
+    blk_rec->num_instr  = 0;
+    blk_rec->p_instr    = &blk_pool[blk_pool_idx];
+    blk_rec->p_chain[RV32I_BLK_CHAIN_TAKEN]     = NULL;
+    blk_rec->p_chain[RV32I_BLK_CHAIN_NOT_TAKEN] = NULL;
+    blk_rec->exec_count = 0;
+    blk_rec->jit_state  = RV32I_JIT_NONE;
+    blk_rec->thr_ready  = false;
+}
+
+// -----------------------------------------------------------
+// Complete the block being recorded (if any), making it valid
+// if it has at least one instruction
+// -----------------------------------------------------------
+
+void rv32i_cpu::end_block()
+{
+    if (blk_rec != NULL && blk_rec->num_instr)
+    {
+        uint32_t end_addr = blk_rec_pc + 4*blk_rec->num_instr - 1;
+
+        // Flag the lines covered by the block in the filter (at most two)
+        blk_filter[(blk_rec_pc >> RV32I_BLK_LINE_BITS) & blk_filter_mask] = 1;
+        blk_filter[(end_addr   >> RV32I_BLK_LINE_BITS) & blk_filter_mask] = 1;
+
+        blk_rec->tag  = blk_rec_pc;
+        blk_pool_idx += blk_rec->num_instr;
+
+        blk_build_count++;
+    }
+
+    blk_rec = NULL;
+}
+
+// -----------------------------------------------------------
+// Invalidate any block containing the given address. Any
+// block executing is requested to exit, and any recording
+// of a block that may include the address is abandoned.
+// -----------------------------------------------------------
+
+void rv32i_cpu::invalidate_blocks(const uint32_t byte_addr)
+{
+    uint32_t word_addr = byte_addr & MASK_INSTR_ADDR;
+
+    // A block containing the address must start within a maximum block's length before it
+    for (uint32_t offset = 0; offset < 4*RV32I_BLK_MAX_INSTR; offset += 4)
+    {
+        uint32_t       start = word_addr - offset;
+        rv32i_block_t* p_blk = &blk_tbl[(start >> 2) & blk_tbl_mask];
+
+        if (p_blk->tag == start && offset < 4*p_blk->num_instr)
+        {
+            p_blk->tag = RV32I_DCACHE_INVALID_TAG;
+            blk_exit   = true;
+        }
+    }
+
+    if (blk_rec != NULL && (word_addr - blk_rec_pc) < 4*RV32I_BLK_MAX_INSTR)
+    {
+        blk_rec  = NULL;
+        blk_exit = true;
+    }
+}
+
+// -----------------------------------------------------------
+// Invalidate all basic blocks and free the pool (and any
+// JIT code translated from them)
+// -----------------------------------------------------------
+
+void rv32i_cpu::flush_blocks()
+{
+    if (blk_tbl != NULL)
+    {
+        for (uint32_t idx = 0; idx <= blk_tbl_mask; idx++)
+        {
+            blk_tbl[idx].tag = RV32I_DCACHE_INVALID_TAG;
+        }
+
+        memset(blk_filter, 0, blk_filter_mask + 1);
+    }
+
+    blk_pool_idx = 0;
+    jit_code_idx = 0;
+    blk_rec      = NULL;
+    blk_exit     = true;
+}
+
+// -----------------------------------------------------------
+// Bytes of host memory allocated for the decoded instruction,
+// basic block and JIT caches (the JIT code cache being
+// reserved in full, though only pages written are resident)
+// -----------------------------------------------------------
+
+uint64_t rv32i_cpu::cache_footprint()
+{
+    uint64_t bytes = 0;
+
+    if (dcache != NULL)
+    {
+        bytes += (uint64_t)(dcache_mask + 1) * sizeof(rv32i_dcache_entry_t);
+    }
+
+    if (blk_tbl != NULL)
+    {
+        bytes += (uint64_t)(blk_tbl_mask + 1) * sizeof(rv32i_block_t) +
+                 (uint64_t)blk_pool_size      * sizeof(rv32i_dcache_entry_t) +
+                 (uint64_t)(blk_filter_mask + 1);
+    }
+
+    if (jit_seg_pool != NULL)
+    {
+        bytes += (uint64_t)blk_pool_size * sizeof(rv32i_jit_seg_t);
+    }
+
+    if (jit_code != NULL)
+    {
+        bytes += jit_code_size;
+    }
+
+    return bytes;
+}
+
+// -----------------------------------------------------------
+// Decode table method
+//
+// Walk the (construction time) decode tables to find the
+// entry for an instruction. Only used to generate the
+// flattened decode lookup.
+//
+// Returns NULL on a failed decode, or a pointer to a
+// table entry.
+// -----------------------------------------------------------
+
+rv32i_decode_table_t* rv32i_cpu::table_decode(const opcode_t instr, rv32i_decode_t& decoded_data)
+{
+
+    rv32i_decode_table_t* p_entry = NULL;
+
+    decoded_data.instr  = instr;
+    decoded_data.opcode = (instr & RV32I_MASK_OPCODE)  >> RV32I_OPCODE_START_BIT;
+    decoded_data.funct3 = (instr & RV32I_MASK_FUNCT_3) >> RV32I_FUNCT_3_START_BIT;
+    decoded_data.funct7 = (instr & RV32I_MASK_FUNCT_7) >> RV32I_FUNCT_7_START_BIT;
+
+    // Check this is a 32 bit instruction before proceeding
+    if ((decoded_data.opcode & RV32I_MASK_32BIT_INSTR) == RV32I_MASK_32BIT_INSTR)
+    {
+        p_entry = &primary_tbl[decoded_data.opcode >> 2];
+
+        // Follow the tables down to until an instruction entry
+        if (p_entry->sub_table)
+        {
+            // Get secondary table entry, if there is one
+            p_entry = &p_entry->ref.p_entry[decoded_data.funct3];
+
+            // Get tertiary table entry, if there is one
+            if (p_entry->sub_table)
+            {
+                // Get entry indexed by funct7, unless a system opcode with funct3 = 0 (ECALL/EBREAK),
+                // where funct12 is used instead (the I type immediate field)
+                if (decoded_data.opcode == RV32I_SYS_OPCODE && decoded_data.funct3 == 0)
+                {
+                    // Mask imm value to ensure within table bounds.
+                    // TODO: Should really check for all 0s on other bits.
+                    p_entry = &p_entry->ref.p_entry[((instr & RV32I_MASK_IMM_I) >> RV32I_IMM_I_START_BIT) & 0x3];
+                }
+                else
+                {
+                    p_entry = &p_entry->ref.p_entry[decoded_data.funct7];
+                }
+
+                // It is illegal, in the base class, to have a fourth level of sub-table.
+                // Call virtual function so child classes can handle separately. Base
+                // class method returns NULL
+                if (p_entry->sub_table)
+                {
+                    decode_exception(p_entry, decoded_data);
+                }
+            }
+        }
+    }
+
+    return p_entry;
+}
+
+// -----------------------------------------------------------
+// Return the flattened decode lookup handler index for a
+// decode table entry, adding a new handler if not already
+// present. Returns -1 if the handler table is full.
+// -----------------------------------------------------------
+
+int rv32i_cpu::dec_handler_idx(const rv32i_decode_table_t* p_entry)
+{
+    if (p_entry == NULL)
+    {
+        return RV32I_DEC_NO_HANDLER;
+    }
+
+    for (uint32_t idx = RV32I_DEC_NO_HANDLER+1; idx < p_dec->num_handlers; idx++)
+    {
+        if (p_dec->handlers[idx].p          == p_entry->p                    &&
+            p_dec->handlers[idx].instr_name == p_entry->ref.entry.instr_name &&
+            p_dec->handlers[idx].instr_fmt  == p_entry->ref.entry.instr_fmt)
+        {
+            return idx;
+        }
+    }
+
+    if (p_dec->num_handlers == RV32I_DEC_MAX_HANDLERS)
+    {
+        return -1;
+    }
+
+    p_dec->handlers[p_dec->num_handlers] = {p_entry->p, p_entry->p_trace, p_entry->ref.entry.instr_name, p_entry->ref.entry.instr_fmt};
+
+    return p_dec->num_handlers++;
+}
+
+// -----------------------------------------------------------
+// Allocate a decode table, from init_decode_tables(). It is
+// freed once the flattened decode lookup is generated.
+// -----------------------------------------------------------
+
+rv32i_decode_table_t* rv32i_cpu::new_decode_table(const int size)
+{
+    rv32i_decode_table_t* p_tbl = new rv32i_decode_table_t[size]();
+
+    dec_tbls.push_back(p_tbl);
+
+    return p_tbl;
+}
+
+// -----------------------------------------------------------
+// Get the flattened decode lookup for this core's class,
+// generating it from the decode tables if this is the first
+// such core to be run. Cores of the same class have the same
+// instructions, so share (read only) a single lookup.
+//
+// Returns non-zero if the lookup tables are too small.
+// -----------------------------------------------------------
+
+int rv32i_cpu::build_decode()
+{
+    std::lock_guard<std::mutex> lock(dec_lookup_mutex);
+
+    for (p_dec = dec_lookups; p_dec != NULL; p_dec = p_dec->p_next)
+    {
+        if (*p_dec->p_type == typeid(*this))
+        {
+            return 0;
+        }
+    }
+
+    init_decode_tables();
+
+    p_dec = new rv32i_decode_lookup_t;
+
+    int error = gen_decode();
+
+    for (size_t idx = 0; idx < dec_tbls.size(); idx++)
+    {
+        delete [] dec_tbls[idx];
+    }
+    dec_tbls.clear();
+
+    if (error)
+    {
+        delete p_dec;
+        p_dec = NULL;
+    }
+    else
+    {
+        p_dec->p_type = &typeid(*this);
+        p_dec->p_next = dec_lookups;
+        dec_lookups   = p_dec;
+    }
+
+    return error;
+}
+
+// -----------------------------------------------------------
+// Generate the flattened decode lookup from the decode tables
+//
+// Every combination of opcode[6:2], funct3 and funct7 (or
+// funct12[1:0] for ECALL/EBREAK) is decoded via the tables.
+// Where an opcode/funct3 pair decodes to the same handler for
+// all values of funct7, the first level holds the handler
+// index directly, else it references a row (shared between
+// pairs with identical rows) decoded on funct7.
+//
+// Returns non-zero if the lookup tables are too small.
+// -----------------------------------------------------------
+
+int rv32i_cpu::gen_decode()
+{
+    rv32i_decode_t        decode;
+    uint8_t               row[RV32I_DEC_ROW_SIZE];
+
+    // Handler index 0 is a failed decode
+    p_dec->handlers[RV32I_DEC_NO_HANDLER] = {NULL, NULL, reserved_str, RV32I_INSTR_ILLEGAL};
+    p_dec->num_handlers                   = RV32I_DEC_NO_HANDLER+1;
+    p_dec->num_rows                       = 0;
+
+    for (uint32_t l1_idx = 0; l1_idx < RV32I_DEC_L1_SIZE; l1_idx++)
+    {
+        uint32_t opcode  = ((l1_idx / RV32I_NUM_SECONDARY_OPCODES) << 2) | RV32I_MASK_32BIT_INSTR;
+        uint32_t funct3  = l1_idx % RV32I_NUM_SECONDARY_OPCODES;
+        bool     funct12 = opcode == RV32I_SYS_OPCODE && funct3 == 0;
+        bool     uniform = true;
+
+        for (uint32_t key = 0; key < RV32I_DEC_ROW_SIZE; key++)
+        {
+            opcode_t instr = (funct3 << RV32I_FUNCT_3_START_BIT) | (opcode << RV32I_OPCODE_START_BIT) |
+                             (funct12 ? ((key & 0x3) << RV32I_IMM_I_START_BIT) : (key << RV32I_FUNCT_7_START_BIT));
+
+            int idx = dec_handler_idx(table_decode(instr, decode));
+
+            if (idx < 0)
+            {
+                fprintf(stderr, "***ERROR: too many instructions for decode lookup\n");
+                return USER_ERROR;
+            }
+
+            row[key] = idx;
+            uniform  = uniform && row[key] == row[0];
+        }
+
+        if (uniform)
+        {
+            p_dec->l1[l1_idx] = row[0];
+        }
+        else
+        {
+            // Share an existing identical row, if there is one
+            uint32_t row_idx;
+            for (row_idx = 0; row_idx < p_dec->num_rows; row_idx++)
+            {
+                if (memcmp(p_dec->rows[row_idx], row, RV32I_DEC_ROW_SIZE) == 0)
+                {
+                    break;
+                }
+            }
+
+            if (row_idx == p_dec->num_rows)
+            {
+                if (p_dec->num_rows == RV32I_DEC_MAX_ROWS)
+                {
+                    fprintf(stderr, "***ERROR: too many decode rows for decode lookup\n");
+                    return USER_ERROR;
+                }
+
+                memcpy(p_dec->rows[p_dec->num_rows++], row, RV32I_DEC_ROW_SIZE);
+            }
+
+            p_dec->l1[l1_idx] = RV32I_DEC_ROW_FLAG | (funct12 ? RV32I_DEC_FUNCT12_FLAG : 0) | row_idx;
+        }
+    }
+
+    return 0;
+}
+
+// -----------------------------------------------------------
+// Primary Decode method
+//
+// Decode the opcode and function fields, to look up the
+// instruction in the flattened decode lookup, and then only
+// the register and immediate fields used by the instruction's
+// format.
+// 
+// Returns NULL on a failed decode, or a pointer to an
+// instruction handler.
+// -----------------------------------------------------------
+
+rv32i_handler_t* rv32i_cpu::primary_decode(const opcode_t instr, rv32i_decode_t& decoded_data)
+{
+
+    rv32i_handler_t* p_entry = NULL;
+
+    // Extract the fields needed to look up the instruction
+    decoded_data.instr  = instr;
+    decoded_data.opcode = (instr & RV32I_MASK_OPCODE)  >> RV32I_OPCODE_START_BIT;
+    decoded_data.funct3 = (instr & RV32I_MASK_FUNCT_3) >> RV32I_FUNCT_3_START_BIT;
+    decoded_data.funct7 = (instr & RV32I_MASK_FUNCT_7) >> RV32I_FUNCT_7_START_BIT;
+
+    decoded_data.rd     = 0;
+    decoded_data.rs1    = 0;
+    decoded_data.rs2    = 0;
+    decoded_data.imm_i  = 0;
+
+    // Check this is a 32 bit instruction before proceeding
+    if ((decoded_data.opcode & RV32I_MASK_32BIT_INSTR) == RV32I_MASK_32BIT_INSTR)
+    {
+        uint32_t idx = p_dec->l1[((decoded_data.opcode >> 2) * RV32I_NUM_SECONDARY_OPCODES) | decoded_data.funct3];
+
+        // If decoded on funct7 (or funct12 for ECALL/EBREAK), index into the referenced row
+        if (idx & RV32I_DEC_ROW_FLAG)
+        {
+            uint32_t key = (idx & RV32I_DEC_FUNCT12_FLAG) ? ((instr >> RV32I_IMM_I_START_BIT) & 0x3) : decoded_data.funct7;
+
+            idx = p_dec->rows[idx & RV32I_DEC_IDX_MASK][key];
+        }
+
+        if (idx != RV32I_DEC_NO_HANDLER)
+        {
+            p_entry = &p_dec->handlers[idx];
+        }
+    }
+
+    // Extract the register and immediate fields for the instruction's format
+    if (p_entry != NULL)
+    {
+        switch (p_entry->instr_fmt)
+        {
+        case RV32I_INSTR_FMT_R:
+        case RV32I_INSTR_FMT_R4:
+            decoded_data.rd    = (instr & RV32I_MASK_Rx_RD)  >> RV32I_Rx_RD_START_BIT;
+            decoded_data.rs1   = (instr & RV32I_MASK_Rx_RS1) >> RV32I_Rx_RS1_START_BIT;
+            decoded_data.rs2   = (instr & RV32I_MASK_Rx_RS2) >> RV32I_Rx_RS2_START_BIT;
+            break;
+
+        case RV32I_INSTR_FMT_I:
+            decoded_data.rd    = (instr & RV32I_MASK_Rx_RD)  >> RV32I_Rx_RD_START_BIT;
+            decoded_data.rs1   = (instr & RV32I_MASK_Rx_RS1) >> RV32I_Rx_RS1_START_BIT;
+            decoded_data.imm_i = SIGN_EXT12((instr & RV32I_MASK_IMM_I) >> RV32I_IMM_I_START_BIT);
+            break;
+
+        case RV32I_INSTR_FMT_S:
+            decoded_data.rs1   = (instr & RV32I_MASK_Rx_RS1) >> RV32I_Rx_RS1_START_BIT;
+            decoded_data.rs2   = (instr & RV32I_MASK_Rx_RS2) >> RV32I_Rx_RS2_START_BIT;
+            decoded_data.imm_s = SIGN_EXT12((((instr & RV32I_MASK_IMM_S_11_5)  >> RV32I_IMM_S_11_5_START_BIT) << 5) |
+                                            (((instr & RV32I_MASK_IMM_S_4_0)   >> RV32I_IMM_S_4_0_START_BIT) << 0));
+            break;
+
+        case RV32I_INSTR_FMT_B:
+            decoded_data.rs1   = (instr & RV32I_MASK_Rx_RS1) >> RV32I_Rx_RS1_START_BIT;
+            decoded_data.rs2   = (instr & RV32I_MASK_Rx_RS2) >> RV32I_Rx_RS2_START_BIT;
+            decoded_data.imm_b = SIGN_EXT13((((instr & RV32I_MASK_IMM_B_12)    >> RV32I_IMM_B_12_START_BIT) << 12) |
+                                            (((instr & RV32I_MASK_IMM_B_11)    >> RV32I_IMM_B_11_START_BIT)   << 11) |
+                                            (((instr & RV32I_MASK_IMM_B_10_5)  >> RV32I_IMM_B_10_5_START_BIT) <<  5) |
+                                            (((instr & RV32I_MASK_IMM_B_4_1)   >> RV32I_IMM_B_4_1_START_BIT)  <<  1));
+            break;
+
+        case RV32I_INSTR_FMT_U:
+            decoded_data.rd    = (instr & RV32I_MASK_Rx_RD)  >> RV32I_Rx_RD_START_BIT;
+
+            // U type has immediate bits in matching instruction bit positions (incl. sign bit)
+            decoded_data.imm_u = (instr & RV32I_MASK_IMM_U);
+            break;
+
+        case RV32I_INSTR_FMT_J:
+            decoded_data.rd    = (instr & RV32I_MASK_Rx_RD)  >> RV32I_Rx_RD_START_BIT;
+            decoded_data.imm_j = SIGN_EXT21((((instr & RV32I_MASK_IMM_J_20)    >> RV32I_IMM_J_20_START_BIT) << 20) |
+                                            (((instr & RV32I_MASK_IMM_J_19_12) >> RV32I_IMM_J_19_12_START_BIT) << 12) |
+                                            (((instr & RV32I_MASK_IMM_J_11)    >> RV32I_IMM_J_11_START_BIT)    << 11) |
+                                            (((instr & RV32I_MASK_IMM_J_10_1)  >> RV32I_IMM_J_10_1_START_BIT)  <<  1));
+            break;
+
+        default:
+            break;
+        }
+    }
+
+#ifdef RV32E_EXTENSION
+    // If E extensions enabled, it is illegal to have register references
+    // greater than x15
+    if (decoded_data.rd  >= RV32I_NUM_OF_REGISTERS  ||
+        decoded_data.rs1 >= RV32I_NUM_OF_REGISTERS  ||
+        decoded_data.rs2 >= RV32I_NUM_OF_REGISTERS)
+    {
+        p_entry = NULL;
+    }
+#endif
+
+    return p_entry;
+}
+
+// -------------------------------------------------------------------------
+//  Memory access methods
+// -------------------------------------------------------------------------
+
+int rv32i_cpu::set_int_mem(const uint32_t base, const uint32_t size)
+{
+    // Round size up to whole pages
+    uint64_t map_size = ((uint64_t)size + RV32I_TLB_PAGE_MASK) & ~(uint64_t)RV32I_TLB_PAGE_MASK;
+
+    // The rounded size must still fit the 32 bit int_mem_size
+    if ((base & RV32I_TLB_PAGE_MASK) || map_size > 0xffffffffULL || base + map_size - 1 > 0xffffffffULL)
+    {
+        return 1;
+    }
+
+    free_int_mem();
+    flush_tlb();
+
+    if (map_size)
+    {
+        // An anonymous mapping, with pages only taken from the host when first accessed
+#if defined (_WIN32) || defined (_WIN64)
+        int_mem = (uint8_t*)VirtualAlloc(NULL, (size_t)map_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+        void* p = mmap(NULL, (size_t)map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+        int_mem = (p == MAP_FAILED) ? NULL : (uint8_t*)p;
+#endif
+        if (int_mem == NULL)
+        {
+            return 1;
+        }
+    }
+
+    int_mem_base = base;
+    int_mem_size = (uint32_t)map_size;
+
+    return 0;
+}
+
+void rv32i_cpu::share_int_mem(const rv32i_cpu* p_cpu)
+{
+    free_int_mem();
+    flush_tlb();
+
+    int_mem        = p_cpu->int_mem;
+    int_mem_base   = p_cpu->int_mem_base;
+    int_mem_size   = p_cpu->int_mem_size;
+    int_mem_shared = true;
+}
+
+void rv32i_cpu::free_int_mem()
+{
+    // Memory shared from another core is left for it to free
+    if (int_mem_shared)
+    {
+        int_mem        = NULL;
+        int_mem_size   = 0;
+        int_mem_shared = false;
+    }
+    else if (int_mem != NULL)
+    {
+#if defined (_WIN32) || defined (_WIN64)
+        VirtualFree(int_mem, 0, MEM_RELEASE);
+#else
+        munmap(int_mem, int_mem_size);
+#endif
+        int_mem      = NULL;
+        int_mem_size = 0;
+    }
+}
+
+// -------------------------------------------------------------------------
+//  Reserved guest address space methods
+// -------------------------------------------------------------------------
+
+#ifdef RV32I_GUEST_SPACE_SUPPORTED
+
+// Direct guest accessors, passed the host address and access type (and the data
+// for stores). The load or store at each _op label, the accessor's first
+// instruction, is the only one that may fault. The fault handler then redirects
+// execution to a memory map stub with the same arguments, as if it had been
+// called in the accessor's place, so that the access is completed outside the
+// signal handler, and the stub returns to the accessor's caller.
+#define RV32I_GUEST_ACCESSOR(_name, _instr)                                     \
+    "    .globl  " #_name "\n    .hidden " #_name "\n"                          \
+    "    .globl  " #_name "_op\n    .hidden " #_name "_op\n"                    \
+    "    .type   " #_name ", @function\n"                                       \
+    #_name ":\n" #_name "_op:\n    " _instr "\n    ret\n"
+
+__asm__ (
+    "    .text\n"
+    RV32I_GUEST_ACCESSOR(rv32i_guest_ld8,  "movzbl (%rdi), %eax")
+    RV32I_GUEST_ACCESSOR(rv32i_guest_ld16, "movzwl (%rdi), %eax")
+    RV32I_GUEST_ACCESSOR(rv32i_guest_ld32, "movl   (%rdi), %eax")
+    RV32I_GUEST_ACCESSOR(rv32i_guest_st8,  "movb   %sil, (%rdi)")
+    RV32I_GUEST_ACCESSOR(rv32i_guest_st16, "movw   %si,  (%rdi)")
+    RV32I_GUEST_ACCESSOR(rv32i_guest_st32, "movl   %esi, (%rdi)")
+);
+
+extern "C" {
+    uint32_t rv32i_guest_ld8  (const uint8_t* p_host, const int type);
+    uint32_t rv32i_guest_ld16 (const uint8_t* p_host, const int type);
+    uint32_t rv32i_guest_ld32 (const uint8_t* p_host, const int type);
+    void     rv32i_guest_st8  (uint8_t* p_host, const uint32_t data, const int type);
+    void     rv32i_guest_st16 (uint8_t* p_host, const uint32_t data, const int type);
+    void     rv32i_guest_st32 (uint8_t* p_host, const uint32_t data, const int type);
+
+    extern const char rv32i_guest_ld8_op[];
+    extern const char rv32i_guest_ld16_op[];
+    extern const char rv32i_guest_ld32_op[];
+    extern const char rv32i_guest_st8_op[];
+    extern const char rv32i_guest_st16_op[];
+    extern const char rv32i_guest_st32_op[];
+}
+
+// Faulting accessor instructions, and whether a load or a store
+static const struct {
+    const char* p_op;
+    bool        load;
+} guest_accessors[] = {
+    {rv32i_guest_ld8_op,  true},
+    {rv32i_guest_ld16_op, true},
+    {rv32i_guest_ld32_op, true},
+    {rv32i_guest_st8_op,  false},
+    {rv32i_guest_st16_op, false},
+    {rv32i_guest_st32_op, false}
+};
+
+// Cpus with a reserved guest space, searched by the fault handler. Slots are
+// claimed and released, and the handler installed, under the lock, with the
+// handler itself only reading the slots, without locking.
+static std::atomic<rv32i_cpu*> guest_cpus[RV32I_MAX_GUEST_SPACES];
+static std::mutex              guest_mutex;
+
+// Action for faults outside of the guest spaces, before the handler was installed
+static struct sigaction        guest_prev_action;
+static std::atomic<bool>       guest_handler_installed(false);
+
+static void guest_fault_handler(int sig, siginfo_t* p_info, void* p_context)
+{
+    if (!rv32i_cpu::guest_access_fault((const uint8_t*)p_info->si_addr, p_context))
+    {
+        // Not a guest access, so restore the previous action, which is
+        // taken when the faulting instruction is re-executed on return
+        sigaction(SIGSEGV, &guest_prev_action, NULL);
+        guest_handler_installed = false;
+    }
+}
+
+// Redirect a faulting guest access to the memory map stub for a load or store,
+// returning false if the fault was not from a guest accessor, with an address
+// in a guest space. Only the saved registers are updated, so that nothing but
+// async-signal-safe operations are made in the signal handler, with the stub
+// passed the cpu as an extra argument (in a register the accessor doesn't use).
+bool rv32i_cpu::guest_access_fault(const uint8_t* p_fault, void* p_context)
+{
+    greg_t* p_regs = ((ucontext_t*)p_context)->uc_mcontext.gregs;
+
+    for (int cpu = 0; cpu < RV32I_MAX_GUEST_SPACES; cpu++)
+    {
+        rv32i_cpu* p_cpu = guest_cpus[cpu];
+
+        if (p_cpu == NULL || (uint64_t)(p_fault - p_cpu->guest_mem) >= RV32I_GUEST_SPACE_SIZE)
+        {
+            continue;
+        }
+
+        for (unsigned idx = 0; idx < sizeof(guest_accessors)/sizeof(guest_accessors[0]); idx++)
+        {
+            if ((const char*)p_regs[REG_RIP] == guest_accessors[idx].p_op)
+            {
+                if (guest_accessors[idx].load)
+                {
+                    p_regs[REG_RDX] = (greg_t)p_cpu;
+                    p_regs[REG_RIP] = (greg_t)guest_load_map;
+                }
+                else
+                {
+                    p_regs[REG_RCX] = (greg_t)p_cpu;
+                    p_regs[REG_RIP] = (greg_t)guest_store_map;
+                }
+
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Memory map stubs, completing guest accesses redirected from the fault handler,
+// outside of it, so the memory map's callbacks are called as for any other access
+uint32_t rv32i_cpu::guest_load_map(const uint8_t* p_host, const int type, rv32i_cpu* p_cpu)
+{
+    bool     fault  = false;
+    uint32_t rd_val = p_cpu->read_mem_map((uint32_t)(p_host - p_cpu->guest_mem), type, fault);
+
+    // The memory map may itself make guest accesses, so the fault
+    // status is only updated once the access completes
+    p_cpu->guest_fault = fault;
+
+    return rd_val;
+}
+
+void rv32i_cpu::guest_store_map(uint8_t* p_host, const uint32_t data, const int type, rv32i_cpu* p_cpu)
+{
+    bool fault = false;
+
+    p_cpu->write_mem_map((uint32_t)(p_host - p_cpu->guest_mem), data, type, fault);
+
+    p_cpu->guest_fault = fault;
+}
+
+#endif
+
+int rv32i_cpu::reserve_guest_space()
+{
+#ifdef RV32I_GUEST_SPACE_SUPPORTED
+    if (guest_mem != NULL)
+    {
+        return 0;
+    }
+
+    // Reserve the space and its guard areas with no access, and no host memory
+    // committed, so pages are only taken from the host when first written
+    void* p = mmap(NULL, (size_t)(RV32I_GUEST_SPACE_SIZE + 2*RV32I_GUEST_GUARD_SIZE), PROT_NONE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (p == MAP_FAILED)
+    {
+        return 1;
+    }
+
+    guest_mem = (uint8_t*)p + RV32I_GUEST_GUARD_SIZE;
+
+    if (protect_guest_space())
+    {
+        free_guest_space();
+        return 1;
+    }
+
+    // Any cached decodes were from memory no longer accessed
+    flush_tlb();
+    flush_dcache();
+
+    // Cores may reserve their spaces from several threads at once, so a slot
+    // is claimed (once the space is set up) and the handler installed, under
+    // the lock, with the space freed if either fails
+    {
+        std::lock_guard<std::mutex> lock(guest_mutex);
+
+        int cpu;
+
+        for (cpu = 0; cpu < RV32I_MAX_GUEST_SPACES && guest_cpus[cpu] != NULL; cpu++);
+
+        if (cpu < RV32I_MAX_GUEST_SPACES && !guest_handler_installed)
+        {
+            struct sigaction action;
+
+            memset(&action, 0, sizeof(action));
+            sigemptyset(&action.sa_mask);
+            action.sa_sigaction = guest_fault_handler;
+            action.sa_flags     = SA_SIGINFO;
+
+            guest_handler_installed = sigaction(SIGSEGV, &action, &guest_prev_action) == 0;
+        }
+
+        if (cpu < RV32I_MAX_GUEST_SPACES && guest_handler_installed)
+        {
+            guest_cpus[cpu] = this;
+            return 0;
+        }
+    }
+
+    free_guest_space();
+    return 1;
+#else
+    return 1;
+#endif
+}
+
+void rv32i_cpu::free_guest_space()
+{
+#ifdef RV32I_GUEST_SPACE_SUPPORTED
+    if (guest_mem != NULL)
+    {
+        std::lock_guard<std::mutex> lock(guest_mutex);
+
+        for (int cpu = 0; cpu < RV32I_MAX_GUEST_SPACES; cpu++)
+        {
+            if (guest_cpus[cpu] == this)
+            {
+                guest_cpus[cpu] = NULL;
+            }
+        }
+
+        munmap(guest_mem - RV32I_GUEST_GUARD_SIZE, (size_t)(RV32I_GUEST_SPACE_SIZE + 2*RV32I_GUEST_GUARD_SIZE));
+        guest_mem = NULL;
+    }
+#endif
+}
+
+// Guest space pages are directly accessible unless left inaccessible
+// for a region, or the real time clock registers
+bool rv32i_cpu::guest_page_direct(const uint32_t page)
+{
+    if (page == (RV32I_RTCLOCK_ADDRESS & ~RV32I_TLB_PAGE_MASK))
+    {
+        return false;
+    }
+
+    for (uint32_t idx = 0; idx < num_regions; idx++)
+    {
+        if (regions[idx].base <= (page | RV32I_TLB_PAGE_MASK) && regions[idx].base + (regions[idx].size - 1) >= page)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Make all of the guest space accessible, except for the pages holding
+// registered regions and the real time clock registers, and those of a
+// lazily loaded executable not yet populated
+int rv32i_cpu::protect_guest_space()
+{
+#ifdef RV32I_GUEST_SPACE_SUPPORTED
+    if (mprotect(guest_mem, (size_t)RV32I_GUEST_SPACE_SIZE, PROT_READ | PROT_WRITE))
+    {
+        return 1;
+    }
+
+    for (uint32_t idx = 0; idx <= num_regions; idx++)
+    {
+        uint64_t base = (idx == num_regions) ? RV32I_RTCLOCK_ADDRESS : regions[idx].base;
+        uint64_t last = (idx == num_regions) ? RV32I_RTCLOCK_CMP_ADDRESS + 7 : base + regions[idx].size - 1;
+
+        base &= ~(uint64_t)RV32I_TLB_PAGE_MASK;
+        last |= RV32I_TLB_PAGE_MASK;
+
+        if (mprotect(guest_mem + base, (size_t)(last - base + 1), PROT_NONE))
+        {
+            return 1;
+        }
+    }
+
+    for (uint32_t seg = 0; seg < lazy_num_segs; seg++)
+    {
+        for (uint32_t idx = 0; idx < lazy_segs[seg].num_pages; idx++)
+        {
+            if ((lazy_segs[seg].p_pending[idx >> 3] >> (idx & 7)) & 1)
+            {
+                mprotect(guest_mem + (lazy_segs[seg].vaddr & ~RV32I_TLB_PAGE_MASK) + ((uint64_t)idx << RV32I_TLB_PAGE_BITS),
+                         RV32I_TLB_PAGE_SIZE, PROT_NONE);
+            }
+        }
+    }
+
+    return 0;
+#else
+    return 1;
+#endif
+}
+
+// Insert a region in the memory map, keeping it sorted on base address
+int rv32i_cpu::register_region(const rv32i_region_t &region)
+{
+    uint32_t idx;
+
+    if (num_regions == RV32I_MAX_REGIONS || region.size == 0 || region.base + (region.size - 1) < region.base)
+    {
+        return 1;
+    }
+
+    // Find the insertion point, and check the region doesn't overlap its neighbours
+    for (idx = 0; idx < num_regions && regions[idx].base < region.base; idx++);
+
+    if ((idx > 0           && regions[idx-1].base + (regions[idx-1].size - 1) >= region.base) ||
+        (idx < num_regions && region.base + (region.size - 1) >= regions[idx].base))
+    {
+        return 1;
+    }
+
+    memmove(&regions[idx+1], &regions[idx], (num_regions - idx) * sizeof(rv32i_region_t));
+    regions[idx] = region;
+    num_regions++;
+
+    // Regions have moved, and pages of the region may already be mapped by the page callback
+    p_last_region = NULL;
+    flush_tlb();
+
+    // The region's pages are no longer directly accessible guest RAM
+    if (guest_mem != NULL)
+    {
+        return protect_guest_space();
+    }
+
+    return 0;
+}
+
+int rv32i_cpu::register_ram(const uint32_t base, const uint32_t size, uint8_t* p_host, const bool writable, const uint32_t latency)
+{
+    rv32i_region_t region;
+
+    if (((base | size) & RV32I_TLB_PAGE_MASK) || p_host == NULL)
+    {
+        return 1;
+    }
+
+    region.base      = base;
+    region.size      = size;
+    region.type      = writable ? RV32I_REGION_RAM : RV32I_REGION_ROM;
+    region.perm      = writable ? RV32I_REGION_PERM_RWX : (RV32I_REGION_PERM_R | RV32I_REGION_PERM_X);
+    region.latency   = latency;
+    region.p_host    = p_host;
+    region.p_handler = NULL;
+
+    return register_region(region);
+}
+
+int rv32i_cpu::register_mmio(const uint32_t base, const uint32_t size, p_rv32i_memcallback_t handler, const int perm, const uint32_t latency)
+{
+    rv32i_region_t region;
+
+    if (handler == NULL)
+    {
+        return 1;
+    }
+
+    region.base      = base;
+    region.size      = size;
+    region.type      = RV32I_REGION_MMIO;
+    region.perm      = perm;
+    region.latency   = latency;
+    region.p_host    = NULL;
+    region.p_handler = handler;
+
+    return register_region(region);
+}
+
+// Return the region containing the given address, or NULL if none
+rv32i_region_t* rv32i_cpu::find_region(const uint32_t byte_addr)
+{
+    // Accesses tend to be to the same region as the last
+    if (p_last_region != NULL && byte_addr - p_last_region->base < p_last_region->size)
+    {
+        return p_last_region;
+    }
+
+    // Binary search for the last region starting at, or below, the address
+    int             lo    = 0;
+    int             hi    = (int)num_regions - 1;
+    rv32i_region_t* p_rgn = NULL;
+
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) / 2;
+
+        if (regions[mid].base <= byte_addr)
+        {
+            p_rgn = &regions[mid];
+            lo    = mid + 1;
+        }
+        else
+        {
+            hi    = mid - 1;
+        }
+    }
+
+    if (p_rgn != NULL && byte_addr - p_rgn->base < p_rgn->size)
+    {
+        p_last_region = p_rgn;
+        return p_rgn;
+    }
+
+    return NULL;
+}
+
+// Return true if any MMIO region overlaps the given page
+bool rv32i_cpu::mmio_in_page(const uint32_t page)
+{
+    for (uint32_t idx = 0; idx < num_regions && regions[idx].base <= page + RV32I_TLB_PAGE_MASK; idx++)
+    {
+        if (regions[idx].type == RV32I_REGION_MMIO && regions[idx].base + (regions[idx].size - 1) >= page)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Map the page holding the given address in a TLB entry, if a RAM (or ROM)
+// region covers it, or else the RAM page callback returns memory for it, or
+// it is internal memory with no memory callback that could take precedence.
+// The page callback is told whether the page is mapped for a write, so that
+// it need not allocate a page only read. Returns false if the page is not
+// RAM, leaving the entry unchanged.
+bool rv32i_cpu::tlb_fill(const uint32_t byte_addr, rv32i_tlb_entry_t* p_tlb, const bool write)
+{
+    uint32_t        page  = byte_addr & ~RV32I_TLB_PAGE_MASK;
+    rv32i_region_t* p_rgn;
+
+    // The page with the memory mapped real time clock registers is never RAM
+    if (page == (RV32I_RTCLOCK_ADDRESS & ~RV32I_TLB_PAGE_MASK))
+    {
+        return false;
+    }
+
+    if ((p_rgn = find_region(byte_addr)) != NULL)
+    {
+        if (p_rgn->type == RV32I_REGION_MMIO)
+        {
+            return false;
+        }
+
+        p_tlb->tag     = page;
+        p_tlb->wr_tag  = (p_rgn->type == RV32I_REGION_RAM) ? page : RV32I_TLB_INVALID_TAG;
+        p_tlb->p_host  = p_rgn->p_host + (page - p_rgn->base);
+        p_tlb->latency = p_rgn->latency;
+
+        return true;
+    }
+
+    // Pages from the callback, or internal memory, must not hide any part of a device
+    if (mmio_in_page(page))
+    {
+        return false;
+    }
+
+    uint8_t* p_host = NULL;
+
+#ifdef RV32I_GUEST_SPACE_SUPPORTED
+    // Directly accessible guest space pages only get here on faulting while
+    // pending population by a lazy load, and are then accessed in place
+    if (guest_mem != NULL && guest_page_direct(page))
+    {
+        p_host = guest_mem + page;
+    }
+    else
+#endif
+    if (p_page_callback != NULL)
+    {
+        p_host = p_page_callback(page, write);
+    }
+
+    if (p_host == NULL && p_mem_callback == NULL && page - int_mem_base < int_mem_size)
+    {
+        p_host = int_mem + (page - int_mem_base);
+    }
+
+    if (p_host != NULL)
+    {
+        p_tlb->tag     = page;
+        p_tlb->wr_tag  = page;
+        p_tlb->p_host  = p_host;
+        p_tlb->latency = 0;
+
+        return true;
+    }
+
+    return false;
+}
+
+uint32_t rv32i_cpu::read_mem (const uint32_t byte_addr, const int type, bool &fault)
+{
+    fault = false;
+
+    // Check alignment
+    if (((byte_addr & 0x1) && (type & MEM_NOT_DBG_MASK) != MEM_RD_ACCESS_BYTE) ||
+        ((byte_addr & 0x3) != 0x00 && (type == MEM_RD_ACCESS_WORD || type == MEM_RD_ACCESS_INSTR)))
+    {
+        process_trap((type == MEM_RD_ACCESS_INSTR) ? RV32I_IADDR_MISALIGNED : RV32I_LADDR_MISALIGNED);
+        fault = true;
+        return 0;
+    }
+
+#ifdef RV32I_GUEST_SPACE_SUPPORTED
+    // Accesses to a reserved guest space are made directly, with any to
+    // inaccessible pages redirected by the fault handler to the memory map
+    if (guest_mem != NULL)
+    {
+        uint32_t rd_val;
+
+        guest_fault = false;
+
+        switch (type & MEM_NOT_DBG_MASK)
+        {
+        case MEM_RD_ACCESS_BYTE:
+            rd_val = rv32i_guest_ld8(guest_mem + byte_addr, type);
+            break;
+        case MEM_RD_ACCESS_HWORD:
+            rd_val = rv32i_guest_ld16(guest_mem + byte_addr, type);
+            break;
+        default:
+            rd_val = rv32i_guest_ld32(guest_mem + byte_addr, type);
+            break;
+        }
+
+        fault = guest_fault;
+        return rd_val;
+    }
+#endif
+
+    return read_mem_map(byte_addr, type, fault);
+}
+
+uint32_t rv32i_cpu::read_mem_map (const uint32_t byte_addr, const int type, bool &fault)
+{
+    uint32_t rd_val = 0;
+    uint32_t word;
+
+    int  mem_callback_delay    = RV32I_EXT_MEM_NOT_PROCESSED;
+
+    // Populate a page of a lazily loaded executable on its first access
+    if (lazy_pending)
+    {
+        lazy_populate(byte_addr);
+    }
+
+    // Accesses to RAM pages mapped in the TLB are made directly to host
+    // memory (with the host assumed little endian, as the guest)
+    rv32i_tlb_entry_t* p_tlb = &tlb[(byte_addr >> RV32I_TLB_PAGE_BITS) & RV32I_TLB_MASK];
+
+    if (p_tlb->tag == (byte_addr & ~RV32I_TLB_PAGE_MASK) || tlb_fill(byte_addr, p_tlb, false))
+    {
+        const uint8_t* p_mem = p_tlb->p_host + (byte_addr & RV32I_TLB_PAGE_MASK);
+        uint16_t       hword;
+
+        cycle_count += p_tlb->latency;
+
+        switch (type & MEM_NOT_DBG_MASK)
+        {
+        case MEM_RD_ACCESS_BYTE:
+            return *p_mem;
+        case MEM_RD_ACCESS_HWORD:
+            memcpy(&hword, p_mem, sizeof(hword));
+            return hword;
+        default:
+            memcpy(&word, p_mem, sizeof(word));
+            return word;
+        }
+    }
+
+    // Any region not mapped in the TLB is a device, so call its handler
+    rv32i_region_t* p_rgn = find_region(byte_addr);
+
+    if (p_rgn != NULL)
+    {
+        bool instr = (type & MEM_NOT_DBG_MASK) == MEM_RD_ACCESS_INSTR;
+
+        if (!(p_rgn->perm & (instr ? RV32I_REGION_PERM_X : RV32I_REGION_PERM_R)))
+        {
+            // Flag as a bus error only if this is not a debug access
+            if (!(type & MEM_DBG_MASK))
+            {
+                process_trap(instr ? RV32I_INSTR_ACCESS_FAULT : RV32I_LOAD_ACCESS_FAULT);
+                fault = true;
+            }
+            return 0;
+        }
+
+        mem_callback_delay = p_rgn->p_handler(byte_addr, rd_val, type, cycle_count);
+
+        if (mem_callback_delay != RV32I_EXT_MEM_NOT_PROCESSED)
+        {
+            cycle_count += p_rgn->latency + mem_callback_delay;
+            return rd_val;
+        }
+    }
+
+    // If a callback registered for memory accesses call it now,
+    // unless accessing the memory mapped real time clock CSR registers
+    // (mtime and mtimecmp)
+    if (p_mem_callback != NULL && ((byte_addr & 0xfffffff0) != RV32I_RTCLOCK_ADDRESS))
+    {
+        // Execute callback function
+        mem_callback_delay = p_mem_callback(byte_addr, rd_val, type, cycle_count);
+    }
+
+    // If no external processing of read, access the internal memory.
+    if (mem_callback_delay == RV32I_EXT_MEM_NOT_PROCESSED)
+    {
+        // Check if accessing the real time clock memory mapped csr register
+        if ((byte_addr & 0xfffffff8) == RV32I_RTCLOCK_ADDRESS) 
+        {
+            word = (uint32_t)(mtime() >> ((byte_addr & 0x00000004) ? 32 : 0));
+        }
+        // Check if accessing the memory mapped time compare register
+        else if ((byte_addr & 0xfffffff8) == RV32I_RTCLOCK_CMP_ADDRESS) 
+        {
+            word = (uint32_t)(mtimecmp >> ((byte_addr & 0x00000004) ? 32 : 0)); 
+        }
+        else
+        {
+            // Check input is a valid address
+            if (byte_addr - int_mem_base >= int_mem_size)
+            {
+                // Flag as a bus error only if this is not a debug access, as debugger may try
+                // to inspect non-valid addresses.
+                if (!(type & MEM_DBG_MASK))
+                {
+                    process_trap(RV32I_LOAD_ACCESS_FAULT);
+                    fault = true;
+                }
+                return 0;
+            }
+
+            // Native width load of only the bytes accessed (host little endian, as the guest)
+            const uint8_t* p_mem = int_mem + (byte_addr - int_mem_base);
+            uint16_t       hword;
+
+            switch (type & MEM_NOT_DBG_MASK)
+            {
+            case MEM_RD_ACCESS_BYTE:
+                word = *p_mem;
+                break;
+            case MEM_RD_ACCESS_HWORD:
+                memcpy(&hword, p_mem, sizeof(hword));
+                word = hword;
+                break;
+            default:
+                memcpy(&word, p_mem, sizeof(word));
+                break;
+            }
+        }
+
+        switch (type & MEM_NOT_DBG_MASK)
+        {
+        case MEM_RD_ACCESS_BYTE:
+            rd_val = word & 0xff;
+            break;
+        case MEM_RD_ACCESS_HWORD:
+            rd_val = word & 0xffff;
+            break;
+        case MEM_RD_ACCESS_INSTR:
+        case MEM_RD_ACCESS_WORD:
+            rd_val = word;
+            break;
+        default:
+            fprintf(stderr, "***ERROR: invalid read access type (%d)\n", type);
+            exit(USER_ERROR);
+            break;
+        }
+    }
+    else
+    {
+        cycle_count += mem_callback_delay;
+    }
+
+    return rd_val;
+}
+
+void rv32i_cpu::write_mem (const uint32_t byte_addr, const uint32_t data, const int type, bool &fault)
+{
+    fault = false;
+
+    // Check alignment
+    if (((byte_addr & 0x1) && type != MEM_WR_ACCESS_BYTE) ||
+        ((byte_addr & 0x3) != 0x00 && (type == MEM_WR_ACCESS_WORD || type == MEM_WR_ACCESS_INSTR)))
+    {
+        process_trap((type == MEM_WR_ACCESS_INSTR) ? RV32I_IADDR_MISALIGNED : RV32I_ST_AMO_ADDR_MISALIGNED);
+        fault = true;
+        return;
+    }
+
+    // Any write to memory might be to instruction memory, so invalidate any
+    // cached decode for the written word (stores, loading and debugger writes
+    // all come through here)
+    invalidate_dcache(byte_addr);
+
+    // A write also clears any core's reservation of the written granule
+    rsvd_clear(byte_addr);
+
+#ifdef RV32I_GUEST_SPACE_SUPPORTED
+    // Writes to a reserved guest space are made directly, as for reads
+    if (guest_mem != NULL)
+    {
+        guest_fault = false;
+
+        switch (type)
+        {
+        case MEM_WR_ACCESS_BYTE:
+            rv32i_guest_st8(guest_mem + byte_addr, data, type);
+            break;
+        case MEM_WR_ACCESS_HWORD:
+            rv32i_guest_st16(guest_mem + byte_addr, data, type);
+            break;
+        default:
+            rv32i_guest_st32(guest_mem + byte_addr, data, type);
+            break;
+        }
+
+        fault = guest_fault;
+        return;
+    }
+#endif
+
+    write_mem_map(byte_addr, data, type, fault);
+}
+
+void rv32i_cpu::write_mem_map (const uint32_t byte_addr, const uint32_t data, const int type, bool &fault)
+{
+    int       mem_callback_delay    = RV32I_EXT_MEM_NOT_PROCESSED;
+    uint32_t  word = data;
+
+    // Populate a page of a lazily loaded executable on its first access,
+    // before the write updates it
+    if (lazy_pending)
+    {
+        lazy_populate(byte_addr);
+    }
+
+    // Writes to writable RAM pages mapped in the TLB are made directly to
+    // host memory (with the host assumed little endian, as the guest)
+    rv32i_tlb_entry_t* p_tlb = &tlb[(byte_addr >> RV32I_TLB_PAGE_BITS) & RV32I_TLB_MASK];
+    uint32_t           page  = byte_addr & ~RV32I_TLB_PAGE_MASK;
+
+    if (p_tlb->wr_tag == page || (tlb_fill(byte_addr, p_tlb, true) && p_tlb->wr_tag == page))
+    {
+        uint8_t* p_mem = p_tlb->p_host + (byte_addr & RV32I_TLB_PAGE_MASK);
+        uint16_t hword = (uint16_t)word;
+
+        cycle_count += p_tlb->latency;
+
+        switch (type)
+        {
+        case MEM_WR_ACCESS_BYTE:
+            *p_mem = (uint8_t)word;
+            break;
+        case MEM_WR_ACCESS_HWORD:
+            memcpy(p_mem, &hword, sizeof(hword));
+            break;
+        default:
+            memcpy(p_mem, &word, sizeof(word));
+            break;
+        }
+
+        return;
+    }
+
+    // Any other write to a region is either to ROM, which only loading may
+    // write, or to a device, so call its handler
+    rv32i_region_t* p_rgn = find_region(byte_addr);
+
+    if (p_rgn != NULL)
+    {
+        if (p_rgn->type == RV32I_REGION_ROM && type == MEM_WR_ACCESS_INSTR)
+        {
+            memcpy(p_rgn->p_host + (byte_addr - p_rgn->base), &word, sizeof(word));
+            return;
+        }
+
+        if (!(p_rgn->perm & RV32I_REGION_PERM_W))
+        {
+            process_trap(RV32I_ST_AMO_ACCESS_FAULT);
+            fault = true;
+            return;
+        }
+
+        if ((mem_callback_delay = p_rgn->p_handler(byte_addr, word, type, cycle_count)) != RV32I_EXT_MEM_NOT_PROCESSED)
+        {
+            mem_callback_delay += p_rgn->latency;
+        }
+    }
+
+    // If a callback registered for memory accesses call it now, unless accessing
+    // the memory mapped real time clock CSR registers (mtime and mtimecmp), or
+    // a device has processed the write
+    if (p_mem_callback != NULL && mem_callback_delay == RV32I_EXT_MEM_NOT_PROCESSED && ((byte_addr & 0xfffffff0) != RV32I_RTCLOCK_ADDRESS))
+    {
+        // Execute callback function
+        mem_callback_delay = p_mem_callback(byte_addr, word, type, cycle_count);
+    }
+
+    // An externally processed write may be to a device that changes the interrupt
+    // state, so schedule the interrupt callback now, and any executing basic block
+    // must exit to allow it to be called
+    if (mem_callback_delay != RV32I_EXT_MEM_NOT_PROCESSED)
+    {
+        schedule_event(RV32I_EVENT_INT_CALLBACK, cycle_count);
+        blk_exit = true;
+    }
+
+    // If no external processing of write, access the internal memory.
+    if (mem_callback_delay == RV32I_EXT_MEM_NOT_PROCESSED)
+    {
+        if ((byte_addr & 0xfffffff8) == RV32I_RTCLOCK_ADDRESS) 
+        {
+            // At this time, don't write as this is a free running RT clock,
+            // but have to handle to avoid attempt to write to internal
+            // memory at an out-of-range address 
+        }
+        // Check if accessing the memory mapped time compare register
+        else if ((byte_addr & 0xfffffff8) == RV32I_RTCLOCK_CMP_ADDRESS) 
+        {
+            mtimecmp = (mtimecmp & ((byte_addr & 0x00000004) ? 0xFFFFFFFFULL : 0xFFFFFFFF00000000ULL)) | 
+                                   ((uint64_t)word << ((byte_addr & 0x00000004) ? 32 : 0)) ;
+
+            // Timer comparison must be redone with the new value
+            schedule_event(RV32I_EVENT_TIMER, cycle_count);
+        }
+        else
+        {
+            // Check input is a valid address
+            if (byte_addr - int_mem_base >= int_mem_size) 
+            {
+                process_trap(RV32I_ST_AMO_ACCESS_FAULT);
+                fault = true;
+                return;
+            }
+
+            // Native width store (host little endian, as the guest)
+            uint8_t* p_mem = int_mem + (byte_addr - int_mem_base);
+            uint16_t hword = (uint16_t)word;
+
+            switch (type)
+            {
+            case MEM_WR_ACCESS_BYTE:
+                *p_mem = (uint8_t)word;
+                break;
+            case MEM_WR_ACCESS_HWORD:
+                memcpy(p_mem, &hword, sizeof(hword));
+                break;
+            case MEM_WR_ACCESS_INSTR:
+            case MEM_WR_ACCESS_WORD:
+                memcpy(p_mem, &word, sizeof(word));
+                break;
+            default:
+                fprintf(stderr, "***ERROR: invalid write access type (%d)\n", type);
+                exit(USER_ERROR);
+                break;
+            }
+        }
+    }
+    else
+    {
+        cycle_count += mem_callback_delay;
+    }
+}
+
+// -------------------------------------------------------------------------
+//  Atomic memory access methods
+// -------------------------------------------------------------------------
+
+// Result of an atomic memory operation on a word's value
+static inline uint32_t amo_result(const int op, const uint32_t mem_val, const uint32_t data)
+{
+    switch (op)
+    {
+    case RV32I_AMO_SWAP: return data;
+    case RV32I_AMO_ADD:  return mem_val + data;
+    case RV32I_AMO_XOR:  return mem_val ^ data;
+    case RV32I_AMO_AND:  return mem_val & data;
+    case RV32I_AMO_OR:   return mem_val | data;
+    case RV32I_AMO_MIN:  return ((int32_t)mem_val < (int32_t)data) ? mem_val : data;
+    case RV32I_AMO_MAX:  return ((int32_t)mem_val > (int32_t)data) ? mem_val : data;
+    case RV32I_AMO_MINU: return (mem_val < data) ? mem_val : data;
+    default:             return (mem_val > data) ? mem_val : data;
+    }
+}
+
+// Host atomic compare and swap of a word, returning its previous value
+static inline uint32_t host_cas32(uint8_t* p_mem, uint32_t expected, const uint32_t desired)
+{
+#if defined (_WIN32) || defined (_WIN64)
+    return (uint32_t)InterlockedCompareExchange((volatile LONG*)p_mem, (LONG)desired, (LONG)expected);
+#else
+    __atomic_compare_exchange_n((uint32_t*)p_mem, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return expected;
+#endif
+}
+
+// Host atomic operation on a word, returning its previous value
+static inline uint32_t host_amo32(uint8_t* p_mem, const int op, const uint32_t data)
+{
+#if defined (_WIN32) || defined (_WIN64)
+    volatile LONG* p = (volatile LONG*)p_mem;
+
+    switch (op)
+    {
+    case RV32I_AMO_SWAP: return (uint32_t)InterlockedExchange(p, (LONG)data);
+    case RV32I_AMO_ADD:  return (uint32_t)InterlockedExchangeAdd(p, (LONG)data);
+    case RV32I_AMO_XOR:  return (uint32_t)InterlockedXor(p, (LONG)data);
+    case RV32I_AMO_AND:  return (uint32_t)InterlockedAnd(p, (LONG)data);
+    case RV32I_AMO_OR:   return (uint32_t)InterlockedOr(p, (LONG)data);
+    }
+#else
+    uint32_t* p = (uint32_t*)p_mem;
+
+    switch (op)
+    {
+    case RV32I_AMO_SWAP: return __atomic_exchange_n(p, data, __ATOMIC_SEQ_CST);
+    case RV32I_AMO_ADD:  return __atomic_fetch_add(p, data, __ATOMIC_SEQ_CST);
+    case RV32I_AMO_XOR:  return __atomic_fetch_xor(p, data, __ATOMIC_SEQ_CST);
+    case RV32I_AMO_AND:  return __atomic_fetch_and(p, data, __ATOMIC_SEQ_CST);
+    case RV32I_AMO_OR:   return __atomic_fetch_or(p, data, __ATOMIC_SEQ_CST);
+    }
+#endif
+
+    // Minimum and maximum have no host instruction, so are compare and swapped until no other update intervenes
+    uint32_t mem_val = *(volatile uint32_t*)p_mem;
+    uint32_t prev_val;
+
+    while ((prev_val = host_cas32(p_mem, mem_val, amo_result(op, mem_val, data))) != mem_val)
+    {
+        mem_val = prev_val;
+    }
+
+    return mem_val;
+}
+
+uint32_t rv32i_cpu::load_reserved (const uint32_t byte_addr, bool &fault)
+{
+    // Reserve before loading, so that any store after the load clears the reservation,
+    // replacing only this core's own reservation, and leaving other cores' intact
+    if (p_rsvd_domain != NULL)
+    {
+        uint64_t bit = 1ULL << rsvd_slot;
+
+        if (rsvd_held && RSVD_IDX(rsvd_addr) != RSVD_IDX(byte_addr))
+        {
+            p_rsvd_domain->holders[RSVD_IDX(rsvd_addr)].fetch_and(~bit);
+        }
+
+        p_rsvd_domain->slots[rsvd_slot] = RSVD_ENTRY(byte_addr);
+        p_rsvd_domain->holders[RSVD_IDX(byte_addr)].fetch_or(bit);
+    }
+
+    uint32_t rd_val = read_mem(byte_addr, MEM_RD_ACCESS_WORD, fault);
+
+    rsvd_held = !fault;
+    rsvd_addr = byte_addr;
+    rsvd_val  = rd_val;
+
+    return rd_val;
+}
+
+bool rv32i_cpu::store_conditional (const uint32_t byte_addr, const uint32_t data, bool &fault)
+{
+    bool     held = rsvd_held && byte_addr == rsvd_addr;
+
+    fault     = false;
+
+    // A misaligned store conditional traps, whether or not it would be made
+    if (byte_addr & 0x3)
+    {
+        process_trap(RV32I_ST_AMO_ADDR_MISALIGNED);
+        fault = true;
+        return false;
+    }
+
+    rsvd_held = false;
+
+    // The reservation is claimed (and so cleared) only if no store has cleared it
+    // (and is cleared regardless if this is to another address)
+    if (p_rsvd_domain != NULL)
+    {
+        uint32_t entry = RSVD_ENTRY(rsvd_addr);
+
+        held = p_rsvd_domain->slots[rsvd_slot].compare_exchange_strong(entry, 0) && held;
+
+        p_rsvd_domain->holders[RSVD_IDX(rsvd_addr)].fetch_and(~(1ULL << rsvd_slot));
+    }
+
+    if (!held)
+    {
+        return false;
+    }
+
+    // RAM is stored only if still holding the loaded value, to cover stores
+    // made between the load reserved's reservation and its load, or after
+    // another core's store conditional cleared this reservation (as it
+    // clears any others) but before it stored
+    uint8_t* p_page = direct_page(byte_addr, true);
+
+    if (p_page != NULL)
+    {
+        invalidate_dcache(byte_addr);
+
+        // As for any write, clear other cores' reservations of the granule
+        rsvd_clear(byte_addr);
+
+        return host_cas32(p_page + (byte_addr & RV32I_TLB_PAGE_MASK), rsvd_val, data) == rsvd_val;
+    }
+
+    // A core in no domain has no other cores to lock the bus against
+    std::unique_lock<std::mutex> lock;
+
+    if (p_rsvd_domain != NULL)
+    {
+        lock = std::unique_lock<std::mutex>(p_rsvd_domain->bus_mutex);
     }
 
-    if (cfg.en_brk_on_addr && cfg.brk_addr == state.hart[curr_hart].pc)
+    write_mem(byte_addr, data, MEM_WR_ACCESS_WORD, fault);
+
+    return !fault;
+}
+
+void rv32i_cpu::rsvd_clear (const uint32_t byte_addr)
+{
+    if (p_rsvd_domain != NULL)
     {
-        error = SIGTERM;
+        p_rsvd_domain->clear(byte_addr);
     }
-    else if (cfg.num_instr != 0 && instr_count >= cfg.num_instr)
+    // With no domain, only this core's own reservation can be cleared
+    else if (rsvd_held && RSVD_GRANULE(byte_addr) == RSVD_GRANULE(rsvd_addr))
     {
-        error = SIGTRAP;
+        rsvd_held = false;
     }
-
-    return error;
 }
 
-// -----------------------------------------------------------
-// Execute an instruction
-// -----------------------------------------------------------
-
-int  rv32i_cpu::execute(rv32i_decode_t& decode, rv32i_decode_table_t* p_entry)
+int rv32i_cpu::join_rsvd_domain (rv32i_rsvd_domain* p_domain)
 {
-    int error = 0;
+    int slot;
 
- 
-    (this->*p_entry->p)(&decode);
- 
-    cycle_count += 1;
+    rsvd_release();
 
-    // If an illegal/unimplemented instruction, or halt on a system instruction, flag to calling function
-    if ((halt_rsvd_instr && trap) || (halt_ecall && (trap == SIGTERM || trap == SIGTRAP)))
+    if ((slot = p_domain->alloc_slot()) == RSVD_NO_SLOT)
     {
-        error = trap;
-        trap = 0;
+        return 1;
     }
 
-    return error;
-}
+    p_rsvd_domain = p_domain;
+    rsvd_slot     = slot;
 
-// -----------------------------------------------------------
-// Primary Decode method
-//
-// Decode all possible fields here to reflect a logic
-// implementation to extract values without full decode
-// 
-// Returns NULL on a failed decode, or a pointer to an
-// instruction function.
-// -----------------------------------------------------------
+    return 0;
+}
 
-rv32i_decode_table_t* rv32i_cpu::primary_decode(const opcode_t instr, rv32i_decode_t& decoded_data)
+void rv32i_cpu::rsvd_release ()
 {
+    if (p_rsvd_domain != NULL)
+    {
+        p_rsvd_domain->free_slot(rsvd_slot);
+        p_rsvd_domain = NULL;
+        rsvd_slot     = RSVD_NO_SLOT;
+    }
 
-    rv32i_decode_table_t* p_entry = NULL;
+    rsvd_held = false;
+}
 
-    // Extract the different fields from the instruction
-    decoded_data.instr  = instr;
-    decoded_data.opcode = (instr & RV32I_MASK_OPCODE)  >> RV32I_OPCODE_START_BIT;
-    decoded_data.funct3 = (instr & RV32I_MASK_FUNCT_3) >> RV32I_FUNCT_3_START_BIT;
-    decoded_data.funct7 = (instr & RV32I_MASK_FUNCT_7) >> RV32I_FUNCT_7_START_BIT;
+uint32_t rv32i_cpu::amo_word (const uint32_t byte_addr, const int op, const uint32_t data, bool &fault)
+{
+    uint8_t* p_page = (byte_addr & 0x3) ? NULL : direct_page(byte_addr, true);
 
-    decoded_data.rd  = (instr & RV32I_MASK_Rx_RD)  >> RV32I_Rx_RD_START_BIT;
-    decoded_data.rs1 = (instr & RV32I_MASK_Rx_RS1) >> RV32I_Rx_RS1_START_BIT;
-    decoded_data.rs2 = (instr & RV32I_MASK_Rx_RS2) >> RV32I_Rx_RS2_START_BIT;
+    fault = false;
 
-    decoded_data.imm_i = SIGN_EXT12((instr & RV32I_MASK_IMM_I) >> RV32I_IMM_I_START_BIT);
+    if (p_page != NULL)
+    {
+        invalidate_dcache(byte_addr);
 
-    // U type has immediate bits in matching instruction bit positions (incl. sign bit)
-    decoded_data.imm_u = (instr & RV32I_MASK_IMM_U);
+        // As for any write, clear any reservation of the granule
+        rsvd_clear(byte_addr);
 
-    decoded_data.imm_s = SIGN_EXT12((((instr & RV32I_MASK_IMM_S_11_5)  >> RV32I_IMM_S_11_5_START_BIT) << 5) |
-                                    (((instr & RV32I_MASK_IMM_S_4_0)   >> RV32I_IMM_S_4_0_START_BIT) << 0));
+        return host_amo32(p_page + (byte_addr & RV32I_TLB_PAGE_MASK), op, data);
+    }
 
-    decoded_data.imm_b = SIGN_EXT13((((instr & RV32I_MASK_IMM_B_12)    >> RV32I_IMM_B_12_START_BIT) << 12) |
-                                    (((instr & RV32I_MASK_IMM_B_11)    >> RV32I_IMM_B_11_START_BIT)   << 11) |
-                                    (((instr & RV32I_MASK_IMM_B_10_5)  >> RV32I_IMM_B_10_5_START_BIT) <<  5) |
-                                    (((instr & RV32I_MASK_IMM_B_4_1)   >> RV32I_IMM_B_4_1_START_BIT)  <<  1));
+    // Memory not directly accessible (including misaligned addresses, which
+    // trap) is read and written with the bus locked against other AMOs
+    std::unique_lock<std::mutex> lock;
 
-    decoded_data.imm_j = SIGN_EXT21((((instr & RV32I_MASK_IMM_J_20)    >> RV32I_IMM_J_20_START_BIT) << 20) |
-                                    (((instr & RV32I_MASK_IMM_J_19_12) >> RV32I_IMM_J_19_12_START_BIT) << 12) |
-                                    (((instr & RV32I_MASK_IMM_J_11)    >> RV32I_IMM_J_11_START_BIT)    << 11) |
-                                    (((instr & RV32I_MASK_IMM_J_10_1)  >> RV32I_IMM_J_10_1_START_BIT)  <<  1));
+    if (p_rsvd_domain != NULL)
+    {
+        lock = std::unique_lock<std::mutex>(p_rsvd_domain->bus_mutex);
+    }
 
-    // Check this is a 32 bit instruction before proceeding
-    if ((decoded_data.opcode & RV32I_MASK_32BIT_INSTR) == RV32I_MASK_32BIT_INSTR)
+    uint32_t rd_val = read_mem(byte_addr, MEM_RD_ACCESS_WORD, fault);
+
+    if (!fault)
     {
-        p_entry = &primary_tbl[decoded_data.opcode >> 2];
+        write_mem(byte_addr, amo_result(op, rd_val, data), MEM_WR_ACCESS_WORD, fault);
+    }
 
-        // Follow the tables down to until an instruction entry
-        if (p_entry->sub_table)
-        {
-            // Get secondary table entry, if there is one
-            p_entry = &p_entry->ref.p_entry[decoded_data.funct3];
+    return rd_val;
+}
 
-            // Get tertiary table entry, if there is one
-            if (p_entry->sub_table)
-            {
-                // Get entry indexed by funct7, unless a system opcode with funct3 = 0 (ECALL/EBREAK),
-                // where funct12 is used instead (= imm_i)
-                if (decoded_data.opcode == RV32I_SYS_OPCODE && decoded_data.funct3 == 0)
-                {
-                    // Mask imm value to ensure within table bounds.
-                    // TODO: Should really check for all 0s on other bits.
-                    p_entry = &p_entry->ref.p_entry[decoded_data.imm_i & 0x3];
-                }
-                else
-                {
-                    p_entry = &p_entry->ref.p_entry[decoded_data.funct7];
-                }
+uint8_t* rv32i_cpu::direct_page (const uint32_t byte_addr, const bool write)
+{
+    uint32_t page = byte_addr & ~RV32I_TLB_PAGE_MASK;
 
-                // It is illegal, in the base class, to have a fourth level of sub-table.
-                // Call virtual function so child classes can handle separately. Base
-                // class method returns NULL
-                if (p_entry->sub_table)
-                {
-                    decode_exception(p_entry, decoded_data);
-                }
-            }
-        }
+    // Populate a page of a lazily loaded executable before accessing it directly
+    if (lazy_pending)
+    {
+        lazy_populate(byte_addr);
     }
 
-#ifdef RV32E_EXTENSION
-    // If E extensions enabled, it is illegal to have register references
-    // greater than x15
-    if (decoded_data.rd  >= RV32I_NUM_OF_REGISTERS  ||
-        decoded_data.rs1 >= RV32I_NUM_OF_REGISTERS  ||
-        decoded_data.rs2 >= RV32I_NUM_OF_REGISTERS)
+#ifdef RV32I_GUEST_SPACE_SUPPORTED
+    if (guest_mem != NULL)
     {
-        p_entry = NULL;
+        return guest_page_direct(page) ? guest_mem + page : NULL;
     }
 #endif
 
-    // Copy the instruction entry information to the decoded_data structure
-    if (p_entry != NULL)
+    rv32i_tlb_entry_t* p_tlb = &tlb[(byte_addr >> RV32I_TLB_PAGE_BITS) & RV32I_TLB_MASK];
+
+    if ((write ? p_tlb->wr_tag : p_tlb->tag) == page ||
+        (tlb_fill(byte_addr, p_tlb, write) && (write ? p_tlb->wr_tag : p_tlb->tag) == page))
     {
-        decoded_data.entry = p_entry->ref.entry;
+        return p_tlb->p_host;
     }
 
-    return p_entry;
+    return NULL;
 }
 
-// -------------------------------------------------------------------------
-//  Memory access methods
-// -------------------------------------------------------------------------
-
-uint32_t rv32i_cpu::read_mem (const uint32_t byte_addr, const int type, bool &fault)
+int rv32i_cpu::read_block (const uint32_t byte_addr, void* p_buf, const uint32_t len)
 {
-    uint32_t rd_val = 0;
-    uint32_t word;
+    uint8_t* p_dst  = (uint8_t*)p_buf;
+    uint32_t addr   = byte_addr;
+    uint32_t remain = len;
+    int      error  = 0;
 
-    fault = false;
+    while (remain)
+    {
+        uint32_t offset = addr & RV32I_TLB_PAGE_MASK;
+        uint32_t chunk  = (remain < RV32I_TLB_PAGE_SIZE - offset) ? remain : RV32I_TLB_PAGE_SIZE - offset;
+        uint8_t* p_host = direct_page(addr, false);
 
-    int  mem_callback_delay    = RV32I_EXT_MEM_NOT_PROCESSED;
+        if (p_host != NULL)
+        {
+            memcpy(p_dst, p_host + offset, chunk);
+        }
+        else
+        {
+            for (uint32_t idx = 0; idx < chunk; idx++)
+            {
+                bool fault;
 
-    // Check alignment
-    if (((byte_addr & 0x1) && type != MEM_RD_ACCESS_BYTE) ||
-        ((byte_addr & 0x3) != 0x00 && (type == MEM_RD_ACCESS_WORD || type == MEM_RD_ACCESS_INSTR)))
-    {
-        process_trap((type == MEM_RD_ACCESS_INSTR) ? RV32I_IADDR_MISALIGNED : RV32I_LADDR_MISALIGNED);
-        fault = true;
-        return 0;
-    }
+                p_dst[idx] = (uint8_t)read_mem(addr + idx, MEM_RD_ACCESS_BYTE | MEM_DBG_MASK, fault);
+                error     |= fault;
+            }
+        }
 
-    // If a callback registered for memory accesses call it now,
-    // unless accessing the memory mapped real time clock CSR register
-    if (p_mem_callback != NULL && ((byte_addr & 0xfffffff8) != RV32I_RTCLOCK_CMP_ADDRESS))
-    {
-        // Execute callback function
-        mem_callback_delay = p_mem_callback(byte_addr, rd_val, type, cycle_count);
+        p_dst  += chunk;
+        addr   += chunk;
+        remain -= chunk;
     }
 
-    // If no external processing of read, access the internal memory.
-    if (mem_callback_delay == RV32I_EXT_MEM_NOT_PROCESSED)
+    return error;
+}
+
+int rv32i_cpu::write_block (const uint32_t byte_addr, const void* p_buf, const uint32_t len, const bool load)
+{
+    const uint8_t* p_src   = (const uint8_t*)p_buf;
+    uint32_t       addr    = byte_addr;
+    uint32_t       remain  = len;
+    int            error   = 0;
+    const int      wr_type = load ? MEM_WR_ACCESS_INSTR : MEM_WR_ACCESS_WORD;
+
+    while (remain)
     {
-        // Check if accessing the real time clock memory mapped csr register
-        if ((byte_addr & 0xfffffff8) == RV32I_RTCLOCK_ADDRESS) 
-        {
-            word = (uint32_t)(real_time_us() >> ((byte_addr & 0x00000004) ? 32 : 0));
-        }
-        // Check if accessing the memory mapped time compare register
-        else if ((byte_addr & 0xfffffff8) == RV32I_RTCLOCK_CMP_ADDRESS) 
+        uint32_t offset = addr & RV32I_TLB_PAGE_MASK;
+        uint32_t chunk  = (remain < RV32I_TLB_PAGE_SIZE - offset) ? remain : RV32I_TLB_PAGE_SIZE - offset;
+        uint8_t* p_host = direct_page(addr, true);
+
+        if (p_host != NULL)
         {
-            word = (uint32_t)(mtimecmp >> ((byte_addr & 0x00000004) ? 32 : 0)); 
+            memcpy(p_host + offset, p_src, chunk);
+
+            // Invalidate any cached decodes of the words written (as write_mem() does)
+            for (uint32_t word_addr = addr & ~0x3U; ; word_addr += 4)
+            {
+                invalidate_dcache(word_addr);
+
+                if (word_addr == ((addr + chunk - 1) & ~0x3U))
+                {
+                    break;
+                }
+            }
+
+            // Likewise clear any core's reservations of the granules written
+            for (uint32_t grn_addr = RSVD_GRANULE(addr); ; grn_addr += RV32I_RSVD_GRANULE_BYTES)
+            {
+                rsvd_clear(grn_addr);
+
+                if (grn_addr == RSVD_GRANULE(addr + chunk - 1))
+                {
+                    break;
+                }
+            }
         }
         else
         {
-            // Check input is a valid address
-            if (byte_addr > RV32I_INT_MEM_WORDS)
+            uint32_t idx = 0;
+
+            while (idx < chunk)
             {
-                // Flag as a bus error only if this is not a debug access, as debugger may try
-                // to inspect non-valid addresses.
-                if (!(type & MEM_DBG_MASK))
+                bool     fault;
+                uint32_t word;
+
+                if (!((addr + idx) & 0x3) && chunk - idx >= 4)
                 {
-                    process_trap(RV32I_LOAD_ACCESS_FAULT);
-                    fault = true;
+                    memcpy(&word, p_src + idx, sizeof(word));
+                    write_mem(addr + idx, word, wr_type, fault);
+                    idx += 4;
+                }
+                else
+                {
+                    write_mem(addr + idx, p_src[idx], MEM_WR_ACCESS_BYTE, fault);
+                    idx++;
                 }
-                return 0;
-            }
 
-            word = (internal_mem[byte_addr + 0] << 0) |
-                   (internal_mem[byte_addr + 1] << 8) |
-                   (internal_mem[byte_addr + 2] << 16) |
-                   (internal_mem[byte_addr + 3] << 24);
+                error |= fault;
+            }
         }
 
-        switch (type & MEM_NOT_DBG_MASK)
-        {
-        case MEM_RD_ACCESS_BYTE:
-            rd_val = word & 0xff;
-            break;
-        case MEM_RD_ACCESS_HWORD:
-            rd_val = word & 0xffff;
-            break;
-        case MEM_RD_ACCESS_INSTR:
-        case MEM_RD_ACCESS_WORD:
-            rd_val = word;
-            break;
-        default:
-            fprintf(stderr, "***ERROR: invalid read access type (%d)\n", type);
-            exit(USER_ERROR);
-            break;
-        }
+        p_src  += chunk;
+        addr   += chunk;
+        remain -= chunk;
     }
-    else
+
+    return error;
+}
+
+// -----------------------------------------------------------
+// External CSR register access, by address
+// -----------------------------------------------------------
+
+bool rv32i_cpu::read_csr (const uint32_t addr, uint32_t &val, const int hart_num)
+{
+    int idx = csr_storage_index(addr);
+
+    if (idx < 0)
     {
-        cycle_count += mem_callback_delay;
+        return false;
     }
 
-    return rd_val;
+    val = hart_state(hart_num).csr[idx];
+
+    return true;
 }
 
-void rv32i_cpu::write_mem (const uint32_t byte_addr, const uint32_t data, const int type, bool &fault)
+bool rv32i_cpu::write_csr (const uint32_t addr, const uint32_t val, const int hart_num)
 {
-    int       mem_callback_delay    = RV32I_EXT_MEM_NOT_PROCESSED;
-    uint32_t  word = data;
-
-    fault = false;
+    int idx = csr_storage_index(addr);
 
-    // Check alignment
-    if (((byte_addr & 0x1) && type != MEM_WR_ACCESS_BYTE) ||
-        ((byte_addr & 0x3) != 0x00 && (type == MEM_WR_ACCESS_WORD || type == MEM_WR_ACCESS_INSTR)))
+    if (idx < 0)
     {
-        process_trap((type == MEM_WR_ACCESS_INSTR) ? RV32I_IADDR_MISALIGNED : RV32I_ST_AMO_ADDR_MISALIGNED);
-        fault = true;
-        return;
+        return false;
     }
 
-    // If a callback registered for memory accesses call it now,
-    // unless accessing the memory mapped real time clock CSR register
-    if (p_mem_callback != NULL && ((byte_addr & 0xfffffff8) != RV32I_RTCLOCK_CMP_ADDRESS))
+    hart_state(hart_num).csr[idx] = val;
+
+    // The write may have enabled a pending interrupt
+    schedule_event(RV32I_EVENT_INT_UPDATE, clk_cycles());
+
+    return true;
+}
+
+// -----------------------------------------------------------
+// Find the registers of a hart changed since its last snapshot
+// -----------------------------------------------------------
+
+void rv32i_cpu::dirty_regs (rv32i_dirty_regs_t &dirty, const int hart_num)
+{
+    const rv32i_hart_state &curr  = hart_state(hart_num);
+    const rv32i_hart_state &clean = clean_state[hart_num];
+
+    dirty.pc       = curr.pc != clean.pc;
+    dirty.x        = 0;
+    dirty.f        = 0;
+    dirty.num_csrs = 0;
+
+    for (uint32_t reg = 0; reg < RV32I_NUM_OF_REGISTERS; reg++)
     {
-        // Execute callback function
-        mem_callback_delay = p_mem_callback(byte_addr, word, type, cycle_count);
+        dirty.x |= (uint32_t)(curr.x[reg] != clean.x[reg]) << reg;
+        dirty.f |= (uint32_t)(curr.f[reg] != clean.f[reg]) << reg;
     }
 
-    // If no external processing of write, access the internal memory.
-    if (mem_callback_delay == RV32I_EXT_MEM_NOT_PROCESSED)
+    for (uint32_t idx = 0; idx < RV32I_NUM_OF_CSRS; idx++)
     {
+        int addr;
 
-        // Check input is a valid address
-        if (byte_addr >= RV32I_INT_MEM_WORDS) 
-        {
-            process_trap(RV32I_ST_AMO_ACCESS_FAULT);
-            fault = true;
-            return;
-        }
-
-        if ((byte_addr & 0xfffffff8) == RV32I_RTCLOCK_ADDRESS) 
+        if (curr.csr[idx] != clean.csr[idx] && (addr = csr_storage_addr(idx)) >= 0)
         {
-            // At this time, don't write as this is a free running RT clock,
-            // but have to handle to avoid attempt to write to internal
-            // memory at an out-of-range address 
-        }
-        // Check if accessing the memory mapped time compare register
-        else if ((byte_addr & 0xfffffff8) == RV32I_RTCLOCK_CMP_ADDRESS) 
-        {
-            mtimecmp = (mtimecmp & ((byte_addr & 0x00000004) ? 0xFFFFFFFF00000000ULL : 0xFFFFFFFFULL)) | 
-                                   ((uint64_t)word << ((byte_addr & 0x00000004) ? 32 : 0)) ;
-        }
-        else
-        {
-            switch (type)
-            {
-            case MEM_WR_ACCESS_BYTE:
-                internal_mem[byte_addr + 0] = word & 0xff;
-                break;
-            case MEM_WR_ACCESS_HWORD:
-                internal_mem[byte_addr + 0] = (word >> 0) & 0xff;
-                internal_mem[byte_addr + 1] = (word >> 8) & 0xff;
-                break;
-            case MEM_WR_ACCESS_INSTR:
-            case MEM_WR_ACCESS_WORD:
-                internal_mem[byte_addr + 0] = (word >> 0) & 0xff;
-                internal_mem[byte_addr + 1] = (word >> 8) & 0xff;
-                internal_mem[byte_addr + 2] = (word >> 16) & 0xff;
-                internal_mem[byte_addr + 3] = (word >> 24) & 0xff;
-                break;
-            default:
-                fprintf(stderr, "***ERROR: invalid write access type (%d)\n", type);
-                exit(USER_ERROR);
-                break;
-            }
+            dirty.csr_addr[dirty.num_csrs++] = (uint16_t)addr;
         }
     }
-    else
-    {
-        cycle_count += mem_callback_delay;
-    }
 }
 
 // ===========================================================
@@ -613,6 +2936,7 @@ void rv32i_cpu::write_mem (const uint32_t byte_addr, const uint32_t data, const
 // -----------------------------------------------------------
 // Illegal/unimplemented instructions end up here
 //
+template <bool TRACE>
 void rv32i_cpu::reserved(const p_rv32i_decode_t d)
 {
     fprintf(dasm_fp, "**ERROR: Illegal/Unsupported instruction\n");
@@ -625,81 +2949,88 @@ void rv32i_cpu::reserved(const p_rv32i_decode_t d)
 // -----------------------------------------------------------
 // Arithmetic immediate instructions
 //
+template <bool TRACE>
 void rv32i_cpu::addi(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_I_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_I_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = state.hart[curr_hart].x[d->rs1] + d->imm_i;
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_ADD(state.hart[curr_hart].x[d->rs1], d->imm_i);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::slti(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_I_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_I_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = ((int32_t)state.hart[curr_hart].x[d->rs1] < (int32_t)d->imm_i) ? 1 : 0;
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_SLT(state.hart[curr_hart].x[d->rs1], d->imm_i);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::sltiu(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_I_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_I_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = ((uint32_t)state.hart[curr_hart].x[d->rs1] < (uint32_t)d->imm_i) ? 1 : 0;
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_SLTU(state.hart[curr_hart].x[d->rs1], d->imm_i);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::xori(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_I_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_I_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = state.hart[curr_hart].x[d->rs1] ^ d->imm_i;
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_XOR(state.hart[curr_hart].x[d->rs1], d->imm_i);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::ori(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_I_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_I_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = state.hart[curr_hart].x[d->rs1] | d->imm_i;
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_OR(state.hart[curr_hart].x[d->rs1], d->imm_i);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::andi(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_I_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_I_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = state.hart[curr_hart].x[d->rs1] & d->imm_i;
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_AND(state.hart[curr_hart].x[d->rs1], d->imm_i);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::slli(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_I_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i & RV32I_MASK_IMM_I_SHAMT);
+    RV32I_DISASSEM_I_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i & RV32I_MASK_IMM_I_SHAMT);
 
     if (d->instr & RV32I_SHIFT_RSVD_BIT_MASK)
     {
@@ -709,16 +3040,17 @@ void rv32i_cpu::slli(const p_rv32i_decode_t d)
     {
         if (d->rd)
         {
-            state.hart[curr_hart].x[d->rd] = state.hart[curr_hart].x[d->rs1] << (d->imm_i & RV32I_MASK_IMM_I_SHAMT);
+            state.hart[curr_hart].x[d->rd] = RV32I_OP_SLL(state.hart[curr_hart].x[d->rs1], d->imm_i);
         }
 
         increment_pc();
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::srli(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_I_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i & RV32I_MASK_IMM_I_SHAMT);
+    RV32I_DISASSEM_I_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i & RV32I_MASK_IMM_I_SHAMT);
 
     if (d->instr & RV32I_SHIFT_RSVD_BIT_MASK)
     {
@@ -728,16 +3060,17 @@ void rv32i_cpu::srli(const p_rv32i_decode_t d)
     {
         if (d->rd)
         {
-            state.hart[curr_hart].x[d->rd] = state.hart[curr_hart].x[d->rs1] >> (d->imm_i & RV32I_MASK_IMM_I_SHAMT);
+            state.hart[curr_hart].x[d->rd] = RV32I_OP_SRL(state.hart[curr_hart].x[d->rs1], d->imm_i);
         }
 
         increment_pc();
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::srai(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_I_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i & RV32I_MASK_IMM_I_SHAMT);
+    RV32I_DISASSEM_I_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i & RV32I_MASK_IMM_I_SHAMT);
 
     if (d->instr & RV32I_SHIFT_RSVD_BIT_MASK)
     {
@@ -747,8 +3080,7 @@ void rv32i_cpu::srai(const p_rv32i_decode_t d)
     {
         if (d->rd)
         {
-            state.hart[curr_hart].x[d->rd] = (state.hart[curr_hart].x[d->rs1] >> (d->imm_i & RV32I_MASK_IMM_I_SHAMT)) |
-                ((state.hart[curr_hart].x[d->rs1] & MASK_SIGN_BIT32) ? ~(WORD_MASK >> d->imm_i) : 0);
+            state.hart[curr_hart].x[d->rd] = RV32I_OP_SRA(state.hart[curr_hart].x[d->rs1], d->imm_i);
         }
 
         increment_pc();
@@ -758,122 +3090,131 @@ void rv32i_cpu::srai(const p_rv32i_decode_t d)
 // -----------------------------------------------------------
 // Arithmetic register to register instructions
 //
+template <bool TRACE>
 void rv32i_cpu::addr(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = state.hart[curr_hart].x[d->rs1] + state.hart[curr_hart].x[d->rs2];
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_ADD(state.hart[curr_hart].x[d->rs1], state.hart[curr_hart].x[d->rs2]);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::subr(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = state.hart[curr_hart].x[d->rs1] - state.hart[curr_hart].x[d->rs2];
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_SUB(state.hart[curr_hart].x[d->rs1], state.hart[curr_hart].x[d->rs2]);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::sllr(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = state.hart[curr_hart].x[d->rs1] << (state.hart[curr_hart].x[d->rs2] & RV32I_MASK_IMM_I_SHAMT);
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_SLL(state.hart[curr_hart].x[d->rs1], state.hart[curr_hart].x[d->rs2]);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::sltr(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = ((int32_t)state.hart[curr_hart].x[d->rs1] < (int32_t)state.hart[curr_hart].x[d->rs2]) ? 1 : 0;
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_SLT(state.hart[curr_hart].x[d->rs1], state.hart[curr_hart].x[d->rs2]);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::sltur(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = ((uint32_t)state.hart[curr_hart].x[d->rs1] < (uint32_t)state.hart[curr_hart].x[d->rs2]) ? 1 : 0;
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_SLTU(state.hart[curr_hart].x[d->rs1], state.hart[curr_hart].x[d->rs2]);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::xorr(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = state.hart[curr_hart].x[d->rs1] ^ state.hart[curr_hart].x[d->rs2];
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_XOR(state.hart[curr_hart].x[d->rs1], state.hart[curr_hart].x[d->rs2]);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::srlr(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = state.hart[curr_hart].x[d->rs1] >> (state.hart[curr_hart].x[d->rs2] & RV32I_MASK_IMM_I_SHAMT);
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_SRL(state.hart[curr_hart].x[d->rs1], state.hart[curr_hart].x[d->rs2]);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::srar(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = (state.hart[curr_hart].x[d->rs1] >> (state.hart[curr_hart].x[d->rs2] & RV32I_MASK_IMM_I_SHAMT)) |
-                                        ((state.hart[curr_hart].x[d->rs1] & MASK_SIGN_BIT32) ? ~(WORD_MASK >> state.hart[curr_hart].x[d->rs2]) : 0);
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_SRA(state.hart[curr_hart].x[d->rs1], state.hart[curr_hart].x[d->rs2]);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::orr(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = state.hart[curr_hart].x[d->rs1] | state.hart[curr_hart].x[d->rs2];
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_OR(state.hart[curr_hart].x[d->rs1], state.hart[curr_hart].x[d->rs2]);
     }
 
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::andr(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_R_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->rs2);
+    RV32I_DISASSEM_R_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->rs2);
 
     if (d->rd)
     {
-        state.hart[curr_hart].x[d->rd] = state.hart[curr_hart].x[d->rs1] & state.hart[curr_hart].x[d->rs2];
+        state.hart[curr_hart].x[d->rd] = RV32I_OP_AND(state.hart[curr_hart].x[d->rs1], state.hart[curr_hart].x[d->rs2]);
     }
 
     increment_pc();
@@ -882,9 +3223,10 @@ void rv32i_cpu::andr(const p_rv32i_decode_t d)
 // -----------------------------------------------------------
 // Upper immediate instructions
 //
+template <bool TRACE>
 void rv32i_cpu::auipc(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_U_TYPE(d->instr, d->entry.instr_name, d->rd, d->imm_u);
+    RV32I_DISASSEM_U_TYPE(d->instr, instr_name(d), d->rd, d->imm_u);
 
     if (d->rd)
     {
@@ -894,9 +3236,10 @@ void rv32i_cpu::auipc(const p_rv32i_decode_t d)
     increment_pc();
 }
 
+template <bool TRACE>
 void rv32i_cpu::lui(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_U_TYPE(d->instr, d->entry.instr_name, d->rd, d->imm_u);
+    RV32I_DISASSEM_U_TYPE(d->instr, instr_name(d), d->rd, d->imm_u);
 
     if (d->rd)
     {
@@ -909,13 +3252,14 @@ void rv32i_cpu::lui(const p_rv32i_decode_t d)
 // -----------------------------------------------------------
 // Load/store instructions
 //
+template <bool TRACE>
 void rv32i_cpu::lb(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_IL_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_IL_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1] + d->imm_i;
 
@@ -934,13 +3278,14 @@ void rv32i_cpu::lb(const p_rv32i_decode_t d)
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::lh(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_IL_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_IL_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1] + d->imm_i;
 
@@ -959,13 +3304,14 @@ void rv32i_cpu::lh(const p_rv32i_decode_t d)
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::lw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_IL_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_IL_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1] + d->imm_i;
 
@@ -983,13 +3329,14 @@ void rv32i_cpu::lw(const p_rv32i_decode_t d)
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::lbu(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_IL_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_IL_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1] + d->imm_i;
 
@@ -1007,13 +3354,14 @@ void rv32i_cpu::lbu(const p_rv32i_decode_t d)
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::lhu(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_IL_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_IL_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1] + d->imm_i;
 
@@ -1031,13 +3379,14 @@ void rv32i_cpu::lhu(const p_rv32i_decode_t d)
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::sb(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_S_TYPE(d->instr, d->entry.instr_name, d->rs1, d->rs2, d->imm_s);
+    RV32I_DISASSEM_S_TYPE(d->instr, instr_name(d), d->rs1, d->rs2, d->imm_s);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1] + d->imm_s;
 
@@ -1050,13 +3399,14 @@ void rv32i_cpu::sb(const p_rv32i_decode_t d)
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::sh(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_S_TYPE(d->instr, d->entry.instr_name, d->rs1, d->rs2, d->imm_s);
+    RV32I_DISASSEM_S_TYPE(d->instr, instr_name(d), d->rs1, d->rs2, d->imm_s);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1] + d->imm_s;
 
@@ -1069,13 +3419,14 @@ void rv32i_cpu::sh(const p_rv32i_decode_t d)
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::sw(const p_rv32i_decode_t d)
 {
     bool access_fault = false;
 
-    RV32I_DISASSEM_S_TYPE(d->instr, d->entry.instr_name, d->rs1, d->rs2, d->imm_s);
+    RV32I_DISASSEM_S_TYPE(d->instr, instr_name(d), d->rs1, d->rs2, d->imm_s);
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         access_addr = state.hart[curr_hart].x[d->rs1] + d->imm_s;
 
@@ -1091,13 +3442,14 @@ void rv32i_cpu::sw(const p_rv32i_decode_t d)
 // -----------------------------------------------------------
 // Branch instructions
 //
+template <bool TRACE>
 void rv32i_cpu::beq(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_B_TYPE(d->instr, d->entry.instr_name, d->rs1, d->rs2, d->imm_b);
+    RV32I_DISASSEM_B_TYPE(d->instr, instr_name(d), d->rs1, d->rs2, d->imm_b);
 
     access_addr = state.hart[curr_hart].pc + d->imm_b;
 
-    if (!disassemble && state.hart[curr_hart].x[d->rs1] == state.hart[curr_hart].x[d->rs2])
+    if (!RV32I_DISASSEM_ONLY && state.hart[curr_hart].x[d->rs1] == state.hart[curr_hart].x[d->rs2])
     {
         // Check for misalignment on target address
         if (access_addr & 0x00000003)
@@ -1116,13 +3468,14 @@ void rv32i_cpu::beq(const p_rv32i_decode_t d)
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::bne(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_B_TYPE(d->instr, d->entry.instr_name, d->rs1, d->rs2, d->imm_b);
+    RV32I_DISASSEM_B_TYPE(d->instr, instr_name(d), d->rs1, d->rs2, d->imm_b);
 
     access_addr = state.hart[curr_hart].pc + d->imm_b;
 
-    if (!disassemble && state.hart[curr_hart].x[d->rs1] != state.hart[curr_hart].x[d->rs2])
+    if (!RV32I_DISASSEM_ONLY && state.hart[curr_hart].x[d->rs1] != state.hart[curr_hart].x[d->rs2])
     {
         // Check for misalignment on target address
         if (access_addr & 0x00000003)
@@ -1141,13 +3494,14 @@ void rv32i_cpu::bne(const p_rv32i_decode_t d)
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::blt(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_B_TYPE(d->instr, d->entry.instr_name, d->rs1, d->rs2, d->imm_b);
+    RV32I_DISASSEM_B_TYPE(d->instr, instr_name(d), d->rs1, d->rs2, d->imm_b);
 
     access_addr = state.hart[curr_hart].pc + d->imm_b;
 
-    if (!disassemble && (int32_t)state.hart[curr_hart].x[d->rs1] < (int32_t)state.hart[curr_hart].x[d->rs2])
+    if (!RV32I_DISASSEM_ONLY && (int32_t)state.hart[curr_hart].x[d->rs1] < (int32_t)state.hart[curr_hart].x[d->rs2])
     {
         // Check for misalignment on target address
         if (access_addr & 0x00000003)
@@ -1166,13 +3520,14 @@ void rv32i_cpu::blt(const p_rv32i_decode_t d)
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::bge(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_B_TYPE(d->instr, d->entry.instr_name, d->rs1, d->rs2, d->imm_b);
+    RV32I_DISASSEM_B_TYPE(d->instr, instr_name(d), d->rs1, d->rs2, d->imm_b);
 
     access_addr = state.hart[curr_hart].pc + d->imm_b;
 
-    if (!disassemble && (int32_t)state.hart[curr_hart].x[d->rs1] >= (int32_t)state.hart[curr_hart].x[d->rs2])
+    if (!RV32I_DISASSEM_ONLY && (int32_t)state.hart[curr_hart].x[d->rs1] >= (int32_t)state.hart[curr_hart].x[d->rs2])
     {
         // Check for misalignment on target address
         if (access_addr & 0x00000003)
@@ -1191,13 +3546,14 @@ void rv32i_cpu::bge(const p_rv32i_decode_t d)
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::bltu(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_B_TYPE(d->instr, d->entry.instr_name, d->rs1, d->rs2, d->imm_b);
+    RV32I_DISASSEM_B_TYPE(d->instr, instr_name(d), d->rs1, d->rs2, d->imm_b);
 
     access_addr = state.hart[curr_hart].pc + d->imm_b;
 
-    if (!disassemble && state.hart[curr_hart].x[d->rs1] < state.hart[curr_hart].x[d->rs2])
+    if (!RV32I_DISASSEM_ONLY && state.hart[curr_hart].x[d->rs1] < state.hart[curr_hart].x[d->rs2])
     {
         // Check for misalignment on target address
         if (access_addr & 0x00000003)
@@ -1216,13 +3572,14 @@ void rv32i_cpu::bltu(const p_rv32i_decode_t d)
     };
 }
 
+template <bool TRACE>
 void rv32i_cpu::bgeu(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_B_TYPE(d->instr, d->entry.instr_name, d->rs1, d->rs2, d->imm_b);
+    RV32I_DISASSEM_B_TYPE(d->instr, instr_name(d), d->rs1, d->rs2, d->imm_b);
 
     access_addr = state.hart[curr_hart].pc + d->imm_b;
 
-    if (!disassemble && state.hart[curr_hart].x[d->rs1] >= state.hart[curr_hart].x[d->rs2])
+    if (!RV32I_DISASSEM_ONLY && state.hart[curr_hart].x[d->rs1] >= state.hart[curr_hart].x[d->rs2])
     {
         // Check for misalignment on target address
         if (access_addr & 0x00000003)
@@ -1244,12 +3601,13 @@ void rv32i_cpu::bgeu(const p_rv32i_decode_t d)
 // -----------------------------------------------------------
 // Jump and link instructions
 //
+template <bool TRACE>
 void rv32i_cpu::jal(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_J_TYPE(d->instr, d->entry.instr_name, d->rd, d->imm_j);
+    RV32I_DISASSEM_J_TYPE(d->instr, instr_name(d), d->rd, d->imm_j);
     RV32I_DISASSEM_PC_JUMP;
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
 
         access_addr = state.hart[curr_hart].pc + d->imm_j;
@@ -1275,12 +3633,13 @@ void rv32i_cpu::jal(const p_rv32i_decode_t d)
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::jalr(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_I_TYPE(d->instr, d->entry.instr_name, d->rd, d->rs1, d->imm_i);
+    RV32I_DISASSEM_I_TYPE(d->instr, instr_name(d), d->rd, d->rs1, d->imm_i);
     RV32I_DISASSEM_PC_JUMP;
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         uint32_t next_pc = state.hart[curr_hart].pc + 4;
 
@@ -1314,11 +3673,19 @@ void rv32i_cpu::jalr(const p_rv32i_decode_t d)
 // Note that in this ISS, all instructions are completed
 // before executing the next, so no out-of-order memory
 // accesses can occur between harts or external models. Thus
-// FENCE does nothing.
+// FENCE does nothing. FENCE.I (which shares the MISC-MEM
+// opcode) flushes the decoded instruction cache, in case
+// instruction memory was modified other than by write_mem().
 //
+template <bool TRACE>
 void rv32i_cpu::fence(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_IF_TYPE(d->instr, d->entry.instr_name, d->imm_i);
+    RV32I_DISASSEM_IF_TYPE(d->instr, instr_name(d), d->imm_i);
+
+    if (!RV32I_DISASSEM_ONLY && d->funct3 == RV32I_FENCEI_FUNCT3)
+    {
+        flush_dcache();
+    }
 
     increment_pc();
 }
@@ -1326,12 +3693,13 @@ void rv32i_cpu::fence(const p_rv32i_decode_t d)
 // -----------------------------------------------------------
 // System instructions
 //
+template <bool TRACE>
 void rv32i_cpu::ecall(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_SYS_TYPE(d->instr, d->entry.instr_name);
+    RV32I_DISASSEM_SYS_TYPE(d->instr, instr_name(d));
     RV32I_DISASSEM_PC_JUMP;
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         if (halt_ecall)
         {
@@ -1348,12 +3716,13 @@ void rv32i_cpu::ecall(const p_rv32i_decode_t d)
     }
 }
 
+template <bool TRACE>
 void rv32i_cpu::ebreak(const p_rv32i_decode_t d)
 {
-    RV32I_DISASSEM_SYS_TYPE(d->instr, d->entry.instr_name);
+    RV32I_DISASSEM_SYS_TYPE(d->instr, instr_name(d));
     RV32I_DISASSEM_PC_JUMP;
 
-    if (!disassemble)
+    if (!RV32I_DISASSEM_ONLY)
     {
         if (halt_ecall)
         {
@@ -31,7 +31,11 @@
 // INCLUDES
 // -------------------------------------------------------------------------
 
+#include <atomic>
+#include <cassert>
 #include <chrono>
+#include <mutex>
+#include <thread>
 #include <cstdio>
 #include <cstdint>
 #include <cstring>
@@ -42,6 +46,75 @@
 // DEFINES
 // -------------------------------------------------------------------------
 
+// Forward reference of the JIT's code emitter (see rv32i_cpu_jit.h)
+class rv32i_jit_emitter;
+
+// -------------------------------------------------------------------------
+// LR/SC reservations, and the bus lock for AMOs, of the cores sharing a
+// memory (e.g. the harts of a multiprocessor), which join it to have their
+// LR/SC and AMOs atomic with respect to each other. It must outlive them.
+// -------------------------------------------------------------------------
+
+class rv32i_rsvd_domain
+{
+public:
+    LIBRISCV32_API               rv32i_rsvd_domain ();
+
+    // Allocate a free reservation slot, returning -1 if all are taken, and free one
+    int                          alloc_slot        (void);
+    void                         free_slot         (const int slot);
+
+    // Clear every core's reservation of the granule holding a written address
+    void                         clear             (const uint32_t byte_addr);
+
+    // Reservations of the cores, one slot per core, each the reserved granule's
+    // address with RSVD_VALID set, or 0 if none, with a bit each in slots_used
+    std::atomic<uint32_t>        slots             [RV32I_RSVD_MAX_CORES];
+    std::atomic<uint64_t>        slots_used;
+
+    // Holders of reservations, indexed by granule address, with a bit set for each
+    // slot that may hold a reservation of a granule of the entry. A slot's bit is
+    // set before its reservation's load, and cleared when it next reserves a granule
+    // of another entry, or its store conditional is made.
+    std::atomic<uint64_t>        holders           [RV32I_RSVD_TBL_SIZE];
+
+    // Lock held by AMOs (and store conditionals) to memory not directly accessible
+    std::mutex                   bus_mutex;
+};
+
+// -------------------------------------------------------------------------
+// Time base of the cores of a system (e.g. the harts of a multiprocessor),
+// which join it to share one mtime. Virtual mtime is derived from the
+// system's cycle count, advanced by the system at the end of each quantum
+// (once every core has run it) by the most cycles any core ran, with a
+// core's mtime during a quantum including the cycles it has run since the
+// quantum's start. The time source is configured, and paced virtual time
+// measured from, once at the start of the system's run, rather than at each
+// core's run() of a quantum. It must outlive the cores.
+// -------------------------------------------------------------------------
+
+class rv32i_time_base
+{
+public:
+    LIBRISCV32_API               rv32i_time_base   ();
+
+    // Configure the time source from the run configuration, at the start of a run
+    LIBRISCV32_API void          start             (const rv32i_cfg_s &cfg);
+
+    // Advance the system's cycle count at the end of a quantum
+    LIBRISCV32_API void          advance           (const rv32i_time_t cycles) { sys_cycles += cycles; };
+
+    // mtime time source mode, virtual time's frequency ratio, and the wall
+    // clock and mtime at the start of the run when pacing virtual time
+    int                          time_mode;
+    uint32_t                     cycles_per_tick;
+    rv32i_time_t                 pace_wall_base;
+    rv32i_time_t                 pace_mtime_base;
+
+    // System cycle count at the start of the current quantum
+    rv32i_time_t                 sys_cycles;
+};
+
 // -------------------------------------------------------------------------
 // Class definition for RISC-V RV32I instruction set simulator model
 // -------------------------------------------------------------------------
@@ -56,22 +129,24 @@ public:
 
     // Define a class to hold all of the CPU registers. This makes it easier
     // to access all of the state as a single unit for debug purposes, and
-    // save & restore features.
+    // save & restore features. The most used state is placed first, to share
+    // the fewest cache lines.
     class rv32i_hart_state
     {
     public:
 
-        // General purpose registers
-        uint32_t x[RV32I_NUM_OF_REGISTERS];
+        // Program counter
+        uint32_t pc;
 
-        // Floating point registers (for RV32F/RV32D)
-        uint64_t f[RV32I_NUM_OF_REGISTERS];
+        // General purpose registers
+        uint32_t x[RV32I_NUM_OF_REGISTERS] = { 0 };
 
-        // CSR registrs
-        uint32_t csr[RV32I_CSR_SPACE_SIZE] = { 0 };
+        // Implemented CSR registers, indexed by their RV32CSR_IDX_xxx storage
+        // index (with the floating point and trap CSRs first), rather than address
+        uint32_t csr[RV32I_NUM_OF_CSRS] = { 0 };
 
-        // Control and status registers
-        uint32_t pc;                                // Program counter
+        // Floating point registers (for RV32F/RV32D)
+        uint64_t f[RV32I_NUM_OF_REGISTERS] = { 0 };
 
     };
 
@@ -95,7 +170,20 @@ public:
             LIBRISCV32_API      rv32i_cpu                     (FILE* dbgfp = stdout);
 
     // Virtual destructor for polymorphic class
-    virtual LIBRISCV32_API      ~rv32i_cpu                    (){/* No dynamic allocation yet */}
+    virtual LIBRISCV32_API      ~rv32i_cpu                    ()
+    {
+        delete [] dcache;
+        delete [] blk_tbl;
+        delete [] blk_pool;
+        delete [] blk_filter;
+        delete [] jit_seg_pool;
+        jit_free_code();
+        free_int_mem();
+        free_guest_space();
+        lazy_release();
+        free_symbols();
+        rsvd_release();
+    }
 
     // ------------------------------------------------
     // Public methods (user interface)
@@ -103,15 +191,113 @@ public:
     
     LIBRISCV32_API int         run                            (rv32i_cfg_s &cfg);
 
-    // Read executable
-    LIBRISCV32_API int         read_elf                       (const char* const filename);
+    // Read executable, setting the reset vector to its entry point (also returned in
+    // p_entry, if not NULL). Returns non-zero if the file is invalid or loading faults.
+    // If lazy, segments' pages are only populated from the file on first access, with
+    // whole pages in internal memory or a guest space mapped from the file directly.
+    LIBRISCV32_API int         read_elf                       (const char* const filename, uint32_t* p_entry = NULL, const bool lazy = false);
+
+    // Read an executable's symbol table and DWARF line table (if present), replacing any
+    // previously read. Returns non-zero if the file is invalid or tables can't be allocated.
+    LIBRISCV32_API int         read_elf_symbols               (const char* const filename);
+
+    // Look up the symbol containing addr, returning its name and addr's offset from it,
+    // or NULL if none. The source line lookup similarly returns the file name and line.
+    // Both are binary searches that allocate nothing, for use at high rates.
+    LIBRISCV32_API const char* lookup_symbol                  (const uint32_t addr, uint32_t &offset);
+    LIBRISCV32_API const char* lookup_line                    (const uint32_t addr, uint32_t &line);
                                                               
     // External direct memory access
     LIBRISCV32_API uint32_t    read_mem                       (const uint32_t byte_addr, const int type, bool &fault);
     LIBRISCV32_API void        write_mem                      (const uint32_t byte_addr, const uint32_t data, const int type, bool &fault);
 
-    // Callback function registration
-    LIBRISCV32_API void        register_ext_mem_callback      (p_rv32i_memcallback_t callback_func) { p_mem_callback = callback_func; };
+    // Block transfers between a host buffer and memory, of any length and alignment.
+    // RAM is copied directly a page at a time, with any other memory accessed a byte
+    // at a time, as debug reads (which do not fault), or as data writes for whole
+    // aligned words. Writes when loading (load set) are instead loading
+    // (MEM_WR_ACCESS_INSTR) word writes, which alone may write ROM. Returns non-zero
+    // if any access faulted.
+    LIBRISCV32_API int         read_block                     (const uint32_t byte_addr, void* p_buf, const uint32_t len);
+    LIBRISCV32_API int         write_block                    (const uint32_t byte_addr, const void* p_buf, const uint32_t len, const bool load = false);
+
+    // Callback function registration. Internal memory is only mapped in the TLB
+    // when there is no memory callback to take precedence, so it is flushed.
+    LIBRISCV32_API void        register_ext_mem_callback      (p_rv32i_memcallback_t callback_func) { p_mem_callback = callback_func; flush_tlb(); };
+    LIBRISCV32_API void        register_ram_page_callback     (p_rv32i_pagecallback_t callback_func){ p_page_callback = callback_func; flush_tlb(); };
+
+    // Set the internal memory's (page aligned) base address and size, normally
+    // from the rv32i_cfg_s int_mem_base and int_mem_size values. Memory is
+    // reserved from the host on demand, so only pages accessed take up space.
+    // Any previous contents are discarded, so this should be called before
+    // loading a program. Returns non-zero if misaligned, the size rounds up to
+    // 4GB or beyond the top of the address space, or allocation fails.
+    LIBRISCV32_API int         set_int_mem                    (const uint32_t base, const uint32_t size);
+
+    // Use another core's internal memory in place of this one's, as for the harts of
+    // a multiprocessor. That core must not reconfigure its memory, and must outlive this one.
+    LIBRISCV32_API void        share_int_mem                  (const rv32i_cpu* p_cpu);
+
+    // Join a reservation domain, shared with the other cores accessing the same memory,
+    // leaving any previous one. Returns non-zero if the domain's slots are all taken.
+    LIBRISCV32_API int         join_rsvd_domain               (rv32i_rsvd_domain* p_domain);
+
+    // Join a time base, shared with the other cores of a system, for them all to see
+    // the same mtime (or leave any, with NULL), taking effect from the next run()
+    LIBRISCV32_API void        join_time_base                 (rv32i_time_base* p_base)            { p_time_base = p_base; };
+
+    // Reserve the whole 32 bit address space in host virtual memory (Linux x86-64
+    // hosts only), with loads and stores then made directly, without a TLB lookup.
+    // All addresses are RAM, in place of the internal memory and memory callbacks,
+    // except pages holding a registered region or the real time clock registers.
+    // These are left inaccessible, and the host fault on accessing one is caught
+    // and the access routed through the memory map as normal, after returning from
+    // the fault handler (so callbacks need not be async-signal-safe). May be called
+    // for different cores from several threads. Returns non-zero if not supported
+    // on the host, or the reservation fails.
+    LIBRISCV32_API int         reserve_guest_space            (void);
+
+    // Called from the host fault handler to redirect a faulting guest space access to the
+    // memory map, with the fault address and signal context. Returns false if not a guest
+    // space access.
+    static bool                guest_access_fault             (const uint8_t* p_fault, void* p_context);
+
+    // Memory map registration. Accesses to a registered region are decoded
+    // before the memory access callback, which then only sees accesses to
+    // addresses outside of all regions (or those an MMIO handler declines,
+    // by returning RV32I_EXT_MEM_NOT_PROCESSED).
+    //
+    // RAM (or ROM, if not writable) regions are page aligned and held in host
+    // memory, in little endian byte order, and are accessed directly via the
+    // TLB. ROM may only be written by loading (MEM_WR_ACCESS_INSTR accesses).
+    //
+    // MMIO regions have their own handler, of the memory access callback type
+    // (passed the full address), with accesses lacking permission faulting.
+    //
+    // The latency is added to the cycle count for each access (and also any
+    // returned by an MMIO handler). Return non-zero if a region is misaligned,
+    // overlaps another, or too many are registered.
+    LIBRISCV32_API int         register_ram                   (const uint32_t base, const uint32_t size, uint8_t* p_host, const bool writable = true, const uint32_t latency = 0);
+    LIBRISCV32_API int         register_mmio                  (const uint32_t base, const uint32_t size, p_rv32i_memcallback_t handler,
+                                                               const int perm = RV32I_REGION_PERM_RW, const uint32_t latency = 0);
+
+    // Invalidate all TLB entries, or those for the page holding an address. This must
+    // be called if memory returned by the RAM page callback is remapped or freed.
+    LIBRISCV32_API void        flush_tlb                      (void)
+    {
+        for (int idx = 0; idx < RV32I_TLB_SIZE; idx++)
+        {
+            tlb[idx].tag    = RV32I_TLB_INVALID_TAG;
+            tlb[idx].wr_tag = RV32I_TLB_INVALID_TAG;
+        }
+    };
+
+    LIBRISCV32_API void        flush_tlb_page                 (const uint32_t byte_addr)
+    {
+        rv32i_tlb_entry_t* p_tlb = &tlb[(byte_addr >> RV32I_TLB_PAGE_BITS) & RV32I_TLB_MASK];
+
+        p_tlb->tag    = RV32I_TLB_INVALID_TAG;
+        p_tlb->wr_tag = RV32I_TLB_INVALID_TAG;
+    };
 
     // Reset the cpu (i.e. generate a reset pin assertion event)
     LIBRISCV32_API void        reset_cpu                      (void)                                { reset(); };
@@ -128,8 +314,70 @@ public:
         return state.hart[curr_hart].pc;
     };
 
-    LIBRISCV32_API rv32i_hart_state rv32_get_cpu_state(int hart_num = 0)                            { return state.hart[hart_num]; }
-    LIBRISCV32_API void             rv32_set_cpu_state(rv32i_hart_state &s, int hart_num = 0)       { state.hart[hart_num] = s; }
+    // Invalidate all decoded instruction cache entries and basic blocks. Writes
+    // via write_mem() are tracked automatically, but this should be called if
+    // instruction memory is modified by any other means (e.g. directly by an
+    // external model)
+    LIBRISCV32_API void        flush_dcache                   (void)
+    {
+        for (uint32_t idx = 0; dcache != NULL && idx <= dcache_mask; idx++)
+        {
+            dcache[idx].tag = RV32I_DCACHE_INVALID_TAG;
+        }
+
+        flush_blocks();
+    };
+
+    // Decoded instruction cache statistics
+    LIBRISCV32_API uint64_t    dcache_hits                    ()                                    { return dcache_hit_count; };
+    LIBRISCV32_API uint64_t    dcache_misses                  ()                                    { return dcache_miss_count; };
+
+    // Basic block cache statistics
+    LIBRISCV32_API uint64_t    blk_executions                 ()                                    { return blk_exec_count; };
+    LIBRISCV32_API uint64_t    blk_chained                    ()                                    { return blk_chain_count; };
+    LIBRISCV32_API uint64_t    blk_builds                     ()                                    { return blk_build_count; };
+
+    // Bytes of host memory allocated for the decoded instruction, basic block and JIT caches
+    LIBRISCV32_API uint64_t    cache_footprint                ();
+
+    // Total number of instructions executed by calls to run()
+    LIBRISCV32_API uint64_t    instructions_run               ()                                    { return instr_run_count; };
+
+    // Clock cycle count
+    LIBRISCV32_API rv32i_time_t clock_cycles                  ()                                    { return cycle_count; };
+
+    // Whether the last call to run() stopped at its instruction limit, rather than
+    // halting (both return SIGTRAP if halted by an ebreak)
+    LIBRISCV32_API bool        instr_limit_reached            ()                                    { return limit_reached; };
+
+    // JIT statistics
+    LIBRISCV32_API uint64_t    jit_translations               ()                                    { return jit_trans_count; };
+    LIBRISCV32_API uint64_t    jit_executions                 ()                                    { return jit_exec_count; };
+    LIBRISCV32_API uint64_t    jit_checks                     ()                                    { return jit_check_count; };
+
+    LIBRISCV32_API rv32i_hart_state rv32_get_cpu_state(int hart_num = 0)                            { return hart_state(hart_num); }
+    LIBRISCV32_API void             rv32_set_cpu_state(rv32i_hart_state &s, int hart_num = 0)       { hart_state(hart_num) = s; }
+
+    // Register access for external tools (e.g. debuggers and co-simulation) without copying the
+    // state, with a read only view of all of a hart's registers for batched access. CSRs are
+    // accessed by address, returning false if not implemented (writes ignore the write masks).
+    // Register numbers are masked to the number of registers, and the hart number must be
+    // less than RV32I_NUM_OF_HARTS (which is asserted).
+    LIBRISCV32_API const rv32i_hart_state& rv32_cpu_state_view(int hart_num = 0)                   { return hart_state(hart_num); }
+
+    LIBRISCV32_API uint32_t    read_pc                        (const int hart_num = 0)              { return hart_state(hart_num).pc; }
+    LIBRISCV32_API void        write_pc                       (const uint32_t val, const int hart_num = 0) { hart_state(hart_num).pc = val; }
+    LIBRISCV32_API uint32_t    read_xreg                      (const uint32_t reg, const int hart_num = 0) { return hart_state(hart_num).x[reg & RV32I_REG_IDX_MASK]; }
+    LIBRISCV32_API void        write_xreg                     (const uint32_t reg, const uint32_t val, const int hart_num = 0) { if (reg & RV32I_REG_IDX_MASK) hart_state(hart_num).x[reg & RV32I_REG_IDX_MASK] = val; }
+    LIBRISCV32_API uint64_t    read_freg                      (const uint32_t reg, const int hart_num = 0) { return hart_state(hart_num).f[reg & RV32I_REG_IDX_MASK]; }
+    LIBRISCV32_API void        write_freg                     (const uint32_t reg, const uint64_t val, const int hart_num = 0) { hart_state(hart_num).f[reg & RV32I_REG_IDX_MASK] = val; }
+    LIBRISCV32_API bool        read_csr                       (const uint32_t addr, uint32_t &val, const int hart_num = 0);
+    LIBRISCV32_API bool        write_csr                      (const uint32_t addr, const uint32_t val, const int hart_num = 0);
+
+    // Dirty register tracking. Snapshot a hart's registers (e.g. when stopped), and later
+    // find those that have changed since, so only they need fetching.
+    LIBRISCV32_API void        snapshot_regs                  (const int hart_num = 0)              { clean_state[hart_num] = hart_state(hart_num); }
+    LIBRISCV32_API void        dirty_regs                     (rv32i_dirty_regs_t &dirty, const int hart_num = 0);
 
     // ------------------------------------------------
     // Public member variables
@@ -146,59 +394,59 @@ protected:
     // ------------------------------------------------
 
     // Mappings of register indexes to register name strings 
-    const char* rmap_str[32] = { "zero", "ra", "sp",  "gp",  "tp", "t0", "t1", "t2",
-                                 "s0",   "s1", "a0",  "a1",  "a2", "a3", "a4", "a5",
-                                 "a6",   "a7", "s2",  "s3",  "s4", "s5", "s6", "s7",
-                                 "s8",   "s9", "s10", "s11", "t3", "t4", "t5", "t6"};
+    static constexpr const char* rmap_str[32] = { "zero", "ra", "sp",  "gp",  "tp", "t0", "t1", "t2",
+                                                  "s0",   "s1", "a0",  "a1",  "a2", "a3", "a4", "a5",
+                                                  "a6",   "a7", "s2",  "s3",  "s4", "s5", "s6", "s7",
+                                                  "s8",   "s9", "s10", "s11", "t3", "t4", "t5", "t6"};
 
     // Mappings of register indexes to register name strings 
-    const char* fmap_str[32] = { "ft0", "ft1", "ft2",  "ft3",  "ft4", "ft5", "ft6",  "ft7",
-                                 "fs0", "fs1", "fa0",  "fa1",  "fa2", "fa3", "fa4",  "fa5",
-                                 "fa6", "fa7", "fs2",  "fs3",  "fs4", "fs5", "fs6",  "fs7",
-                                 "fs8", "fs9", "fs10", "fs11", "ft8", "ft9", "ft10", "ft11"};
+    static constexpr const char* fmap_str[32] = { "ft0", "ft1", "ft2",  "ft3",  "ft4", "ft5", "ft6",  "ft7",
+                                                  "fs0", "fs1", "fa0",  "fa1",  "fa2", "fa3", "fa4",  "fa5",
+                                                  "fa6", "fa7", "fs2",  "fs3",  "fs4", "fs5", "fs6",  "fs7",
+                                                  "fs8", "fs9", "fs10", "fs11", "ft8", "ft9", "ft10", "ft11"};
 
     // String constants for instruction disassembly
-    const char reserved_str[DISASSEM_STR_SIZE] = "reserved ";
-    const char lb_str      [DISASSEM_STR_SIZE] = "lb       ";
-    const char lh_str      [DISASSEM_STR_SIZE] = "lh       ";
-    const char lw_str      [DISASSEM_STR_SIZE] = "lw       ";
-    const char lbu_str     [DISASSEM_STR_SIZE] = "lbu      ";
-    const char lhu_str     [DISASSEM_STR_SIZE] = "lhu      ";
-    const char sb_str      [DISASSEM_STR_SIZE] = "sb       ";
-    const char sh_str      [DISASSEM_STR_SIZE] = "sh       ";
-    const char sw_str      [DISASSEM_STR_SIZE] = "sw       ";
-    const char beq_str     [DISASSEM_STR_SIZE] = "beq      ";
-    const char bne_str     [DISASSEM_STR_SIZE] = "bne      ";
-    const char blt_str     [DISASSEM_STR_SIZE] = "blt      ";
-    const char bge_str     [DISASSEM_STR_SIZE] = "bge      ";
-    const char bltu_str    [DISASSEM_STR_SIZE] = "bltu     ";
-    const char bgeu_str    [DISASSEM_STR_SIZE] = "bgeu     ";
-    const char jalr_str    [DISASSEM_STR_SIZE] = "jalr     ";
-    const char jal_str     [DISASSEM_STR_SIZE] = "jal      ";
-    const char fence_str   [DISASSEM_STR_SIZE] = "fence    ";
-    const char addi_str    [DISASSEM_STR_SIZE] = "addi     ";
-    const char slti_str    [DISASSEM_STR_SIZE] = "slti     ";
-    const char sltiu_str   [DISASSEM_STR_SIZE] = "sltiu    ";
-    const char xori_str    [DISASSEM_STR_SIZE] = "xori     ";
-    const char ori_str     [DISASSEM_STR_SIZE] = "ori      ";
-    const char andi_str    [DISASSEM_STR_SIZE] = "andi     ";
-    const char slli_str    [DISASSEM_STR_SIZE] = "slli     ";
-    const char srli_str    [DISASSEM_STR_SIZE] = "srli     ";
-    const char srai_str    [DISASSEM_STR_SIZE] = "srai     ";
-    const char add_str     [DISASSEM_STR_SIZE] = "add      ";
-    const char sub_str     [DISASSEM_STR_SIZE] = "sub      ";
-    const char sll_str     [DISASSEM_STR_SIZE] = "sll      ";
-    const char slt_str     [DISASSEM_STR_SIZE] = "slt      ";
-    const char sltu_str    [DISASSEM_STR_SIZE] = "sltu     ";
-    const char xor_str     [DISASSEM_STR_SIZE] = "xor      ";
-    const char srl_str     [DISASSEM_STR_SIZE] = "srl      ";
-    const char sra_str     [DISASSEM_STR_SIZE] = "sra      ";
-    const char or_str      [DISASSEM_STR_SIZE] = "or       ";
-    const char and_str     [DISASSEM_STR_SIZE] = "and      ";
-    const char ecall_str   [DISASSEM_STR_SIZE] = "ecall    ";
-    const char ebrk_str    [DISASSEM_STR_SIZE] = "ebreak   ";
-    const char auipc_str   [DISASSEM_STR_SIZE] = "auipc    ";
-    const char lui_str     [DISASSEM_STR_SIZE] = "lui      ";
+    static constexpr char reserved_str[] = "reserved ";
+    static constexpr char lb_str      [] = "lb       ";
+    static constexpr char lh_str      [] = "lh       ";
+    static constexpr char lw_str      [] = "lw       ";
+    static constexpr char lbu_str     [] = "lbu      ";
+    static constexpr char lhu_str     [] = "lhu      ";
+    static constexpr char sb_str      [] = "sb       ";
+    static constexpr char sh_str      [] = "sh       ";
+    static constexpr char sw_str      [] = "sw       ";
+    static constexpr char beq_str     [] = "beq      ";
+    static constexpr char bne_str     [] = "bne      ";
+    static constexpr char blt_str     [] = "blt      ";
+    static constexpr char bge_str     [] = "bge      ";
+    static constexpr char bltu_str    [] = "bltu     ";
+    static constexpr char bgeu_str    [] = "bgeu     ";
+    static constexpr char jalr_str    [] = "jalr     ";
+    static constexpr char jal_str     [] = "jal      ";
+    static constexpr char fence_str   [] = "fence    ";
+    static constexpr char addi_str    [] = "addi     ";
+    static constexpr char slti_str    [] = "slti     ";
+    static constexpr char sltiu_str   [] = "sltiu    ";
+    static constexpr char xori_str    [] = "xori     ";
+    static constexpr char ori_str     [] = "ori      ";
+    static constexpr char andi_str    [] = "andi     ";
+    static constexpr char slli_str    [] = "slli     ";
+    static constexpr char srli_str    [] = "srli     ";
+    static constexpr char srai_str    [] = "srai     ";
+    static constexpr char add_str     [] = "add      ";
+    static constexpr char sub_str     [] = "sub      ";
+    static constexpr char sll_str     [] = "sll      ";
+    static constexpr char slt_str     [] = "slt      ";
+    static constexpr char sltu_str    [] = "sltu     ";
+    static constexpr char xor_str     [] = "xor      ";
+    static constexpr char srl_str     [] = "srl      ";
+    static constexpr char sra_str     [] = "sra      ";
+    static constexpr char or_str      [] = "or       ";
+    static constexpr char and_str     [] = "and      ";
+    static constexpr char ecall_str   [] = "ecall    ";
+    static constexpr char ebrk_str    [] = "ebreak   ";
+    static constexpr char auipc_str   [] = "auipc    ";
+    static constexpr char lui_str     [] = "lui      ";
 
     // ------------------------------------------------
     // Internal Type definitions
@@ -228,27 +476,38 @@ protected:
     // Load/store or jump target address (for trap handling)
     uint32_t              access_addr;
 
-    // RV32I Decode tables
-    rv32i_decode_table_t  primary_tbl    [RV32I_NUM_PRIMARY_OPCODES];
-    rv32i_decode_table_t  load_tbl       [RV32I_NUM_SECONDARY_OPCODES];
-    rv32i_decode_table_t  store_tbl      [RV32I_NUM_SECONDARY_OPCODES];
-    rv32i_decode_table_t  branch_tbl     [RV32I_NUM_SECONDARY_OPCODES];
-    rv32i_decode_table_t  op_imm_tbl     [RV32I_NUM_SECONDARY_OPCODES];
-    rv32i_decode_table_t  op_tbl         [RV32I_NUM_SECONDARY_OPCODES];
-    rv32i_decode_table_t  arith_tbl      [RV32I_NUM_TERTIARY_OPCODES];
-    rv32i_decode_table_t  sri_tbl        [RV32I_NUM_TERTIARY_OPCODES];
-    rv32i_decode_table_t  srr_tbl        [RV32I_NUM_TERTIARY_OPCODES];
-    rv32i_decode_table_t  sll_tbl        [RV32I_NUM_TERTIARY_OPCODES];
-    rv32i_decode_table_t  slt_tbl        [RV32I_NUM_TERTIARY_OPCODES];
-    rv32i_decode_table_t  sltu_tbl       [RV32I_NUM_TERTIARY_OPCODES];
-    rv32i_decode_table_t  xor_tbl        [RV32I_NUM_TERTIARY_OPCODES];
-    rv32i_decode_table_t  or_tbl         [RV32I_NUM_TERTIARY_OPCODES];
-    rv32i_decode_table_t  and_tbl        [RV32I_NUM_TERTIARY_OPCODES];
+    // RV32I Decode tables. These only exist while the flattened decode
+    // lookup is generated, being allocated by init_decode_tables()
+    rv32i_decode_table_t* primary_tbl;
+    rv32i_decode_table_t* load_tbl;
+    rv32i_decode_table_t* store_tbl;
+    rv32i_decode_table_t* branch_tbl;
+    rv32i_decode_table_t* op_imm_tbl;
+    rv32i_decode_table_t* op_tbl;
+    rv32i_decode_table_t* arith_tbl;
+    rv32i_decode_table_t* sri_tbl;
+    rv32i_decode_table_t* srr_tbl;
+    rv32i_decode_table_t* sll_tbl;
+    rv32i_decode_table_t* slt_tbl;
+    rv32i_decode_table_t* sltu_tbl;
+    rv32i_decode_table_t* xor_tbl;
+    rv32i_decode_table_t* or_tbl;
+    rv32i_decode_table_t* and_tbl;
 
 
     // Decode table for SYSTEM instructions
-    rv32i_decode_table_t  sys_tbl        [RV32I_NUM_SECONDARY_OPCODES];
-    rv32i_decode_table_t  e_tbl          [RV32I_NUM_SYSTEM_OPCODES];
+    rv32i_decode_table_t* sys_tbl;
+    rv32i_decode_table_t* e_tbl;
+
+    // Flattened decode lookup, generated from the above tables (and those
+    // of any extensions) on the first run, and shared by all cores of the
+    // same class. Only this is used to decode.
+    rv32i_decode_lookup_t* p_dec;
+
+    // Cycle count at which each interrupt event source is next due,
+    // and the earliest of them, checked by the run loop
+    rv32i_time_t          event_cycle    [RV32I_NUM_EVENTS];
+    rv32i_time_t          next_event_cycle;
 
     // ------------------------------------------------
     // Private member variables
@@ -258,13 +517,37 @@ protected:
     // Trap status
     int32_t               trap;
 
-    // Internal memory
-    uint8_t               internal_mem   [4*RV32I_INT_MEM_WORDS+4];
+    // Internal memory, and its base address and size
+    uint8_t*              int_mem;
+    uint32_t              int_mem_base;
+    uint32_t              int_mem_size;
+    bool                  int_mem_shared;
+
+    // Reservation domain joined (or NULL if none) and LR/SC reservation slot in
+    // it (or -1), and whether a reservation is held, with the address reserved
+    // and the value it was loaded with
+    rv32i_rsvd_domain*    p_rsvd_domain;
+    int                   rsvd_slot;
+    bool                  rsvd_held;
+    uint32_t              rsvd_addr;
+    uint32_t              rsvd_val;
 
     rv32i_time_t          cycle_count;
 
     rv32i_time_t          mtimecmp;
 
+    // mtime time source mode, virtual time's frequency ratio, and the wall
+    // clock and mtime at the start of a run when pacing virtual time
+    int                   time_mode;
+    uint32_t              cycles_per_tick;
+    rv32i_time_t          pace_wall_base;
+    rv32i_time_t          pace_mtime_base;
+
+    // Time base joined (or NULL if none), and the cycle count at the start of
+    // the current run() (i.e. the system's quantum) when one has been joined
+    rv32i_time_base*      p_time_base;
+    rv32i_time_t          run_cycle_base;
+
     // String forming scratch space
     char                  str            [NUM_DISASSEM_BUFS][DISASSEM_STR_SIZE];
     int                   str_idx;
@@ -272,28 +555,119 @@ protected:
     // Pointer to external memory callback function
     p_rv32i_memcallback_t p_mem_callback;
 
+    // Software TLB of host pointers to RAM pages, filled from the registered
+    // RAM regions and the RAM page callback
+    rv32i_tlb_entry_t     tlb            [RV32I_TLB_SIZE];
+    p_rv32i_pagecallback_t p_page_callback;
+
+    // Memory map regions (sorted on base address), and the last one found
+    rv32i_region_t        regions        [RV32I_MAX_REGIONS];
+    uint32_t              num_regions;
+    rv32i_region_t*       p_last_region;
+
+    // Reserved guest address space (if any), and the fault status of the
+    // last direct access, which may be set by a memory map stub
+    uint8_t*              guest_mem;
+    volatile bool         guest_fault;
+
+    // Lazily loaded ELF file contents, its segments, and the number of their
+    // pages still to be populated
+    const uint8_t*        lazy_file;
+    size_t                lazy_size;
+    rv32i_lazy_seg_t      lazy_segs      [RV32I_MAX_LAZY_SEGS];
+    uint32_t              lazy_num_segs;
+    uint32_t              lazy_pending;
+
+    // Executable symbol and source line tables, and the pool of their names,
+    // with the source line last labelled in the disassembly
+    rv32i_symbol_t*       syms;
+    uint32_t              num_syms;
+    rv32i_line_t*         lines;
+    uint32_t              num_lines;
+    char*                 sym_pool;
+    const char*           dasm_file;
+    uint32_t              dasm_line;
+
+    // Snapshot of each hart's registers for dirty register tracking
+    rv32i_hart_state      clean_state    [RV32I_NUM_OF_HARTS];
+
     // Current instruction
     uint32_t              curr_instr;
 
     // Reset vector
     uint32_t              reset_vector;
 
+    // Decoded instruction cache (of dcache_mask+1 entries), and its hit/miss counts
+    rv32i_dcache_entry_t* dcache;
+    uint32_t              dcache_mask;
+    bool                  dcache_en;
+    uint64_t              dcache_hit_count;
+    uint64_t              dcache_miss_count;
+
+    // Basic block cache, the pool its blocks' instructions are allocated from,
+    // and a filter flagging memory lines that are covered by a block
+    rv32i_block_t*        blk_tbl;
+    uint32_t              blk_tbl_mask;
+    rv32i_dcache_entry_t* blk_pool;
+    uint32_t              blk_pool_size;
+    uint32_t              blk_pool_idx;
+    uint8_t*              blk_filter;
+    uint32_t              blk_filter_mask;
+    bool                  blk_en;
+
+    // Block currently being recorded (NULL if none)
+    rv32i_block_t*        blk_rec;
+    uint32_t              blk_rec_pc;
+
+    // Flag to terminate execution of a block early (e.g. on a write to one)
+    bool                  blk_exit;
+
+    uint64_t              blk_exec_count;
+    uint64_t              blk_chain_count;
+    uint64_t              blk_build_count;
+
+    // JIT code cache (its size and next free byte), and the pool that translated
+    // blocks' segments are allocated from (parallel to the block pool)
+    uint8_t*              jit_code;
+    uint32_t              jit_code_size;
+    uint32_t              jit_code_idx;
+    rv32i_jit_seg_t*      jit_seg_pool;
+    bool                  jit_en;
+    bool                  jit_check;
+
+    uint64_t              jit_trans_count;
+    uint64_t              jit_exec_count;
+    uint64_t              jit_check_count;
+
+    // Threaded dispatch engine enable
+    bool                  thr_en;
+
+    // Instructions executed over all calls to run()
+    uint64_t              instr_run_count;
+
+    // Last call to run() stopped at its instruction limit
+    bool                  limit_reached;
+
     // ------------------------------------------------
     // Virtual methods
     // ------------------------------------------------
 public:
     // Instruction for illegal/unimplemented instructions. Public
-    // so derived classes can use same function, and virtual so
-    // can be overloaded.
-    virtual void reserved                 (const p_rv32i_decode_t);
+    // so derived classes can use same function. Not virtual, as
+    // instruction methods are templates (with traced and untraced
+    // variants), but a derived class can add its own to the
+    // decode tables instead.
+    template <bool TRACE> void reserved   (const p_rv32i_decode_t);
 
 protected:
     // State reset
     virtual void     reset                ();
 
-    // Increment PC. For RV32I always 4, but can be overridden
-    // to support compressed instructions (RV32C)
-    virtual void increment_pc()
+    // Increment PC. Always 4, as no compressed instructions (RV32C)
+    // are supported, and so not virtual (the decoded instruction
+    // cache, block cache and execution engines all assume 4 byte
+    // instructions too)
+    void increment_pc()
     {
         state.hart[curr_hart].pc += 4;
     }
@@ -302,6 +676,11 @@ protected:
     virtual uint32_t access_csr(const unsigned funct3, const uint32_t addr, const uint32_t rd, const uint32_t value) { return 1;}
     virtual uint32_t csr_wr_mask(const uint32_t addr, bool& unimp) { unimp = true; return 0;}
 
+    // Place holder virtual methods mapping between CSR addresses and storage indices, with
+    // -1 returned for an unimplemented CSR (or storage index)
+    virtual int      csr_storage_index(const uint32_t addr) { return -1; }
+    virtual int      csr_storage_addr(const uint32_t idx) { return -1; }
+
 private:
     // RV32I trap processing. Since CSR registers not implemented,
     // the PC is redirected to a fixed trap location. Can be overridden
@@ -312,13 +691,32 @@ private:
     }
 
     // Virtual place holder for adding interrupt features
-    // (external time and software. Called once per execute() cycle.
-    virtual int process_interrupts() { return 0; };
+    // (external time and software). Called when the earliest
+    // scheduled event is due, and must reschedule the interrupt
+    // events it processes. The base class has no interrupts, so
+    // none are due again until another is scheduled.
+    virtual int process_interrupts()
+    {
+        for (int event = 0; event < RV32I_NUM_INT_EVENTS; event++)
+        {
+            event_cycle[event] = RV32I_EVENT_NEVER;
+        }
+        update_next_event();
+
+        return 0;
+    };
+
+    // Hook called by the execution loop for a core class (CORE) of
+    // rv32i_cpu itself, so through the virtual method. The final
+    // rv32_core<> class hides this with a statically bound call.
+    int core_process_interrupts()
+    {
+        return process_interrupts();
+    }
 
-    // Fetch next instruction. For RV32I, always a simple 32 bit read.
-    // Can be overridden to support compressed instructions (RV32C),
-    // expanding to 32 bits, and managing half word PC increments. 
-    virtual uint32_t fetch_instruction()
+    // Fetch next instruction. Always a simple 32 bit read, as for
+    // increment_pc().
+    uint32_t fetch_instruction()
     {
         bool fault;
         return read_mem(state.hart[curr_hart].pc, MEM_RD_ACCESS_INSTR, fault);
@@ -335,6 +733,23 @@ private:
 
 protected:
 
+    // Decode table set up, for generating the flattened decode lookup. Extensions
+    // override this to add their instructions to the tables of the class they extend,
+    // allocating any tables of their own with new_decode_table().
+    virtual void init_decode_tables      (void);
+
+    // Run the execution loop, with traced (trace true) or untraced instruction methods.
+    // The final rv32_core<> class overrides this to run the loop for its own class, with
+    // its hooks then bound statically. The loop is called once per run(), so this is the
+    // only virtual call needed to select it.
+    virtual int  run_engine              (rv32i_cfg_s &cfg, unsigned &instr_count, const bool trace);
+
+    // Execution loop, for a core class (CORE) whose hooks it calls, and with traced
+    // (TRACE true) and untraced variants. Each class run is instantiated in rv32i_cpu.cpp.
+    template <class CORE, bool TRACE>
+    int  run_loop                        (rv32i_cfg_s &cfg, unsigned &instr_count);
+    rv32i_decode_table_t* new_decode_table (const int size);
+
     // Disassembly register name decode to a fixed width string
     // (Uses [and clobbers] scratch member variable "str and its
     // index, str_idx")
@@ -375,6 +790,17 @@ protected:
         return str[str_idx];
     }
 
+    // Disassembly instruction name. Decoded instructions do not
+    // carry their table entry, so it is looked up by decoding the
+    // instruction again (only done when disassembling)
+    inline const char* instr_name        (const p_rv32i_decode_t d)
+    {
+        rv32i_decode_t        decode;
+        rv32i_handler_t*      p_entry = primary_decode(d->instr, decode);
+
+        return (p_entry != NULL) ? p_entry->instr_name : reserved_str;
+    }
+
     // Return real time as the number of microseconds 
     inline uint64_t real_time_us() {
         using namespace std::chrono;
@@ -385,6 +811,67 @@ protected:
         return cycle_count;
     }
 
+    // Return the cycle count virtual mtime is derived from, which is the system's
+    // when sharing a time base
+    inline rv32i_time_t sys_cycles() {
+        return (p_time_base != NULL) ? p_time_base->sys_cycles + (cycle_count - run_cycle_base) : cycle_count;
+    }
+
+    // Return mtime, from the configured time source
+    inline rv32i_time_t mtime() {
+        return (time_mode == RV32I_TIME_REAL) ? (rv32i_time_t)real_time_us() : sys_cycles() / cycles_per_tick;
+    }
+
+    // Return the cycle count at which virtual mtime reaches the given time
+    inline rv32i_time_t mtime_cycle(const uint64_t time) {
+        if (time >= (uint64_t)(RV32I_EVENT_NEVER / cycles_per_tick))
+        {
+            return RV32I_EVENT_NEVER;
+        }
+
+        return (rv32i_time_t)time * cycles_per_tick - (sys_cycles() - cycle_count);
+    }
+
+    inline bool virtual_time() {
+        return time_mode != RV32I_TIME_REAL;
+    }
+
+    // mtimecmp is unsigned (as is mtime, though never large enough for it to matter)
+    inline uint64_t get_mtimecmp() {
+        return (uint64_t)mtimecmp;
+    }
+
+    // Schedule an interrupt event source to be processed at, or
+    // beyond, the given cycle count
+    inline void schedule_event(const int event, const rv32i_time_t cycle)
+    {
+        event_cycle[event] = cycle;
+
+        if (cycle < next_event_cycle)
+        {
+            next_event_cycle = cycle;
+        }
+    }
+
+    inline bool event_due(const int event) {
+        return cycle_count >= event_cycle[event];
+    }
+
+    // Recalculate the earliest scheduled event, after processed
+    // events have been rescheduled
+    inline void update_next_event()
+    {
+        next_event_cycle = RV32I_EVENT_NEVER;
+
+        for (int event = 0; event < RV32I_NUM_EVENTS; event++)
+        {
+            if (event_cycle[event] < next_event_cycle)
+            {
+                next_event_cycle = event_cycle[event];
+            }
+        }
+    }
+
     inline uint32_t get_curr_instruction()
     {
         return curr_instr;
@@ -395,70 +882,189 @@ protected:
         return access_addr;
     }
 
+    // Atomic word accesses (for the A extension), atomic with respect to all
+    // cores of this core's reservation domain, including those run on other
+    // host threads. A load reserved sets this core's reservation in its slot
+    // of the domain's table, replacing only its own, and any store (or AMO or
+    // store conditional) to the reserved granule clears it. A store conditional
+    // (returning true if made) only stores to the reserved address while the
+    // reservation is held. A core in no domain has its memory to itself, so
+    // keeps its reservation to itself, cleared by its own stores. AMOs return
+    // the word's original value. RAM is accessed with host atomic instructions,
+    // and other memory with the domain's bus lock held for the access.
+    uint32_t        load_reserved        (const uint32_t byte_addr, bool &fault);
+    bool            store_conditional    (const uint32_t byte_addr, const uint32_t data, bool &fault);
+    uint32_t        amo_word             (const uint32_t byte_addr, const int op, const uint32_t data, bool &fault);
+
+    // Clear any reservation of the granule holding a written address
+    void            rsvd_clear           (const uint32_t byte_addr);
+
+    // Leave the reservation domain, freeing this core's slot for reuse by another core
+    void            rsvd_release         (void);
+
     // ------------------------------------------------
     // Private methods
     // ------------------------------------------------
 private:
 
+    // A hart's state, for the external register accessors, which are passed its number
+    inline rv32i_hart_state& hart_state(const int hart_num)
+    {
+        assert((unsigned)hart_num < RV32I_NUM_OF_HARTS);
+
+        return state.hart[hart_num];
+    }
+
+    // Invalidate any decoded instruction cache entry, or basic block, for the word at the given address
+    inline void invalidate_dcache(const uint32_t byte_addr)
+    {
+        if (dcache != NULL)
+        {
+            rv32i_dcache_entry_t* p_dc = &dcache[(byte_addr >> 2) & dcache_mask];
+
+            if (p_dc->tag == (byte_addr & MASK_INSTR_ADDR))
+            {
+                p_dc->tag = RV32I_DCACHE_INVALID_TAG;
+            }
+        }
+
+        // Only search for blocks if the address is in a line flagged as having one
+        if (blk_filter != NULL && (blk_filter[(byte_addr >> RV32I_BLK_LINE_BITS) & blk_filter_mask] || blk_rec != NULL))
+        {
+            invalidate_blocks(byte_addr);
+        }
+    }
+
+    // Map the page holding an address in a TLB entry, if it is RAM, for a read or a write
+    bool tlb_fill                        (const uint32_t byte_addr, rv32i_tlb_entry_t* p_tlb, const bool write);
+
+    // Release the internal memory back to the host
+    void            free_int_mem         (void);
+
+    // Reserved guest address space methods
+    void            free_guest_space     (void);
+    int             protect_guest_space  (void);
+    bool            guest_page_direct    (const uint32_t page);
+
+    // Memory map stubs that faulting guest accesses are redirected to, with the accessors' arguments
+    static uint32_t guest_load_map       (const uint8_t* p_host, const int type, rv32i_cpu* p_cpu);
+    static void     guest_store_map      (uint8_t* p_host, const uint32_t data, const int type, rv32i_cpu* p_cpu);
+
+    // Memory accesses through the memory map, after alignment checking
+    uint32_t        read_mem_map         (const uint32_t byte_addr, const int type, bool &fault);
+    void            write_mem_map        (const uint32_t byte_addr, const uint32_t data, const int type, bool &fault);
+
+    // Host pointer to a directly accessible (and writable, if write) RAM page, or NULL
+    uint8_t*        direct_page          (const uint32_t byte_addr, const bool write);
+
+    // Lazy ELF loading methods (rv32i_cpu_elf.cpp)
+    int             lazy_add_segment     (const uint32_t vaddr, const uint32_t filesz, const uint32_t memsz, const uint32_t offset, const int fd);
+    void            lazy_populate        (const uint32_t byte_addr);
+    void            lazy_release         (void);
+    void            free_symbols         (void);
+
+    // Memory map methods
+    int             register_region      (const rv32i_region_t &region);
+    rv32i_region_t* find_region          (const uint32_t byte_addr);
+    bool            mmio_in_page         (const uint32_t page);
+
+    // Basic block cache methods
+    void invalidate_blocks               (const uint32_t byte_addr);
+    void flush_blocks                    (void);
+    void start_block                     (const uint32_t pc);
+    void end_block                       (void);
+    template <bool TRACE>
+    int  execute_block                   (rv32i_block_t* p_blk, uint32_t max_instr, unsigned &instr_count);
+
+    // JIT methods (rv32i_cpu_jit.cpp)
+    bool jit_alloc_code                  (const uint32_t size);
+    bool jit_protect_code                (const uint32_t offset, const uint32_t len, const bool writable);
+    void jit_free_code                   (void);
+    void jit_translate                   (rv32i_block_t* p_blk);
+    bool jit_emit_instr                  (rv32i_jit_emitter &e, const rv32i_dcache_entry_t* p_instr, const uint32_t pc);
+    int  jit_execute_block               (rv32i_block_t* p_blk, unsigned &instr_count);
+    int  jit_check_segment               (rv32i_block_t* p_blk, const uint32_t idx, const rv32i_jit_seg_t* p_seg);
+
+    // Threaded dispatch engine methods (rv32i_cpu_thr.cpp)
+    int  thr_op                          (const rv32i_dcache_entry_t* p_instr);
+    int  thr_execute_block               (rv32i_block_t* p_blk, uint32_t max_instr, unsigned &instr_count);
+
+    // Processing of due events (with the interrupts processed by the core class
+    // CORE's hook), and pacing of virtual time to the wall clock
+    template <class CORE>
+    int  process_events                  (void);
+    void pace_time                       (void);
+
+    // Single instruction fetch, decode and execute
+    template <bool TRACE>
+    int  step                            (rv32i_dcache_entry_t* p_rec);
+
     // Execution of instruction method
-    int  execute                         (rv32i_decode_t &decode, rv32i_decode_table_t*);
+    template <bool TRACE>
+    int  execute                         (rv32i_decode_t &decode, rv32i_handler_t*);
 
     // Primary instruction decode method
-    rv32i_decode_table_t* primary_decode (const opcode_t instr, rv32i_decode_t& decoded_data);
+    rv32i_handler_t* primary_decode      (const opcode_t instr, rv32i_decode_t& decoded_data);
+
+    // Flattened decode lookup generation methods
+    int  build_decode                    (void);
+    int  gen_decode                      (void);
+    int  dec_handler_idx                 (const rv32i_decode_table_t* p_entry);
+    rv32i_decode_table_t* table_decode   (const opcode_t instr, rv32i_decode_t& decoded_data);
 
     // ------------------------------------------------
     // Instruction methods
     // ------------------------------------------------
 
     // RV32I instruction methods
-    void lui                             (const p_rv32i_decode_t);
-    void auipc                           (const p_rv32i_decode_t);
-
-    void jal                             (const p_rv32i_decode_t);
-    void jalr                            (const p_rv32i_decode_t);
-
-    void beq                             (const p_rv32i_decode_t);
-    void bne                             (const p_rv32i_decode_t);
-    void blt                             (const p_rv32i_decode_t);
-    void bge                             (const p_rv32i_decode_t);
-    void bltu                            (const p_rv32i_decode_t);
-    void bgeu                            (const p_rv32i_decode_t);
-
-    void lb                              (const p_rv32i_decode_t);
-    void lh                              (const p_rv32i_decode_t);
-    void lw                              (const p_rv32i_decode_t);
-    void lbu                             (const p_rv32i_decode_t);
-    void lhu                             (const p_rv32i_decode_t);
-    void sb                              (const p_rv32i_decode_t);
-    void sh                              (const p_rv32i_decode_t);
-    void sw                              (const p_rv32i_decode_t);
-
-    void addi                            (const p_rv32i_decode_t);
-    void slti                            (const p_rv32i_decode_t);
-    void sltiu                           (const p_rv32i_decode_t);
-    void xori                            (const p_rv32i_decode_t);
-    void ori                             (const p_rv32i_decode_t);
-    void andi                            (const p_rv32i_decode_t);
-    void slli                            (const p_rv32i_decode_t);
-    void srli                            (const p_rv32i_decode_t);
-    void srai                            (const p_rv32i_decode_t);
+    template <bool TRACE> void lui       (const p_rv32i_decode_t);
+    template <bool TRACE> void auipc     (const p_rv32i_decode_t);
+
+    template <bool TRACE> void jal       (const p_rv32i_decode_t);
+    template <bool TRACE> void jalr      (const p_rv32i_decode_t);
+
+    template <bool TRACE> void beq       (const p_rv32i_decode_t);
+    template <bool TRACE> void bne       (const p_rv32i_decode_t);
+    template <bool TRACE> void blt       (const p_rv32i_decode_t);
+    template <bool TRACE> void bge       (const p_rv32i_decode_t);
+    template <bool TRACE> void bltu      (const p_rv32i_decode_t);
+    template <bool TRACE> void bgeu      (const p_rv32i_decode_t);
+
+    template <bool TRACE> void lb        (const p_rv32i_decode_t);
+    template <bool TRACE> void lh        (const p_rv32i_decode_t);
+    template <bool TRACE> void lw        (const p_rv32i_decode_t);
+    template <bool TRACE> void lbu       (const p_rv32i_decode_t);
+    template <bool TRACE> void lhu       (const p_rv32i_decode_t);
+    template <bool TRACE> void sb        (const p_rv32i_decode_t);
+    template <bool TRACE> void sh        (const p_rv32i_decode_t);
+    template <bool TRACE> void sw        (const p_rv32i_decode_t);
+
+    template <bool TRACE> void addi      (const p_rv32i_decode_t);
+    template <bool TRACE> void slti      (const p_rv32i_decode_t);
+    template <bool TRACE> void sltiu     (const p_rv32i_decode_t);
+    template <bool TRACE> void xori      (const p_rv32i_decode_t);
+    template <bool TRACE> void ori       (const p_rv32i_decode_t);
+    template <bool TRACE> void andi      (const p_rv32i_decode_t);
+    template <bool TRACE> void slli      (const p_rv32i_decode_t);
+    template <bool TRACE> void srli      (const p_rv32i_decode_t);
+    template <bool TRACE> void srai      (const p_rv32i_decode_t);
                                          
-    void addr                            (const p_rv32i_decode_t);
-    void subr                            (const p_rv32i_decode_t);
-    void sllr                            (const p_rv32i_decode_t);
-    void sltr                            (const p_rv32i_decode_t);
-    void sltur                           (const p_rv32i_decode_t);
-    void xorr                            (const p_rv32i_decode_t);
-    void srlr                            (const p_rv32i_decode_t);
-    void srar                            (const p_rv32i_decode_t);
-    void orr                             (const p_rv32i_decode_t);
-    void andr                            (const p_rv32i_decode_t);
-
-    void fence                           (const p_rv32i_decode_t);
+    template <bool TRACE> void addr      (const p_rv32i_decode_t);
+    template <bool TRACE> void subr      (const p_rv32i_decode_t);
+    template <bool TRACE> void sllr      (const p_rv32i_decode_t);
+    template <bool TRACE> void sltr      (const p_rv32i_decode_t);
+    template <bool TRACE> void sltur     (const p_rv32i_decode_t);
+    template <bool TRACE> void xorr      (const p_rv32i_decode_t);
+    template <bool TRACE> void srlr      (const p_rv32i_decode_t);
+    template <bool TRACE> void srar      (const p_rv32i_decode_t);
+    template <bool TRACE> void orr       (const p_rv32i_decode_t);
+    template <bool TRACE> void andr      (const p_rv32i_decode_t);
+
+    template <bool TRACE> void fence     (const p_rv32i_decode_t);
 
     // RV32I virtual system instructions
-    void ecall                           (const p_rv32i_decode_t);
-    void ebreak                          (const p_rv32i_decode_t);
+    template <bool TRACE> void ecall     (const p_rv32i_decode_t);
+    template <bool TRACE> void ebreak    (const p_rv32i_decode_t);
 };
 
 #endif
@@ -30,149 +30,1223 @@
 
 #include <cstdio>
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#if defined (_WIN32) || defined (_WIN64)
+# include <cstdlib>
+#else
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
 
 #include "rv32i_cpu_elf.h"
 #include "rv32i_cpu.h"
 
+// Zeros used for uninitialised data (BSS)
+static const uint8_t elf_zeros[RV32I_TLB_PAGE_SIZE] = {0};
+
+// Maximum number of entry formats in a DWARF 5 line table header
+#define ELF_MAX_LINE_FORMATS 16
+
+// Flags of a symbol's name offset whilst sorting, ordering functions ahead
+// of untyped labels, and global symbols ahead of local
+#define ELF_SYM_LABEL        0x80000000
+#define ELF_SYM_LOCAL        0x40000000
+#define ELF_SYM_FLAGS        (ELF_SYM_LABEL | ELF_SYM_LOCAL)
+
+// Symbol and line tables, and their string pool, whilst being built
+typedef struct {
+    rv32i_symbol_t* syms;
+    uint32_t        num_syms;
+    uint32_t        syms_cap;
+    rv32i_line_t*   lines;
+    uint32_t        num_lines;
+    uint32_t        lines_cap;
+    char*           pool;
+    uint32_t        pool_size;
+    uint32_t        pool_cap;
+} elf_tables_t;
+
+// Sections of the file referenced from the line table
+typedef struct {
+    const uint8_t*  p_str;
+    uint32_t        str_size;
+    const uint8_t*  p_line_str;
+    uint32_t        line_str_size;
+} elf_debug_strs_t;
+
+// ----------------------------------
+// elf_map()
+//
+// Map the contents of file filename
+// read only into host memory, returning
+// its size in size (or NULL on error)
+//
+static const uint8_t* elf_map (const char* const filename, size_t &size)
+{
+#if defined (_WIN32) || defined (_WIN64)
+    FILE*    fp;
+    uint8_t* p_file = NULL;
+
+    // Read the whole file in one operation
+    if ((fp = fopen(filename, "rb")) != NULL)
+    {
+        if (fseek(fp, 0, SEEK_END) == 0 && (long)(size = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0 &&
+            (p_file = (uint8_t*)malloc(size)) != NULL && fread(p_file, 1, size, fp) != size)
+        {
+            free(p_file);
+            p_file = NULL;
+        }
+        fclose(fp);
+    }
+
+    return p_file;
+#else
+    struct stat st;
+    void*       p_file = MAP_FAILED;
+    int         fd;
+
+    if ((fd = open(filename, O_RDONLY)) >= 0)
+    {
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            size   = (size_t)st.st_size;
+            p_file = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+
+        // The mapping remains valid once the file is closed
+        close(fd);
+    }
+
+    return (p_file == MAP_FAILED) ? NULL : (const uint8_t*)p_file;
+#endif
+}
+
+// ----------------------------------
+// elf_unmap()
+//
+// Release a file mapped by elf_map()
+//
+static void elf_unmap (const uint8_t* p_file, const size_t size)
+{
+#if defined (_WIN32) || defined (_WIN64)
+    free((void*)p_file);
+#else
+    munmap((void*)p_file, size);
+#endif
+}
+
 // ----------------------------------
 // read_elf()
 //
 // Read ELF formatted executable from
-// filename, and load to memory
+// filename, and load to memory. Each
+// loadable segment is copied as a
+// block, with its uninitialised data
+// (BSS) zeroed. The reset vector is
+// set to the executable's entry point,
+// which is also returned in p_entry,
+// if not NULL. If lazy, the segments
+// are only registered, and each page
+// populated on first access.
 //
-int rv32i_cpu::read_elf (const char * const filename)
+int rv32i_cpu::read_elf (const char * const filename, uint32_t* p_entry, const bool lazy)
 {
-    unsigned    i;
-    int         c;
-    uint32_t    pcount, bytecount = 0;
-    uint32_t    word;
-    pElf32_Ehdr h;
-    pElf32_Phdr h2[ELF_MAX_NUM_PHDR];
-    char        buf[sizeof(Elf32_Ehdr)];
-    char        buf2[sizeof(Elf32_Phdr)*ELF_MAX_NUM_PHDR];
-    const char* ptr;
-    FILE*       elf_fp;
-    bool        access_fault = false;
+    const uint8_t* p_file;
+    size_t         size;
+    pElf32_Ehdr    h;
+    pElf32_Phdr    h2;
+    int            error = 0;
+    int            fd    = -1;
 
+    // Discard any pages still pending from a previous lazy load
+    lazy_release();
 
-    // Open program file ready for loading
-    if ((elf_fp = fopen(filename, "rb")) == NULL)
+    // Map program file ready for loading
+    if ((p_file = elf_map(filename, size)) == NULL)
     {
         fprintf(stderr, "*** ReadElf(): Unable to open file %s for reading\n", filename); //LCOV_EXCL_LINE
         return USER_ERROR;                                                           //LCOV_EXCL_LINE
     }
 
-    // Read elf header
-    h = (pElf32_Ehdr) buf;
-    for (i = 0; i < sizeof(Elf32_Ehdr); i++)
+    h = (pElf32_Ehdr)p_file;
+
+    //LCOV_EXCL_START
+    // Check some things
+    if (size < sizeof(Elf32_Ehdr) || memcmp(h->e_ident, ELF_IDENT, 4))
+    {
+        fprintf(stderr, "*** ReadElf(): not an ELF file\n");
+        error = USER_ERROR;
+    }
+    else if (h->e_ident[EI_CLASS] != ELFCLASS32 || h->e_ident[EI_DATA] != ELFDATA2LSB)
+    {
+        fprintf(stderr, "*** ReadElf(): not a 32 bit little endian ELF file\n");
+        error = USER_ERROR;
+    }
+    else if (h->e_type != ET_EXEC)
+    {
+        fprintf(stderr, "*** ReadElf(): not an executable ELF file\n");
+        error = USER_ERROR;
+    }
+    else if (h->e_machine != EM_RISCV)
+    {
+        fprintf(stderr, "*** ReadElf(): not a RISC-V ELF file (e_machine=0x%03x)\n", h->e_machine);
+        error = USER_ERROR;
+    }
+    else if (h->e_phnum && (h->e_phentsize != sizeof(Elf32_Phdr) ||
+             (uint64_t)h->e_phoff + (uint64_t)h->e_phnum * sizeof(Elf32_Phdr) > size))
+    {
+        fprintf(stderr, "*** ReadElf(): program headers outside of file\n");
+        error = USER_ERROR;
+    }
+    //LCOV_EXCL_STOP
+
+#if !(defined (_WIN32) || defined (_WIN64))
+    // Whole pages of file data are mapped directly from the file when loading lazily
+    if (!error && lazy)
+    {
+        fd = open(filename, O_RDONLY);
+    }
+#endif
+
+    // Load text/data segments
+    for (unsigned pcount = 0; !error && pcount < h->e_phnum; pcount++)
+    {
+        h2 = (pElf32_Phdr)(p_file + h->e_phoff) + pcount;
+
+        if (h2->p_type != PT_LOAD)
+        {
+            continue;
+        }
+
+        // Check the segment is within the file, and fits in memory
+        if ((uint64_t)h2->p_offset + h2->p_filesz > size || h2->p_filesz > h2->p_memsz)
+        {
+            fprintf(stderr, "*** ReadElf(): segment data outside of file\n");                //LCOV_EXCL_LINE
+            error = USER_ERROR;                                                          //LCOV_EXCL_LINE
+        }
+        else if ((uint64_t)h2->p_vaddr + h2->p_memsz > (1ULL << 32))
+        {
+            fprintf(stderr, "*** ReadElf(): segment memory footprint outside of memory range\n"); //LCOV_EXCL_LINE
+            error = USER_ERROR;                                                               //LCOV_EXCL_LINE
+        }
+        else if (lazy)
+        {
+            if (lazy_add_segment(h2->p_vaddr, h2->p_filesz, h2->p_memsz, h2->p_offset, fd))
+            {
+                fprintf(stderr, "*** ReadElf(): too many segments to load lazily\n");  //LCOV_EXCL_LINE
+                error = USER_ERROR;                                                 //LCOV_EXCL_LINE
+            }
+        }
+        else
+        {
+            // Copy the file's data, and zero the remainder of the segment
+            bool fault = write_block(h2->p_vaddr, p_file + h2->p_offset, h2->p_filesz, true) != 0;
+
+            for (uint64_t offset = h2->p_filesz; !fault && offset < h2->p_memsz; offset += RV32I_TLB_PAGE_SIZE)
+            {
+                uint32_t len = (h2->p_memsz - offset < RV32I_TLB_PAGE_SIZE) ? (uint32_t)(h2->p_memsz - offset) : RV32I_TLB_PAGE_SIZE;
+
+                fault = write_block(h2->p_vaddr + (uint32_t)offset, elf_zeros, len, true) != 0;
+            }
+
+            if (fault)
+            {
+                fprintf(stderr, "*** ReadElf(): memory access fault loading program\n");
+                error = USER_ERROR;
+            }
+        }
+    }
+
+#if !(defined (_WIN32) || defined (_WIN64))
+    if (fd >= 0)
     {
-        buf[i] = fgetc(elf_fp);
-        bytecount++;
-        if (buf[i] == EOF) 
+        close(fd);
+    }
+#endif
+
+    if (lazy)
+    {
+        // Memory has changed underneath any cached decodes and translations
+        flush_tlb();
+        flush_dcache();
+        flush_blocks();
+
+        // The file is kept for populating pages until none are left pending
+        if (!error && lazy_pending)
         {
-            fprintf(stderr, "*** ReadElf(): unexpected EOF\n");                           //LCOV_EXCL_LINE
-           return USER_ERROR;                                                       //LCOV_EXCL_LINE
-        } 
+            lazy_file = p_file;
+            lazy_size = size;
+            p_file    = NULL;
+        }
+        else
+        {
+            lazy_release();
+        }
     }
 
-    //LCOV_EXCL_START
-    // Check some things
-    ptr= ELF_IDENT;
-    for (i = 0; i < 4; i++) 
+    // Start execution from the entry point
+    if (!error)
     {
-        if (h->e_ident[i] != ptr[i])
+        reset_vector             = h->e_entry;
+        state.hart[curr_hart].pc = reset_vector;
+
+        if (p_entry != NULL)
         {
-            fprintf(stderr, "*** ReadElf(): not an ELF file\n");
-            return USER_ERROR;
+            *p_entry = h->e_entry;
         }
     }
 
-    if (h->e_type != ET_EXEC)
+    if (p_file != NULL)
     {
-        fprintf(stderr, "*** ReadElf(): not an executable ELF file\n");
-        return USER_ERROR;
+        elf_unmap(p_file, size);
     }
 
-    if (h->e_machine != EM_RISCV)
+    return error;
+}
+
+// ----------------------------------
+// lazy_add_segment()
+//
+// Register a loadable segment for
+// lazy loading, marking all its pages
+// pending. Where fd is valid, pages
+// wholly of file data in flat RAM are
+// mapped copy-on-write from the file
+// instead.
+//
+int rv32i_cpu::lazy_add_segment (const uint32_t vaddr, const uint32_t filesz, const uint32_t memsz, const uint32_t offset, const int fd)
+{
+    if (memsz == 0)
     {
-        fprintf(stderr, "*** ReadElf(): not a RISC-V ELF file (e_machine=0x%03x)\n", h->e_machine);
-        return USER_ERROR;
+        return 0;
     }
 
-    if (h->e_phnum > ELF_MAX_NUM_PHDR)
+    if (lazy_num_segs == RV32I_MAX_LAZY_SEGS)
     {
-        fprintf(stderr, "*** ReadElf(): Number of Phdr (%d) exceeds maximum supported (%d)\n", h->e_phnum, ELF_MAX_NUM_PHDR);
-        return USER_ERROR;
+        return 1;
     }
-    //LCOV_EXCL_STOP
 
-    // Read program headers
-    for (pcount=0 ; pcount < h->e_phnum; pcount++)
+    rv32i_lazy_seg_t* p_seg = &lazy_segs[lazy_num_segs++];
+    uint32_t          first = vaddr & ~RV32I_TLB_PAGE_MASK;
+
+    p_seg->vaddr     = vaddr;
+    p_seg->filesz    = filesz;
+    p_seg->memsz     = memsz;
+    p_seg->offset    = offset;
+    p_seg->num_pages = (uint32_t)((((uint64_t)vaddr + memsz - 1) >> RV32I_TLB_PAGE_BITS) - (first >> RV32I_TLB_PAGE_BITS) + 1);
+    p_seg->p_pending = new uint8_t[(p_seg->num_pages + 7) / 8];
+
+    memset(p_seg->p_pending, 0, (p_seg->num_pages + 7) / 8);
+
+    for (uint32_t idx = 0; idx < p_seg->num_pages; idx++)
+    {
+        uint32_t page   = first + (idx << RV32I_TLB_PAGE_BITS);
+        uint8_t* p_host = NULL;
+
+        // Find the host page if this is flat RAM, without going through any callbacks
+#ifdef RV32I_GUEST_SPACE_SUPPORTED
+        if (guest_mem != NULL)
+        {
+            p_host = guest_page_direct(page) ? guest_mem + page : NULL;
+        }
+        else
+#endif
+        if (p_mem_callback == NULL && p_page_callback == NULL && page - int_mem_base < int_mem_size &&
+            find_region(page) == NULL && !mmio_in_page(page))
+        {
+            p_host = int_mem + (page - int_mem_base);
+        }
+
+#if !(defined (_WIN32) || defined (_WIN64))
+        // Pages wholly of file data, at a page aligned file offset, are mapped from the file
+        if (fd >= 0 && p_host != NULL && page >= vaddr && (uint64_t)page + RV32I_TLB_PAGE_SIZE <= (uint64_t)vaddr + filesz &&
+            ((offset + (page - vaddr)) & RV32I_TLB_PAGE_MASK) == 0 &&
+            mmap(p_host, RV32I_TLB_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, offset + (page - vaddr)) != MAP_FAILED)
+        {
+            continue;
+        }
+#endif
+
+        p_seg->p_pending[idx >> 3] |= 1 << (idx & 7);
+        lazy_pending++;
+
+#ifdef RV32I_GUEST_SPACE_SUPPORTED
+        // Pending guest space pages fault, so the fast path populates them on a miss
+        if (guest_mem != NULL && p_host != NULL)
+        {
+            mprotect(p_host, RV32I_TLB_PAGE_SIZE, PROT_NONE);
+        }
+#endif
+    }
+
+    return 0;
+}
+
+// ----------------------------------
+// lazy_populate()
+//
+// Populate the page holding byte_addr
+// from each lazily loaded segment it
+// is still pending for
+//
+void rv32i_cpu::lazy_populate (const uint32_t byte_addr)
+{
+    rv32i_lazy_seg_t* p_segs[RV32I_MAX_LAZY_SEGS];
+    uint32_t          num_segs = 0;
+    uint32_t          page     = byte_addr & ~RV32I_TLB_PAGE_MASK;
+
+    // Clear the pending bits first, as populating accesses the page again
+    for (uint32_t seg = 0; seg < lazy_num_segs; seg++)
+    {
+        rv32i_lazy_seg_t* p_seg = &lazy_segs[seg];
+        uint32_t          idx   = (page >> RV32I_TLB_PAGE_BITS) - (p_seg->vaddr >> RV32I_TLB_PAGE_BITS);
+
+        if (idx < p_seg->num_pages && ((p_seg->p_pending[idx >> 3] >> (idx & 7)) & 1))
+        {
+            p_seg->p_pending[idx >> 3] &= ~(1 << (idx & 7));
+            p_segs[num_segs++] = p_seg;
+            lazy_pending--;
+        }
+    }
+
+    if (num_segs == 0)
+    {
+        return;
+    }
+
+#ifdef RV32I_GUEST_SPACE_SUPPORTED
+    if (guest_mem != NULL && guest_page_direct(page))
+    {
+        mprotect(guest_mem + page, RV32I_TLB_PAGE_SIZE, PROT_READ | PROT_WRITE);
+    }
+#endif
+
+    for (uint32_t seg = 0; seg < num_segs; seg++)
+    {
+        rv32i_lazy_seg_t* p_seg    = p_segs[seg];
+        uint64_t          start    = (page > p_seg->vaddr) ? page : p_seg->vaddr;
+        uint64_t          end      = (uint64_t)p_seg->vaddr + p_seg->memsz;
+        uint64_t          file_end = (uint64_t)p_seg->vaddr + p_seg->filesz;
+
+        if (end > (uint64_t)page + RV32I_TLB_PAGE_SIZE)
+        {
+            end = (uint64_t)page + RV32I_TLB_PAGE_SIZE;
+        }
+
+        // Copy the file's data, and zero the remainder of the segment
+        if (start < file_end)
+        {
+            uint64_t len = ((file_end < end) ? file_end : end) - start;
+            write_block((uint32_t)start, lazy_file + p_seg->offset + (start - p_seg->vaddr), (uint32_t)len, true);
+            start += len;
+        }
+
+        if (start < end)
+        {
+            write_block((uint32_t)start, elf_zeros, (uint32_t)(end - start), true);
+        }
+    }
+
+    if (lazy_pending == 0)
     {
-        for (i = 0; i < sizeof(Elf32_Phdr); i++)
+        lazy_release();
+    }
+}
+
+// ----------------------------------
+// lazy_release()
+//
+// Discard the state of a lazy load,
+// along with any pages not yet
+// populated
+//
+void rv32i_cpu::lazy_release (void)
+{
+    for (uint32_t seg = 0; seg < lazy_num_segs; seg++)
+    {
+#ifdef RV32I_GUEST_SPACE_SUPPORTED
+        // Make pending guest space pages accessible again
+        for (uint32_t idx = 0; guest_mem != NULL && idx < lazy_segs[seg].num_pages; idx++)
         {
-            c = fgetc(elf_fp);
-            if (c == EOF)
+            uint32_t page = (lazy_segs[seg].vaddr & ~RV32I_TLB_PAGE_MASK) + (idx << RV32I_TLB_PAGE_BITS);
+
+            if (((lazy_segs[seg].p_pending[idx >> 3] >> (idx & 7)) & 1) && guest_page_direct(page))
             {
-                fprintf(stderr, "*** ReadElf(): unexpected EOF\n");                         //LCOV_EXCL_LINE
-                return USER_ERROR;                                                     //LCOV_EXCL_LINE
-            } 
-            buf2[i+(pcount * sizeof(Elf32_Phdr))] = c;
-            bytecount++;
+                mprotect(guest_mem + page, RV32I_TLB_PAGE_SIZE, PROT_READ | PROT_WRITE);
+            }
         }
+#endif
+        delete [] lazy_segs[seg].p_pending;
     }
 
-    // Load text/data segments
-    for (pcount=0 ; pcount < h->e_phnum; pcount++)
+    if (lazy_file != NULL)
+    {
+        elf_unmap(lazy_file, lazy_size);
+    }
+
+    lazy_file     = NULL;
+    lazy_size     = 0;
+    lazy_num_segs = 0;
+    lazy_pending  = 0;
+}
+
+// ----------------------------------
+// elf_grow()
+//
+// Ensure the array at *pp_buf, of
+// cap elements of elem_size bytes,
+// has room for needed elements,
+// returning false if it can't
+//
+static bool elf_grow (void** pp_buf, uint32_t &cap, const uint64_t needed, const size_t elem_size)
+{
+    if (needed > cap)
+    {
+        uint64_t new_cap = cap ? cap : 256;
+        void*    p_new;
+
+        while (new_cap < needed)
+        {
+            new_cap *= 2;
+        }
+
+        if (new_cap > 0xffffffffULL || (p_new = realloc(*pp_buf, (size_t)new_cap * elem_size)) == NULL)
+        {
+            return false;
+        }
+
+        *pp_buf = p_new;
+        cap     = (uint32_t)new_cap;
+    }
+
+    return true;
+}
+
+// ----------------------------------
+// elf_pool_add()
+//
+// Add string name to the tables'
+// pool, prefixed with directory dir
+// if not NULL and name is relative.
+// Returns the string's pool offset,
+// or ~0 if the pool can't grow.
+//
+static uint32_t elf_pool_add (elf_tables_t &t, const char* dir, const char* name)
+{
+    size_t   dir_len  = (dir != NULL && *dir != '\0' && name[0] != '/' && name[1] != ':') ? strlen(dir) : 0;
+    size_t   name_len = strlen(name);
+    uint32_t offset   = t.pool_size;
+
+    if (!elf_grow((void**)&t.pool, t.pool_cap, (uint64_t)t.pool_size + dir_len + name_len + 2, 1))
+    {
+        return ~0U;
+    }
+
+    if (dir_len)
+    {
+        memcpy(t.pool + t.pool_size, dir, dir_len);
+        t.pool[t.pool_size + dir_len] = '/';
+        t.pool_size += (uint32_t)dir_len + 1;
+    }
+
+    memcpy(t.pool + t.pool_size, name, name_len + 1);
+    t.pool_size += (uint32_t)name_len + 1;
+
+    return offset;
+}
+
+// ----------------------------------
+// DWARF field readers. Each advances
+// p, stopping at end if the data
+// would overrun it.
+//
+static uint64_t elf_fixed (const uint8_t* &p, const uint8_t* end, const unsigned bytes)
+{
+    uint64_t val = 0;
+
+    if ((size_t)(end - p) < bytes)
+    {
+        p = end;
+        return 0;
+    }
+
+    for (unsigned idx = 0; idx < bytes && idx < 8; idx++)
+    {
+        val |= (uint64_t)p[idx] << (8*idx);
+    }
+
+    p += bytes;
+
+    return val;
+}
+
+static uint64_t elf_uleb (const uint8_t* &p, const uint8_t* end)
+{
+    uint64_t val   = 0;
+    unsigned shift = 0;
+
+    while (p < end)
+    {
+        uint8_t byte = *p++;
+
+        if (shift < 64)
+        {
+            val |= (uint64_t)(byte & 0x7f) << shift;
+        }
+        shift += 7;
+
+        if (!(byte & 0x80))
+        {
+            break;
+        }
+    }
+
+    return val;
+}
+
+static int64_t elf_sleb (const uint8_t* &p, const uint8_t* end)
+{
+    uint64_t val   = 0;
+    unsigned shift = 0;
+    uint8_t  byte  = 0;
+
+    while (p < end)
+    {
+        byte = *p++;
+
+        if (shift < 64)
+        {
+            val |= (uint64_t)(byte & 0x7f) << shift;
+        }
+        shift += 7;
+
+        if (!(byte & 0x80))
+        {
+            break;
+        }
+    }
+
+    if (shift < 64 && (byte & 0x40))
+    {
+        val |= ~0ULL << shift;
+    }
+
+    return (int64_t)val;
+}
+
+// Returns the NUL terminated string at p, or NULL if not terminated before end
+static const char* elf_string (const uint8_t* &p, const uint8_t* end)
+{
+    const uint8_t* p_nul = (const uint8_t*)memchr(p, 0, end - p);
+    const char*    str   = (const char*)p;
+
+    if (p_nul == NULL)
+    {
+        p = end;
+        return NULL;
+    }
+
+    p = p_nul + 1;
+
+    return str;
+}
+
+// Returns the string at offset within a string section, or NULL if outside it
+static const char* elf_string_at (const uint8_t* p_sect, const uint32_t size, const uint64_t offset)
+{
+    const uint8_t* p = p_sect + offset;
+
+    return (p_sect != NULL && offset < size) ? elf_string(p, p_sect + size) : NULL;
+}
+
+// ----------------------------------
+// elf_form()
+//
+// Read a DWARF 5 line table header
+// entry field of the given form,
+// returning a string in str, else
+// a value in val. Returns false for
+// unsupported forms.
+//
+static bool elf_form (const uint8_t* &p, const uint8_t* end, const uint64_t form, const elf_debug_strs_t &strs,
+                      const char* &str, uint64_t &val)
+{
+    str = NULL;
+    val = 0;
+
+    switch (form)
+    {
+    case DW_FORM_string:    str = elf_string(p, end);                                                  break;
+    case DW_FORM_strp:      str = elf_string_at(strs.p_str, strs.str_size, elf_fixed(p, end, 4));           break;
+    case DW_FORM_line_strp: str = elf_string_at(strs.p_line_str, strs.line_str_size, elf_fixed(p, end, 4)); break;
+    case DW_FORM_data1:     val = elf_fixed(p, end, 1);                                                break;
+    case DW_FORM_data2:     val = elf_fixed(p, end, 2);                                                break;
+    case DW_FORM_data4:     val = elf_fixed(p, end, 4);                                                break;
+    case DW_FORM_data8:     val = elf_fixed(p, end, 8);                                                break;
+    case DW_FORM_data16:    elf_fixed(p, end, 16);                                                     break;
+    case DW_FORM_udata:     val = elf_uleb(p, end);                                                    break;
+    case DW_FORM_sdata:     val = (uint64_t)elf_sleb(p, end);                                          break;
+    case DW_FORM_block:     val = elf_uleb(p, end); p += ((uint64_t)(end - p) < val) ? (end - p) : val; break;
+    default:                return false;
+    }
+
+    return true;
+}
+
+// ----------------------------------
+// elf_line_unit()
+//
+// Run the DWARF (versions 2 to 5)
+// line number program of the unit
+// between p and end, adding its rows
+// to the line table. A unit that
+// can't be parsed is ignored from
+// that point. Returns non-zero if
+// the tables can't grow.
+//
+static int elf_line_unit (elf_tables_t &t, const uint8_t* p, const uint8_t* end, const elf_debug_strs_t &strs)
+{
+    const char** dirs      = NULL;
+    uint32_t*    files     = NULL;
+    uint32_t     dirs_cap  = 0;
+    uint32_t     files_cap = 0;
+    uint32_t     num_dirs  = 0;
+    uint32_t     num_files = 0;
+    bool         ok        = true;
+    int          error     = 0;
+
+    uint32_t version = (uint32_t)elf_fixed(p, end, 2);
+
+    if (version < 2 || version > 5)
+    {
+        return 0;
+    }
+
+    if (version == 5)
+    {
+        // Address and segment selector sizes
+        elf_fixed(p, end, 2);
+    }
+
+    uint32_t       hdr_len = (uint32_t)elf_fixed(p, end, 4);
+    const uint8_t* prog    = p + hdr_len;
+
+    if (hdr_len > (uint64_t)(end - p))
+    {
+        return 0;
+    }
+
+    uint32_t       min_len     = (uint32_t)elf_fixed(p, prog, 1);
+    uint32_t       max_ops     = (version >= 4) ? (uint32_t)elf_fixed(p, prog, 1) : 1;
+    uint32_t       is_stmt     = (uint32_t)elf_fixed(p, prog, 1);
+    int32_t        line_base   = (int8_t)elf_fixed(p, prog, 1);
+    uint32_t       line_range  = (uint32_t)elf_fixed(p, prog, 1);
+    uint32_t       opcode_base = (uint32_t)elf_fixed(p, prog, 1);
+    const uint8_t* std_lens    = p;
+
+    (void)is_stmt;
+
+    // VLIW operation indices are not supported
+    if (line_range == 0 || opcode_base == 0 || max_ops != 1 || (uint64_t)(prog - p) < opcode_base - 1)
+    {
+        return 0;
+    }
+
+    p += opcode_base - 1;
+
+    if (version < 5)
+    {
+        const char* str;
+
+        // Directories and files are numbered from 1, with 0 the (unknown) compilation directory
+        if (!elf_grow((void**)&dirs, dirs_cap, 1, sizeof(const char*)) || !elf_grow((void**)&files, files_cap, 1, sizeof(uint32_t)))
+        {
+            error = USER_ERROR;
+        }
+        else
+        {
+            dirs[num_dirs++]   = NULL;
+            files[num_files++] = ~0U;
+        }
+
+        while (!error && (str = elf_string(p, prog)) != NULL && *str != '\0')
+        {
+            if (!elf_grow((void**)&dirs, dirs_cap, num_dirs + 1, sizeof(const char*)))
+            {
+                error = USER_ERROR;
+            }
+            else
+            {
+                dirs[num_dirs++] = str;
+            }
+        }
+
+        while (!error && (str = elf_string(p, prog)) != NULL && *str != '\0')
+        {
+            uint64_t dir_idx = elf_uleb(p, prog);
+
+            // Modification time and length
+            elf_uleb(p, prog);
+            elf_uleb(p, prog);
+
+            if (!elf_grow((void**)&files, files_cap, num_files + 1, sizeof(uint32_t)) ||
+                (files[num_files++] = elf_pool_add(t, (dir_idx < num_dirs) ? dirs[dir_idx] : NULL, str)) == ~0U)
+            {
+                error = USER_ERROR;
+            }
+        }
+    }
+    else
+    {
+        // Directory, then file name, entries, each described by pairs of content type and form
+        for (int table = 0; ok && !error && table < 2; table++)
+        {
+            uint64_t formats[ELF_MAX_LINE_FORMATS][2];
+            uint32_t num_formats = (uint32_t)elf_fixed(p, prog, 1);
+
+            if (num_formats > ELF_MAX_LINE_FORMATS)
+            {
+                ok = false;
+                break;
+            }
+
+            for (uint32_t fmt = 0; fmt < num_formats; fmt++)
+            {
+                formats[fmt][0] = elf_uleb(p, prog);
+                formats[fmt][1] = elf_uleb(p, prog);
+            }
+
+            uint64_t count = elf_uleb(p, prog);
+
+            for (uint64_t entry = 0; ok && !error && entry < count; entry++)
+            {
+                const char* path    = NULL;
+                uint64_t    dir_idx = 0;
+
+                for (uint32_t fmt = 0; ok && fmt < num_formats; fmt++)
+                {
+                    const char* str;
+                    uint64_t    val;
+
+                    ok = elf_form(p, prog, formats[fmt][1], strs, str, val);
+
+                    if (formats[fmt][0] == DW_LNCT_path)
+                    {
+                        path = str;
+                    }
+                    else if (formats[fmt][0] == DW_LNCT_directory_index)
+                    {
+                        dir_idx = val;
+                    }
+                }
+
+                if (!ok || path == NULL)
+                {
+                    ok = false;
+                }
+                else if (table == 0)
+                {
+                    if (!elf_grow((void**)&dirs, dirs_cap, num_dirs + 1, sizeof(const char*)))
+                    {
+                        error = USER_ERROR;
+                    }
+                    else
+                    {
+                        dirs[num_dirs++] = path;
+                    }
+                }
+                else if (!elf_grow((void**)&files, files_cap, num_files + 1, sizeof(uint32_t)) ||
+                         (files[num_files++] = elf_pool_add(t, (dir_idx < num_dirs) ? dirs[dir_idx] : NULL, path)) == ~0U)
+                {
+                    error = USER_ERROR;
+                }
+            }
+        }
+    }
+
+    // Run the line number program from its initial state, adding a row for each emitted
+    p = prog;
+
+    uint32_t addr = 0;
+    uint32_t file = 1;
+    int64_t  line = 1;
+
+    while (ok && !error && p < end)
     {
-        h2[pcount] = (pElf32_Phdr) &buf2[pcount * sizeof(Elf32_Phdr)];
+        uint32_t op   = *p++;
+        bool     emit = false;
+        bool     eos  = false;
 
-        // Gobble bytes until section start
-        for (; bytecount < h2[pcount]->p_offset; bytecount++)
+        if (op >= opcode_base)
         {
-            c = fgetc(elf_fp);
-            if (c == EOF) {
-                fprintf(stderr, "*** ReadElf(): unexpected EOF\n");                         //LCOV_EXCL_LINE
-                return USER_ERROR;                                                      //LCOV_EXCL_LINE
+            uint32_t adj = op - opcode_base;
+
+            addr += (adj / line_range) * min_len;
+            line += line_base + (int32_t)(adj % line_range);
+            emit  = true;
+        }
+        else if (op == 0)
+        {
+            // Extended opcode, with its length
+            uint64_t       len     = elf_uleb(p, end);
+            const uint8_t* ext_end = p + len;
+
+            if (len == 0 || len > (uint64_t)(end - p))
+            {
+                ok = false;
+                break;
+            }
+
+            switch (*p++)
+            {
+            case DW_LNE_end_sequence: emit = eos = true;                                  break;
+            case DW_LNE_set_address:  addr = (uint32_t)elf_fixed(p, ext_end, (unsigned)(len - 1)); break;
+            default:                                                                      break;
+            }
+
+            p = ext_end;
+        }
+        else
+        {
+            switch (op)
+            {
+            case DW_LNS_copy:             emit = true;                                              break;
+            case DW_LNS_advance_pc:       addr += (uint32_t)elf_uleb(p, end) * min_len;             break;
+            case DW_LNS_advance_line:     line += elf_sleb(p, end);                                 break;
+            case DW_LNS_set_file:         file  = (uint32_t)elf_uleb(p, end);                       break;
+            case DW_LNS_const_add_pc:     addr += ((255 - opcode_base) / line_range) * min_len;     break;
+            case DW_LNS_fixed_advance_pc: addr += (uint32_t)elf_fixed(p, end, 2);                   break;
+            default:
+                // Skip the operands of any other standard opcode
+                for (uint32_t arg = 0; arg < std_lens[op - 1]; arg++)
+                {
+                    elf_uleb(p, end);
+                }
+                break;
+            }
+        }
+
+        // Rows with an unknown file (or line) are dropped
+        if (emit && (eos || (file < num_files && files[file] != ~0U && line > 0 && line <= 0xffffffffLL)))
+        {
+            if (!elf_grow((void**)&t.lines, t.lines_cap, (uint64_t)t.num_lines + 1, sizeof(rv32i_line_t)))
+            {
+                error = USER_ERROR;
+            }
+            else
+            {
+                t.lines[t.num_lines].addr = addr;
+                t.lines[t.num_lines].line = eos ? 0 : (uint32_t)line;
+                t.lines[t.num_lines].file = eos ? 0 : files[file];
+                t.num_lines++;
             }
         }
 
-        // Check we can load the segment to memory
-        if ((h2[pcount]->p_vaddr + h2[pcount]->p_memsz) >= (1U << MEM_SIZE_BITS))
+        if (eos)
+        {
+            addr = 0;
+            file = 1;
+            line = 1;
+        }
+    }
+
+    free(dirs);
+    free(files);
+
+    return error;
+}
+
+// ----------------------------------
+// read_elf_symbols()
+//
+// Read the symbol table and DWARF
+// line table of ELF executable
+// filename into sorted tables for
+// lookup by address. Either table
+// may be empty if the file has no
+// such section.
+//
+int rv32i_cpu::read_elf_symbols (const char* const filename)
+{
+    const uint8_t*   p_file;
+    size_t           size;
+    pElf32_Ehdr      h;
+    pElf32_Shdr      sh;
+    elf_tables_t     t;
+    elf_debug_strs_t strs;
+    int              error = 0;
+
+    free_symbols();
+
+    memset(&t, 0, sizeof(t));
+    memset(&strs, 0, sizeof(strs));
+
+    if ((p_file = elf_map(filename, size)) == NULL)
+    {
+        fprintf(stderr, "*** ReadElfSymbols(): Unable to open file %s for reading\n", filename); //LCOV_EXCL_LINE
+        return USER_ERROR;                                                                   //LCOV_EXCL_LINE
+    }
+
+    h  = (pElf32_Ehdr)p_file;
+    sh = (pElf32_Shdr)(p_file + h->e_shoff);
+
+    //LCOV_EXCL_START
+    if (size < sizeof(Elf32_Ehdr) || memcmp(h->e_ident, ELF_IDENT, 4) ||
+        h->e_ident[EI_CLASS] != ELFCLASS32 || h->e_ident[EI_DATA] != ELFDATA2LSB)
+    {
+        fprintf(stderr, "*** ReadElfSymbols(): not a 32 bit little endian ELF file\n");
+        error = USER_ERROR;
+    }
+    else if (h->e_shnum && (h->e_shentsize != sizeof(Elf32_Shdr) || h->e_shstrndx >= h->e_shnum ||
+             (uint64_t)h->e_shoff + (uint64_t)h->e_shnum * sizeof(Elf32_Shdr) > size))
+    {
+        fprintf(stderr, "*** ReadElfSymbols(): section headers outside of file\n");
+        error = USER_ERROR;
+    }
+    //LCOV_EXCL_STOP
+
+    // Locate the sections, ignoring any not wholly within the file
+    const Elf32_Shdr* p_symtab    = NULL;
+    const Elf32_Shdr* p_debug_line = NULL;
+
+    for (unsigned idx = 0; !error && idx < h->e_shnum; idx++)
+    {
+        const Elf32_Shdr* p_shstr = &sh[h->e_shstrndx];
+        const char*       name;
+
+        if ((uint64_t)sh[idx].sh_offset + sh[idx].sh_size > size || (uint64_t)p_shstr->sh_offset + p_shstr->sh_size > size)
         {
-            fprintf(stderr, "*** ReadElf(): segment memory footprint outside of internal memory range\n"); //LCOV_EXCL_LINE
-            return USER_ERROR;                                                                        //LCOV_EXCL_LINE
+            continue;
         }
 
-        // For p_filesz bytes ...
-        i = (bytecount - h2[pcount]->p_offset);
-        word = 0;
-        for (; bytecount < h2[pcount]->p_offset + h2[pcount]->p_filesz; bytecount++)
+        if (sh[idx].sh_type == SHT_SYMTAB && sh[idx].sh_link < h->e_shnum && p_symtab == NULL)
         {
-            if ((c = fgetc(elf_fp)) == EOF)
+            p_symtab = &sh[idx];
+        }
+        else if ((name = elf_string_at(p_file + p_shstr->sh_offset, p_shstr->sh_size, sh[idx].sh_name)) != NULL)
+        {
+            if (!strcmp(name, ".debug_line"))
+            {
+                p_debug_line = &sh[idx];
+            }
+            else if (!strcmp(name, ".debug_str"))
             {
-                fprintf(stderr, "*** ReadElf(): unexpected EOF\n");                          //LCOV_EXCL_LINE
-                return USER_ERROR;                                                      //LCOV_EXCL_LINE
+                strs.p_str    = p_file + sh[idx].sh_offset;
+                strs.str_size = sh[idx].sh_size;
             }
+            else if (!strcmp(name, ".debug_line_str"))
+            {
+                strs.p_line_str    = p_file + sh[idx].sh_offset;
+                strs.line_str_size = sh[idx].sh_size;
+            }
+        }
+    }
 
-            // Little endian
-            word |= (c << ((bytecount & 3) * 8));
+    // Symbols of code (functions, and untyped labels), keeping the names from the string table at
+    // the start of the pool, so their offsets are unchanged. The offsets are flagged whilst sorting.
+    if (!error && p_symtab != NULL && sh[p_symtab->sh_link].sh_size < ELF_SYM_LOCAL &&
+        (uint64_t)sh[p_symtab->sh_link].sh_offset + sh[p_symtab->sh_link].sh_size <= size)
+    {
+        const Elf32_Shdr* p_strtab = &sh[p_symtab->sh_link];
+        const Elf32_Sym*  p_sym    = (const Elf32_Sym*)(p_file + p_symtab->sh_offset);
+        uint32_t          num      = p_symtab->sh_size / sizeof(Elf32_Sym);
 
-            if ((bytecount&3) == 3)
+        if (!elf_grow((void**)&t.pool, t.pool_cap, (uint64_t)p_strtab->sh_size + 1, 1) ||
+            !elf_grow((void**)&t.syms, t.syms_cap, num + 1, sizeof(rv32i_symbol_t)))
+        {
+            error = USER_ERROR;
+        }
+        else
+        {
+            memcpy(t.pool, p_file + p_strtab->sh_offset, p_strtab->sh_size);
+            t.pool[p_strtab->sh_size] = '\0';
+            t.pool_size               = p_strtab->sh_size + 1;
+
+            for (uint32_t idx = 0; idx < num; idx++)
             {
-                write_mem(h2[pcount]->p_vaddr + i, word, MEM_WR_ACCESS_INSTR, access_fault);
-                i+=4;
-                word = 0;
+                uint32_t    type = ELF32_ST_TYPE(p_sym[idx].st_info);
+                const char* name = t.pool + p_sym[idx].st_name;
 
-                if (access_fault)
+                if ((type == STT_FUNC || type == STT_NOTYPE) && p_sym[idx].st_name < p_strtab->sh_size &&
+                    p_sym[idx].st_shndx != SHN_UNDEF && p_sym[idx].st_shndx < SHN_LORESERVE &&
+                    name[0] != '\0' && name[0] != '$' && strncmp(name, ".L", 2))
                 {
-                    fprintf(stderr, "*** ReadElf(): memory access fault loading program\n");
-                    return USER_ERROR;
+                    t.syms[t.num_syms].addr = p_sym[idx].st_value;
+                    t.syms[t.num_syms].size = p_sym[idx].st_size;
+                    t.syms[t.num_syms].name = p_sym[idx].st_name | ((type == STT_FUNC) ? 0 : ELF_SYM_LABEL) |
+                                              ((ELF32_ST_BIND(p_sym[idx].st_info) == STB_LOCAL) ? ELF_SYM_LOCAL : 0);
+                    t.num_syms++;
                 }
             }
         }
     }
 
+    // Source line rows from each unit of the line table (in 32 bit DWARF format)
+    if (!error && p_debug_line != NULL)
+    {
+        const uint8_t* p   = p_file + p_debug_line->sh_offset;
+        const uint8_t* end = p + p_debug_line->sh_size;
+
+        while (!error && (size_t)(end - p) >= 4)
+        {
+            uint32_t unit_len = (uint32_t)elf_fixed(p, end, 4);
+
+            if (unit_len >= 0xfffffff0 || unit_len > (size_t)(end - p))
+            {
+                break;
+            }
+
+            error = elf_line_unit(t, p, p + unit_len, strs);
+
+            p += unit_len;
+        }
+    }
+
+    elf_unmap(p_file, size);
+
+    if (error)
+    {
+        free(t.syms);
+        free(t.lines);
+        free(t.pool);
+
+        return error;
+    }
+
+    // Sort the symbols by address, with functions ahead of labels and global symbols ahead of
+    // local at the same address, keeping only the first at each and clearing the flags
+    std::stable_sort(t.syms, t.syms + t.num_syms, [](const rv32i_symbol_t& a, const rv32i_symbol_t& b)
+                     { return a.addr < b.addr || (a.addr == b.addr && (a.name & ELF_SYM_FLAGS) < (b.name & ELF_SYM_FLAGS)); });
+
+    num_syms = 0;
+    for (uint32_t idx = 0; idx < t.num_syms; idx++)
+    {
+        if (num_syms == 0 || t.syms[num_syms - 1].addr != t.syms[idx].addr)
+        {
+            t.syms[num_syms]       = t.syms[idx];
+            t.syms[num_syms].name &= ~ELF_SYM_FLAGS;
+            num_syms++;
+        }
+    }
+
+    // Sort the line rows by address, with the end of a sequence ahead of a row starting
+    // another at the same address, and keep only the last row at each address
+    std::stable_sort(t.lines, t.lines + t.num_lines, [](const rv32i_line_t& a, const rv32i_line_t& b)
+                     { return a.addr < b.addr || (a.addr == b.addr && a.line == 0 && b.line != 0); });
+
+    num_lines = 0;
+    for (uint32_t idx = 0; idx < t.num_lines; idx++)
+    {
+        if (num_lines && t.lines[num_lines - 1].addr == t.lines[idx].addr)
+        {
+            num_lines--;
+        }
+
+        t.lines[num_lines++] = t.lines[idx];
+    }
+
+    syms     = t.syms;
+    lines    = t.lines;
+    sym_pool = t.pool;
+
     return 0;
 }
 
+// ----------------------------------
+// lookup_symbol()
+//
+// Find the symbol containing addr,
+// being the last at or below it
+// (and within its size, if known)
+//
+const char* rv32i_cpu::lookup_symbol (const uint32_t addr, uint32_t &offset)
+{
+    uint32_t lo = 0;
+    uint32_t hi = num_syms;
+
+    // Find the first symbol above addr
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) >> 1;
+
+        if (syms[mid].addr <= addr)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    if (lo == 0 || (syms[lo - 1].size != 0 && addr - syms[lo - 1].addr >= syms[lo - 1].size))
+    {
+        return NULL;
+    }
+
+    offset = addr - syms[lo - 1].addr;
+
+    return sym_pool + syms[lo - 1].name;
+}
+
+// ----------------------------------
+// lookup_line()
+//
+// Find the source line of addr,
+// from the last line table row at or
+// below it
+//
+const char* rv32i_cpu::lookup_line (const uint32_t addr, uint32_t &line)
+{
+    uint32_t lo = 0;
+    uint32_t hi = num_lines;
+
+    // Find the first row above addr
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) >> 1;
+
+        if (lines[mid].addr <= addr)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    // No row, or the end of a sequence
+    if (lo == 0 || lines[lo - 1].line == 0)
+    {
+        return NULL;
+    }
+
+    line = lines[lo - 1].line;
+
+    return sym_pool + lines[lo - 1].file;
+}
+
+// ----------------------------------
+// free_symbols()
+//
+// Release the symbol and line tables
+//
+void rv32i_cpu::free_symbols (void)
+{
+    free(syms);
+    free(lines);
+    free(sym_pool);
+
+    syms      = NULL;
+    num_syms  = 0;
+    lines     = NULL;
+    num_lines = 0;
+    sym_pool  = NULL;
+    dasm_file = NULL;
+    dasm_line = 0;
+}
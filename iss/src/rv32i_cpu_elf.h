@@ -40,6 +40,11 @@
 // -------------------------------------------------------------------------
 
 #define EI_NIDENT                 16
+#define EI_CLASS                  4
+#define EI_DATA                   5
+
+#define ELFCLASS32                1
+#define ELFDATA2LSB               1
                                   
 #define ET_NONE                   0
 #define ET_REL                    1
@@ -62,7 +67,48 @@
 
 #define ELF_IDENT                 "\177ELF"
 
-#define ELF_MAX_NUM_PHDR          4
+#define PT_NULL                   0
+#define PT_LOAD                   1
+
+#define SHN_UNDEF                 0
+#define SHN_LORESERVE             0xff00
+
+#define SHT_SYMTAB                2
+#define SHT_STRTAB                3
+
+#define STB_LOCAL                 0
+#define STT_NOTYPE                0
+#define STT_FUNC                  2
+
+#define ELF32_ST_BIND(_i)         ((_i) >> 4)
+#define ELF32_ST_TYPE(_i)         ((_i) & 0xf)
+
+// DWARF line number program opcodes
+#define DW_LNS_copy               1
+#define DW_LNS_advance_pc         2
+#define DW_LNS_advance_line       3
+#define DW_LNS_set_file           4
+#define DW_LNS_const_add_pc       8
+#define DW_LNS_fixed_advance_pc   9
+
+#define DW_LNE_end_sequence       1
+#define DW_LNE_set_address        2
+
+// DWARF 5 line table header entry content types and forms
+#define DW_LNCT_path              1
+#define DW_LNCT_directory_index   2
+
+#define DW_FORM_data2             0x05
+#define DW_FORM_data4             0x06
+#define DW_FORM_data8             0x07
+#define DW_FORM_string            0x08
+#define DW_FORM_block             0x09
+#define DW_FORM_data1             0x0b
+#define DW_FORM_sdata             0x0d
+#define DW_FORM_strp              0x0e
+#define DW_FORM_udata             0x0f
+#define DW_FORM_data16            0x1e
+#define DW_FORM_line_strp         0x1f
 
 #define PF_X                      0x1             /* Executable. */
 #define PF_W                      0x2             /* Writable. */
@@ -110,5 +156,27 @@ typedef struct {
     Elf32_Word p_align;
 } Elf32_Phdr, *pElf32_Phdr;
 
+typedef struct {
+    Elf32_Word sh_name;
+    Elf32_Word sh_type;
+    Elf32_Word sh_flags;
+    Elf32_Addr sh_addr;
+    Elf32_Off  sh_offset;
+    Elf32_Word sh_size;
+    Elf32_Word sh_link;
+    Elf32_Word sh_info;
+    Elf32_Word sh_addralign;
+    Elf32_Word sh_entsize;
+} Elf32_Shdr, *pElf32_Shdr;
+
+typedef struct {
+    Elf32_Word    st_name;
+    Elf32_Addr    st_value;
+    Elf32_Word    st_size;
+    unsigned char st_info;
+    unsigned char st_other;
+    Elf32_Half    st_shndx;
+} Elf32_Sym, *pElf32_Sym;
+
 
 #endif
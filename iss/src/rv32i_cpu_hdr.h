@@ -34,6 +34,7 @@
 #include <cstdio>
 #include <cstdint>
 #include <csignal>
+#include <typeinfo>
 
 // -------------------------------------------------------------------------
 // DEFINES
@@ -203,6 +204,20 @@
 
 // SYSTEM intructions' opcode
 #define RV32I_SYS_OPCODE                               0x73
+
+// OP instructions' opcode, and funct7 value of the RV32M instructions within it
+#define RV32I_OP_OPCODE                                0x33
+#define RV32M_MULDIV_FUNCT7                            0x01
+
+// Primary table indexes (opcode[6:2]) of instructions that end a basic block
+#define RV32I_MISC_MEM_IDX                             0x03
+#define RV32I_BRANCH_IDX                               0x18
+#define RV32I_JALR_IDX                                 0x19
+#define RV32I_JAL_IDX                                  0x1b
+#define RV32I_SYSTEM_IDX                               0x1c
+
+// MISC-MEM funct3 value for FENCE.I
+#define RV32I_FENCEI_FUNCT3                            1
                                                        
 #define RV32CSR_PRIV_MASK                              0x300
 #define RV32CSR_RIV_START_BIT                          8
@@ -218,13 +233,119 @@
 #else
 #define RV32I_NUM_OF_REGISTERS                         32
 #endif
+#define RV32I_REG_IDX_MASK                             (RV32I_NUM_OF_REGISTERS-1)
 #define RV32I_NUM_OF_HARTS                             1
 #define RV32I_CSR_SPACE_SIZE                           4096
+#define RV32I_NUM_OF_CSRS                              129
 #define RV32I_NUM_PRIMARY_OPCODES                      32
 #define RV32I_NUM_SECONDARY_OPCODES                    8
 #define RV32I_NUM_TERTIARY_OPCODES                     128
 #define RV32I_NUM_SYSTEM_OPCODES                       4
-#define RV32I_INT_MEM_WORDS                            (16*1024)
+
+// Default internal memory base address and size. Internal memory is flat
+// RAM, accessed if the memory callback does not process an access
+#define RV32I_INT_MEM_BASE                             0x00000000
+#define RV32I_INT_MEM_SIZE                             (64*1024)
+
+// Flattened decode lookup definitions. The first level is indexed on
+// opcode[6:2] and funct3, with entries either a handler index, or (with
+// RV32I_DEC_ROW_FLAG set) a row of handler indexes decoded on funct7, or
+// on funct12[1:0] for ECALL/EBREAK (RV32I_DEC_FUNCT12_FLAG set). Handler
+// index 0 is reserved for a failed decode.
+#define RV32I_DEC_L1_SIZE                              (RV32I_NUM_PRIMARY_OPCODES*RV32I_NUM_SECONDARY_OPCODES)
+#define RV32I_DEC_ROW_SIZE                             RV32I_NUM_TERTIARY_OPCODES
+#define RV32I_DEC_MAX_ROWS                             32
+#define RV32I_DEC_MAX_HANDLERS                         256
+#define RV32I_DEC_ROW_FLAG                             0x8000
+#define RV32I_DEC_FUNCT12_FLAG                         0x4000
+#define RV32I_DEC_IDX_MASK                             0x00ff
+#define RV32I_DEC_NO_HANDLER                           0
+
+// Decoded instruction cache definitions (direct mapped, indexed on the
+// instruction word address, so size is a power of 2). The default number
+// of entries can be overridden with rv32i_cfg_s dcache_size.
+#define RV32I_DCACHE_SIZE                              4096
+#define RV32I_DCACHE_INVALID_TAG                       0xffffffff
+
+// Software TLB definitions. The TLB is direct mapped on the page number (size
+// a power of 2), caching host pointers to pages of RAM, either in registered
+// RAM (or ROM) regions, or returned by a RAM page callback.
+#define RV32I_TLB_PAGE_BITS                            12
+#define RV32I_TLB_PAGE_SIZE                            (1 << RV32I_TLB_PAGE_BITS)
+#define RV32I_TLB_PAGE_MASK                            (RV32I_TLB_PAGE_SIZE-1)
+#define RV32I_TLB_SIZE                                 256
+#define RV32I_TLB_MASK                                 (RV32I_TLB_SIZE-1)
+#define RV32I_TLB_INVALID_TAG                          0xffffffff
+
+// Memory map definitions. Registered regions are held sorted on their base
+// address, and may not overlap. RAM and ROM regions must be page aligned.
+#define RV32I_MAX_REGIONS                              32
+#define RV32I_REGION_RAM                               0
+#define RV32I_REGION_ROM                               1
+#define RV32I_REGION_MMIO                              2
+
+// Memory region access permissions
+#define RV32I_REGION_PERM_R                            0x1
+#define RV32I_REGION_PERM_W                            0x2
+#define RV32I_REGION_PERM_X                            0x4
+#define RV32I_REGION_PERM_RW                           (RV32I_REGION_PERM_R | RV32I_REGION_PERM_W)
+#define RV32I_REGION_PERM_RWX                          (RV32I_REGION_PERM_RW | RV32I_REGION_PERM_X)
+
+// Reserved guest address space definitions. The whole 32 bit address space
+// can be reserved in host virtual memory (Linux x86-64 hosts only), between
+// inaccessible guard areas, with a maximum number of cpus reserving one
+#if defined(__linux__) && defined(__x86_64__)
+#define RV32I_GUEST_SPACE_SUPPORTED
+#endif
+#define RV32I_GUEST_SPACE_SIZE                         0x100000000ULL
+#define RV32I_GUEST_GUARD_SIZE                         (64*1024)
+#define RV32I_MAX_GUEST_SPACES                         16
+
+// Maximum number of lazily loaded ELF segments, whose pages are
+// populated from the file on their first access
+#define RV32I_MAX_LAZY_SEGS                            16
+
+// Basic block cache definitions. Blocks are held in a direct mapped table
+// indexed on their start address (size a power of 2), with their decoded
+// instructions allocated from a pool which is flushed when exhausted.
+// Blocks covering a region of memory are flagged in a filter table at
+// a granularity of 1 << RV32I_BLK_LINE_BITS bytes (size a power of 2).
+// The default sizes can be overridden with rv32i_cfg_s blk_tbl_size,
+// blk_pool_size and blk_filter_size.
+#define RV32I_BLK_TBL_SIZE                             4096
+#define RV32I_BLK_MAX_INSTR                            32
+#define RV32I_BLK_POOL_SIZE                            (16*1024)
+#define RV32I_BLK_LINE_BITS                            8
+#define RV32I_BLK_FILTER_SIZE                          (64*1024)
+#define RV32I_BLK_CHAIN_TAKEN                          0
+#define RV32I_BLK_CHAIN_NOT_TAKEN                      1
+
+// JIT definitions. Blocks executed RV32I_JIT_THRESHOLD times are translated
+// to host code in a code cache of RV32I_JIT_CODE_SIZE bytes (by default, or
+// rv32i_cfg_s jit_code_size), which is reset along with the block pool.
+// Translation is only supported on x86-64 hosts.
+// The code cache's protection is changed in pages of RV32I_JIT_PAGE_SIZE bytes
+// (the x86-64 host page size).
+#define RV32I_JIT_THRESHOLD                            16
+#define RV32I_JIT_CODE_SIZE                            (1024*1024)
+#define RV32I_JIT_MAX_BLK_CODE                         2048
+#define RV32I_JIT_PAGE_SIZE                            4096
+#define RV32I_JIT_NONE                                 0
+#define RV32I_JIT_DONE                                 1
+#define RV32I_JIT_FAILED                               2
+
+#if defined(__x86_64__) || defined(_M_X64)
+# define RV32I_JIT_HOST_SUPPORTED                      true
+#else
+# define RV32I_JIT_HOST_SUPPORTED                      false
+#endif
+
+// The threaded dispatch engine uses labels as values, so is only available with GNU compatible compilers
+#if defined(__GNUC__)
+# define RV32I_THR_SUPPORTED                           true
+#else
+# define RV32I_THR_SUPPORTED                           false
+#endif
 
 // The RV32I base class has a hardwired MTVEC location since
 // since CSR accesses are not supported. Set to riscv-test-env
@@ -238,6 +359,62 @@
 #define RV32I_RTCLOCK_ADDRESS                          0xafffffe0
 #define RV32I_RTCLOCK_CMP_ADDRESS                      0xafffffe8
 
+// Interrupt event sources. Each is scheduled for the cycle count at
+// which it is next to be processed, rather than polled every instruction
+#define RV32I_EVENT_INT_CALLBACK                       0         // External interrupt callback wakeup
+#define RV32I_EVENT_TIMER                              1         // mtime/mtimecmp comparison
+#define RV32I_EVENT_INT_UPDATE                         2         // Re-evaluation of pending/enabled interrupts
+#define RV32I_NUM_INT_EVENTS                           3
+#define RV32I_EVENT_PACE                               3         // Wall clock pacing of virtual time
+#define RV32I_NUM_EVENTS                               4
+
+// Cycle count for events that are not scheduled
+#define RV32I_EVENT_NEVER                              0x7fffffffffffffffLL
+
+// Interval, in cycles, between comparisons of the (real time) mtime with mtimecmp
+#define RV32I_TIMER_POLL_CYCLES                        1024
+
+// mtime time source modes
+#define RV32I_TIME_REAL                                0         // Wall clock time, in microseconds
+#define RV32I_TIME_VIRTUAL                             1         // Derived from the cycle count
+#define RV32I_TIME_PACED                               2         // Virtual, with execution paced to the wall clock
+
+// Default number of cycles per (microsecond) tick of virtual mtime
+#define RV32I_DEFAULT_CYCLES_PER_TICK                  100
+
+// LR/SC reservation granule size, the number of cores that may join a reservation domain
+// (a bit each in its holders table), and the number of entries in a domain's table of
+// holders (indexed by granule address, so granules may share one)
+#define RV32I_RSVD_GRANULE_BYTES                       32
+#define RV32I_RSVD_MAX_CORES                           64
+#define RV32I_RSVD_TBL_SIZE                            256
+#define RV32I_RSVD_TBL_MASK                            (RV32I_RSVD_TBL_SIZE-1)
+
+// Atomic memory operations (the AMO instructions' funct5 values)
+#define RV32I_AMO_ADD                                  0x00
+#define RV32I_AMO_SWAP                                 0x01
+#define RV32I_AMO_XOR                                  0x04
+#define RV32I_AMO_OR                                   0x08
+#define RV32I_AMO_AND                                  0x0c
+#define RV32I_AMO_MIN                                  0x10
+#define RV32I_AMO_MAX                                  0x14
+#define RV32I_AMO_MINU                                 0x18
+#define RV32I_AMO_MAXU                                 0x1c
+
+// Default number of instructions each hart of a multiprocessor runs between synchronisations
+#define RV32I_SMP_QUANTUM                              1000
+
+// Default cache sizes for each hart of a multiprocessor, smaller than a lone
+// core's, as all the harts share the working set of the same program
+#define RV32I_SMP_DCACHE_SIZE                          1024
+#define RV32I_SMP_BLK_TBL_SIZE                         1024
+#define RV32I_SMP_BLK_POOL_SIZE                        (4*1024)
+#define RV32I_SMP_BLK_FILTER_SIZE                      (16*1024)
+#define RV32I_SMP_JIT_CODE_SIZE                        (256*1024)
+
+// Interval, in cycles, between pacing of virtual time to the wall clock
+#define RV32I_PACE_CYCLES                              100000
+
 // FP rounding modes
 #define RV32I_RNE                                      0
 #define RV32I_RTZ                                      1
@@ -292,11 +469,16 @@
   #define SWAPHALF(_ARG) _ARG
 #endif
 
+// Macros for the untraced and traced variants of an instruction method
+// in a decode table entry, and of one for a core class (_core)
+#define RV32I_HANDLER(_cls,_f)                         (pFunc_t)&_cls::_f<false>, (pFunc_t)&_cls::_f<true>
+#define RV32I_CORE_HANDLER(_cls,_core,_f)              (pFunc_t)&_cls::_f<_core,false>, (pFunc_t)&_cls::_f<_core,true>
+
 // Macro to initialise a primary table entry with secondary table.
 // Could not get designator on union to work on both visual studio
 // and g++, even though available from C99 onwards. So used this
 // macro instead.
-#define INIT_TBL_WITH_SUBTBL(_a,_b)                    {_a.sub_table=true;_a.ref.p_entry=(_b); _a.p=NULL;}
+#define INIT_TBL_WITH_SUBTBL(_a,_b)                    {_a.sub_table=true;_a.ref.p_entry=(_b); _a.p=NULL; _a.p_trace=NULL;}
 
 // Macros to sign extend
 #define SIGN_EXT8(_val)                                ((int32_t)((_val) | (((_val) & MASK_SIGN_BYTE)  ? ~BYTE_MASK  : 0)))
@@ -309,105 +491,140 @@
 // RISC-V specific definitions
 //
 
+// Integer computational operation macros, giving an instruction's result from its source
+// operand values. These are the single definition of these operations, used by both the
+// instruction methods and the threaded dispatch engine.
+#define RV32I_OP_ADD(_a,_b)                            ((uint32_t)(_a) + (uint32_t)(_b))
+#define RV32I_OP_SUB(_a,_b)                            ((uint32_t)(_a) - (uint32_t)(_b))
+#define RV32I_OP_SLT(_a,_b)                            (((int32_t)(_a) < (int32_t)(_b)) ? 1 : 0)
+#define RV32I_OP_SLTU(_a,_b)                           (((uint32_t)(_a) < (uint32_t)(_b)) ? 1 : 0)
+#define RV32I_OP_XOR(_a,_b)                            ((uint32_t)(_a) ^ (uint32_t)(_b))
+#define RV32I_OP_OR(_a,_b)                             ((uint32_t)(_a) | (uint32_t)(_b))
+#define RV32I_OP_AND(_a,_b)                            ((uint32_t)(_a) & (uint32_t)(_b))
+#define RV32I_OP_SLL(_a,_b)                            ((uint32_t)(_a) << ((_b) & RV32I_MASK_IMM_I_SHAMT))
+#define RV32I_OP_SRL(_a,_b)                            ((uint32_t)(_a) >> ((_b) & RV32I_MASK_IMM_I_SHAMT))
+#define RV32I_OP_SRA(_a,_b)                            (RV32I_OP_SRL(_a,_b) | (((_a) & MASK_SIGN_BIT32) ? ~(WORD_MASK >> ((_b) & RV32I_MASK_IMM_I_SHAMT)) : 0))
+
+#define RV32M_OP_MUL(_a,_b)                            ((uint32_t)((uint64_t)(_a) * (uint64_t)(_b)))
+#define RV32M_OP_MULH(_a,_b)                           ((uint32_t)(((int64_t)(int32_t)(_a) * (int64_t)(int32_t)(_b)) >> 32))
+#define RV32M_OP_MULHSU(_a,_b)                         ((uint32_t)(((int64_t)(int32_t)(_a) * (uint64_t)(_b)) >> 32))
+#define RV32M_OP_MULHU(_a,_b)                          ((uint32_t)(((uint64_t)(_a) * (uint64_t)(_b)) >> 32))
+
+// Division by zero and overflow results as per Vol1. 7.2
+#define RV32M_DIV_OVERFLOW(_a,_b)                      ((uint32_t)(_a) == MASK_BIT31 && (uint32_t)(_b) == WORD_MASK)
+#define RV32M_OP_DIV(_a,_b)                            (((_b) == 0) ? WORD_MASK : RV32M_DIV_OVERFLOW(_a,_b) ? MASK_BIT31 : \
+                                                            (uint32_t)((int32_t)(_a) / (int32_t)(_b)))
+#define RV32M_OP_DIVU(_a,_b)                           (((_b) == 0) ? WORD_MASK : (uint32_t)(_a) / (uint32_t)(_b))
+#define RV32M_OP_REM(_a,_b)                            (((_b) == 0) ? (uint32_t)(_a) : RV32M_DIV_OVERFLOW(_a,_b) ? 0 : \
+                                                            (uint32_t)((int32_t)(_a) % (int32_t)(_b)))
+#define RV32M_OP_REMU(_a,_b)                           (((_b) == 0) ? (uint32_t)(_a) : (uint32_t)(_a) % (uint32_t)(_b))
+
 // Disassembly macros. Note, the raw instruction value could be byte swapped to match the
 // the listings of the GNU assembler, meaning the left most byte is the least significant
 // (RISC-V is little endian by default---see [1] section 1.5). The objdump disassembly
 // output does not do this and the word reads as per the manual. This model does the latter
 // as it is easier to cross-reference to the instruction definitions.
+//
+// The instruction macros are used in the instruction methods, which have a traced (TRACE
+// true) variant, selected when disassembling, and an untraced variant with no disassembly
+// overhead. Likewise, disassemble mode (which does not execute instructions) is only
+// tested in the traced variant, using RV32I_DISASSEM_ONLY.
+#define RV32I_DISASSEM_ONLY                                  (TRACE && disassemble)
+
 #define RV32I_DISASSEM_B_TYPE(_instr,_str,_rs1,_rs2,_imm_b)  {                                                                           \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %s %d\n",  state.hart[curr_hart].pc, _instr, _str, rmap(_rs1), rmap(_rs2),  _imm_b);     \
 }
 
 #define RV32I_DISASSEM_R_TYPE(_instr,_str,_rd,_rs1,_rs2)     {                                                                           \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %s %s\n",  state.hart[curr_hart].pc, _instr, _str,rmap(_rd),rmap(_rs1), rmap_str[_rs2]); \
 }
 
 #define RV32I_DISASSEM_RA_TYPE(_instr,_str,_rd,_rs1,_rs2)     {                                                                          \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %s (%s)\n",  state.hart[curr_hart].pc, _instr, _str,rmap(_rd),rmap(_rs2), rmap_str[_rs1]); \
 }
 
 #define RV32I_DISASSEM_RF_TYPE(_instr,_str,_rd,_rs1,_rs2)     {                                                                          \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %s %s\n",  state.hart[curr_hart].pc, _instr, _str,fmap(_rd),fmap(_rs1), fmap_str[_rs2]); \
 }
 
 #define RV32I_DISASSEM_RFCVT1_TYPE(_instr,_str,_rd,_rs1,_rs2)     {                                                                      \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %s\n",  state.hart[curr_hart].pc, _instr, _str,rmap(_rd),fmap_str[_rs1]);                \
 }
 
 #define RV32I_DISASSEM_RFCVT2_TYPE(_instr,_str,_rd,_rs1,_rs2)     {                                                                      \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %s\n",  state.hart[curr_hart].pc, _instr, _str,fmap(_rd), rmap_str[_rs1]); \
 }
 
 #define RV32I_DISASSEM_RFCVT3_TYPE(_instr,_str,_rd,_rs1,_rs2)     {                                                                      \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %s\n",  state.hart[curr_hart].pc, _instr, _str,fmap(_rd), fmap_str[_rs1]); \
 }
 
 #define RV32I_DISASSEM_R4_TYPE(_instr,_str,_rd,_rs1,_rs2,_rs3)     {                                                                     \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %s %s %s\n",  state.hart[curr_hart].pc, _instr, _str,fmap(_rd),fmap(_rs1),fmap(_rs2),fmap_str[_rs3]); \
 }
 
 #define RV32I_DISASSEM_I_TYPE(_instr,_str,_rd,_rs1,_imm_i)   {                                                                           \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %s %d\n",  state.hart[curr_hart].pc, _instr, _str, rmap(_rd),  rmap(_rs1),  _imm_i);     \
 }
 
 #define RV32I_DISASSEM_S_TYPE(_instr,_str,_rs1,_rs2,_imm_s)  {                                                                           \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %d(%s)\n", state.hart[curr_hart].pc, _instr, _str, rmap(_rs2), _imm_s, rmap_str[_rs1]);  \
 }
 
 #define RV32I_DISASSEM_SFS_TYPE(_instr,_str,_rs1,_rs2,_imm_s)  {                                                                         \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %d(%s)\n", state.hart[curr_hart].pc, _instr, _str, fmap(_rs2), _imm_s, rmap_str[_rs1]);      \
 }
 
 #define RV32I_DISASSEM_IL_TYPE(_instr,_str,_rd,_rs1,_imm_i)  {                                                               /* LOAD */  \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %d(%s)\n", state.hart[curr_hart].pc, _instr, _str, rmap(_rd),  _imm_i, rmap_str[_rs1]);  \
 }
 
 #define RV32I_DISASSEM_IF_TYPE(_instr,_str,_imm_i)           {                                                               /* FENCE */ \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %d, %d\n",    state.hart[curr_hart].pc, _instr, _str, ((_imm_i)>>4)&0xf, ((_imm_i)>>0)&0xf);\
 }
 
 #define RV32I_DISASSEM_IFS_TYPE(_instr,_str,_rd,_rs1,_imm_i)  {                                                               /* LOAD */ \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %d(%s)\n", state.hart[curr_hart].pc, _instr, _str, fmap(_rd), _imm_i, rmap_str[_rs1]);   \
 }
 
 #define RV32I_DISASSEM_ICSR_TYPE(_instr,_str,_rd,_csr,_rs1)  {                                                               /* CSR */   \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s 0x%03x, %s\n",state.hart[curr_hart].pc,_instr,_str,rmap(_rd),_csr&0xfff,rmap_str[_rs1]); \
 }
 #define RV32I_DISASSEM_ICSRI_TYPE(_instr,_str,_rd,_csr,_imm) {                                                             /* CSR imm */ \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s 0x%03x, %d\n",state.hart[curr_hart].pc, _instr, _str, rmap(_rd),_csr & 0xfff, _imm);     \
 }
 #define RV32I_DISASSEM_J_TYPE(_instr,_str,_rd,_imm_j)        {                                                                           \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s %d\n",     state.hart[curr_hart].pc, _instr, _str, rmap(_rd),  _imm_j);                  \
 }
 
 #define RV32I_DISASSEM_U_TYPE(_instr,_str,_rd,_imm_u)        {                                                                           \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s %s 0x%08x\n", state.hart[curr_hart].pc, _instr, _str, rmap(_rd),  _imm_u);                  \
 }
 
 #define RV32I_DISASSEM_SYS_TYPE(_instr,_str)                 {                                                                           \
-    if (disassemble || rt_disassem)                                                                                                      \
+    if (TRACE)                                                                                                                           \
         fprintf(dasm_fp, "%08x: 0x%08x    %s\n",           state.hart[curr_hart].pc, _instr, _str);                                      \
 }
 #define RV32I_DISASSEM_PC_JUMP                               {                                                                           \
-    if (rt_disassem)                                                                                                                     \
+    if (TRACE && rt_disassem)                                                                                                            \
         fprintf(dasm_fp, "    *\n");                                                                                                     \
 }
 #define RV32I_DISASSEM_INT_PC_JUMP                               {                                                                           \
@@ -426,10 +643,13 @@ typedef  int64_t rv32i_time_t;
 // by any function registered with the ISS.
 
 // External interrupt callback is passed current time value. The function can
-// optionally return a future time in 'wakeup_time' which will delay the
-// subsequent recall to be at, or beyond, that time. Any time less will result
-// in the function be called in the next time slot. The return value is a
-// 32 bit bitmap of requesting external interrupts.
+// optionally return a future time in 'wakeup_time', at, or beyond, which it is next
+// called (RV32I_EVENT_NEVER if it need not be, e.g. if its interrupts only change on
+// memory writes). If it leaves 'wakeup_time' unchanged, or sets any time less, it is
+// called in the next time slot (i.e. polled every cycle). The function is also called
+// after any write processed by the memory callback or an MMIO handler, as this may
+// change the interrupt state. The return value is a 32 bit bitmap of requesting
+// external interrupts.
 
 typedef uint32_t (*p_rv32i_intcallback_t) (const rv32i_time_t time, rv32i_time_t *wakeup_time);
 
@@ -444,6 +664,17 @@ typedef uint32_t (*p_rv32i_intcallback_t) (const rv32i_time_t time, rv32i_time_t
 // is greater than 0, the cycle count will be incremented by the value returned.
 typedef int      (*p_rv32i_memcallback_t) (const uint32_t byte_addr, uint32_t &data, const int type, const rv32i_time_t time);
 
+// RAM page callback is passed the address of a page (of RV32I_TLB_PAGE_SIZE bytes),
+// and must return a pointer to the host memory holding it, in little endian byte
+// order, or NULL if the page is not plain RAM (e.g. it has memory mapped devices).
+// Accesses to returned pages bypass the memory access callback, and the pages must
+// remain valid until the TLB is flushed. Accesses to other pages are unaffected.
+// 'write' is set when the page is mapped for a write, and clear for a read (or
+// fetch), so a callback may return NULL for a page it has not yet allocated when
+// read, leaving the read to the memory access callback, and allocate only on a write.
+
+typedef uint8_t* (*p_rv32i_pagecallback_t) (const uint32_t page_addr, const bool write);
+
 // Decode table entry structure type definition
 typedef struct
 {
@@ -454,22 +685,25 @@ typedef struct
 // Forward reference the decode table structure type
 struct rv32i_decode_table_t;
 
-// Current decoded instruction type, combining opcode and a pointer to its
-// entry in the decode table
+// Current decoded instruction type. This is kept compact (16 bytes) so decoded
+// instructions can be cached densely. Only the register and immediate fields
+// of the instruction's format are decoded (the unused registers are 0), and,
+// as a format has at most one immediate value, the immediates share storage.
 typedef struct {
     uint32_t                                           instr;          // Full instruction opcode
-    uint32_t                                           opcode;         // Opcode field
-    uint32_t                                           funct3;         // Sub-function value (R, I, S and B types)
-    uint32_t                                           funct7;         // Sub-function value (R-type)
-    uint32_t                                           rd;             // Destination register
-    uint32_t                                           rs1;            // Source register 1
-    uint32_t                                           rs2;            // Source register 2
-    uint32_t                                           imm_i;          // Sign extended immediate value for I type
-    uint32_t                                           imm_s;          // Sign extended immediate value for S type
-    uint32_t                                           imm_b;          // Sign extended immediate value for B type
-    uint32_t                                           imm_u;          // Sign extended immediate value for U type
-    uint32_t                                           imm_j;          // Sign extended immediate value for J type
-    rv32i_table_entry_t                                entry;          // Copy of instruction tabel entry
+    union {
+        uint32_t                                       imm_i;          // Sign extended immediate value for I type
+        uint32_t                                       imm_s;          // Sign extended immediate value for S type
+        uint32_t                                       imm_b;          // Sign extended immediate value for B type
+        uint32_t                                       imm_u;          // Sign extended immediate value for U type
+        uint32_t                                       imm_j;          // Sign extended immediate value for J type
+    };
+    uint8_t                                            opcode;         // Opcode field
+    uint8_t                                            funct3;         // Sub-function value (R, I, S and B types)
+    uint8_t                                            funct7;         // Sub-function value (R-type)
+    uint8_t                                            rd;             // Destination register
+    uint8_t                                            rs1;            // Source register 1
+    uint8_t                                            rs2;            // Source register 2
 } rv32i_decode_t, *p_rv32i_decode_t;
 
 // Forward class reference for following type definition
@@ -489,10 +723,135 @@ typedef struct rv32i_decode_table_t
         rv32i_decode_table_t*                          p_entry;        // A pointer to a sub-table
     } ref;
 
-    // Pointer to an instruction function
+    // Pointers to the untraced and traced variants of an instruction function
     pFunc_t                                            p;
+    pFunc_t                                            p_trace;
 } rv32i_decode_table_t;
 
+// Instruction handler type, referenced by index from the flattened decode lookup
+typedef struct
+{
+    pFunc_t                                            p;              // Pointer to an instruction function
+    pFunc_t                                            p_trace;        // Pointer to traced variant of instruction function
+    const char*                                        instr_name;     // Instruction name string for disassembly
+    int                                                instr_fmt;      // Instruction format
+} rv32i_handler_t;
+
+// Flattened decode lookup type, shared by all cores of the class (identified
+// by p_type) it was generated for
+typedef struct rv32i_decode_lookup_t
+{
+    const std::type_info*                              p_type;         // Class of core lookup is for
+    uint32_t                                           num_handlers;   // Number of handlers used
+    uint32_t                                           num_rows;       // Number of rows used
+    uint16_t                                           l1       [RV32I_DEC_L1_SIZE];
+    uint8_t                                            rows     [RV32I_DEC_MAX_ROWS][RV32I_DEC_ROW_SIZE];
+    rv32i_handler_t                                    handlers [RV32I_DEC_MAX_HANDLERS];
+    rv32i_decode_lookup_t*                             p_next;         // Next lookup, for another class
+} rv32i_decode_lookup_t;
+
+// Decoded instruction cache entry type. The tag is the address of the cached
+// instruction (always word aligned, so RV32I_DCACHE_INVALID_TAG never matches)
+typedef struct
+{
+    uint32_t                                           tag;            // Address of cached instruction
+    uint32_t                                           fetch_cycles;   // Cycles added by the instruction's fetch
+    rv32i_decode_t                                     decode;         // Decoded instruction
+    rv32i_handler_t*                                   p_entry;        // Resolved instruction handler
+    const void*                                        thr_label;      // Threaded dispatch label (in blocks only)
+} rv32i_dcache_entry_t;
+
+// Software TLB entry type. The tags are the address of the mapped page
+// (so RV32I_TLB_INVALID_TAG never matches), with the write tag invalid
+// if the page is read only.
+typedef struct
+{
+    uint32_t                                           tag;            // Address of page mapped for reads
+    uint32_t                                           wr_tag;         // Address of page mapped for writes
+    uint8_t*                                           p_host;         // Host memory holding the page
+    uint32_t                                           latency;        // Cycles added by each access
+} rv32i_tlb_entry_t;
+
+// Memory map region type
+typedef struct
+{
+    uint32_t                                           base;           // Address of first byte of region
+    uint32_t                                           size;           // Size of region in bytes
+    int                                                type;           // RAM, ROM or MMIO
+    int                                                perm;           // Access permissions
+    uint32_t                                           latency;        // Cycles added by each access
+    uint8_t*                                           p_host;         // Host memory holding region (RAM/ROM)
+    p_rv32i_memcallback_t                              p_handler;      // Access handler (MMIO)
+} rv32i_region_t;
+
+// Lazily loaded ELF segment, with a bitmap of its pages yet to be populated
+typedef struct {
+    uint32_t                                           vaddr;          // Address of segment
+    uint32_t                                           filesz;         // Bytes of segment in file
+    uint32_t                                           memsz;          // Bytes of segment in memory (zeroed beyond filesz)
+    uint32_t                                           offset;         // Offset of segment data in file
+    uint32_t                                           num_pages;      // Number of pages the segment spans
+    uint8_t*                                           p_pending;      // Bitmap of pages not yet populated
+} rv32i_lazy_seg_t;
+
+// Registers of a hart changed since its last register snapshot
+typedef struct {
+    bool                                               pc;             // Program counter changed
+    uint32_t                                           x;              // Bitmap of changed integer registers
+    uint32_t                                           f;              // Bitmap of changed floating point registers
+    uint32_t                                           num_csrs;       // Number of changed CSRs
+    uint16_t                                           csr_addr[RV32I_NUM_OF_CSRS]; // Addresses of changed CSRs
+} rv32i_dirty_regs_t;
+
+// Executable symbol, sorted by address, with its name an offset into the symbol string pool
+typedef struct {
+    uint32_t                                           addr;           // Address of symbol
+    uint32_t                                           size;           // Size of symbol (0 if unknown)
+    uint32_t                                           name;           // Offset of name in string pool
+} rv32i_symbol_t;
+
+// Source line table row, sorted by address, with its file an offset into the symbol string
+// pool. Each row covers addresses up to the next, with a line of 0 marking the end of a sequence.
+typedef struct {
+    uint32_t                                           addr;           // First address of row
+    uint32_t                                           line;           // Source line number
+    uint32_t                                           file;           // Offset of file name in string pool
+} rv32i_line_t;
+
+// JIT native code type. Passed a pointer to the integer registers, the
+// function returns the updated PC.
+typedef uint32_t (*p_rv32i_jit_func_t) (uint32_t* x);
+
+// JIT block segment type. A translated block is split into segments of either a
+// run of instructions executed by one native function, or (when func is NULL)
+// a single instruction executed by its handler.
+typedef struct
+{
+    p_rv32i_jit_func_t                                 func;           // Native code (or NULL if interpreted)
+    uint32_t                                           num_instr;      // Number of instructions in segment
+    uint32_t                                           cycles;         // Total fetch and execute cycles of segment
+    uint32_t                                           last_instr;     // Opcode of last instruction in segment
+    uint32_t                                           target;         // Jump target of a terminating branch or jal
+    bool                                               has_target;     // Flag segment updates the access address
+} rv32i_jit_seg_t;
+
+// Basic block type. A block is a run of sequential decoded instructions (held in
+// the block pool) ending in a control flow, system or fence instruction. The
+// chain pointers cache the blocks last found at the taken and not taken
+// successor addresses, and must be checked against the block tags before use.
+typedef struct rv32i_block_t
+{
+    uint32_t                                           tag;            // Address of first instruction
+    uint32_t                                           num_instr;      // Number of instructions in block
+    rv32i_dcache_entry_t*                              p_instr;        // First decoded instruction in pool
+    rv32i_block_t*                                     p_chain[2];     // Last seen successor blocks
+    uint32_t                                           exec_count;     // Executions counted towards JIT threshold
+    int                                                jit_state;      // JIT translation status of block
+    rv32i_jit_seg_t*                                   p_seg;          // First JIT segment (if translated)
+    uint32_t                                           num_seg;        // Number of JIT segments
+    bool                                               thr_ready;      // Flag instructions' dispatch labels set
+} rv32i_block_t;
+
 struct  rv32i_cfg_s {
     const char*    exec_fname;
     bool           user_fname;
@@ -508,6 +867,24 @@ struct  rv32i_cfg_s {
     bool           update_rst_vec;
     uint32_t       new_rst_vec;
     FILE*          dbg_fp;
+    bool           en_dcache;
+    bool           en_blk_cache;
+    bool           stats_en;
+    bool           en_jit;
+    bool           jit_check;
+    bool           en_threaded;
+    int            time_mode;
+    uint32_t       cycles_per_tick;
+    uint32_t       int_mem_base;
+    uint32_t       int_mem_size;
+    bool           en_guest_space;
+    unsigned       smp_quantum;
+    bool           smp_parallel;
+    uint32_t       dcache_size;
+    uint32_t       blk_tbl_size;
+    uint32_t       blk_pool_size;
+    uint32_t       blk_filter_size;
+    uint32_t       jit_code_size;
 
     rv32i_cfg_s()
     {
@@ -525,6 +902,26 @@ struct  rv32i_cfg_s {
         update_rst_vec   = false;
         new_rst_vec      = RV32I_RESET_VECTOR;
         dbg_fp           = stdout;
+        en_dcache        = true;
+        en_blk_cache     = true;
+        stats_en         = false;
+        en_jit           = false;
+        jit_check        = false;
+        en_threaded      = false;
+        time_mode        = RV32I_TIME_REAL;
+        cycles_per_tick  = RV32I_DEFAULT_CYCLES_PER_TICK;
+        int_mem_base     = RV32I_INT_MEM_BASE;
+        int_mem_size     = RV32I_INT_MEM_SIZE;
+        en_guest_space   = false;
+        smp_quantum      = RV32I_SMP_QUANTUM;
+        smp_parallel     = false;
+
+        // Cache sizes of 0 select the defaults (smaller for a multiprocessor's harts)
+        dcache_size      = 0;
+        blk_tbl_size     = 0;
+        blk_pool_size    = 0;
+        blk_filter_size  = 0;
+        jit_code_size    = 0;
     }
 };
 
@@ -0,0 +1,533 @@
+//=============================================================
+//
+// Copyright (c) 2021 Simon Southwell. All rights reserved.
+//
+// Date: 16th October 2026
+//
+// JIT (x86-64 binary translation) methods of rv32i_cpu
+//
+// This file is part of the RISC-V instruction set simulator
+// (rv32i_cpu)
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+// -------------------------------------------------------------------------
+// INCLUDES
+// -------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstdint>
+
+#if defined (_WIN32) || defined (_WIN64)
+# define  WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#else
+# include <sys/mman.h>
+#endif
+
+#include "rv32i_cpu_jit.h"
+#include "rv32i_cpu.h"
+
+// -------------------------------------------------------------------------
+// DEFINES
+// -------------------------------------------------------------------------
+
+// Function values of RV32M multiply instructions
+#define RV32I_JIT_MUL_FUNCT3                           0
+#define RV32I_JIT_MULH_FUNCT3                          1
+#define RV32I_JIT_MULHSU_FUNCT3                        2
+#define RV32I_JIT_MULHU_FUNCT3                         3
+
+// -----------------------------------------------------------
+// Allocate executable memory for the JIT code cache, of
+// size bytes rounded up to whole pages (and at least the
+// largest block's code), returning true on success. The
+// cache is never writable and executable at once (W^X), so
+// is mapped executable, with pages made writable only while
+// code is emitted.
+// -----------------------------------------------------------
+
+bool rv32i_cpu::jit_alloc_code(const uint32_t size)
+{
+    const uint32_t page_mask = RV32I_JIT_PAGE_SIZE - 1;
+
+    jit_code_size = (size < RV32I_JIT_MAX_BLK_CODE) ? RV32I_JIT_MAX_BLK_CODE : size;
+    jit_code_size = (jit_code_size + page_mask) & ~page_mask;
+
+#if defined (_WIN32) || defined (_WIN64)
+    jit_code = (uint8_t*)VirtualAlloc(NULL, jit_code_size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READ);
+#else
+    void* p  = mmap(NULL, jit_code_size, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    jit_code = (p == MAP_FAILED) ? NULL : (uint8_t*)p;
+#endif
+
+    jit_code_idx = 0;
+
+    return jit_code != NULL;
+}
+
+// -----------------------------------------------------------
+// Make the pages of the JIT code cache holding the given
+// range writable (and not executable), to emit code, or
+// executable (and not writable), to run it. Returns false
+// if the protection could not be changed.
+// -----------------------------------------------------------
+
+bool rv32i_cpu::jit_protect_code(const uint32_t offset, const uint32_t len, const bool writable)
+{
+    const uint32_t page_mask = RV32I_JIT_PAGE_SIZE - 1;
+    uint32_t       start     = offset & ~page_mask;
+    uint32_t       end       = (offset + len + page_mask) & ~page_mask;
+
+    if (end > jit_code_size)
+    {
+        end = jit_code_size;
+    }
+
+#if defined (_WIN32) || defined (_WIN64)
+    DWORD old_prot;
+
+    return VirtualProtect(jit_code + start, end - start, writable ? PAGE_READWRITE : PAGE_EXECUTE_READ, &old_prot) != 0;
+#else
+    return mprotect(jit_code + start, end - start, writable ? (PROT_READ | PROT_WRITE) : (PROT_READ | PROT_EXEC)) == 0;
+#endif
+}
+
+// -----------------------------------------------------------
+// Free the JIT code cache
+// -----------------------------------------------------------
+
+void rv32i_cpu::jit_free_code()
+{
+    if (jit_code != NULL)
+    {
+#if defined (_WIN32) || defined (_WIN64)
+        VirtualFree(jit_code, 0, MEM_RELEASE);
+#else
+        munmap(jit_code, jit_code_size);
+#endif
+        jit_code = NULL;
+    }
+}
+
+// -----------------------------------------------------------
+// Translate a block into segments. Runs of instructions that
+// can be emitted as native code are placed in a single
+// segment, with all others (loads/stores, CSR, atomic,
+// floating point, division, system etc.) left as single
+// instruction segments executed by their handlers. The block
+// is marked as failed if nothing could be translated.
+// -----------------------------------------------------------
+
+void rv32i_cpu::jit_translate(rv32i_block_t* p_blk)
+{
+    // Allocate the block's segments in the pool, in parallel with its instructions
+    uint32_t              pool_idx = (uint32_t)(p_blk->p_instr - blk_pool);
+    rv32i_jit_seg_t*      p_seg    = &jit_seg_pool[pool_idx];
+    rv32i_dcache_entry_t* p_instr  = p_blk->p_instr;
+    uint32_t              num_native = 0;
+
+    p_blk->jit_state = RV32I_JIT_FAILED;
+
+    // Blocks are only translated if the code cache can hold the largest possible block's code,
+    // and the pages it could be emitted to can be made writable
+    if (jit_code_idx + RV32I_JIT_MAX_BLK_CODE > jit_code_size ||
+        !jit_protect_code(jit_code_idx, RV32I_JIT_MAX_BLK_CODE, true))
+    {
+        return;
+    }
+
+    rv32i_jit_emitter e(&jit_code[jit_code_idx]);
+
+    p_blk->p_seg   = p_seg;
+    p_blk->num_seg = 0;
+
+    uint32_t idx = 0;
+    while (idx < p_blk->num_instr)
+    {
+        uint32_t pc       = p_blk->tag + 4*idx;
+        uint8_t* p_start  = e.ptr();
+
+        p_seg->func       = NULL;
+        p_seg->num_instr  = 0;
+        p_seg->cycles     = 0;
+        p_seg->has_target = false;
+
+        e.prologue();
+
+        // Add instructions to the native segment until one can't be translated
+        while (idx < p_blk->num_instr && jit_emit_instr(e, &p_instr[idx], pc))
+        {
+            p_seg->num_instr++;
+            p_seg->cycles    += p_instr[idx].fetch_cycles + 1;
+            p_seg->last_instr = p_instr[idx].decode.instr;
+
+            idx++;
+            pc += 4;
+
+            // A branch or jal terminates the segment, returning the new PC itself
+            uint32_t opcode_idx = p_instr[idx-1].decode.opcode >> 2;
+            if (opcode_idx == RV32I_BRANCH_IDX || opcode_idx == RV32I_JAL_IDX)
+            {
+                p_seg->has_target = true;
+                p_seg->target     = (pc - 4) + ((opcode_idx == RV32I_JAL_IDX) ? p_instr[idx-1].decode.imm_j : p_instr[idx-1].decode.imm_b);
+                break;
+            }
+        }
+
+        if (p_seg->num_instr)
+        {
+            if (!p_seg->has_target)
+            {
+                e.ret_pc(pc);
+            }
+
+            p_seg->func = (p_rv32i_jit_func_t)p_start;
+            num_native += p_seg->num_instr;
+        }
+        else
+        {
+            // Discard the prologue, and leave the instruction to its handler
+            e.set_ptr(p_start);
+
+            p_seg->num_instr  = 1;
+            idx++;
+        }
+
+        p_seg++;
+        p_blk->num_seg++;
+    }
+
+    // The pages are executable again before any of their code is run (and the
+    // block's code is not run if they can't be)
+    if (!jit_protect_code(jit_code_idx, RV32I_JIT_MAX_BLK_CODE, false))
+    {
+        return;
+    }
+
+    if (num_native)
+    {
+        jit_code_idx    += (uint32_t)(e.ptr() - &jit_code[jit_code_idx]);
+        p_blk->jit_state = RV32I_JIT_DONE;
+        jit_trans_count++;
+    }
+}
+
+// -----------------------------------------------------------
+// Emit native code for a single instruction, returning false
+// (having emitted nothing) if it can't be translated. The
+// native code must update the registers exactly as the
+// instruction's handler would.
+// -----------------------------------------------------------
+
+bool rv32i_cpu::jit_emit_instr(rv32i_jit_emitter &e, const rv32i_dcache_entry_t* p_instr, const uint32_t pc)
+{
+    const rv32i_decode_t* d = &p_instr->decode;
+    pFunc_t               p = p_instr->p_entry->p;
+
+    // Registers outside of those implemented (i.e. RV32E) are left to the handlers
+    if (d->rd >= RV32I_NUM_OF_REGISTERS || d->rs1 >= RV32I_NUM_OF_REGISTERS || d->rs2 >= RV32I_NUM_OF_REGISTERS)
+    {
+        return false;
+    }
+
+    // Register-immediate instructions
+    if (p == &rv32i_cpu::addi<false>  || p == &rv32i_cpu::xori<false>  || p == &rv32i_cpu::ori<false>  || p == &rv32i_cpu::andi<false> ||
+        p == &rv32i_cpu::slti<false>  || p == &rv32i_cpu::sltiu<false>)
+    {
+        if (d->rd)
+        {
+            e.mov_r_x(X86_EAX, d->rs1);
+
+            if      (p == &rv32i_cpu::addi<false>)  e.alu_r_imm(X86_EXT_ADD, X86_EAX, d->imm_i);
+            else if (p == &rv32i_cpu::xori<false>)  e.alu_r_imm(X86_EXT_XOR, X86_EAX, d->imm_i);
+            else if (p == &rv32i_cpu::ori<false>)   e.alu_r_imm(X86_EXT_OR,  X86_EAX, d->imm_i);
+            else if (p == &rv32i_cpu::andi<false>)  e.alu_r_imm(X86_EXT_AND, X86_EAX, d->imm_i);
+            else
+            {
+                e.alu_r_imm(X86_EXT_CMP, X86_EAX, d->imm_i);
+                e.setcc_r((p == &rv32i_cpu::slti<false>) ? X86_CC_L : X86_CC_B, X86_EAX);
+            }
+
+            e.mov_x_r(d->rd, X86_EAX);
+        }
+    }
+    // Immediate shifts (those with reserved bits set trap in the handler)
+    else if (p == &rv32i_cpu::slli<false> || p == &rv32i_cpu::srli<false> || p == &rv32i_cpu::srai<false>)
+    {
+        if (d->instr & RV32I_SHIFT_RSVD_BIT_MASK)
+        {
+            return false;
+        }
+
+        if (d->rd)
+        {
+            int ext = (p == &rv32i_cpu::slli<false>) ? X86_EXT_SHL : (p == &rv32i_cpu::srli<false>) ? X86_EXT_SHR : X86_EXT_SAR;
+
+            e.mov_r_x(X86_EAX, d->rs1);
+            e.shift_r_imm(ext, X86_EAX, d->imm_i & RV32I_MASK_IMM_I_SHAMT);
+            e.mov_x_r(d->rd, X86_EAX);
+        }
+    }
+    // Register-register instructions
+    else if (p == &rv32i_cpu::addr<false>  || p == &rv32i_cpu::subr<false>  || p == &rv32i_cpu::xorr<false> || p == &rv32i_cpu::orr<false> ||
+             p == &rv32i_cpu::andr<false>  || p == &rv32i_cpu::sltr<false>  || p == &rv32i_cpu::sltur<false>)
+    {
+        if (d->rd)
+        {
+            e.mov_r_x(X86_EAX, d->rs1);
+
+            if      (p == &rv32i_cpu::addr<false>)  e.alu_r_x(X86_ADD_R_RM, X86_EAX, d->rs2);
+            else if (p == &rv32i_cpu::subr<false>)  e.alu_r_x(X86_SUB_R_RM, X86_EAX, d->rs2);
+            else if (p == &rv32i_cpu::xorr<false>)  e.alu_r_x(X86_XOR_R_RM, X86_EAX, d->rs2);
+            else if (p == &rv32i_cpu::orr<false>)   e.alu_r_x(X86_OR_R_RM,  X86_EAX, d->rs2);
+            else if (p == &rv32i_cpu::andr<false>)  e.alu_r_x(X86_AND_R_RM, X86_EAX, d->rs2);
+            else
+            {
+                e.alu_r_x(X86_CMP_R_RM, X86_EAX, d->rs2);
+                e.setcc_r((p == &rv32i_cpu::sltr<false>) ? X86_CC_L : X86_CC_B, X86_EAX);
+            }
+
+            e.mov_x_r(d->rd, X86_EAX);
+        }
+    }
+    // Register shifts (x86 masks the shift amount in cl to 5 bits, as RV32I does)
+    else if (p == &rv32i_cpu::sllr<false> || p == &rv32i_cpu::srlr<false> || p == &rv32i_cpu::srar<false>)
+    {
+        if (d->rd)
+        {
+            int ext = (p == &rv32i_cpu::sllr<false>) ? X86_EXT_SHL : (p == &rv32i_cpu::srlr<false>) ? X86_EXT_SHR : X86_EXT_SAR;
+
+            e.mov_r_x(X86_EAX, d->rs1);
+            e.mov_r_x(X86_ECX, d->rs2);
+            e.shift_r_cl(ext, X86_EAX);
+            e.mov_x_r(d->rd, X86_EAX);
+        }
+    }
+    else if (p == &rv32i_cpu::lui<false> || p == &rv32i_cpu::auipc<false>)
+    {
+        if (d->rd)
+        {
+            e.mov_x_imm(d->rd, (p == &rv32i_cpu::lui<false>) ? d->imm_u : d->imm_u + pc);
+        }
+    }
+    // RV32M multiplies, identified by encoding as the handlers are in a derived class
+    else if (d->opcode == RV32I_OP_OPCODE && d->funct7 == RV32M_MULDIV_FUNCT7 &&
+             d->funct3 <= RV32I_JIT_MULHU_FUNCT3 && p != &rv32i_cpu::reserved<false>)
+    {
+        if (d->rd)
+        {
+            switch (d->funct3)
+            {
+            case RV32I_JIT_MUL_FUNCT3:
+                e.mov_r_x(X86_EAX, d->rs1);
+                e.imul_r_x(X86_EAX, d->rs2);
+                break;
+            case RV32I_JIT_MULH_FUNCT3:
+                e.movsxd_r_x(X86_EAX, d->rs1);
+                e.movsxd_r_x(X86_EDX, d->rs2);
+                break;
+            case RV32I_JIT_MULHSU_FUNCT3:
+                e.movsxd_r_x(X86_EAX, d->rs1);
+                e.mov_r_x(X86_EDX, d->rs2);
+                break;
+            case RV32I_JIT_MULHU_FUNCT3:
+                e.mov_r_x(X86_EAX, d->rs1);
+                e.mov_r_x(X86_EDX, d->rs2);
+                break;
+            }
+
+            // High word results from a 64 bit multiply of the extended operands
+            if (d->funct3 != RV32I_JIT_MUL_FUNCT3)
+            {
+                e.imul64_r_r(X86_EAX, X86_EDX);
+                e.shr64_r_imm(X86_EAX, 32);
+            }
+
+            e.mov_x_r(d->rd, X86_EAX);
+        }
+    }
+    // Conditional branches, returning the taken or not taken PC. Misaligned targets trap in the handler.
+    else if (p == &rv32i_cpu::beq<false>  || p == &rv32i_cpu::bne<false>  || p == &rv32i_cpu::blt<false> ||
+             p == &rv32i_cpu::bge<false>  || p == &rv32i_cpu::bltu<false> || p == &rv32i_cpu::bgeu<false>)
+    {
+        uint32_t target = pc + d->imm_b;
+
+        if (target & 0x3)
+        {
+            return false;
+        }
+
+        int cc = (p == &rv32i_cpu::beq<false>)  ? X86_CC_E  : (p == &rv32i_cpu::bne<false>)  ? X86_CC_NE :
+                 (p == &rv32i_cpu::blt<false>)  ? X86_CC_L  : (p == &rv32i_cpu::bge<false>)  ? X86_CC_GE :
+                 (p == &rv32i_cpu::bltu<false>) ? X86_CC_B  :                           X86_CC_AE;
+
+        e.mov_r_x(X86_EAX, d->rs1);
+        e.alu_r_x(X86_CMP_R_RM, X86_EAX, d->rs2);
+        e.jcc_short(cc, 6);                           // Skip not taken return (mov eax, imm32; ret)
+        e.ret_pc(pc + 4);
+        e.ret_pc(target);
+    }
+    else if (p == &rv32i_cpu::jal<false>)
+    {
+        uint32_t target = pc + d->imm_j;
+
+        if (target & 0x3)
+        {
+            return false;
+        }
+
+        if (d->rd)
+        {
+            e.mov_x_imm(d->rd, pc + 4);
+        }
+
+        e.ret_pc(target);
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------
+// Execute a translated block's segments. As for
+// execute_block(), execution stops early on an error, a
+// non-sequential PC update, or a request to exit the block.
+// -----------------------------------------------------------
+
+int rv32i_cpu::jit_execute_block(rv32i_block_t* p_blk, unsigned &instr_count)
+{
+    int              error   = 0;
+    uint32_t         next_pc = p_blk->tag;
+    uint32_t         idx     = 0;
+    rv32i_jit_seg_t* p_seg   = p_blk->p_seg;
+
+    blk_exec_count++;
+
+    blk_exit = false;
+
+    for (uint32_t seg = 0; seg < p_blk->num_seg; seg++, p_seg++)
+    {
+        if (p_seg->func != NULL)
+        {
+            if (jit_check)
+            {
+                error = jit_check_segment(p_blk, idx, p_seg);
+            }
+            else
+            {
+                state.hart[curr_hart].pc = p_seg->func(state.hart[curr_hart].x);
+
+                cycle_count += p_seg->cycles;
+                curr_instr   = p_seg->last_instr;
+
+                if (p_seg->has_target)
+                {
+                    access_addr = p_seg->target;
+                }
+            }
+
+            jit_exec_count++;
+        }
+        else
+        {
+            rv32i_dcache_entry_t* p_instr = &p_blk->p_instr[idx];
+
+            cycle_count += p_instr->fetch_cycles;
+            curr_instr   = p_instr->decode.instr;
+
+            error        = execute<false>(p_instr->decode, p_instr->p_entry);
+        }
+
+        idx     += p_seg->num_instr;
+        next_pc += 4*p_seg->num_instr;
+
+        if (error || blk_exit || state.hart[curr_hart].pc != next_pc)
+        {
+            break;
+        }
+    }
+
+    instr_count += idx;
+
+    return error;
+}
+
+// -----------------------------------------------------------
+// Lockstep check of a native segment. The native code is run
+// and its results saved, before the registers are restored
+// and the segment's instructions are run by their handlers.
+// Any difference in the resultant state is reported, and
+// SIGABRT returned.
+// -----------------------------------------------------------
+
+int rv32i_cpu::jit_check_segment(rv32i_block_t* p_blk, const uint32_t idx, const rv32i_jit_seg_t* p_seg)
+{
+    int                   error        = 0;
+    uint32_t*             x            = state.hart[curr_hart].x;
+    uint32_t              start_pc     = state.hart[curr_hart].pc;
+    rv32i_time_t          start_cycles = cycle_count;
+    uint32_t              x_start[RV32I_NUM_OF_REGISTERS];
+    uint32_t              x_jit  [RV32I_NUM_OF_REGISTERS];
+
+    // Run native code
+    memcpy(x_start, x, sizeof(x_start));
+
+    uint32_t jit_pc = p_seg->func(x);
+
+    memcpy(x_jit, x, sizeof(x_jit));
+    memcpy(x, x_start, sizeof(x_start));
+
+    // Run the same instructions through their handlers
+    rv32i_dcache_entry_t* p_instr = &p_blk->p_instr[idx];
+
+    for (uint32_t i = 0; i < p_seg->num_instr && !error; i++, p_instr++)
+    {
+        cycle_count += p_instr->fetch_cycles;
+        curr_instr   = p_instr->decode.instr;
+
+        error        = execute<false>(p_instr->decode, p_instr->p_entry);
+    }
+
+    jit_check_count++;
+
+    if (!error && (memcmp(x_jit, x, sizeof(x_jit))                     ||
+                   jit_pc != state.hart[curr_hart].pc                   ||
+                   (cycle_count - start_cycles) != p_seg->cycles        ||
+                   curr_instr != p_seg->last_instr                      ||
+                   (p_seg->has_target && access_addr != p_seg->target)))
+    {
+        fprintf(stderr, "***ERROR: JIT mismatch in segment at 0x%08x (%d instructions)\n", start_pc, p_seg->num_instr);
+
+        for (int ridx = 0; ridx < RV32I_NUM_OF_REGISTERS; ridx++)
+        {
+            if (x_jit[ridx] != x[ridx])
+            {
+                fprintf(stderr, "    x%d: jit=0x%08x interpreter=0x%08x\n", ridx, x_jit[ridx], x[ridx]);
+            }
+        }
+
+        fprintf(stderr, "    pc: jit=0x%08x interpreter=0x%08x\n", jit_pc, state.hart[curr_hart].pc);
+
+        error = SIGABRT;
+    }
+
+    return error;
+}
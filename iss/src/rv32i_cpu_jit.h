@@ -0,0 +1,166 @@
+//=============================================================
+//
+// Copyright (c) 2021 Simon Southwell. All rights reserved.
+//
+// Date: 16th October 2026
+//
+// x86-64 code emitter for the rv32i_cpu JIT
+//
+// This file is part of the RISC-V instruction set simulator
+// (rv32i_cpu)
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+#ifndef _RV32I_CPU_JIT_H_
+#define _RV32I_CPU_JIT_H_
+
+// -------------------------------------------------------------------------
+// INCLUDES
+// -------------------------------------------------------------------------
+
+#include <cstdint>
+#include <cstring>
+
+// -------------------------------------------------------------------------
+// DEFINES
+// -------------------------------------------------------------------------
+
+// Host registers used by translated code. The RV32 integer registers are
+// accessed in memory relative to r11, which holds the x[] pointer argument.
+#define X86_EAX                                        0
+#define X86_ECX                                        1
+#define X86_EDX                                        2
+
+// Opcodes of 32 bit ALU instructions with a register destination and r/m source
+#define X86_ADD_R_RM                                   0x03
+#define X86_OR_R_RM                                    0x0b
+#define X86_AND_R_RM                                   0x23
+#define X86_SUB_R_RM                                   0x2b
+#define X86_XOR_R_RM                                   0x33
+#define X86_CMP_R_RM                                   0x3b
+
+// ModR/M reg field extensions for the 0x81 (ALU immediate) opcode group
+#define X86_EXT_ADD                                    0
+#define X86_EXT_OR                                     1
+#define X86_EXT_AND                                    4
+#define X86_EXT_SUB                                    5
+#define X86_EXT_XOR                                    6
+#define X86_EXT_CMP                                    7
+
+// ModR/M reg field extensions for the 0xc1/0xd3 (shift) opcode groups
+#define X86_EXT_SHL                                    4
+#define X86_EXT_SHR                                    5
+#define X86_EXT_SAR                                    7
+
+// Condition codes for jcc and setcc
+#define X86_CC_B                                       0x2
+#define X86_CC_AE                                      0x3
+#define X86_CC_E                                       0x4
+#define X86_CC_NE                                      0x5
+#define X86_CC_L                                       0xc
+#define X86_CC_GE                                      0xd
+
+// -------------------------------------------------------------------------
+// Class definition for a simple x86-64 machine code emitter
+// -------------------------------------------------------------------------
+
+class rv32i_jit_emitter
+{
+public:
+    rv32i_jit_emitter (uint8_t* buf) : p_code(buf) {};
+
+    uint8_t* ptr                ()                                      { return p_code; }
+    void     set_ptr            (uint8_t* p)                            { p_code = p; }
+
+    // Function entry: mov r11, <first argument>
+    void     prologue           ()
+    {
+#if defined(_WIN64)
+        byte(0x49); byte(0x89); byte(0xcb);
+#else
+        byte(0x49); byte(0x89); byte(0xfb);
+#endif
+    }
+
+    // Function exit, returning the given PC: mov eax, imm32; ret
+    void     ret_pc             (const uint32_t pc)                     { mov_r_imm(X86_EAX, pc); byte(0xc3); }
+
+    // mov r32, x[r]
+    void     mov_r_x            (const int hreg, const uint32_t r)      { byte(0x41); byte(0x8b); modrm_x(hreg, r); }
+
+    // mov x[r], r32
+    void     mov_x_r            (const uint32_t r, const int hreg)      { byte(0x41); byte(0x89); modrm_x(hreg, r); }
+
+    // mov x[r], imm32
+    void     mov_x_imm          (const uint32_t r, const uint32_t imm)  { byte(0x41); byte(0xc7); modrm_x(0, r); word(imm); }
+
+    // mov r32, imm32
+    void     mov_r_imm          (const int hreg, const uint32_t imm)    { byte(0xb8 | hreg); word(imm); }
+
+    // <op> r32, x[r]
+    void     alu_r_x            (const uint8_t op, const int hreg, const uint32_t r)
+    {
+        byte(0x41); byte(op); modrm_x(hreg, r);
+    }
+
+    // <op> r32, imm32
+    void     alu_r_imm          (const int ext, const int hreg, const uint32_t imm)
+    {
+        byte(0x81); byte(0xc0 | (ext << 3) | hreg); word(imm);
+    }
+
+    // <shift> r32, imm8
+    void     shift_r_imm        (const int ext, const int hreg, const uint8_t shamt)
+    {
+        byte(0xc1); byte(0xc0 | (ext << 3) | hreg); byte(shamt);
+    }
+
+    // <shift> r32, cl
+    void     shift_r_cl         (const int ext, const int hreg)         { byte(0xd3); byte(0xc0 | (ext << 3) | hreg); }
+
+    // set<cc> r8; movzx r32, r8 (hreg must be eax, ecx or edx)
+    void     setcc_r            (const int cc, const int hreg)
+    {
+        byte(0x0f); byte(0x90 | cc); byte(0xc0 | hreg);
+        byte(0x0f); byte(0xb6);      byte(0xc0 | (hreg << 3) | hreg);
+    }
+
+    // imul r32, x[r]
+    void     imul_r_x           (const int hreg, const uint32_t r)      { byte(0x41); byte(0x0f); byte(0xaf); modrm_x(hreg, r); }
+
+    // movsxd r64, x[r]
+    void     movsxd_r_x         (const int hreg, const uint32_t r)      { byte(0x49); byte(0x63); modrm_x(hreg, r); }
+
+    // imul r64, r64
+    void     imul64_r_r         (const int hdst, const int hsrc)        { byte(0x48); byte(0x0f); byte(0xaf); byte(0xc0 | (hdst << 3) | hsrc); }
+
+    // shr r64, imm8
+    void     shr64_r_imm        (const int hreg, const uint8_t shamt)   { byte(0x48); byte(0xc1); byte(0xe8 | hreg); byte(shamt); }
+
+    // j<cc> rel8
+    void     jcc_short          (const int cc, const int8_t rel)        { byte(0x70 | cc); byte((uint8_t)rel); }
+
+private:
+    void     byte               (const uint8_t b)                       { *p_code++ = b; }
+    void     word               (const uint32_t w)                      { memcpy(p_code, &w, 4); p_code += 4; }
+
+    // ModR/M and displacement for [r11 + 4*r]
+    void     modrm_x            (const int hreg, const uint32_t r)      { byte(0x43 | (hreg << 3)); byte((uint8_t)(r * 4)); }
+
+    uint8_t* p_code;
+};
+
+#endif
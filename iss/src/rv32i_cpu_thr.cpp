@@ -0,0 +1,242 @@
+//=============================================================
+//
+// Copyright (c) 2021 Simon Southwell. All rights reserved.
+//
+// Date: 16th October 2026
+//
+// Threaded dispatch execution engine method of rv32i_cpu
+//
+// This file is part of the RISC-V instruction set simulator
+// (rv32i_cpu)
+//
+// This code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// The code is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this code. If not, see <http://www.gnu.org/licenses/>.
+//
+//=============================================================
+
+// -------------------------------------------------------------------------
+// INCLUDES
+// -------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstdint>
+
+#include "rv32i_cpu.h"
+
+// -------------------------------------------------------------------------
+// DEFINES
+// -------------------------------------------------------------------------
+
+// Operations executed directly by the threaded engine, indexing its
+// table of labels. All others are dispatched to their instruction methods.
+// The RV32M operations are in funct3 order.
+enum rv32i_thr_op_e
+{
+    THR_HANDLER,
+    THR_ADDI,  THR_SLTI,  THR_SLTIU, THR_XORI,  THR_ORI,   THR_ANDI,
+    THR_SLLI,  THR_SRLI,  THR_SRAI,
+    THR_ADD,   THR_SUB,   THR_SLL,   THR_SLT,   THR_SLTU,  THR_XOR,
+    THR_SRL,   THR_SRA,   THR_OR,    THR_AND,
+    THR_LUI,   THR_AUIPC,
+    THR_MUL,   THR_MULH,  THR_MULHSU, THR_MULHU, THR_DIV,  THR_DIVU,
+    THR_REM,   THR_REMU,
+    THR_NUM_OPS
+};
+
+#if RV32I_THR_SUPPORTED
+
+// Set up for, and jump to, the current instruction's label
+#define RV32I_THR_DISPATCH {                                  \
+    d            = &p_instr->decode;                          \
+    cycle_count += p_instr->fetch_cycles;                     \
+    curr_instr   = d->instr;                                  \
+    goto *p_instr->thr_label;                                 \
+}
+
+// Complete a directly executed instruction, and dispatch the next (if any).
+// As for RV32I's increment_pc(), the PC always increments by 4.
+#define RV32I_THR_NEXT {                                      \
+    p_hart->pc  += 4;                                         \
+    cycle_count += 1;                                         \
+    if (++idx == max_instr)                                   \
+    {                                                         \
+        goto thr_exit;                                        \
+    }                                                         \
+    p_instr++;                                                \
+    RV32I_THR_DISPATCH;                                       \
+}
+
+// Execute an operation writing to rd (except for x0)
+#define RV32I_THR_OP(_result) {                               \
+    if (d->rd)                                                \
+    {                                                         \
+        x[d->rd] = (_result);                                 \
+    }                                                         \
+    RV32I_THR_NEXT;                                           \
+}
+
+// -----------------------------------------------------------
+// Map a decoded instruction to its threaded engine operation
+// -----------------------------------------------------------
+
+int rv32i_cpu::thr_op(const rv32i_dcache_entry_t* p_instr)
+{
+    const rv32i_decode_t* d = &p_instr->decode;
+    pFunc_t               p = p_instr->p_entry->p;
+
+    // Shifts with reserved bits set trap in their instruction methods
+    bool shift_ok = !(d->instr & RV32I_SHIFT_RSVD_BIT_MASK);
+
+    if      (p == &rv32i_cpu::addi<false>)              return THR_ADDI;
+    else if (p == &rv32i_cpu::slti<false>)              return THR_SLTI;
+    else if (p == &rv32i_cpu::sltiu<false>)             return THR_SLTIU;
+    else if (p == &rv32i_cpu::xori<false>)              return THR_XORI;
+    else if (p == &rv32i_cpu::ori<false>)               return THR_ORI;
+    else if (p == &rv32i_cpu::andi<false>)              return THR_ANDI;
+    else if (p == &rv32i_cpu::slli<false> && shift_ok)  return THR_SLLI;
+    else if (p == &rv32i_cpu::srli<false> && shift_ok)  return THR_SRLI;
+    else if (p == &rv32i_cpu::srai<false> && shift_ok)  return THR_SRAI;
+    else if (p == &rv32i_cpu::addr<false>)              return THR_ADD;
+    else if (p == &rv32i_cpu::subr<false>)              return THR_SUB;
+    else if (p == &rv32i_cpu::sllr<false>)              return THR_SLL;
+    else if (p == &rv32i_cpu::sltr<false>)              return THR_SLT;
+    else if (p == &rv32i_cpu::sltur<false>)             return THR_SLTU;
+    else if (p == &rv32i_cpu::xorr<false>)              return THR_XOR;
+    else if (p == &rv32i_cpu::srlr<false>)              return THR_SRL;
+    else if (p == &rv32i_cpu::srar<false>)              return THR_SRA;
+    else if (p == &rv32i_cpu::orr<false>)               return THR_OR;
+    else if (p == &rv32i_cpu::andr<false>)              return THR_AND;
+    else if (p == &rv32i_cpu::lui<false>)               return THR_LUI;
+    else if (p == &rv32i_cpu::auipc<false>)             return THR_AUIPC;
+
+    // RV32M instructions, identified by encoding as their methods are in a derived class
+    if (d->opcode == RV32I_OP_OPCODE && d->funct7 == RV32M_MULDIV_FUNCT7 && p != &rv32i_cpu::reserved<false>)
+    {
+        return THR_MUL + d->funct3;
+    }
+
+    return THR_HANDLER;
+}
+
+// -----------------------------------------------------------
+// Execute up to max_instr instructions of a basic block using
+// direct threaded dispatch. The computational instructions
+// are executed inline (using the same operation definitions
+// as their instruction methods) and all others by their
+// methods. As for execute_block(), execution stops early on
+// an error, a non-sequential PC update, or a request to exit
+// the block.
+// -----------------------------------------------------------
+
+int rv32i_cpu::thr_execute_block(rv32i_block_t* p_blk, uint32_t max_instr, unsigned &instr_count)
+{
+    // Labels in rv32i_thr_op_e order
+    static const void* const labels[THR_NUM_OPS] =
+    {
+        &&thr_handler,
+        &&thr_addi, &&thr_slti, &&thr_sltiu, &&thr_xori, &&thr_ori, &&thr_andi,
+        &&thr_slli, &&thr_srli, &&thr_srai,
+        &&thr_add,  &&thr_sub,  &&thr_sll,   &&thr_slt,  &&thr_sltu, &&thr_xor,
+        &&thr_srl,  &&thr_sra,  &&thr_or,    &&thr_and,
+        &&thr_lui,  &&thr_auipc,
+        &&thr_mul,  &&thr_mulh, &&thr_mulhsu, &&thr_mulhu, &&thr_div, &&thr_divu,
+        &&thr_rem,  &&thr_remu
+    };
+
+    int                   error   = 0;
+    uint32_t              idx     = 0;
+    rv32i_dcache_entry_t* p_instr = p_blk->p_instr;
+    rv32i_hart_state*     p_hart  = &state.hart[curr_hart];
+    uint32_t*             x       = p_hart->x;
+    rv32i_decode_t*       d;
+
+    // Resolve the block's instructions to their labels on first use
+    if (!p_blk->thr_ready)
+    {
+        for (uint32_t i = 0; i < p_blk->num_instr; i++)
+        {
+            p_instr[i].thr_label = labels[thr_op(&p_instr[i])];
+        }
+
+        p_blk->thr_ready = true;
+    }
+
+    blk_exec_count++;
+
+    blk_exit = false;
+
+    RV32I_THR_DISPATCH;
+
+thr_handler:
+    error = execute<false>(p_instr->decode, p_instr->p_entry);
+    idx++;
+
+    if (error || blk_exit || idx == max_instr || p_hart->pc != p_blk->tag + 4*idx)
+    {
+        goto thr_exit;
+    }
+
+    p_instr++;
+    RV32I_THR_DISPATCH;
+
+thr_addi:   RV32I_THR_OP(RV32I_OP_ADD   (x[d->rs1], d->imm_i));
+thr_slti:   RV32I_THR_OP(RV32I_OP_SLT   (x[d->rs1], d->imm_i));
+thr_sltiu:  RV32I_THR_OP(RV32I_OP_SLTU  (x[d->rs1], d->imm_i));
+thr_xori:   RV32I_THR_OP(RV32I_OP_XOR   (x[d->rs1], d->imm_i));
+thr_ori:    RV32I_THR_OP(RV32I_OP_OR    (x[d->rs1], d->imm_i));
+thr_andi:   RV32I_THR_OP(RV32I_OP_AND   (x[d->rs1], d->imm_i));
+thr_slli:   RV32I_THR_OP(RV32I_OP_SLL   (x[d->rs1], d->imm_i));
+thr_srli:   RV32I_THR_OP(RV32I_OP_SRL   (x[d->rs1], d->imm_i));
+thr_srai:   RV32I_THR_OP(RV32I_OP_SRA   (x[d->rs1], d->imm_i));
+thr_add:    RV32I_THR_OP(RV32I_OP_ADD   (x[d->rs1], x[d->rs2]));
+thr_sub:    RV32I_THR_OP(RV32I_OP_SUB   (x[d->rs1], x[d->rs2]));
+thr_sll:    RV32I_THR_OP(RV32I_OP_SLL   (x[d->rs1], x[d->rs2]));
+thr_slt:    RV32I_THR_OP(RV32I_OP_SLT   (x[d->rs1], x[d->rs2]));
+thr_sltu:   RV32I_THR_OP(RV32I_OP_SLTU  (x[d->rs1], x[d->rs2]));
+thr_xor:    RV32I_THR_OP(RV32I_OP_XOR   (x[d->rs1], x[d->rs2]));
+thr_srl:    RV32I_THR_OP(RV32I_OP_SRL   (x[d->rs1], x[d->rs2]));
+thr_sra:    RV32I_THR_OP(RV32I_OP_SRA   (x[d->rs1], x[d->rs2]));
+thr_or:     RV32I_THR_OP(RV32I_OP_OR    (x[d->rs1], x[d->rs2]));
+thr_and:    RV32I_THR_OP(RV32I_OP_AND   (x[d->rs1], x[d->rs2]));
+thr_lui:    RV32I_THR_OP(d->imm_u);
+thr_auipc:  RV32I_THR_OP(d->imm_u + p_hart->pc);
+thr_mul:    RV32I_THR_OP(RV32M_OP_MUL   (x[d->rs1], x[d->rs2]));
+thr_mulh:   RV32I_THR_OP(RV32M_OP_MULH  (x[d->rs1], x[d->rs2]));
+thr_mulhsu: RV32I_THR_OP(RV32M_OP_MULHSU(x[d->rs1], x[d->rs2]));
+thr_mulhu:  RV32I_THR_OP(RV32M_OP_MULHU (x[d->rs1], x[d->rs2]));
+thr_div:    RV32I_THR_OP(RV32M_OP_DIV   (x[d->rs1], x[d->rs2]));
+thr_divu:   RV32I_THR_OP(RV32M_OP_DIVU  (x[d->rs1], x[d->rs2]));
+thr_rem:    RV32I_THR_OP(RV32M_OP_REM   (x[d->rs1], x[d->rs2]));
+thr_remu:   RV32I_THR_OP(RV32M_OP_REMU  (x[d->rs1], x[d->rs2]));
+
+thr_exit:
+    instr_count += idx;
+
+    return error;
+}
+
+#else
+
+// Without labels as values support the engine is never enabled, but
+// the methods are defined for linking
+int rv32i_cpu::thr_op(const rv32i_dcache_entry_t* p_instr)
+{
+    return THR_HANDLER;
+}
+
+int rv32i_cpu::thr_execute_block(rv32i_block_t* p_blk, uint32_t max_instr, unsigned &instr_count)
+{
+    return execute_block(p_blk, max_instr, instr_count);
+}
+
+#endif
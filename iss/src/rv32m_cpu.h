@@ -27,46 +27,70 @@
 #ifndef _RV32M_CPU_H_
 #define _RV32M_CPU_H_
 
-#include "rv32_extensions.h"
 #include "rv32i_cpu_hdr.h"
-#include RV32M_INCLUDE
+#include "rv32i_cpu.h"
 
-class rv32m_cpu : public RV32_M_INHERITANCE_CLASS
+template <class BASE>
+class rv32m_cpu : public BASE
 {
 public:
              LIBRISCV32_API      rv32m_cpu      (FILE* dbgfp = stdout);
     virtual  LIBRISCV32_API      ~rv32m_cpu()   { };
 
+protected:
+    // ------------------------------------------------
+    // Members of the extended classes used here
+    // ------------------------------------------------
+
+    using BASE::state;
+    using BASE::curr_hart;
+    using BASE::dasm_fp;
+    using BASE::disassemble;
+    using BASE::rt_disassem;
+    using BASE::rmap;
+    using BASE::rmap_str;
+    using BASE::instr_name;
+    using BASE::increment_pc;
+    using BASE::arith_tbl;
+    using BASE::sll_tbl;
+    using BASE::slt_tbl;
+    using BASE::sltu_tbl;
+    using BASE::xor_tbl;
+    using BASE::srr_tbl;
+    using BASE::or_tbl;
+    using BASE::and_tbl;
+
 private:
     // ------------------------------------------------
     // Private member variables
     // ------------------------------------------------
 
-    const char mul_str     [DISASSEM_STR_SIZE] = "mul      ";
-    const char mulh_str    [DISASSEM_STR_SIZE] = "mulh     ";
-    const char mulhsu_str  [DISASSEM_STR_SIZE] = "mulhsu   ";
-    const char mulhu_str   [DISASSEM_STR_SIZE] = "mulhu    ";
-    const char div_str     [DISASSEM_STR_SIZE] = "div      ";
-    const char divu_str    [DISASSEM_STR_SIZE] = "divu     ";
-    const char rem_str     [DISASSEM_STR_SIZE] = "rem      ";
-    const char remu_str    [DISASSEM_STR_SIZE] = "remu     ";
+    static constexpr char mul_str     [] = "mul      ";
+    static constexpr char mulh_str    [] = "mulh     ";
+    static constexpr char mulhsu_str  [] = "mulhsu   ";
+    static constexpr char mulhu_str   [] = "mulhu    ";
+    static constexpr char div_str     [] = "div      ";
+    static constexpr char divu_str    [] = "divu     ";
+    static constexpr char rem_str     [] = "rem      ";
+    static constexpr char remu_str    [] = "remu     ";
 
     // ------------------------------------------------
     // Private member functions
     // ------------------------------------------------
 
     // M extension instructions
-    void mul                             (const p_rv32i_decode_t);
-    void mulh                            (const p_rv32i_decode_t);
-    void mulhsu                          (const p_rv32i_decode_t);
-    void mulhu                           (const p_rv32i_decode_t);
-    void div                             (const p_rv32i_decode_t);
-    void divu                            (const p_rv32i_decode_t);
-    void rem                             (const p_rv32i_decode_t);
-    void remu                            (const p_rv32i_decode_t);
+    template <bool TRACE> void mul       (const p_rv32i_decode_t);
+    template <bool TRACE> void mulh      (const p_rv32i_decode_t);
+    template <bool TRACE> void mulhsu    (const p_rv32i_decode_t);
+    template <bool TRACE> void mulhu     (const p_rv32i_decode_t);
+    template <bool TRACE> void div       (const p_rv32i_decode_t);
+    template <bool TRACE> void divu      (const p_rv32i_decode_t);
+    template <bool TRACE> void rem       (const p_rv32i_decode_t);
+    template <bool TRACE> void remu      (const p_rv32i_decode_t);
 
 protected:
-
+    // Add the RV32M instructions to the decode tables
+    void init_decode_tables              (void);
 
 };
 
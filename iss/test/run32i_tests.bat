@@ -140,4 +140,78 @@ for %%i in (^
     rm -f obj\%%i.o
     make SUBDIR=rv32ud FNAME=%%i.S
     ..\visualstudio\x64\Debug\rv32.exe -b -t %%i.exe
-  ) 
\ No newline at end of file
+  ) 
+
+  for %%i in (^
+  mul_branch^
+  ) do (
+    echo.
+    echo.
+    echo Running test for %%i ^(JIT^)...
+    make DIR32UI=. FNAME=%%i.S
+    ..\visualstudio\x64\Debug\rv32.exe -b -j -J -t %%i.exe
+    echo.
+    echo Running test for %%i ^(threaded^)...
+    ..\visualstudio\x64\Debug\rv32.exe -b -T -t %%i.exe
+  )
+
+  for %%i in (^
+  int_timer^
+  ) do (
+    echo.
+    echo.
+    echo Running test for %%i...
+    make DIR32UI=. FNAME=%%i.S
+    ..\visualstudio\x64\Debug\rv32.exe -b -t %%i.exe
+    echo.
+    echo Running test for %%i ^(threaded^)...
+    ..\visualstudio\x64\Debug\rv32.exe -b -T -t %%i.exe
+  )
+
+  for %%i in (^
+  smp_amo^
+  smp_int^
+  smp_lrsc^
+  ) do (
+    echo.
+    echo.
+    echo Running test for %%i ^(2 harts^)...
+    make DIR32UI=. FNAME=%%i.S
+    ..\visualstudio\x64\Debug\rv32.exe -b -N 2 -t %%i.exe
+    echo.
+    echo Running test for %%i ^(2 harts, quantum of 1^)...
+    ..\visualstudio\x64\Debug\rv32.exe -e -N 2 -Q 1 -t %%i.exe
+  )
+
+  for %%i in (^
+  smp_amo^
+  smp_int^
+  smp_lrsc^
+  ) do (
+    echo.
+    echo.
+    echo Running test for %%i ^(4 harts in parallel^)...
+    make DIR32UI=. FNAME=%%i.S
+    ..\visualstudio\x64\Debug\rv32.exe -b -N 4 -X -t %%i.exe
+    echo.
+    echo Running test for %%i ^(4 harts in parallel, quantum of 10^)...
+    ..\visualstudio\x64\Debug\rv32.exe -b -N 4 -X -Q 10 -t %%i.exe
+  )
+
+  for %%i in (^
+  sym_line^
+  ) do (
+    echo.
+    echo.
+    echo Running test for %%i...
+    make DIR32UI=. FNAME=%%i.S
+    ..\visualstudio\x64\Debug\rv32.exe -b -r -y -t %%i.exe > %%i.log
+    findstr /c:"PASS" /c:"FAIL" %%i.log
+    for /f "delims=:" %%n in ('findstr /n /c:"line checked by the test scripts" %%i.S') do (
+      findstr /c:"<sym_line_add>:" %%i.log > nul && findstr /r /c:"%%i.S:%%n$" %%i.log > nul && (
+        echo PASS: symbol and line labels
+      ) || (
+        echo *FAIL*: symbol and line labels
+      )
+    )
+  )
@@ -39,7 +39,7 @@ MAKE_ARGS="TESTSRCROOT=$TSTROOT ARCHCHAIN=$ARCHPREFIX"
 #
 # Always build tests  from clean
 #
-rm -rf obj/* *.exe
+rm -rf obj/* *.exe *.log
 
 #
 # RV32I tests
@@ -116,3 +116,93 @@ do
     make $MAKE_ARGS SUBDIR=rv32ud FNAME=$tst.S
     $EXE_DIR/rv32 -b -t $tst.exe
 done
+
+#
+# Execution engine tests, of programs in this folder, with the JIT (its
+# translations checked in lockstep against the interpreter), and with
+# threaded dispatch. The JIT needs an x86-64 build (e.g. the ISS makefile's
+# x64 target, with EXE_DIR=../obj64), and its runs fail on any other.
+#
+for tst in mul_branch
+do
+    echo
+    echo
+    echo "Running test for $tst (JIT)..."
+    make $MAKE_ARGS DIR32UI=. FNAME=$tst.S
+    $EXE_DIR/rv32 -b -j -J -t $tst.exe
+    echo
+    echo "Running test for $tst (threaded)..."
+    $EXE_DIR/rv32 -b -T -t $tst.exe
+done
+
+#
+# Interrupt tests, of programs in this folder, with the interpreter and
+# threaded dispatch
+#
+for tst in int_timer
+do
+    echo
+    echo
+    echo "Running test for $tst..."
+    make $MAKE_ARGS DIR32UI=. FNAME=$tst.S
+    $EXE_DIR/rv32 -b -t $tst.exe
+    echo
+    echo "Running test for $tst (threaded)..."
+    $EXE_DIR/rv32 -b -T -t $tst.exe
+done
+
+#
+# Multiple hart tests, of programs in this folder, scheduled round robin,
+# and with a quantum of one instruction, halting on ecall/ebreak (so that
+# harts halt on an ebreak at the end of a quantum)
+#
+for tst in smp_amo smp_int smp_lrsc
+do
+    echo
+    echo
+    echo "Running test for $tst (2 harts)..."
+    make $MAKE_ARGS DIR32UI=. FNAME=$tst.S
+    $EXE_DIR/rv32 -b -N 2 -t $tst.exe
+    echo
+    echo "Running test for $tst (2 harts, quantum of 1)..."
+    $EXE_DIR/rv32 -e -N 2 -Q 1 -t $tst.exe
+done
+
+#
+# Multiple hart tests, with the harts run in parallel on host threads,
+# with the default quantum, and a short one
+#
+for tst in smp_amo smp_int smp_lrsc
+do
+    echo
+    echo
+    echo "Running test for $tst (4 harts in parallel)..."
+    make $MAKE_ARGS DIR32UI=. FNAME=$tst.S
+    $EXE_DIR/rv32 -b -N 4 -X -t $tst.exe
+    echo
+    echo "Running test for $tst (4 harts in parallel, quantum of 10)..."
+    $EXE_DIR/rv32 -b -N 4 -X -Q 10 -t $tst.exe
+done
+
+#
+# Symbol and source line tests, of programs in this folder built with debug
+# information, with the run-time disassembly labelled from the executable's
+# symbol and DWARF line tables (-r -y), checking the labels of a function
+# and of the line marked in its source
+#
+for tst in sym_line
+do
+    echo
+    echo
+    echo "Running test for $tst..."
+    make $MAKE_ARGS DIR32UI=. FNAME=$tst.S
+    $EXE_DIR/rv32 -b -r -y -t $tst.exe > $tst.log
+    tail -n 1 $tst.log
+    line=`grep -n "line checked by the test scripts" $tst.S | cut -d: -f1`
+    if grep -q "<sym_line_add>:" $tst.log && grep -q "$tst.S:$line\$" $tst.log
+    then
+        echo "PASS: symbol and line labels"
+    else
+        echo "*FAIL*: symbol and line labels"
+    fi
+done